@@ -0,0 +1,312 @@
+#include "DataFlashFileIndex.h"
+
+#if AP_REPLAY_MMAP_ENABLED
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+  DAL messages written with WRITE_REPLAY_BLOCK_IFCHANGED. Each is only
+  written when it changes, so a replay starting part way through a
+  log needs the latest of each before the start point
+ */
+const char *const AP_LoggerFileIndex::state_names[] = {
+    "RFRN", "RISH", "RISI", "RASH", "RASI", "RBRH", "RBRI", "RRNH",
+    "RRNI", "RGPH", "RGPI", "RGPJ", "RMGH", "RMGI", "RBCH", "RBCI",
+    "RVOH", "ROFH", "REPH", "RSLL", "REVH", "RWOH", "RBOH",
+};
+
+bool AP_LoggerFileIndex::is_state_message(const char *name)
+{
+    for (const char *s : state_names) {
+        if (strncmp(name, s, 4) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AP_LoggerFileIndex::~AP_LoggerFileIndex()
+{
+    clear();
+}
+
+void AP_LoggerFileIndex::clear()
+{
+    free(bucket_offsets);
+    bucket_offsets = nullptr;
+    num_buckets = bucket_space = 0;
+    free(setup_offsets);
+    setup_offsets = nullptr;
+    num_setup = setup_space = 0;
+    free(state_offsets);
+    state_offsets = nullptr;
+    num_state = state_space = 0;
+    free(bucket_state_start);
+    bucket_state_start = nullptr;
+    num_bucket_state = bucket_state_space = 0;
+    memset(&hdr, 0, sizeof(hdr));
+}
+
+bool AP_LoggerFileIndex::append(uint64_t *&array, uint32_t &count, uint32_t &space, uint64_t value)
+{
+    if (count == space) {
+        const uint32_t new_space = space ? space * 2 : 1024;
+        uint64_t *new_array = (uint64_t *)realloc(array, new_space * sizeof(uint64_t));
+        if (new_array == nullptr) {
+            return false;
+        }
+        array = new_array;
+        space = new_space;
+    }
+    array[count++] = value;
+    return true;
+}
+
+/*
+  walk the log once, recording where each message type first appears,
+  the format and parameter messages, the first timestamped message in
+  each time bucket and the latest DAL state messages before it
+ */
+bool AP_LoggerFileIndex::build(const uint8_t *data, uint64_t size, int64_t log_mtime)
+{
+    clear();
+
+    uint8_t lengths[256] {};
+    bool timestamped[256] {};
+    bool setup_type[256] {};
+    bool have_time = false;
+
+    // DAL state messages, by type and instance if it has one
+    bool state_type[256] {};
+    bool has_instance[256] {};
+    uint16_t state_slot[256][max_state_instances] {};
+    uint64_t *latest_state = nullptr;
+    uint32_t num_slots = 0;
+    uint32_t slot_space = 0;
+
+    lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+    setup_type[LOG_FORMAT_MSG] = true;
+
+    uint64_t ofs = 0;
+    while (ofs + 3 <= size) {
+        if (data[ofs] != HEAD_BYTE1 || data[ofs+1] != HEAD_BYTE2) {
+            ::printf("Index: bad log header at %llu\n", (unsigned long long)ofs);
+            break;
+        }
+        const uint8_t type = data[ofs+2];
+        const uint8_t len = lengths[type];
+        if (len == 0 || ofs + len > size) {
+            break;
+        }
+
+        if (type == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            memcpy(&f, &data[ofs], sizeof(f));
+            lengths[f.type] = f.length;
+            timestamped[f.type] = f.format[0] == 'Q' && strncmp(f.labels, "TimeUS,", 7) == 0;
+            setup_type[f.type] = setup_type[f.type] || strncmp(f.name, "PARM", 4) == 0;
+            state_type[f.type] = is_state_message(f.name);
+            // instance numbers are the last field, labelled I
+            const size_t nlabels = strnlen(f.labels, sizeof(f.labels));
+            const size_t nformat = strnlen(f.format, sizeof(f.format));
+            has_instance[f.type] = nlabels >= 2 && nformat >= 1 &&
+                strncmp(&f.labels[nlabels-2], ",I", 2) == 0 &&
+                f.format[nformat-1] == 'B';
+        }
+
+        if (state_type[type]) {
+            const uint8_t instance = has_instance[type] ? data[ofs+len-1] % max_state_instances : 0;
+            uint16_t &slot = state_slot[type][instance];
+            if (slot == 0) {
+                // slots are numbered from 1 so zero is unused
+                if (!append(latest_state, num_slots, slot_space, 0)) {
+                    free(latest_state);
+                    return false;
+                }
+                slot = num_slots;
+            }
+            latest_state[slot-1] = ofs;
+        }
+
+        if (setup_type[type] &&
+            !append(setup_offsets, num_setup, setup_space, ofs)) {
+            return false;
+        }
+
+        if (timestamped[type] && len >= 3 + sizeof(uint64_t)) {
+            uint64_t time_us;
+            memcpy(&time_us, &data[ofs+3], sizeof(time_us));
+            if (!have_time) {
+                hdr.first_time_us = time_us;
+                have_time = true;
+            }
+            // times going backwards (e.g. after a reboot in the log)
+            // leave the index pointing at the first pass through the
+            // bucket
+            // a jump of more than a day is a corrupt timestamp
+            const uint64_t max_bucket = num_buckets + 86400ULL * 1000000ULL / bucket_us;
+            const uint64_t bucket = time_us >= hdr.first_time_us ? (time_us - hdr.first_time_us) / bucket_us : 0;
+            if (time_us >= hdr.first_time_us && bucket <= max_bucket) {
+                while (num_buckets <= bucket) {
+                    if (!append(bucket_offsets, num_buckets, bucket_space, ofs) ||
+                        !append(bucket_state_start, num_bucket_state, bucket_state_space, num_state)) {
+                        free(latest_state);
+                        return false;
+                    }
+                    // the state when the bucket starts
+                    for (uint32_t i=0; i<num_slots; i++) {
+                        if (!append(state_offsets, num_state, state_space, latest_state[i])) {
+                            free(latest_state);
+                            return false;
+                        }
+                    }
+                }
+            }
+            if (bucket <= max_bucket && time_us > hdr.last_time_us) {
+                hdr.last_time_us = time_us;
+            }
+        }
+
+        if (hdr.msg_count[type] == 0) {
+            hdr.first_offset[type] = ofs;
+        }
+        hdr.msg_count[type]++;
+        ofs += len;
+    }
+    free(latest_state);
+
+    hdr.magic = index_magic;
+    hdr.version = index_version;
+    hdr.header_size = sizeof(hdr);
+    hdr.log_size = size;
+    hdr.log_mtime = log_mtime;
+    hdr.bucket_us = bucket_us;
+    hdr.num_buckets = num_buckets;
+    hdr.num_setup = num_setup;
+    hdr.num_state = num_state;
+    return true;
+}
+
+/*
+  bucket holding time_us, num_buckets if it is past the end of the
+  log
+ */
+uint32_t AP_LoggerFileIndex::bucket_for_time(uint64_t time_us) const
+{
+    if (time_us <= hdr.first_time_us) {
+        return 0;
+    }
+    const uint64_t bucket = (time_us - hdr.first_time_us) / bucket_us;
+    if (bucket >= num_buckets) {
+        return num_buckets;
+    }
+    return bucket;
+}
+
+uint64_t AP_LoggerFileIndex::offset_for_time(uint64_t time_us) const
+{
+    if (num_buckets == 0 || time_us <= hdr.first_time_us) {
+        return 0;
+    }
+    const uint32_t bucket = bucket_for_time(time_us);
+    if (bucket >= num_buckets) {
+        return hdr.log_size;
+    }
+    return bucket_offsets[bucket];
+}
+
+uint32_t AP_LoggerFileIndex::state_offsets_for_time(uint64_t time_us, const uint64_t *&offsets) const
+{
+    const uint32_t bucket = bucket_for_time(time_us);
+    if (bucket >= num_buckets) {
+        // replay won't start, so there is nothing to pass on
+        return 0;
+    }
+    const uint64_t start = bucket_state_start[bucket];
+    const uint64_t end = bucket+1 < num_buckets ? bucket_state_start[bucket+1] : num_state;
+    offsets = &state_offsets[start];
+    return end - start;
+}
+
+bool AP_LoggerFileIndex::save(const char *filename) const
+{
+    // write to a temporary file and rename so a partial index is
+    // never picked up
+    char tmpname[strlen(filename)+5];
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+    FILE *f = ::fopen(tmpname, "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    if (ok && num_setup > 0) {
+        ok = fwrite(setup_offsets, sizeof(uint64_t), num_setup, f) == num_setup;
+    }
+    if (ok && num_buckets > 0) {
+        ok = fwrite(bucket_offsets, sizeof(uint64_t), num_buckets, f) == num_buckets &&
+            fwrite(bucket_state_start, sizeof(uint64_t), num_buckets, f) == num_buckets;
+    }
+    if (ok && num_state > 0) {
+        ok = fwrite(state_offsets, sizeof(uint64_t), num_state, f) == num_state;
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || ::rename(tmpname, filename) != 0) {
+        ::unlink(tmpname);
+        return false;
+    }
+    return true;
+}
+
+bool AP_LoggerFileIndex::load(const char *filename, uint64_t log_size, int64_t log_mtime)
+{
+    clear();
+
+    FILE *f = ::fopen(filename, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+        hdr.magic == index_magic &&
+        hdr.version == index_version &&
+        hdr.header_size == sizeof(hdr) &&
+        hdr.bucket_us == bucket_us &&
+        hdr.log_size == log_size &&
+        hdr.log_mtime == log_mtime;
+    if (ok && hdr.num_setup > 0) {
+        setup_offsets = (uint64_t *)malloc(hdr.num_setup * sizeof(uint64_t));
+        ok = setup_offsets != nullptr &&
+            fread(setup_offsets, sizeof(uint64_t), hdr.num_setup, f) == hdr.num_setup;
+        num_setup = setup_space = hdr.num_setup;
+    }
+    if (ok && hdr.num_buckets > 0) {
+        bucket_offsets = (uint64_t *)malloc(hdr.num_buckets * sizeof(uint64_t));
+        bucket_state_start = (uint64_t *)malloc(hdr.num_buckets * sizeof(uint64_t));
+        ok = bucket_offsets != nullptr && bucket_state_start != nullptr &&
+            fread(bucket_offsets, sizeof(uint64_t), hdr.num_buckets, f) == hdr.num_buckets &&
+            fread(bucket_state_start, sizeof(uint64_t), hdr.num_buckets, f) == hdr.num_buckets;
+        num_buckets = bucket_space = hdr.num_buckets;
+        num_bucket_state = bucket_state_space = hdr.num_buckets;
+    }
+    if (ok && hdr.num_state > 0) {
+        state_offsets = (uint64_t *)malloc(hdr.num_state * sizeof(uint64_t));
+        ok = state_offsets != nullptr &&
+            fread(state_offsets, sizeof(uint64_t), hdr.num_state, f) == hdr.num_state;
+        num_state = state_space = hdr.num_state;
+    }
+    // bucket state snapshots must lie within the state array
+    for (uint32_t i=0; ok && i<num_buckets; i++) {
+        ok = bucket_state_start[i] <= num_state &&
+            (i == 0 || bucket_state_start[i] >= bucket_state_start[i-1]);
+    }
+    fclose(f);
+    if (!ok) {
+        clear();
+    }
+    return ok;
+}
+
+#endif // AP_REPLAY_MMAP_ENABLED
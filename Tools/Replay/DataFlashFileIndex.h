@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+  one-pass index of a memory mapped DataFlash log, allowing replay to
+  start part way through a log. The index is saved in a sidecar file
+  next to the log so later replays of the same log skip the scan
+ */
+
+#include <AP_Logger/AP_Logger.h>
+
+#include "DataFlashFileReader.h"
+
+#if AP_REPLAY_MMAP_ENABLED
+
+class AP_LoggerFileIndex
+{
+public:
+    AP_LoggerFileIndex() {}
+    ~AP_LoggerFileIndex();
+
+    // width of the time buckets
+    static const uint32_t bucket_us = 1000000;
+
+    // scan a mapped log, building the index
+    bool build(const uint8_t *data, uint64_t size, int64_t log_mtime);
+
+    // load or save the sidecar index for a log with the given size
+    // and modification time. A sidecar for a different log is
+    // rejected
+    bool load(const char *filename, uint64_t log_size, int64_t log_mtime);
+    bool save(const char *filename) const;
+
+    // offset of the first timestamped message in the bucket holding
+    // time_us, or the end of the log if time_us is past the end
+    uint64_t offset_for_time(uint64_t time_us) const;
+
+    // offsets of the messages needed to configure replay before
+    // starting part way through a log (formats and parameters)
+    uint32_t num_setup_offsets() const { return num_setup; }
+    uint64_t setup_offset(uint32_t i) const { return setup_offsets[i]; }
+
+    // offsets of the latest DAL state messages before the bucket
+    // holding time_us, one for each message type and instance seen so
+    // far, in no particular order. Zero where there is none. The DAL
+    // only logs these when they change, so they must be passed on
+    // when starting part way through a log
+    uint32_t state_offsets_for_time(uint64_t time_us, const uint64_t *&offsets) const;
+
+    uint64_t first_time_us() const { return hdr.first_time_us; }
+    uint64_t last_time_us() const { return hdr.last_time_us; }
+    uint64_t message_count(uint8_t type) const { return hdr.msg_count[type]; }
+    uint64_t first_offset(uint8_t type) const { return hdr.first_offset[type]; }
+
+private:
+    struct PACKED index_header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t header_size;
+        uint64_t log_size;
+        int64_t log_mtime;
+        uint64_t first_time_us;
+        uint64_t last_time_us;
+        uint32_t bucket_us;
+        uint32_t num_buckets;
+        uint32_t num_setup;
+        uint32_t num_state;
+        uint64_t msg_count[256];
+        uint64_t first_offset[256];
+    } hdr {};
+
+    static const uint32_t index_magic = 0x49504152; // "RAPI"
+    static const uint16_t index_version = 2;
+
+    // DAL messages written with WRITE_REPLAY_BLOCK_IFCHANGED
+    static const char *const state_names[];
+    static bool is_state_message(const char *name);
+    // instances of a state message tracked separately
+    static const uint8_t max_state_instances = 16;
+
+    uint64_t *bucket_offsets = nullptr;
+    uint32_t num_buckets = 0;
+    uint32_t bucket_space = 0;
+
+    uint64_t *setup_offsets = nullptr;
+    uint32_t num_setup = 0;
+    uint32_t setup_space = 0;
+
+    // snapshots of the latest state message offsets, one per bucket,
+    // each starting at bucket_state_start[bucket] in state_offsets
+    uint64_t *state_offsets = nullptr;
+    uint32_t num_state = 0;
+    uint32_t state_space = 0;
+    uint64_t *bucket_state_start = nullptr;
+    uint32_t num_bucket_state = 0;
+    uint32_t bucket_state_space = 0;
+
+    uint32_t bucket_for_time(uint64_t time_us) const;
+
+    bool append(uint64_t *&array, uint32_t &count, uint32_t &space, uint64_t value);
+    void clear();
+};
+
+#endif // AP_REPLAY_MMAP_ENABLED
@@ -1,14 +1,21 @@
 #include "DataFlashFileReader.h"
+#include "DataFlashFileIndex.h"
 #include <AP_Filesystem/AP_Filesystem.h>
 
 #include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
 #include <cinttypes>
 
+#if AP_REPLAY_MMAP_ENABLED
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #ifndef PRIu64
 #define PRIu64 "llu"
 #endif
@@ -19,10 +26,21 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if AP_REPLAY_MMAP_ENABLED
+    if (map_data != nullptr) {
+        munmap(map_data, map_size);
+    }
+    delete index;
+#endif
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
+#if AP_REPLAY_MMAP_ENABLED
+    if (map_log(logfile)) {
+        return true;
+    }
+#endif
     fd = AP::FS().open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
@@ -30,6 +48,136 @@ bool AP_LoggerFileReader::open_log(const char *logfile)
     return true;
 }
 
+#if AP_REPLAY_MMAP_ENABLED
+/*
+  map the whole log into memory. The mapping is private and writable
+  so that messages can be handed to the message handlers in place
+ */
+bool AP_LoggerFileReader::map_log(const char *logfile)
+{
+    const int mfd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(mfd, &st) != 0 || st.st_size == 0) {
+        ::close(mfd);
+        return false;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, mfd, 0);
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    map_data = (uint8_t *)p;
+    map_size = st.st_size;
+    map_offset = 0;
+    map_mtime = st.st_mtime;
+    map_filename = logfile;
+    return true;
+}
+
+/*
+  load the sidecar index for the log, or scan the log and save one
+ */
+bool AP_LoggerFileReader::load_index(void)
+{
+    if (index != nullptr) {
+        return true;
+    }
+    index = new AP_LoggerFileIndex();
+    if (index == nullptr) {
+        return false;
+    }
+    char idxname[strlen(map_filename)+5];
+    snprintf(idxname, sizeof(idxname), "%s.idx", map_filename);
+    if (index->load(idxname, map_size, map_mtime)) {
+        return true;
+    }
+    ::printf("Indexing %s\n", map_filename);
+    if (!index->build(map_data, map_size, map_mtime)) {
+        delete index;
+        index = nullptr;
+        return false;
+    }
+    if (!index->save(idxname)) {
+        ::printf("Failed to save index %s\n", idxname);
+    }
+    return true;
+}
+#endif // AP_REPLAY_MMAP_ENABLED
+
+#if AP_REPLAY_MMAP_ENABLED
+static int compare_offsets(const void *a, const void *b)
+{
+    const uint64_t ofs_a = *(const uint64_t *)a;
+    const uint64_t ofs_b = *(const uint64_t *)b;
+    return ofs_a < ofs_b ? -1 : ofs_a > ofs_b ? 1 : 0;
+}
+#endif
+
+bool AP_LoggerFileReader::seek_time(uint64_t time_us)
+{
+#if AP_REPLAY_MMAP_ENABLED
+    if (map_data == nullptr || !load_index()) {
+        return false;
+    }
+    const uint64_t target = index->offset_for_time(time_us);
+    if (target < map_offset) {
+        return false;
+    }
+    // the latest DAL state messages, in log order
+    const uint64_t *state_offsets = nullptr;
+    const uint32_t num_state = index->state_offsets_for_time(time_us, state_offsets);
+    uint64_t *state = nullptr;
+    if (num_state > 0) {
+        state = (uint64_t *)malloc(num_state * sizeof(uint64_t));
+        if (state == nullptr) {
+            return false;
+        }
+        memcpy(state, state_offsets, num_state * sizeof(uint64_t));
+        qsort(state, num_state, sizeof(uint64_t), compare_offsets);
+    }
+    // pass on the formats, parameters and state before the start
+    // point, merged so each message follows its format
+    uint32_t s = 0;
+    uint32_t i = 0;
+    bool ok = true;
+    while (ok) {
+        const uint64_t setup_ofs = i < index->num_setup_offsets() ? index->setup_offset(i) : target;
+        const uint64_t state_ofs = s < num_state ? state[s] : target;
+        uint64_t ofs;
+        if (setup_ofs <= state_ofs) {
+            ofs = setup_ofs;
+            i++;
+            if (setup_ofs == state_ofs) {
+                s++;
+            }
+        } else {
+            ofs = state_ofs;
+            s++;
+        }
+        if (ofs >= target) {
+            break;
+        }
+        if (ofs == 0 || ofs < map_offset) {
+            continue;
+        }
+        map_offset = ofs;
+        ok = update();
+    }
+    free(state);
+    if (!ok) {
+        return false;
+    }
+    map_offset = target;
+    return true;
+#else
+    return false;
+#endif
+}
+
 ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
 {
     uint64_t ret = AP::FS().read(fd, buffer, count);
@@ -53,11 +201,35 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
 
 bool AP_LoggerFileReader::update()
 {
-    uint8_t hdr[3];
-    if (read_input(hdr, 3) != 3) {
+#if AP_REPLAY_MMAP_ENABLED
+    if (map_data != nullptr) {
+        if (map_offset + 3 > map_size) {
+            return false;
+        }
+        uint8_t *msg = &map_data[map_offset];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            printf("bad log header\n");
+            return false;
+        }
+        const uint8_t len = msg[2] == LOG_FORMAT_MSG ? sizeof(struct log_Format) : formats[msg[2]].length;
+        if (len == 0) {
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            exit(1);
+        }
+        if (map_offset + len > map_size) {
+            return false;
+        }
+        map_offset += len;
+        bytes_read += len;
+        return process(msg);
+    }
+#endif
+
+    uint8_t msg[256];
+    if (read_input(msg, 3) != 3) {
         return false;
     }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
         printf("bad log header\n");
         return false;
     }
@@ -65,38 +237,46 @@ bool AP_LoggerFileReader::update()
 #if CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
     // running on stm32 is slow enough it is nice to see progress
     if (message_count % 500 == 0) {
-        ::printf("line %u pkt 0x%02x t=%u\n", message_count, hdr[2], AP_HAL::millis());
+        ::printf("line %u pkt 0x%02x t=%u\n", message_count, msg[2], AP_HAL::millis());
     }
 #endif
-    packet_counts[hdr[2]]++;
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
-            return false;
-        }
-        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
-
-        message_count++;
-        return handle_log_format_msg(f);
-    }
-
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
+    const uint8_t len = msg[2] == LOG_FORMAT_MSG ? sizeof(struct log_Format) : formats[msg[2]].length;
+    if (len == 0) {
         // can't just throw these away as the format specifies the
         // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
+        ::printf("No format defined for type (%d)\n", msg[2]);
         exit(1);
     }
-
-    uint8_t msg[f.length];
-
-    memcpy(msg, hdr, 3);
-    if (read_input(&msg[3], f.length-3) != f.length-3) {
+    if (read_input(&msg[3], len-3) != len-3) {
         return false;
     }
+    return process(msg);
+}
 
+/*
+  pass one complete message to the handlers
+ */
+bool AP_LoggerFileReader::process(uint8_t *msg)
+{
+    packet_counts[msg[2]]++;
     message_count++;
-    return handle_msg(f, msg);
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, msg, sizeof(f));
+        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        timestamped[f.type] = f.format[0] == 'Q' && strncmp(f.labels, "TimeUS,", 7) == 0;
+        return handle_log_format_msg(f);
+    }
+
+    if (end_time_us != 0 && timestamped[msg[2]]) {
+        uint64_t time_us;
+        memcpy(&time_us, &msg[3], sizeof(time_us));
+        if (time_us > end_time_us) {
+            return false;
+        }
+    }
+
+    return handle_msg(formats[msg[2]], msg);
 }
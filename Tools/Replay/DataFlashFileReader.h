@@ -4,6 +4,14 @@
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+// logs are memory mapped where the OS supports it, which avoids a
+// copy per message and allows seeking by time through an index
+#ifndef AP_REPLAY_MMAP_ENABLED
+#define AP_REPLAY_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+class AP_LoggerFileIndex;
+
 class AP_LoggerFileReader
 {
 public:
@@ -14,6 +22,15 @@ public:
     bool open_log(const char *logfile);
     bool update();
 
+    // start replaying from the first message at or after log time
+    // time_us, after passing on the format and parameter messages
+    // and the latest DAL state messages that come before it. Only
+    // available for mapped logs
+    bool seek_time(uint64_t time_us);
+
+    // stop replaying once a message is later than log time time_us
+    void set_end_time(uint64_t time_us) { end_time_us = time_us; }
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
@@ -27,6 +44,23 @@ protected:
 
 private:
     ssize_t read_input(void *buf, size_t count);
+    bool process(uint8_t *msg);
+
+#if AP_REPLAY_MMAP_ENABLED
+    bool map_log(const char *logfile);
+    bool load_index(void);
+
+    const char *map_filename = nullptr;
+    uint8_t *map_data = nullptr;
+    uint64_t map_size;
+    uint64_t map_offset;
+    int64_t map_mtime;
+    AP_LoggerFileIndex *index = nullptr;
+#endif
+
+    // true for message types whose first field is TimeUS
+    bool timestamped[256] {};
+    uint64_t end_time_us = 0;
 
     uint64_t bytes_read = 0;
     uint32_t message_count = 0;
@@ -135,11 +135,15 @@ void Replay::usage(void)
     ::printf("\t--param-file FILENAME  load parameters from a file\n");
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
+    ::printf("\t--start-time SECONDS  start replay at this log time (TimeUS in seconds)\n");
+    ::printf("\t--end-time SECONDS  stop replay after this log time (TimeUS in seconds)\n");
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    START_TIME,
+    END_TIME,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -151,6 +155,8 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"param-file",      true,   0, 'F'},
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
+        {"start-time",      true,   0, param_key::START_TIME},
+        {"end-time",        true,   0, param_key::END_TIME},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -186,6 +192,14 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             replay_force_ekf3 = true;
             break;
 
+        case param_key::START_TIME:
+            start_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
+        case param_key::END_TIME:
+            end_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
         case 'h':
         default:
             usage();
@@ -244,6 +258,11 @@ void Replay::setup()
         ::printf("open(%s): %m\n", filename);
         exit(1);
     }
+    if (start_time_us != 0 && !reader.seek_time(start_time_us)) {
+        ::printf("Unable to seek to %.3f seconds\n", start_time_us*1.0e-6);
+        exit(1);
+    }
+    reader.set_end_time(end_time_us);
 }
 
 void Replay::loop()
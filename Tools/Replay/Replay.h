@@ -87,6 +87,10 @@ private:
     const char *filename;
     ReplayVehicle &_vehicle;
 
+    // section of the log to replay, zero for the start/end of the log
+    uint64_t start_time_us;
+    uint64_t end_time_us;
+
     LogReader reader{_vehicle.log_structure, _vehicle.ekf2, _vehicle.ekf3};
 
     void _parse_command_line(uint8_t argc, char * const argv[]);
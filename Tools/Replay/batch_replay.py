@@ -0,0 +1,347 @@
+#!/usr/bin/env python
+
+'''
+Run Replay over many logs in parallel and produce a consolidated report
+
+Each log is replayed by a separate Replay process running in its own
+scratch directory, so replays never share logs, parameters or EKF
+state. The replayed output is then compared against the original EKF
+output recorded in the log, and per-core innovation statistics and the
+maximum divergence of each EKF message field are gathered into a
+single JSON report.
+
+Example:
+  ./waf replay
+  Tools/Replay/batch_replay.py -j 8 --report report.json -p EK3_ACC_P_NSE=0.5 logs/
+'''
+
+from __future__ import print_function
+
+import glob
+import json
+import math
+import multiprocessing
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# EKF output messages compared between the original and replayed cores
+ek2_list = ['NKF1', 'NKF2', 'NKF3', 'NKF4', 'NKF5', 'NKF0', 'NKQ', 'NKY0', 'NKY1']
+ek3_list = ['XKF1', 'XKF2', 'XKF3', 'XKF4', 'XKF0', 'XKFS', 'XKQ', 'XKFD', 'XKV1', 'XKV2', 'XKY0', 'XKY1']
+
+# messages holding the innovations summarised in the report
+innovation_msgs = set(['NKF3', 'XKF3'])
+
+
+def find_logs(paths):
+    '''expand a list of files and directories into a sorted list of logs'''
+    logs = []
+    for path in paths:
+        if os.path.isdir(path):
+            for ext in ['*.BIN', '*.bin']:
+                logs.extend(glob.glob(os.path.join(path, '**', ext), recursive=True))
+        else:
+            logs.append(path)
+    return sorted(set([os.path.abspath(x) for x in logs]))
+
+
+class FieldStats(object):
+    '''running max/rms of a single value'''
+    def __init__(self):
+        self.count = 0
+        self.sum_sq = 0.0
+        self.max_abs = 0.0
+
+    def add(self, value):
+        self.count += 1
+        self.sum_sq += value * value
+        self.max_abs = max(self.max_abs, abs(value))
+
+    def report(self):
+        return {
+            'max_abs': self.max_abs,
+            'rms': math.sqrt(self.sum_sq / self.count) if self.count else 0.0,
+        }
+
+
+def field_matches(v1, v2, accuracy):
+    '''same comparison as check_replay.check_log'''
+    if v1 == v2:
+        return True
+    if accuracy > 0:
+        margin = accuracy * 0.01 * (v1 + v2) * 0.5
+        return abs(v1 - v2) <= abs(margin)
+    return False
+
+
+def analyse_log(logfile, mlist, accuracy=0.0, ignores=set()):
+    '''compare the replayed cores in a Replay output log against the
+    original cores, in a single pass over the log'''
+    from pymavlink import mavutil
+
+    mlog = mavutil.mavlink_connection(logfile)
+    base = {}
+    for m in mlist:
+        base[m] = {}
+    count = 0
+    base_count = 0
+    mismatches = 0
+    divergence = {}
+    innovations = {}
+
+    while True:
+        m = mlog.recv_match(type=mlist)
+        if m is None:
+            break
+        if not hasattr(m, 'C'):
+            continue
+        mtype = m.get_type()
+        core = m.C
+        if core < 100:
+            base[mtype][core] = m
+            base_count += 1
+            continue
+        core -= 100
+        mb = base[mtype].get(core, None)
+        if mb is None:
+            continue
+        count += 1
+        core_div = divergence.setdefault(core, {})
+        core_innov = innovations.setdefault(core, {})
+        for f in m._fieldnames:
+            if f in ['C', 'TimeUS']:
+                continue
+            name = "%s.%s" % (mtype, f)
+            v1 = getattr(m, f)
+            v2 = getattr(mb, f)
+            if not isinstance(v1, (int, float)):
+                continue
+            if mtype in innovation_msgs:
+                if name not in core_innov:
+                    core_innov[name] = FieldStats()
+                core_innov[name].add(v1)
+            if name in ignores:
+                continue
+            if name not in core_div:
+                core_div[name] = 0.0
+            core_div[name] = max(core_div[name], abs(v1 - v2))
+            if not field_matches(v1, v2, accuracy):
+                mismatches += 1
+
+    cores = {}
+    for core in sorted(divergence.keys()):
+        fields = divergence[core]
+        worst = max(fields, key=fields.get) if len(fields) else None
+        cores[str(core)] = {
+            'max_divergence': fields[worst] if worst is not None else 0.0,
+            'max_divergence_field': worst,
+            'divergence': fields,
+            'innovations': dict((k, v.report()) for (k, v) in innovations[core].items()),
+        }
+
+    count_delta = abs(count - base_count)
+    return {
+        'messages': count,
+        'base_messages': base_count,
+        'mismatches': mismatches,
+        'passed': mismatches == 0 and count != 0 and count_delta <= 100,
+        'cores': cores,
+    }
+
+
+def replay_one(job):
+    '''replay a single log in a scratch directory. Runs in a pool worker'''
+    logfile = job['log']
+    result = {
+        'log': logfile,
+        'worker': multiprocessing.current_process().name,
+    }
+    workdir = tempfile.mkdtemp(prefix='replay-', dir=job['tmpdir'])
+    output = os.path.join(workdir, 'replay.txt')
+    cmd = [job['replay']] + job['replay_args'] + [logfile]
+
+    cpu_start = os.times()
+    t0 = time.time()
+    try:
+        with open(output, 'w') as out:
+            ret = subprocess.call(cmd, cwd=workdir, stdout=out, stderr=subprocess.STDOUT,
+                                  timeout=job['timeout'])
+        result['returncode'] = ret
+    except subprocess.TimeoutExpired:
+        result['error'] = 'timed out after %.0fs' % job['timeout']
+    cpu_end = os.times()
+    result['wall_time'] = time.time() - t0
+    result['cpu_time'] = ((cpu_end.children_user - cpu_start.children_user) +
+                          (cpu_end.children_system - cpu_start.children_system))
+
+    if 'error' not in result and result['returncode'] != 0:
+        result['error'] = 'Replay exited with %d' % result['returncode']
+
+    if 'error' not in result:
+        new_logs = glob.glob(os.path.join(workdir, 'logs', '*.BIN'))
+        if len(new_logs) != 1:
+            result['error'] = 'expected a single Replay output log, found %u' % len(new_logs)
+        else:
+            t0 = time.time()
+            try:
+                result.update(analyse_log(new_logs[0], job['mlist'],
+                                          accuracy=job['accuracy'],
+                                          ignores=job['ignores']))
+            except Exception as ex:
+                result['error'] = 'analysis failed: %s' % str(ex)
+            result['analysis_time'] = time.time() - t0
+
+    if 'error' in result:
+        result['passed'] = False
+        with open(output) as f:
+            # the tail of the output is usually enough to see why
+            result['output_tail'] = f.read()[-2000:]
+
+    if job['keep_dir'] is not None:
+        dest = os.path.join(job['keep_dir'], os.path.basename(logfile))
+        shutil.rmtree(dest, ignore_errors=True)
+        shutil.copytree(workdir, dest)
+        result['output_dir'] = dest
+    shutil.rmtree(workdir, ignore_errors=True)
+    return result
+
+
+def progress(msg):
+    # keep stdout clean for the report
+    print("BatchReplay: %s" % msg, file=sys.stderr)
+
+
+def run_batch(args):
+    logs = find_logs(args.logs)
+    if len(logs) == 0:
+        raise ValueError("No logs found")
+
+    replay = os.path.abspath(args.replay)
+    if not os.path.exists(replay):
+        raise ValueError("Replay binary %s not found, build it with ./waf replay" % replay)
+
+    replay_args = []
+    for p in args.parm:
+        replay_args.extend(['--parm', p])
+    if args.param_file is not None:
+        replay_args.extend(['--param-file', os.path.abspath(args.param_file)])
+    if args.force_ekf2:
+        replay_args.append('--force-ekf2')
+    if args.force_ekf3:
+        replay_args.append('--force-ekf3')
+
+    if args.ekf2_only:
+        mlist = ek2_list
+    elif args.ekf3_only:
+        mlist = ek3_list
+    else:
+        mlist = ek2_list + ek3_list
+
+    tmpdir = tempfile.mkdtemp(prefix='batch-replay-')
+    keep_dir = os.path.abspath(args.keep_output) if args.keep_output else None
+    if keep_dir is not None and not os.path.exists(keep_dir):
+        os.makedirs(keep_dir)
+
+    jobs = []
+    for log in logs:
+        jobs.append({
+            'log': log,
+            'replay': replay,
+            'replay_args': replay_args,
+            'mlist': mlist,
+            'accuracy': args.accuracy,
+            'ignores': set(args.ignore_field),
+            'timeout': args.timeout,
+            'tmpdir': tmpdir,
+            'keep_dir': keep_dir,
+        })
+
+    jobs_count = min(args.jobs, len(jobs))
+    progress("Replaying %u logs with %u workers" % (len(jobs), jobs_count))
+
+    results = []
+    t0 = time.time()
+    pool = multiprocessing.Pool(jobs_count)
+    try:
+        # longest logs first so a big log doesn't start last
+        jobs.sort(key=lambda j: os.path.getsize(j['log']), reverse=True)
+        for r in pool.imap_unordered(replay_one, jobs):
+            results.append(r)
+            if r['passed']:
+                status = 'OK'
+            elif 'error' in r:
+                status = 'FAILED: %s' % r['error']
+            else:
+                status = 'FAILED: %u mismatches' % r['mismatches']
+            progress("(%u/%u) %s %.1fs %s" % (len(results), len(jobs), r['log'], r['wall_time'], status))
+        pool.close()
+    except KeyboardInterrupt:
+        pool.terminate()
+        raise
+    finally:
+        pool.join()
+        shutil.rmtree(tmpdir, ignore_errors=True)
+    total_wall = time.time() - t0
+
+    results.sort(key=lambda r: r['log'])
+    sum_wall = sum([r['wall_time'] for r in results])
+    sum_cpu = sum([r['cpu_time'] for r in results])
+    failed = [r['log'] for r in results if not r['passed']]
+
+    report = {
+        'host': platform.node(),
+        'replay': replay,
+        'replay_args': replay_args,
+        'accuracy': args.accuracy,
+        'workers': jobs_count,
+        'logs': len(results),
+        'passed': len(results) - len(failed),
+        'failed': failed,
+        'wall_time': total_wall,
+        'replay_wall_time': sum_wall,
+        'replay_cpu_time': sum_cpu,
+        'speedup': sum_wall / total_wall if total_wall > 0 else 0.0,
+        'results': results,
+    }
+    return report
+
+
+if __name__ == '__main__':
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--replay", default='build/sitl/tool/Replay', help="Replay binary")
+    parser.add_argument("-j", "--jobs", type=int, default=multiprocessing.cpu_count(), help="number of parallel replays")
+    parser.add_argument("--report", default=None, help="write JSON report to this file (default stdout)")
+    parser.add_argument("--keep-output", default=None, help="keep the output of each replay under this directory")
+    parser.add_argument("--timeout", type=float, default=None, help="timeout in seconds for each replay")
+    parser.add_argument("-p", "--parm", action='append', default=[], help="parameter NAME=VALUE passed to Replay")
+    parser.add_argument("--param-file", default=None, help="parameter file passed to Replay")
+    parser.add_argument("--force-ekf2", action='store_true', help="pass --force-ekf2 to Replay")
+    parser.add_argument("--force-ekf3", action='store_true', help="pass --force-ekf3 to Replay")
+    parser.add_argument("--ekf2-only", action='store_true', help="only check EKF2")
+    parser.add_argument("--ekf3-only", action='store_true', help="only check EKF3")
+    parser.add_argument("--accuracy", type=float, default=0.0, help="accuracy percentage for match")
+    parser.add_argument("--ignore-field", action='append', default=[], help="ignore message field when comparing")
+    parser.add_argument("logs", metavar="LOG", nargs="+", help="log files or directories of logs")
+
+    args = parser.parse_args()
+
+    report = run_batch(args)
+
+    if args.report is not None:
+        with open(args.report, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+        progress("Report written to %s" % args.report)
+    else:
+        json.dump(report, sys.stdout, indent=2, sort_keys=True)
+        print("")
+
+    progress("%u/%u logs passed, %.1fs wall, %.1fx speedup over serial" % (
+        report['passed'], report['logs'], report['wall_time'], report['speedup']))
+    if len(report['failed']) != 0:
+        sys.exit(1)
+    sys.exit(0)
@@ -4,6 +4,11 @@
 Create a replay log using master branch.
 Check out a specified branch, compile and run Replay against replay log
 Run check_replay.py over the produced log
+
+For changes which are numerically but not bitwise equivalent, compare
+the EKF3 output of this branch against the logs produced by master
+within a tolerance, e.g. for the sparse covariance update:
+  Tools/Replay/check_replay_branch.py --master=<commit before change> --ekf3-only --accuracy=0.1
 '''
 
 import git
@@ -18,8 +23,11 @@ from pymavlink import DFReader
 import check_replay
 
 class CheckReplayBranch(object):
-    def __init__(self, master='remotes/origin/master'):
+    def __init__(self, master='remotes/origin/master', accuracy=0.0, ignores=set(), ekf3_only=False):
         self.master = master
+        self.ekf3_only = ekf3_only
+        self.accuracy = accuracy
+        self.ignores = ignores
 
     def find_topdir(self):
         here = os.getcwd()
@@ -164,7 +172,7 @@ class CheckReplayBranch(object):
             self.progress("Running check_replay.py on Replay output log: %s" % new_log)
 
             # run check_replay across Replay log
-            if check_replay.check_log(new_log, verbose=True):
+            if check_replay.check_log(new_log, verbose=True, ekf3_only=self.ekf3_only, accuracy=self.accuracy, ignores=self.ignores):
                 self.progress("check_replay.py of (%s): OK" % new_log)
             else:
                 self.progress("check_replay.py of (%s): FAILED" % new_log)
@@ -181,10 +189,13 @@ if __name__ == '__main__':
     from argparse import ArgumentParser
     parser = ArgumentParser(description=__doc__)
     parser.add_argument("--master", default='remotes/origin/master', help="branch to consider master branch")
+    parser.add_argument("--accuracy", type=float, default=0.0, help="accuracy percentage for match, for changes which are numerically but not bitwise equivalent")
+    parser.add_argument("--ignore-field", action='append', default=[], help="ignore message field when comparing")
+    parser.add_argument("--ekf3-only", action='store_true', help="only compare EKF3 output")
 
     args = parser.parse_args()
 
-    s = CheckReplayBranch(master=args.master)
+    s = CheckReplayBranch(master=args.master, accuracy=args.accuracy, ignores=set(args.ignore_field), ekf3_only=args.ekf3_only)
     if not s.run():
         sys.exit(1)
 
@@ -0,0 +1,74 @@
+#!/usr/bin/env python
+
+'''
+check that a replay started part way through a log with --start-time
+sees the same DAL state as a full replay of the same log
+'''
+
+from __future__ import print_function
+
+# DAL messages only logged when they change
+state_list = ['RFRN', 'RISH', 'RISI', 'RASH', 'RASI', 'RBRH', 'RBRI', 'RRNH',
+              'RRNI', 'RGPH', 'RGPI', 'RGPJ', 'RMGH', 'RMGI', 'RBCH', 'RBCI',
+              'RVOH', 'ROFH', 'REPH', 'RSLL', 'REVH', 'RWOH', 'RBOH']
+
+
+def frame_states(logfile, progress=print):
+    '''return the DAL state at the start of each frame, by frame time'''
+    from pymavlink import mavutil
+    progress("Processing log %s" % logfile)
+    mlog = mavutil.mavlink_connection(logfile)
+    state = {}
+    frames = {}
+    while True:
+        m = mlog.recv_match(type=state_list + ['RFRH'])
+        if m is None:
+            break
+        mtype = m.get_type()
+        if mtype == 'RFRH':
+            frames[m.TimeUS] = dict(state)
+            continue
+        key = (mtype, getattr(m, 'I', 0))
+        state[key] = m.get_msgbuf()
+    return frames
+
+
+def check_logs(full_log, seek_log, progress=print, verbose=False):
+    '''check the seek replay log against the full replay log'''
+    full = frame_states(full_log, progress)
+    seek = frame_states(seek_log, progress)
+    if len(seek) == 0:
+        progress("No frames in %s" % seek_log)
+        return False
+    errors = 0
+    count = 0
+    for t in sorted(seek.keys()):
+        if t not in full:
+            progress("Frame %u missing from full replay" % t)
+            errors += 1
+            continue
+        count += 1
+        for key in set(full[t].keys()) | set(seek[t].keys()):
+            if full[t].get(key) != seek[t].get(key):
+                errors += 1
+                if verbose or errors <= 10:
+                    progress("Mismatch in %s[%u] at %u" % (key[0], key[1], t))
+    progress("Processed %u/%u frames, %u errors" % (count, len(seek), errors))
+    return errors == 0
+
+
+if __name__ == '__main__':
+    import sys
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--verbose", action='store_true', help="verbose output")
+    parser.add_argument("full_log", metavar="FULL_LOG", help="replay output from the whole log")
+    parser.add_argument("seek_log", metavar="SEEK_LOG", help="replay output using --start-time")
+
+    args = parser.parse_args()
+
+    if not check_logs(args.full_log, args.seek_log, print, args.verbose):
+        print("FAILED")
+        sys.exit(1)
+    print("Passed")
+    sys.exit(0)
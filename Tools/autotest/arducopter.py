@@ -15,6 +15,7 @@ import numpy
 from pymavlink import quaternion
 from pymavlink import mavutil
 from pymavlink import mavextra
+from pymavlink import mavparm
 from pymavlink import rotmat
 
 from pysim import util
@@ -6569,6 +6570,110 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         if ex is not None:
             raise ex
 
+    def fft_step_tracking(self, options):
+        '''hover with a vibration peak, step its frequency and return the
+        time the FFT takes to track the step and the error afterwards'''
+        start_freq = 150
+        step_freq = 250
+        self.set_parameters({
+            "FFT_OPTIONS": options,
+            "SIM_VIB_FREQ_X": start_freq,
+            "SIM_VIB_FREQ_Y": start_freq,
+            "SIM_VIB_FREQ_Z": start_freq,
+        })
+        self.reboot_sitl()
+
+        self.takeoff(10, mode="ALT_HOLD")
+        self.hover_for_interval(10)
+        tstep = self.get_sim_time()
+        self.set_parameters({
+            "SIM_VIB_FREQ_X": step_freq,
+            "SIM_VIB_FREQ_Y": step_freq,
+            "SIM_VIB_FREQ_Z": step_freq,
+        })
+        tstart_unused, tend, hover_throttle_unused = self.hover_for_interval(15)
+        self.do_RTL()
+
+        mlog = self.dfreader_for_current_onboard_log()
+        latency = None
+        errors = []
+        while True:
+            m = mlog.recv_match(
+                type='FTN1',
+                blocking=False,
+                condition="FTN1.TimeUS>%u and FTN1.TimeUS<%u" % (tstep * 1.0e6, tend * 1.0e6))
+            if m is None:
+                break
+            t = m.TimeUS * 1.0e-6
+            if latency is None and abs(m.PkAvg - step_freq) < step_freq * 0.05:
+                latency = t - tstep
+            # steady state error over the last 5 seconds
+            if t > tend - 5:
+                errors.append(abs(m.PkAvg - step_freq))
+        if latency is None:
+            raise NotAchievedException("FFT_OPTIONS=%u did not track %uHz step" % (options, step_freq))
+        error = numpy.median(numpy.asarray(errors))
+        self.progress("FFT_OPTIONS=%u latency %.2fs error %.2fHz" % (options, latency, error))
+        return latency, error
+
+    def GyroFFTParallel(self):
+        """Check that parallel per-axis and per-IMU FFT analysis tracks a frequency step faster than the sequential analysis"""
+        self.context_push()
+        ex = None
+        try:
+            self.set_parameters({
+                "AHRS_EKF_TYPE": 10,
+                "EK2_ENABLE": 0,
+                "EK3_ENABLE": 0,
+                "INS_LOG_BAT_MASK": 3,
+                "INS_LOG_BAT_OPT": 4,
+                "INS_GYRO_FILTER": 100,
+                "INS_FAST_SAMPLE": 0,
+                "LOG_BITMASK": 958,
+                "LOG_DISARMED": 0,
+                "SIM_DRIFT_SPEED": 0,
+                "SIM_DRIFT_TIME": 0,
+                "SIM_GYR1_RND": 20,
+                "SIM_GYR2_RND": 20,
+                "FFT_ENABLE": 1,
+                "FFT_MINHZ": 50,
+                "FFT_MAXHZ": 450,
+                "FFT_SNR_REF": 10,
+                "FFT_WINDOW_SIZE": 128,
+                "FFT_WINDOW_OLAP": 0.75,
+                "FFT_SAMPLE_MODE": 0,
+            })
+
+            self.start_subtest("Sequential analysis")
+            seq_latency, seq_error = self.fft_step_tracking(0)
+
+            self.start_subtest("Parallel per-axis and per-IMU analysis")
+            par_latency, par_error = self.fft_step_tracking(4 | 8)
+
+            if par_latency >= seq_latency:
+                raise NotAchievedException("Parallel latency %.2fs no better than sequential %.2fs" %
+                                           (par_latency, seq_latency))
+            # within the frequency resolution of the FFT
+            resolution = 1000.0 / 128
+            for (name, error) in ("sequential", seq_error), ("parallel", par_error):
+                if error > resolution:
+                    raise NotAchievedException("%s error %.2fHz above %.2fHz" % (name, error, resolution))
+
+            self.set_parameter("FFT_ENABLE", 0)
+            self.reboot_sitl()
+
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+
+        self.context_pop()
+
+        # must reboot after we move away from EKF type 10 to EKF2 or EKF3
+        self.reboot_sitl()
+
+        if ex is not None:
+            raise ex
+
     def GyroFFTPostFilter(self):
         """Use FFT-driven dynamic harmonic notch to control post-RPM filter motor noise."""
         # basic gyro sample rate test
@@ -8877,6 +8982,9 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             self.start_subtest("%s" % name)
             self.test_replay_bit(func)
 
+        self.start_subtest("Seek")
+        self.test_replay_seek()
+
     def test_replay_bit(self, bit):
 
         self.context_push()
@@ -8905,6 +9013,45 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         if not ok:
             raise NotAchievedException("check_replay (%s) failed" % current_log_filepath)
 
+    def test_replay_seek(self):
+        '''check replay from part way through a log sees the same DAL
+        state as a full replay'''
+        self.context_push()
+        current_log_filepath = self.test_replay_gps_bit()
+
+        replay_logs = []
+        for args in [], ['--start-time', '%f' % self.replay_seek_time(current_log_filepath)]:
+            util.run_cmd(
+                ['build/sitl/tool/Replay'] + args + [current_log_filepath],
+                directory=util.topdir(),
+                checkfail=True,
+                show=True,
+                output=True,
+            )
+            replay_logs.append(self.current_onboard_log_filepath())
+
+        self.context_pop()
+
+        check_replay_seek = util.load_local_module("Tools/Replay/check_replay_seek.py")
+        if not check_replay_seek.check_logs(replay_logs[0], replay_logs[1], self.progress):
+            raise NotAchievedException("check_replay_seek (%s) failed" % current_log_filepath)
+
+    def replay_seek_time(self, logfile):
+        '''a log time in seconds half way through logfile'''
+        dfreader = self.dfreader_for_path(logfile)
+        first = None
+        last = None
+        while True:
+            m = dfreader.recv_match(type='RFRH')
+            if m is None:
+                break
+            if first is None:
+                first = m.TimeUS
+            last = m.TimeUS
+        if first is None:
+            raise NotAchievedException("No RFRH in %s" % logfile)
+        return (first + last) * 0.5e-6
+
     def DefaultIntervalsFromFiles(self):
         '''Test setting default mavlink message intervals from files'''
         ex = None
@@ -9862,11 +10009,257 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
 
         lines = content.split("\n")
 
-        if not lines[0].startswith("TasksV2"):
-            raise NotAchievedException("Expected TasksV2 as first line first not (%s)" % lines[0])
+        # SITL has the per-task histograms
+        if not lines[0].startswith("TasksV5"):
+            raise NotAchievedException("Expected TasksV5 as first line first not (%s)" % lines[0])
         # last line is empty, so -2 here
         if not lines[-2].startswith("AP_Vehicle::update_arming"):
             raise NotAchievedException("Expected EFI last not (%s)" % lines[-2])
+        for field in "LATE=", "MISS=", "P99=":
+            if field not in lines[1]:
+                raise NotAchievedException("Expected %s in (%s)" % (field, lines[1]))
+
+    def ParameterSaveBatching(self):
+        '''Test parameter saves are combined and written in batches'''
+        def save_stats():
+            content = self.fetch_file_via_ftp("@SYS/param_save.txt")
+            self.progress("Got content (%s)" % str(content))
+            lines = content.split("\n")
+            if not lines[0].startswith("ParamSaveV1"):
+                raise NotAchievedException("Expected ParamSaveV1 as first line not (%s)" % lines[0])
+            ret = {}
+            for line in lines[1:]:
+                for field in line.split():
+                    (name, value) = field.split("=")
+                    ret[name] = int(value)
+            return ret
+
+        # a frame parameter file as a user would load it; most of
+        # its values differ from the SITL defaults, so they are
+        # appended to storage the first time they are saved
+        filepath = os.path.join(testdir, "..", "Frame_params", "Holybro-S500.param")
+        parameters = mavparm.MAVParmDict()
+        if not parameters.load(filepath):
+            raise ValueError("Param load failed")
+        names = list(parameters.keys())
+        old_values = self.get_parameters(names)
+        before = save_stats()
+
+        # upload the file twice without waiting for the replies, like
+        # a GCS re-sending sets that weren't acknowledged in time
+        for i in range(2):
+            for name in names:
+                self.send_set_parameter_direct(name, parameters[name])
+        tstart = self.get_sim_time()
+        while True:
+            after = save_stats()
+            if after["queued"] == 0 and after["saves"] - before["saves"] >= 2 * len(names):
+                break
+            if self.get_sim_time_cached() - tstart > 30:
+                raise NotAchievedException("Saves not written (%s)" % str(after))
+            self.delay_sim_time(1)
+
+        delta = {}
+        for name in "saves", "combined", "batches", "writes", "bytes":
+            delta[name] = after[name] - before[name]
+        written = delta["saves"] - delta["combined"]
+        self.progress("%u saves, %u combined, %u batches, %u writes of %u bytes" %
+                      (delta["saves"], delta["combined"], delta["batches"], delta["writes"], delta["bytes"]))
+        if delta["combined"] == 0:
+            raise NotAchievedException("No saves were combined")
+        if delta["batches"] >= written:
+            raise NotAchievedException("Saves were not batched")
+        # a batch updates each stored parameter with at most one
+        # write, and appends new ones with three
+        if delta["writes"] == 0 or delta["writes"] > written + 2 * delta["batches"]:
+            raise NotAchievedException("Expected 1 to %u writes, got %u" %
+                                       (written + 2 * delta["batches"], delta["writes"]))
+        # at least the value of each parameter changed
+        changed = len([name for name in names
+                       if abs(old_values[name] - parameters[name]) > 0.0001 * max(1, abs(parameters[name]))])
+        if changed == 0 or delta["bytes"] < changed:
+            raise NotAchievedException("%u bytes written for %u changed parameters" % (delta["bytes"], changed))
+
+        self.reboot_sitl()
+        self.assert_parameter_values({name: parameters[name] for name in names}, epsilon=0.0001)
+        self.set_parameters(old_values)
+        self.reboot_sitl()
+
+    def param_download_time(self, mav):
+        '''return the sim time taken to get every parameter over mav,
+        re-requesting by index any lost from the PARAM_REQUEST_LIST
+        stream'''
+        target_system = self.sysid_thismav()
+        mav.mav.param_request_list_send(target_system, 1)
+        tstart = self.get_sim_time()
+        last_received = tstart
+        seen = set()
+        count = None
+        while count is None or len(seen) < count:
+            now = self.get_sim_time_cached()
+            if now - tstart > 300:
+                raise NotAchievedException("Parameter download timed out (have %u/%s)" % (len(seen), str(count)))
+            m = mav.recv_match(type='PARAM_VALUE', blocking=True, timeout=1)
+            if m is None or m.param_index == 65535:
+                if count is not None and now - last_received > 5:
+                    missing = [i for i in range(count) if i not in seen]
+                    self.progress("Requesting %u missing parameters" % len(missing))
+                    for i in missing:
+                        mav.mav.param_request_read_send(target_system, 1, b"", i)
+                    last_received = now
+                continue
+            count = m.param_count
+            seen.add(m.param_index)
+            last_received = now
+        return (self.get_sim_time_cached() - tstart, count)
+
+    def ParamDownloadTime(self):
+        '''Time a full parameter download over UDP and a 57600 baud link'''
+        self.context_push()
+        ex = None
+        mav2 = None
+        try:
+            self.start_subtest("UDP")
+            port = self.adjust_ardupilot_port(14600)
+            self.customise_SITL_commandline([
+                "--serial2=udpclient:127.0.0.1:%u" % port,
+            ])
+            self.set_parameter("SERIAL2_PROTOCOL", 2)
+            self.reboot_sitl()
+            mav2 = mavutil.mavlink_connection(
+                "udpin:127.0.0.1:%u" % port,
+                robust_parsing=True,
+                source_system=7,
+                source_component=7,
+            )
+            (udp_time, count) = self.param_download_time(mav2)
+            self.progress("UDP: %u parameters in %.1fs" % (count, udp_time))
+            mav2.close()
+            mav2 = None
+
+            self.start_subtest("57600 baud")
+            self.customise_SITL_commandline([])
+            self.set_parameters({
+                "SERIAL2_PROTOCOL": 2,
+                "SERIAL2_BAUD": 57,
+            })
+            self.reboot_sitl()
+            self.set_parameter("SIM_BAUDLIMIT_EN", 1)
+            mav2 = mavutil.mavlink_connection(
+                "tcp:localhost:%u" % self.adjust_ardupilot_port(5763),
+                robust_parsing=True,
+                source_system=7,
+                source_component=7,
+            )
+            (serial_time, count) = self.param_download_time(mav2)
+            self.progress("57600: %u parameters in %.1fs" % (count, serial_time))
+
+            # each PARAM_VALUE is 37 bytes on the wire. Allow for the
+            # link being shared with the streams
+            if serial_time > 3 * count * 37 / 5760.0:
+                raise NotAchievedException("Download at 57600 took %.1fs for %u parameters" % (serial_time, count))
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+
+        if mav2 is not None:
+            mav2.close()
+
+        self.context_pop()
+        self.reboot_sitl()
+
+        if ex is not None:
+            raise ex
+
+    def StreamRatesOnSlowLink(self):
+        '''Test message priorities on a link too slow for its stream rates'''
+        def stream_info(chan):
+            content = self.fetch_file_via_ftp("@SYS/streams.txt")
+            self.progress("Got content (%s)" % str(content))
+            lines = content.split("\n")
+            if not lines[0].startswith("StreamsV1"):
+                raise NotAchievedException("Expected StreamsV1 as first line not (%s)" % lines[0])
+            link = None
+            messages = {}
+            for line in lines[1:]:
+                fields = line.split()
+                if len(fields) == 0 or fields[0] != "MAV%u" % chan:
+                    continue
+                values = {}
+                for field in fields[1:]:
+                    (name, value) = field.split("=")
+                    values[name] = float(value)
+                if "id" in values:
+                    messages[int(values["id"])] = values
+                else:
+                    link = values
+            return (link, messages)
+
+        self.context_push()
+        ex = None
+        mav2 = None
+        try:
+            # a 19200 baud radio on SERIAL2 with the flight-critical
+            # streams at low rates and the sensor streams at 50Hz
+            self.set_parameters({
+                "SERIAL2_PROTOCOL": 2,
+                "SERIAL2_BAUD": 19,
+                "SR2_EXT_STAT": 2,
+                "SR2_POSITION": 2,
+                "SR2_EXTRA1": 4,
+                "SR2_EXTRA2": 4,
+                "SR2_EXTRA3": 2,
+                "SR2_RAW_SENS": 50,
+                "SR2_RC_CHAN": 50,
+                "SR2_RAW_CTRL": 50,
+            })
+            self.reboot_sitl()
+            self.set_parameter("SIM_BAUDLIMIT_EN", 1)
+
+            mav2 = mavutil.mavlink_connection(
+                "tcp:localhost:%u" % self.adjust_ardupilot_port(5763),
+                robust_parsing=True,
+                source_system=7,
+                source_component=7,
+            )
+
+            # critical messages keep their rate, and the messages a
+            # GCS needs to fly the vehicle get theirs before the
+            # sensor streams get any more of the link
+            self.assert_message_rate_hz("HEARTBEAT", 1, mav=mav2)
+            for (name, want) in ("SYS_STATUS", 2), ("ATTITUDE", 4), ("GLOBAL_POSITION_INT", 2):
+                rate = self.measure_message_rate(name, timeout=20, mav=mav2)
+                if rate < 0.9 * want:
+                    raise NotAchievedException("%s rate %f less than %f" % (name, rate, want))
+
+            (link, messages) = stream_info(2)
+            if link is None:
+                raise NotAchievedException("No stream info for link")
+            if link["saturated"] == 0:
+                raise NotAchievedException("Link was not saturated")
+            if link["bytes/s"] > 1920 * 1.1:
+                raise NotAchievedException("Sent %u bytes/s on a 19200 baud link" % link["bytes/s"])
+            for (msgid, values) in messages.items():
+                if values["got"] > values["req"] * 1.1 + 0.5:
+                    raise NotAchievedException("id=%u got more than requested" % msgid)
+            raw_imu = messages[mavutil.mavlink.MAVLINK_MSG_ID_RAW_IMU]
+            if raw_imu["got"] >= raw_imu["req"]:
+                raise NotAchievedException("Expected RAW_IMU to be slowed down")
+            # ... but not starved by the higher priority messages
+            if raw_imu["got"] == 0:
+                raise NotAchievedException("RAW_IMU starved")
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+
+        if mav2 is not None:
+            mav2.close()
+
+        self.context_pop()
+        self.reboot_sitl()
+
+        if ex is not None:
+            raise ex
 
     def RTL_TO_RALLY(self, target_system=1, target_component=1):
         '''Check RTL to rally point'''
@@ -10689,6 +11082,7 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             Test(self.GyroFFTHarmonic, attempts=4, speedup=8),
             Test(self.GyroFFTAverage, attempts=1, speedup=8),
             Test(self.GyroFFTContinuousAveraging, attempts=4, speedup=8),
+            Test(self.GyroFFTParallel, attempts=2, speedup=8),
             self.GyroFFTPostFilter,
             self.GyroFFTMotorNoiseCheck,
             self.CompassReordering,
@@ -10707,6 +11101,9 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             Test(self.DataFlashErase, attempts=8),
             self.Callisto,
             self.PerfInfo,
+            self.ParameterSaveBatching,
+            self.StreamRatesOnSlowLink,
+            self.ParamDownloadTime,
             self.Replay,
             self.FETtecESC,
             self.ProximitySensors,
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+'''
+read IMU sample stream files (logs/NNNNNNNN.ISB) written by the batch
+sampler with bit 3 of INS_LOG_BAT_OPT set, and convert them for
+offline FFT analysis
+
+The file holds a header, a description of each stream (one per gyro
+and accel) and then fixed size blocks of int16 samples. See
+libraries/AP_InertialSensor/BatchSampler_Stream.cpp for the format.
+
+Examples:
+  Tools/scripts/isb_stream.py logs/00000012.ISB
+  Tools/scripts/isb_stream.py --csv out/ logs/00000012.ISB
+  Tools/scripts/isb_stream.py --npz imu.npz logs/00000012.ISB
+  Tools/scripts/isb_stream.py --fft --fft-length 1024 logs/00000012.ISB
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import os
+import struct
+import sys
+
+STREAM_MAGIC = 0x53425349
+STREAM_VERSION = 1
+BLOCK_MAGIC = 0x4b42
+
+HEADER_FMT = '<IHBBHHQ'
+INFO_FMT = '<BBHf'
+BLOCK_HEADER_FMT = '<HBBHHIQQ'
+
+SENSOR_NAMES = {0: 'Accel', 1: 'Gyro'}
+
+
+class Stream(object):
+    '''samples from one gyro or accel'''
+    def __init__(self, index, sensor_type, instance, multiplier, sample_rate_hz):
+        self.index = index
+        self.sensor_type = sensor_type
+        self.instance = instance
+        self.multiplier = multiplier
+        self.sample_rate_hz = sample_rate_hz
+        self.time_us = []
+        self.x = []
+        self.y = []
+        self.z = []
+        self.blocks = 0
+        self.lost_blocks = 0
+        self.dropped = 0
+        self.next_seqnum = 0
+
+    def name(self):
+        return "%s%u" % (SENSOR_NAMES.get(self.sensor_type, 'Sensor'), self.instance)
+
+    def add_block(self, seqnum, dropped, first_us, last_us, samples):
+        if seqnum != self.next_seqnum:
+            self.lost_blocks += seqnum - self.next_seqnum
+        self.next_seqnum = seqnum + 1
+        self.blocks += 1
+        self.dropped += dropped
+        count = len(samples) // 3
+        # samples are evenly spaced between the first and last time
+        # in a block
+        step = (last_us - first_us) / float(count - 1) if count > 1 else 0.0
+        scale = 1.0 / self.multiplier if self.multiplier else 1.0
+        for i in range(count):
+            self.time_us.append(first_us + i * step)
+            self.x.append(samples[3*i] * scale)
+            self.y.append(samples[3*i+1] * scale)
+            self.z.append(samples[3*i+2] * scale)
+
+    def measured_rate_hz(self):
+        if len(self.time_us) < 2 or self.time_us[-1] <= self.time_us[0]:
+            return 0.0
+        return (len(self.time_us) - 1) * 1.0e6 / (self.time_us[-1] - self.time_us[0])
+
+
+def read_stream_file(filename):
+    '''return the header fields and list of streams in a file'''
+    with open(filename, 'rb') as f:
+        data = f.read()
+
+    ofs = 0
+    hdr_size = struct.calcsize(HEADER_FMT)
+    if len(data) < hdr_size:
+        raise ValueError("%s: file too short" % filename)
+    (magic, version, num_streams, post_filter, block_samples, _, start_us) = struct.unpack_from(HEADER_FMT, data, ofs)
+    if magic != STREAM_MAGIC:
+        raise ValueError("%s: not an IMU stream file" % filename)
+    if version != STREAM_VERSION:
+        raise ValueError("%s: unsupported version %u" % (filename, version))
+    ofs += hdr_size
+
+    streams = []
+    info_size = struct.calcsize(INFO_FMT)
+    for i in range(num_streams):
+        (sensor_type, instance, multiplier, sample_rate_hz) = struct.unpack_from(INFO_FMT, data, ofs)
+        streams.append(Stream(i, sensor_type, instance, multiplier, sample_rate_hz))
+        ofs += info_size
+
+    block_header_size = struct.calcsize(BLOCK_HEADER_FMT)
+    block_size = block_header_size + block_samples * 3 * 2
+    sample_fmt = '<%uh' % (block_samples * 3)
+    while ofs + block_size <= len(data):
+        (magic, index, _, count, dropped, seqnum, first_us, last_us) = struct.unpack_from(BLOCK_HEADER_FMT, data, ofs)
+        if magic != BLOCK_MAGIC or index >= num_streams or count > block_samples:
+            print("%s: bad block at offset %u, stopping" % (filename, ofs), file=sys.stderr)
+            break
+        samples = struct.unpack_from(sample_fmt, data, ofs + block_header_size)
+        streams[index].add_block(seqnum, dropped, first_us, last_us, samples[:count*3])
+        ofs += block_size
+
+    header = {
+        'start_us': start_us,
+        'post_filter': post_filter != 0,
+        'block_samples': block_samples,
+    }
+    return header, streams
+
+
+def write_csv(streams, directory):
+    if not os.path.exists(directory):
+        os.makedirs(directory)
+    for s in streams:
+        path = os.path.join(directory, "%s.csv" % s.name())
+        with open(path, 'w') as f:
+            f.write("TimeUS,X,Y,Z\n")
+            for i in range(len(s.time_us)):
+                f.write("%.0f,%.6f,%.6f,%.6f\n" % (s.time_us[i], s.x[i], s.y[i], s.z[i]))
+        print("Wrote %s" % path)
+
+
+def write_npz(streams, filename):
+    import numpy
+    arrays = {}
+    for s in streams:
+        arrays[s.name() + '_TimeUS'] = numpy.array(s.time_us)
+        arrays[s.name()] = numpy.array([s.x, s.y, s.z]).T
+        arrays[s.name() + '_rate'] = numpy.array(s.measured_rate_hz())
+    numpy.savez_compressed(filename, **arrays)
+    print("Wrote %s" % filename)
+
+
+def print_fft_peaks(streams, fft_length, num_peaks):
+    '''average Hann windowed FFTs over each stream and print the largest peaks'''
+    import numpy
+    for s in streams:
+        rate = s.measured_rate_hz()
+        if len(s.x) < fft_length or rate <= 0:
+            continue
+        window = numpy.hanning(fft_length)
+        freqs = numpy.fft.rfftfreq(fft_length, 1.0 / rate)
+        for axis, values in (('X', s.x), ('Y', s.y), ('Z', s.z)):
+            values = numpy.array(values)
+            frames = len(values) // fft_length
+            psd = numpy.zeros(len(freqs))
+            for i in range(frames):
+                frame = values[i*fft_length:(i+1)*fft_length]
+                psd += numpy.abs(numpy.fft.rfft((frame - frame.mean()) * window))
+            psd /= frames
+            # ignore DC and the lowest bin
+            peaks = numpy.argsort(psd[2:])[::-1][:num_peaks] + 2
+            print("%s %s: %s" % (s.name(), axis,
+                                 ", ".join(["%.1fHz" % freqs[p] for p in sorted(peaks)])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--csv", default=None, help="write one CSV file per stream into this directory")
+    parser.add_argument("--npz", default=None, help="write the samples to a numpy .npz file")
+    parser.add_argument("--fft", action='store_true', help="print the main FFT peaks of each axis")
+    parser.add_argument("--fft-length", type=int, default=1024, help="FFT length")
+    parser.add_argument("--peaks", type=int, default=3, help="number of FFT peaks to print")
+    parser.add_argument("file", metavar="ISB", help="stream file")
+    args = parser.parse_args()
+
+    header, streams = read_stream_file(args.file)
+
+    print("%s: %u streams, %s-filter, started at %.3fs" % (
+        args.file, len(streams), "post" if header['post_filter'] else "pre", header['start_us'] * 1.0e-6))
+    for s in streams:
+        print("  %-7s %8u samples %6u blocks %4u lost blocks %6u dropped samples rate %.1fHz (nominal %.1fHz)" % (
+            s.name(), len(s.x), s.blocks, s.lost_blocks, s.dropped, s.measured_rate_hz(), s.sample_rate_hz))
+
+    if args.csv is not None:
+        write_csv(streams, args.csv)
+    if args.npz is not None:
+        write_npz(streams, args.npz)
+    if args.fft:
+        print_fft_peaks(streams, args.fft_length, args.peaks)
+
+
+if __name__ == '__main__':
+    main()
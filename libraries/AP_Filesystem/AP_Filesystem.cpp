@@ -149,6 +149,12 @@ int32_t AP_Filesystem::write(int fd, const void *buf, uint32_t count)
     return backend.fs.write(fd, buf, count);
 }
 
+int32_t AP_Filesystem::writev(int fd, const AP_Filesystem_Backend::IoVec *iov, uint8_t iovcnt)
+{
+    const Backend &backend = backend_by_fd(fd);
+    return backend.fs.writev(fd, iov, iovcnt);
+}
+
 int AP_Filesystem::fsync(int fd)
 {
     const Backend &backend = backend_by_fd(fd);
@@ -79,6 +79,7 @@ public:
     int close(int fd);
     int32_t read(int fd, void *buf, uint32_t count);
     int32_t write(int fd, const void *buf, uint32_t count);
+    int32_t writev(int fd, const AP_Filesystem_Backend::IoVec *iov, uint8_t iovcnt);
     int fsync(int fd);
     int32_t lseek(int fd, int32_t offset, int whence);
     int stat(const char *pathname, struct stat *stbuf);
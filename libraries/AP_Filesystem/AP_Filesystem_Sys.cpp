@@ -26,6 +26,8 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <AP_Param/AP_Param.h>
+#include <GCS_MAVLink/GCS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -36,10 +38,17 @@ struct SysFileList {
 static const SysFileList sysfs_file_list[] = {
     {"threads.txt"},
     {"tasks.txt"},
+#if AP_SCHEDULER_ENABLED && AP_SCHEDULER_TRACE_ENABLED
+    {"sched_trace.bin"},
+#endif
     {"dma.txt"},
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
+    {"param_save.txt"},
+#if HAL_GCS_ENABLED
+    {"streams.txt"},
+#endif
 #if HAL_MAX_CAN_PROTOCOL_DRIVERS
     {"can_log.txt"},
 #endif
@@ -105,6 +114,11 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "tasks.txt") == 0) {
         AP::scheduler().task_info(*r.str);
     }
+#if AP_SCHEDULER_TRACE_ENABLED
+    if (strcmp(fname, "sched_trace.bin") == 0) {
+        AP::scheduler().trace_info(*r.str);
+    }
+#endif
 #endif
     if (strcmp(fname, "dma.txt") == 0) {
         hal.util->dma_info(*r.str);
@@ -120,6 +134,14 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "timers.txt") == 0) {
         hal.util->timer_info(*r.str);
     }
+    if (strcmp(fname, "param_save.txt") == 0) {
+        AP_Param::save_info(*r.str);
+    }
+#if HAL_GCS_ENABLED
+    if (strcmp(fname, "streams.txt") == 0) {
+        gcs().stream_info(*r.str);
+    }
+#endif
 #if HAL_CANMANAGER_ENABLED
     if (strcmp(fname, "can_log.txt") == 0) {
         AP::can().log_retrieve(*r.str);
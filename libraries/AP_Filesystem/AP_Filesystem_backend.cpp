@@ -18,6 +18,25 @@
 
 extern const AP_HAL::HAL& hal;
 
+/*
+  write several buffers, stopping at the first short write
+*/
+int32_t AP_Filesystem_Backend::writev(int fd, const IoVec *iov, uint8_t iovcnt)
+{
+    int32_t total = 0;
+    for (uint8_t i=0; i<iovcnt; i++) {
+        const int32_t ret = write(fd, iov[i].data, iov[i].len);
+        if (ret < 0) {
+            return total > 0 ? total : ret;
+        }
+        total += ret;
+        if (uint32_t(ret) != iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 /*
   load a full file. Use delete to free the data
 */
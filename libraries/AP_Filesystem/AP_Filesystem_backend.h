@@ -49,6 +49,14 @@ public:
     virtual int close(int fd) { return -1; }
     virtual int32_t read(int fd, void *buf, uint32_t count) { return -1; }
     virtual int32_t write(int fd, const void *buf, uint32_t count) { return -1; }
+
+    // write several buffers in one call, like posix writev(). The
+    // default implementation makes one write() call per buffer
+    struct IoVec {
+        const void *data;
+        uint32_t len;
+    };
+    virtual int32_t writev(int fd, const IoVec *iov, uint8_t iovcnt);
     virtual int fsync(int fd) { return 0; }
     virtual int32_t lseek(int fd, int32_t offset, int whence) { return -1; }
     virtual int stat(const char *pathname, struct stat *stbuf) { return -1; }
@@ -52,6 +52,7 @@ extern const AP_HAL::HAL& hal;
 #define FFT_SNR_PFILT_DEFAULT       10.0f   // post-filter there is much less noise so default should be lower
 #define FFT_STACK_SIZE              1024
 #define FFT_MIN_SAMPLES_PER_FRAME   16
+#define FFT_SDFT_SAMPLES_PER_FRAME  4
 #define FFT_HARMONIC_FIT_DEFAULT    10
 #define FFT_HARMONIC_FIT_FILTER_HZ  15.0f
 #define FFT_HARMONIC_FIT_MULT       50.0f
@@ -169,8 +170,8 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: FFT options
-    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference
-    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise
+    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference,4:Analyse each axis in its own thread (SITL only),8:Analyse every IMU independently, providing separate notch frequencies for each IMU (SITL only),16:Track frequencies with a sliding DFT updated every few samples rather than a windowed FFT of each frame, reducing latency and CPU load
+    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise,2:Parallel axis analysis,3:Per-IMU analysis,4:Sliding DFT analysis
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("OPTIONS", 15, AP_GyroFFT, _options, 0),
@@ -190,7 +191,9 @@ const extern AP_HAL::HAL& hal;
 
 AP_GyroFFT::AP_GyroFFT()
 {
-    _thread_state._noise_needs_calibration = 0x07; // all axes need calibration
+    for (uint8_t imu = 0; imu < FFT_MAX_IMUS; imu++) {
+        _thread_state[imu]._noise_needs_calibration = 0x07; // all axes need calibration
+    }
     AP_Param::setup_object_defaults(this, var_info);
 
     if (_singleton != nullptr) {
@@ -228,13 +231,32 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
     // this is particularly a problem on IMUs with higher sample rates (e.g. BMI088)
     // 16 gives a maximum output rate of 2Khz / 16 = 125Hz per axis or 375Hz in aggregate
     _samples_per_frame = MAX(FFT_MIN_SAMPLES_PER_FRAME, 1 << lrintf(log2f(_samples_per_frame)));
+    // a sliding DFT costs a few operations per sample for each analysed bin rather than a
+    // whole FFT per frame, so it can afford to produce an estimate every few samples
+    _sliding_dft = (_options & uint32_t(Options::SlidingDFT)) != 0;
+    if (_sliding_dft) {
+        _samples_per_frame = FFT_SDFT_SAMPLES_PER_FRAME;
+    }
     if (_num_frames > 0) {
         _num_frames.set(constrain_int16(_num_frames, 2, AP_HAL::DSP::MAX_SLIDING_WINDOW_SIZE));
     }
 
+    // decide how many IMUs to analyse and whether to analyse them in parallel
+    _num_imus = 1;
+#if HAL_GYROFFT_PARALLEL_ENABLED
+    if (_options & uint32_t(Options::MultiIMU)) {
+        _num_imus = MIN(_ins->get_gyro_count(), FFT_MAX_IMUS);
+    }
+    _parallel_pipelines = (_options & uint32_t(Options::ParallelAxes)) != 0;
+#endif
+    _num_pipelines = _num_imus * XYZ_AXIS_COUNT;
+    const uint8_t num_dsp_states = _parallel_pipelines ? _num_pipelines : 1;
+
     // check that we have enough memory for the window size requested
-    // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size, FFT: XYZ_AXIS_COUNT + 3 * _window_size
-    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + 3 + XYZ_AXIS_COUNT + 3 + _num_frames) * sizeof(float);
+    // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size per state, FFT: XYZ_AXIS_COUNT + 3 * _window_size per IMU,
+    // sliding DFT: 3 * _window_size per pipeline
+    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + (3 + _num_frames) * num_dsp_states + (XYZ_AXIS_COUNT + 3) * _num_imus
+        + (_sliding_dft ? 3 * _num_pipelines : 0)) * sizeof(float);
     if (allocation_count * FFT_DEFAULT_WINDOW_SIZE > hal.util->available_memory() / 2) {
         gcs().send_text(MAV_SEVERITY_WARNING, "AP_GyroFFT: disabled, required %u bytes", (unsigned int)allocation_count * FFT_DEFAULT_WINDOW_SIZE);
         return;
@@ -250,19 +272,23 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         _fft_sampling_rate_hz = _ins->get_raw_gyro_rate_hz();
     } else {
         _fft_sampling_rate_hz = loop_rate_hz / _sample_mode;
-        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            if (!_downsampled_gyro_data[axis].set_size(_window_size + _samples_per_frame)) {
-                gcs().send_text(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
-                return;
+        for (uint8_t imu = 0; imu < _num_imus; imu++) {
+            for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                if (!_downsampled_gyro_data[imu][axis].set_size(_window_size + _samples_per_frame)) {
+                    gcs().send_text(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
+                    return;
+                }
             }
         }
     }
     _current_sample_mode = _sample_mode;
 
-    _ref_energy = new Vector3f[_window_size];
-    if (_ref_energy == nullptr) {
-        gcs().send_text(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
-        return;
+    for (uint8_t imu = 0; imu < _num_imus; imu++) {
+        _ref_energy[imu] = new Vector3f[_window_size];
+        if (_ref_energy[imu] == nullptr) {
+            gcs().send_text(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
+            return;
+        }
     }
 
     // make the gyro window match the window size plus a buffer to cope with the backend
@@ -309,40 +335,63 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         }
     }
 
-    // initialise the HAL DSP subsystem
-    _state = hal.dsp->fft_init(_window_size, _fft_sampling_rate_hz, _num_frames);
-    if (_state == nullptr) {
-        gcs().send_text(MAV_SEVERITY_WARNING, "Failed to initialize DSP engine");
-        return;
+    // initialise the HAL DSP subsystem, pipelines run in turn share a single DSP state
+    for (uint8_t i = 0; i < _num_pipelines; i++) {
+        Pipeline& pipeline = _pipelines[i];
+        if (i < num_dsp_states) {
+            pipeline._state = hal.dsp->fft_init(_window_size, _fft_sampling_rate_hz, _num_frames);
+            if (pipeline._state == nullptr) {
+                gcs().send_text(MAV_SEVERITY_WARNING, "Failed to initialize DSP engine");
+                return;
+            }
+        } else {
+            pipeline._state = _pipelines[0]._state;
+        }
+        if (_sliding_dft) {
+            pipeline._sdft = new SlidingDFT();
+            if (pipeline._sdft == nullptr || !pipeline._sdft->init(_window_size)) {
+                gcs().send_text(MAV_SEVERITY_WARNING, "Failed to initialize DSP engine");
+                return;
+            }
+        }
+        pipeline._imu = i / XYZ_AXIS_COUNT;
+        pipeline._axis = i % XYZ_AXIS_COUNT;
+        // the number of cycles required to have a proper noise reference
+        pipeline._noise_cycles = _window_size / _samples_per_frame;
     }
+    _state = _pipelines[0]._state;
 
     // per-axis frame time
     _frame_time_ms = _samples_per_frame * 1000 / _fft_sampling_rate_hz;
     // The update rate for the output, defaults are 1Khz / (1 - 0.5) * 32 == 62hz
     const float output_rate = static_cast<float>(_fft_sampling_rate_hz) / static_cast<float>(_samples_per_frame);
     // establish suitable defaults for the detected values
-    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        _thread_state._center_freq_hz[axis] = _fft_min_hz;
+    for (uint8_t imu = 0; imu < _num_imus; imu++) {
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            _thread_state[imu]._center_freq_hz[axis] = _fft_min_hz;
 
-        for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
-            _thread_state._center_freq_hz_filtered[axis][peak] = _fft_min_hz;
+            for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
+                _thread_state[imu]._center_freq_hz_filtered[axis][peak] = _fft_min_hz;
+            }
+            // number of cycles to average over, two complete windows to be sure
+            _noise_calibration_cycles[imu][axis] = (_window_size / _samples_per_frame) * 2;
+            // harmonic frequency fit should change relatively slowly
+            _harmonic_fit_filter[imu][axis].set_cutoff_frequency(output_rate, MIN(output_rate * 0.48f, FFT_HARMONIC_FIT_FILTER_HZ));
         }
-        // number of cycles to average over, two complete windows to be sure
-        _noise_calibration_cycles[axis] = (_window_size / _samples_per_frame) * 2;
-        // harmonic frequency fit should change relatively slowly
-        _harmonic_fit_filter[axis].set_cutoff_frequency(output_rate, MIN(output_rate * 0.48f, FFT_HARMONIC_FIT_FILTER_HZ));
     }
 
     // configure a filter for frequency, bandwidth and energy for each of the three tracked noise peaks
     // filter more aggressively post-filter since the noise is harder to detect
     const float scale_factor = using_post_filter_samples() ? 0.1f : 1.0f;
-    for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
-        // calculate low-pass filter characteristics based on window size and overlap
-        _center_freq_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.48f * scale_factor);
-        // the bin energy jumps around a lot so requires more filtering
-        _center_freq_energy_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
-        // smooth the bandwidth output more aggressively
-        _center_bandwidth_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+    for (uint8_t imu = 0; imu < _num_imus; imu++) {
+        for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
+            // calculate low-pass filter characteristics based on window size and overlap
+            _center_freq_filter[imu][peak].set_cutoff_frequency(output_rate, output_rate * 0.48f * scale_factor);
+            // the bin energy jumps around a lot so requires more filtering
+            _center_freq_energy_filter[imu][peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+            // smooth the bandwidth output more aggressively
+            _center_bandwidth_filter[imu][peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+        }
     }
 
     // turn down the SNR threshold if examining post-filter
@@ -350,9 +399,6 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         _snr_threshold_db.set_default(FFT_SNR_PFILT_DEFAULT);
     }
 
-    // the number of cycles required to have a proper noise reference
-    _noise_cycles = (_window_size / _samples_per_frame) * XYZ_AXIS_COUNT;
-
     // finally we are done
     _initialized = true;
     update_parameters(true);
@@ -373,18 +419,22 @@ void AP_GyroFFT::sample_gyros()
     // update counters for gyro window
     if (_current_sample_mode > 0) {
         // for loop rate sampling accumulate and average gyro samples
-        _oversampled_gyro_accum += _ins->get_gyro_for_fft();
+        for (uint8_t imu = 0; imu < _num_imus; imu++) {
+            _oversampled_gyro_accum[imu] += _ins->get_gyro_for_fft(gyro_instance(imu));
+        }
         _oversampled_gyro_count++;
 
         if ((_oversampled_gyro_count % _current_sample_mode) == 0) {
-            // calculate mean value of accumulated samples
-            Vector3f sample = _oversampled_gyro_accum / _current_sample_mode;
-            // fast sampling means that the raw gyro values have already been averaged over 8 samples
-            _downsampled_gyro_data[0].push(sample.x);
-            _downsampled_gyro_data[1].push(sample.y);
-            _downsampled_gyro_data[2].push(sample.z);
-
-            _oversampled_gyro_accum.zero();
+            for (uint8_t imu = 0; imu < _num_imus; imu++) {
+                // calculate mean value of accumulated samples
+                Vector3f sample = _oversampled_gyro_accum[imu] / _current_sample_mode;
+                // fast sampling means that the raw gyro values have already been averaged over 8 samples
+                _downsampled_gyro_data[imu][0].push(sample.x);
+                _downsampled_gyro_data[imu][1].push(sample.y);
+                _downsampled_gyro_data[imu][2].push(sample.z);
+
+                _oversampled_gyro_accum[imu].zero();
+            }
             _oversampled_gyro_count = 0;
         }
     }
@@ -401,7 +451,6 @@ void AP_GyroFFT::update()
     WITH_SEMAPHORE(_sem);
 
     _config._analysis_enabled = _analysis_enabled;
-    _global_state = _thread_state;
 
     // calculate health based on being 5 frames behind, SITL needs longer
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -410,23 +459,30 @@ void AP_GyroFFT::update()
     const uint32_t output_delay = _frame_time_ms * FFT_MAX_MISSED_UPDATES;
 #endif
     uint32_t now = AP_HAL::millis();
-    _rpy_health.x = (now - _global_state._health_ms.x <= output_delay);
-    _rpy_health.y = (now - _global_state._health_ms.y <= output_delay);
-    _rpy_health.z = (now - _global_state._health_ms.z <= output_delay);
 
-    _health = _global_state._health;
-    if (!_rpy_health.x) {
-        _health.x = 0;
-    }
-    if (!_rpy_health.y) {
-        _health.y = 0;
-    }
-    if (!_rpy_health.z) {
-        _health.z = 0;
+    for (uint8_t imu = 0; imu < _num_imus; imu++) {
+        const EngineState& global_state = _global_state[imu] = _thread_state[imu];
+        Vector3<uint8_t>& rpy_health = _rpy_health[imu];
+        Vector3<uint8_t>& health = _health[imu];
+
+        rpy_health.x = (now - global_state._health_ms.x <= output_delay);
+        rpy_health.y = (now - global_state._health_ms.y <= output_delay);
+        rpy_health.z = (now - global_state._health_ms.z <= output_delay);
+
+        health = global_state._health;
+        if (!rpy_health.x) {
+            health.x = 0;
+        }
+        if (!rpy_health.y) {
+            health.y = 0;
+        }
+        if (!rpy_health.z) {
+            health.z = 0;
+        }
     }
 }
 
-// analyse gyro data using FFT, returns number of samples still held
+// analyse gyro data using FFT on each pipeline in turn, returns number of samples still held
 // called from FFT thread
 uint16_t AP_GyroFFT::run_cycle()
 {
@@ -434,15 +490,33 @@ uint16_t AP_GyroFFT::run_cycle()
         return 0;
     }
 
+    if (!run_cycle(_pipelines[_update_pipeline])) {
+        return get_available_samples(_pipelines[_update_pipeline]);
+    }
+
+    // move onto the next axis
+    _update_pipeline = (_update_pipeline + 1) % _num_pipelines;
+
+    // samples remaining in the next axis
+    return get_available_samples(_pipelines[_update_pipeline]);
+}
+
+// analyse gyro data using FFT on a single pipeline, returns true if a frame was processed
+// called from FFT thread
+bool AP_GyroFFT::run_cycle(Pipeline& pipeline)
+{
+    if (!analysis_enabled()) {
+        return false;
+    }
+
     if (!_sem.take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
-        return 0;
+        return false;
     }
 
     // do we have enough samples for another pass?
-    if (!start_analysis()) {
-        uint16_t new_sample_count =  get_available_samples(_update_axis);
+    if (!start_analysis(pipeline)) {
         _sem.give();
-        return new_sample_count;
+        return false;
     }
 
     // take a copy of the config inside the semaphore
@@ -453,25 +527,34 @@ uint16_t AP_GyroFFT::run_cycle()
     uint32_t now = AP_HAL::micros();
 
     // get the appropriate gyro buffer
-    FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(_update_axis) : _downsampled_gyro_data[_update_axis]);
-    // if we have many more samples than the window size then we are struggling to 
-    // stay ahead of the gyro loop so drop samples so that this cycle will use all available samples
-    if (gyro_buffer.available() > uint32_t(_state->_window_size + uint16_t(_samples_per_frame >> 1))) { // half the frame size is a heuristic
-        gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
-    }
-    // let's go!
-    hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
+    FloatBuffer& gyro_buffer = get_gyro_window(pipeline);
+    AP_HAL::DSP::FFTWindowState* state = pipeline._state;
+    uint16_t bin_max;
+    if (_sliding_dft) {
+        // slide the DFT over all of the new samples, there is no need to drop samples
+        // when behind as each one is cheap to process
+        hal.dsp->sdft_update(*pipeline._sdft, gyro_buffer, config._fft_start_bin, config._fft_end_bin);
+        bin_max = hal.dsp->sdft_analyse(state, *pipeline._sdft, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+    } else {
+        // if we have many more samples than the window size then we are struggling to 
+        // stay ahead of the gyro loop so drop samples so that this cycle will use all available samples
+        if (gyro_buffer.available() > uint32_t(state->_window_size + uint16_t(_samples_per_frame >> 1))) { // half the frame size is a heuristic
+            gyro_buffer.advance(gyro_buffer.available() - state->_window_size);
+        }
+        // let's go!
+        hal.dsp->fft_start(state, gyro_buffer, _samples_per_frame);
 
-    // calculate FFT and update filters outside the semaphore
-    uint16_t bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+        // calculate FFT and update filters outside the semaphore
+        bin_max = hal.dsp->fft_analyse(state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+    }
 
     // something has been detected, update the peak frequency and associated metrics
-    update_ref_energy(bin_max);
-    calculate_noise(false, config);
+    update_ref_energy(pipeline, bin_max);
+    calculate_noise(pipeline, false, config);
 
     // record how we are doing
-    _thread_state._last_output_us[_update_axis] = AP_HAL::micros();
-    _output_cycle_micros = _thread_state._last_output_us[_update_axis] - now;
+    _thread_state[pipeline._imu]._last_output_us[pipeline._axis] = AP_HAL::micros();
+    _output_cycle_micros = _thread_state[pipeline._imu]._last_output_us[pipeline._axis] - now;
 
 #if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
     // extra logging when running simulations
@@ -482,48 +565,66 @@ uint16_t AP_GyroFFT::run_cycle()
         "F----------",
         "QBfffffffff",
         AP_HAL::micros64(),
-        _update_axis,
-        _state->_peak_data[0]._freq_hz,
-        _state->_peak_data[1]._freq_hz,
-        _state->_peak_data[2]._freq_hz,
-        _state->_peak_data[0]._noise_width_hz,
-        _state->_peak_data[1]._noise_width_hz,
-        _state->_peak_data[2]._noise_width_hz,
-        _state->_freq_bins[_state->_peak_data[0]._bin],
-        _state->_freq_bins[_state->_peak_data[1]._bin],
-        _state->_freq_bins[_state->_peak_data[2]._bin]);
+        uint8_t(pipeline._imu * XYZ_AXIS_COUNT + pipeline._axis),
+        state->_peak_data[0]._freq_hz,
+        state->_peak_data[1]._freq_hz,
+        state->_peak_data[2]._freq_hz,
+        state->_peak_data[0]._noise_width_hz,
+        state->_peak_data[1]._noise_width_hz,
+        state->_peak_data[2]._noise_width_hz,
+        state->_freq_bins[state->_peak_data[0]._bin],
+        state->_freq_bins[state->_peak_data[1]._bin],
+        state->_freq_bins[state->_peak_data[2]._bin]);
 #endif
 
-    // move onto the next axis
-    _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
-
     // ready to receive another frame, because lock contention is so expensive we don't lock
     // around this flag but rather rely on the semaphore at the beginning of the loop to
     // ensure eventual visibility to the main loop
-    _thread_state._analysis_started = false;
+    pipeline._analysis_started = false;
 
-    // samples remaining in the next axis
-    return get_available_samples(_update_axis);
+    return true;
 }
 
 // whether analysis can be run again or not
 // called from FFT thread with the semaphore held
-bool AP_GyroFFT::start_analysis() {
-    if (_thread_state._analysis_started) {
+bool AP_GyroFFT::start_analysis(Pipeline& pipeline) {
+    if (pipeline._analysis_started) {
         return false;
     }
     // don't run any more gyro cycles once noise is calibrated and the self-test is running
-    if (!_thread_state._noise_needs_calibration && !_calibrated) {
+    if (!noise_needs_calibration(_thread_state) && !_calibrated) {
         return false;
     }
 
-    if (get_available_samples(_update_axis) >= _state->_window_size) {
-        _thread_state._analysis_started = true;
+    if (get_available_samples(pipeline) >= get_frame_samples()) {
+        pipeline._analysis_started = true;
         return true;
     }
     return false;
 }
 
+// whether any pipeline is mid-cycle
+bool AP_GyroFFT::analysis_in_progress() const
+{
+    for (uint8_t i = 0; i < _num_pipelines; i++) {
+        if (_pipelines[i]._analysis_started) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// whether any IMU still requires noise calibration
+bool AP_GyroFFT::noise_needs_calibration(const EngineState* state) const
+{
+    for (uint8_t imu = 0; imu < _num_imus; imu++) {
+        if (state[imu]._noise_needs_calibration) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // update calculated values of dynamic parameters - runs at 1Hz
 void AP_GyroFFT::update_parameters(bool force)
 {
@@ -551,21 +652,42 @@ void AP_GyroFFT::update_parameters(bool force)
 void AP_GyroFFT::update_thread(void)
 {
     while (true) {
-        uint16_t remaining_samples = run_cycle();
-        // this is to stop us burning CPU while waiting for samples, the reduction by _samples_per_frame is a heuristic to prevent waiting too long
-        // and missing frames (easy to see in SITL because the noise will keep calibrating)
-        // we always delay by at least 1us to give logging a chance to run at the same priority
-        uint32_t delay = constrain_int32((int16_t)_state->_window_size - (int16_t)remaining_samples, 0, _samples_per_frame)
-            * 1e6 / _fft_sampling_rate_hz;
+        wait_for_samples(run_cycle());
+    }
+}
+
+// thread for processing a single pipeline of gyro data via FFT
+void AP_GyroFFT::update_pipeline_thread(void)
+{
+    Pipeline* pipeline;
+    {
+        // claim the next pipeline, threads are created with the semaphore held
+        WITH_SEMAPHORE(_sem);
+        pipeline = &_pipelines[_pipeline_threads++];
+    }
+
+    while (true) {
+        run_cycle(*pipeline);
+        wait_for_samples(analysis_enabled() ? get_available_samples(*pipeline) : 0);
+    }
+}
+
+// delay an FFT thread while waiting for samples
+void AP_GyroFFT::wait_for_samples(uint16_t remaining_samples) const
+{
+    // this is to stop us burning CPU while waiting for samples, the reduction by _samples_per_frame is a heuristic to prevent waiting too long
+    // and missing frames (easy to see in SITL because the noise will keep calibrating)
+    // we always delay by at least 1us to give logging a chance to run at the same priority
+    uint32_t delay = constrain_int32((int16_t)get_frame_samples() - (int16_t)remaining_samples, 0, _samples_per_frame)
+        * 1e6 / _fft_sampling_rate_hz;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        // in SITL the gyros do not run in a different thread
-        if (delay > 0) {
-            hal.scheduler->delay_microseconds(delay);
-        }
+    // in SITL the gyros do not run in a different thread
+    if (delay > 0) {
+        hal.scheduler->delay_microseconds(delay);
+    }
 #else
-        hal.scheduler->delay_microseconds(MAX(delay, 1U));
+    hal.scheduler->delay_microseconds(MAX(delay, 1U));
 #endif
-    }
 }
 
 // start the update thread
@@ -577,7 +699,15 @@ bool AP_GyroFFT::start_update_thread(void)
         return true;
     }
 
-    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_GyroFFT::update_thread, void), "apm_fft", FFT_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+    if (_parallel_pipelines) {
+        // one thread per pipeline, each claiming its pipeline when it starts
+        for (uint8_t i = 0; i < _num_pipelines; i++) {
+            if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_GyroFFT::update_pipeline_thread, void), "apm_fft", FFT_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+                AP_HAL::panic("Failed to start AP_GyroFFT update thread");
+                return false;
+            }
+        }
+    } else if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_GyroFFT::update_thread, void), "apm_fft", FFT_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
         AP_HAL::panic("Failed to start AP_GyroFFT update thread");
         return false;
     }
@@ -600,13 +730,13 @@ bool AP_GyroFFT::pre_arm_check(char *failure_msg, const uint8_t failure_msg_len)
     }
 
     // analysis is started in the main thread, don't trample on in-flight analysis
-    if (_global_state._analysis_started) {
+    if (analysis_in_progress()) {
         hal.util->snprintf(failure_msg, failure_msg_len, "FFT still analyzing");
         return false;
     }
 
     // still calibrating noise so not ready
-    if (_global_state._noise_needs_calibration) {
+    if (noise_needs_calibration(_global_state)) {
         hal.util->snprintf(failure_msg, failure_msg_len, "FFT calibrating noise");
         return false;
     }
@@ -779,19 +909,21 @@ void AP_GyroFFT::stop_notch_tune()
 
 // return the noise peak that is being tracked
 // called from main thread
-AP_GyroFFT::FrequencyPeak AP_GyroFFT::get_tracked_noise_peak() const
+AP_GyroFFT::FrequencyPeak AP_GyroFFT::get_tracked_noise_peak(uint8_t imu) const
 {
+    const EngineState& global_state = _global_state[imu];
+
     // if the user has specified a specific axis to track then use that
     if (_harmonic_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
         switch (_harmonic_peak) {
         case FFT_HARMONIC_FIT_TRACK_ROLL:
-            if (_global_state._harmonic_fit.x < _harmonic_fit) {
-                return FrequencyPeak(_global_state._tracked_peak.x);
+            if (global_state._harmonic_fit.x < _harmonic_fit) {
+                return FrequencyPeak(global_state._tracked_peak.x);
             }
             break;
         case FFT_HARMONIC_FIT_TRACK_PITCH:
-            if (_global_state._harmonic_fit.y < _harmonic_fit) {
-                return FrequencyPeak(_global_state._tracked_peak.y);
+            if (global_state._harmonic_fit.y < _harmonic_fit) {
+                return FrequencyPeak(global_state._tracked_peak.y);
             }
             break;
         default:
@@ -806,8 +938,8 @@ AP_GyroFFT::FrequencyPeak AP_GyroFFT::get_tracked_noise_peak() const
 
     // required fit of 10% is fairly conservative when testing in SITL, testing shows that it's safer to
     // require both tracked axes to fit - biasing towards the highest energy peak
-    if (_global_state._harmonic_fit.x < _harmonic_fit && _global_state._harmonic_fit.y < _harmonic_fit) {
-        return FrequencyPeak(_global_state._tracked_peak.x);
+    if (global_state._harmonic_fit.x < _harmonic_fit && global_state._harmonic_fit.y < _harmonic_fit) {
+        return FrequencyPeak(global_state._tracked_peak.x);
     }
 
     return FrequencyPeak::CENTER;
@@ -816,8 +948,14 @@ AP_GyroFFT::FrequencyPeak AP_GyroFFT::get_tracked_noise_peak() const
 // weighted center frequency
 float AP_GyroFFT::get_weighted_freq_hz(FrequencyPeak peak) const
 {
-    const Vector3f& energy = get_center_freq_energy(peak);
-    const Vector3f& freq = get_noise_center_freq_hz(peak);
+    return get_weighted_freq_hz(primary_imu(), peak);
+}
+
+// weighted center frequency of an IMU
+float AP_GyroFFT::get_weighted_freq_hz(uint8_t imu, FrequencyPeak peak) const
+{
+    const Vector3f& energy = _global_state[imu]._center_freq_energy_filtered[peak];
+    const Vector3f& freq = _global_state[imu]._center_freq_hz_filtered[peak];
 
     if (!energy.is_nan() && !is_zero(energy.x) && !is_zero(energy.y)) {
         return (freq.x * energy.x + freq.y * energy.y) / (energy.x + energy.y);
@@ -828,13 +966,14 @@ float AP_GyroFFT::get_weighted_freq_hz(FrequencyPeak peak) const
 
 // return an average center frequency weighted by bin energy
 // called from main thread
-float AP_GyroFFT::get_weighted_noise_center_freq_hz() const
+float AP_GyroFFT::get_weighted_noise_center_freq_hz(uint8_t imu) const
 {
-    if (!analysis_enabled()) {
+    if (!analysis_enabled() || imu >= _num_imus) {
         return _fft_min_hz;
     }
 
-    if (_health.is_zero()) {
+    const Vector3<uint8_t>& health = _health[imu];
+    if (health.is_zero()) {
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         // if we are post-filter sampling then throttle estimate will be useless
         if (using_post_filter_samples()) {
@@ -848,29 +987,30 @@ float AP_GyroFFT::get_weighted_noise_center_freq_hz() const
 #endif
     }
 
-    const FrequencyPeak peak = get_tracked_noise_peak();
+    const FrequencyPeak peak = get_tracked_noise_peak(imu);
     // pitch was good or required, roll was not, use pitch only
-    if (!_health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
-        return get_noise_center_freq_hz(peak).y;    // Y-axis
+    if (!health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
+        return _global_state[imu]._center_freq_hz_filtered[peak].y;    // Y-axis
     }
     // roll was good or required, pitch was not, use roll only
-    if (!_health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
-        return get_noise_center_freq_hz(peak).x;    // X-axis
+    if (!health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
+        return _global_state[imu]._center_freq_hz_filtered[peak].x;    // X-axis
     }
 
-    return get_weighted_freq_hz(peak);
+    return get_weighted_freq_hz(imu, peak);
 }
 
 // return all the center frequencies weighted by bin energy
 // called from main thread
-uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t num_freqs, float* freqs) const
+uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t imu, uint8_t num_freqs, float* freqs) const
 {
-    if (!analysis_enabled()) {
+    if (!analysis_enabled() || imu >= _num_imus) {
         freqs[0] = _fft_min_hz;
         return 1;
     }
 
-    if (_health.is_zero()) {
+    const Vector3<uint8_t>& health = _health[imu];
+    if (health.is_zero()) {
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         // if we are post-filter sampling then throttle estimate will be useless
         if (using_post_filter_samples()) {
@@ -886,25 +1026,25 @@ uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t num_freqs,
     }
 
     // pitch was good or required, roll was not, use pitch only
-    if (!_health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
-        const uint8_t tracked_peaks = MIN(_health.y, num_freqs);
+    if (!health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
+        const uint8_t tracked_peaks = MIN(health.y, num_freqs);
         for (uint8_t i = 0; i < tracked_peaks; i++) {
-            freqs[i] = get_noise_center_freq_hz(FrequencyPeak(i)).y;    // Y-axis
+            freqs[i] = _global_state[imu]._center_freq_hz_filtered[i].y;    // Y-axis
         }
         return tracked_peaks;
     }
     // roll was good or required, pitch was not, use roll only
-    if (!_health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
-        const uint8_t tracked_peaks = MIN(_health.x, num_freqs);
+    if (!health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
+        const uint8_t tracked_peaks = MIN(health.x, num_freqs);
         for (uint8_t i = 0; i < tracked_peaks; i++) {
-            freqs[i] = get_noise_center_freq_hz(FrequencyPeak(i)).x;    // X-axis
+            freqs[i] = _global_state[imu]._center_freq_hz_filtered[i].x;    // X-axis
         }
         return tracked_peaks;
     }
 
-    const uint8_t tracked_peaks = MIN(MAX(_health.x, _health.y), num_freqs);
+    const uint8_t tracked_peaks = MIN(MAX(health.x, health.y), num_freqs);
     for (uint8_t i = 0; i < tracked_peaks; i++) {
-        freqs[i] = get_weighted_freq_hz(FrequencyPeak(i));
+        freqs[i] = get_weighted_freq_hz(imu, FrequencyPeak(i));
     }
     return tracked_peaks;
 }
@@ -924,7 +1064,7 @@ float AP_GyroFFT::has_noise_at_frequency_hz(float freq) const
         const Vector3f& snr = get_noise_signal_to_noise_db(FrequencyPeak(i));
 
         for (uint8_t j = 0; j < XYZ_AXIS_COUNT; j++) {
-            if (!_rpy_health[j]) {
+            if (!_rpy_health[primary_imu()][j]) {
                 continue;
             }
 
@@ -990,7 +1130,7 @@ void AP_GyroFFT::write_log_messages()
         get_raw_noise_harmonic_fit().x,
         get_raw_noise_harmonic_fit().y,
         get_raw_noise_harmonic_fit().z,
-        _health.x, _health.y, _health.z, _output_cycle_micros);
+        _health[primary_imu()].x, _health[primary_imu()].y, _health[primary_imu()].z, _output_cycle_micros);
 
     log_noise_peak(0, FrequencyPeak::CENTER);
     if (_tracked_peaks> 1) {
@@ -1005,9 +1145,9 @@ void AP_GyroFFT::write_log_messages()
         // doing this from the update thread overflows the stack
         WITH_SEMAPHORE(_sem);
         gcs().send_text(MAV_SEVERITY_WARNING, "FFT: f:%.1f, fr:%.1f, b:%u, fd:%.1f",
-                        _debug_state._center_freq_hz_filtered[FrequencyPeak::CENTER][_update_axis], _debug_state._center_freq_hz[_update_axis], _debug_max_bin, _debug_max_bin_freq);
+                        _debug_state._center_freq_hz_filtered[FrequencyPeak::CENTER][0], _debug_state._center_freq_hz[0], _debug_max_bin, _debug_max_bin_freq);
         gcs().send_text(MAV_SEVERITY_WARNING, "FFT: bw:%.1f, e:%.1f, r:%.1f, snr:%.1f",
-                        _debug_state._center_bandwidth_hz_filtered[FrequencyPeak::CENTER][_update_axis], _debug_max_freq_bin, _ref_energy[_debug_max_bin][_update_axis], _debug_snr);
+                        _debug_state._center_bandwidth_hz_filtered[FrequencyPeak::CENTER][0], _debug_max_freq_bin, _ref_energy[0][_debug_max_bin][0], _debug_snr);
         _last_output_ms = now;
     }
 #endif
@@ -1060,157 +1200,160 @@ float AP_GyroFFT::get_weighted_noise_center_bandwidth_hz() const
         return 0.0f;
     }
 
-    const FrequencyPeak peak = get_tracked_noise_peak();
+    const FrequencyPeak peak = get_tracked_noise_peak(primary_imu());
 
     return calculate_weighted_freq_hz(get_center_freq_energy(peak), get_noise_center_bandwidth_hz(peak));
 }
 
 // calculate noise frequencies from FFT data provided by the HAL subsystem
 // called from FFT thread
-void AP_GyroFFT::calculate_noise(bool calibrating, const EngineConfig& config)
+void AP_GyroFFT::calculate_noise(const Pipeline& pipeline, bool calibrating, const EngineConfig& config)
 {
+    EngineState& thread_state = _thread_state[pipeline._imu];
+    const uint8_t axis = pipeline._axis;
+
     // calculate the SNR and center frequency energy
     float weighted_center_freq_hz = 0.0f;
 
-    uint8_t num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, calibrating, config);
+    uint8_t num_peaks = calculate_tracking_peaks(pipeline, weighted_center_freq_hz, calibrating, config);
 
-    _thread_state._center_freq_bin[_update_axis] = _state->_peak_data[_thread_state._center_peak[_update_axis]]._bin;
-    _thread_state._center_freq_hz[_update_axis] = weighted_center_freq_hz;
+    thread_state._center_freq_bin[axis] = pipeline._state->_peak_data[thread_state._center_peak[axis]]._bin;
+    thread_state._center_freq_hz[axis] = weighted_center_freq_hz;
     // record the last time we had a good signal on this axis
     if (num_peaks > 0) {
-        _thread_state._health_ms[_update_axis] = AP_HAL::millis();
+        thread_state._health_ms[axis] = AP_HAL::millis();
     } else {
-        _thread_state._health_ms[_update_axis] = 0;
+        thread_state._health_ms[axis] = 0;
     }
-    _thread_state._health[_update_axis] = num_peaks;
+    thread_state._health[axis] = num_peaks;
     FrequencyPeak tracked_peak = FrequencyPeak::CENTER;
 
     // record the tracked peak for harmonic fit, but only if we have more than one noise peak
     // this checks filtered energies and so can allow energies to be closer together
-    if (num_peaks > 1 && _tracked_peaks > 1 && !is_zero(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis))) {
-        if (get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis) > get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis)
+    if (num_peaks > 1 && _tracked_peaks > 1 && !is_zero(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline))) {
+        if (get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline) > get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, pipeline)
             // ignore the fit if there is too big a discrepancy between the energies
-            && get_tl_center_freq_energy(FrequencyPeak::CENTER, _update_axis) < get_tl_center_freq_energy(FrequencyPeak::LOWER_SHOULDER, _update_axis) * FFT_HARMONIC_FIT_MULT) {
+            && get_tl_center_freq_energy(FrequencyPeak::CENTER, pipeline) < get_tl_center_freq_energy(FrequencyPeak::LOWER_SHOULDER, pipeline) * FFT_HARMONIC_FIT_MULT) {
             tracked_peak = FrequencyPeak::LOWER_SHOULDER;
-        } else if (num_peaks > 2 && get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis) > get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis)
+        } else if (num_peaks > 2 && get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline) > get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, pipeline)
             // ignore the fit if there is too big a discrepancy between the energies
-            && get_tl_center_freq_energy(FrequencyPeak::CENTER, _update_axis) < get_tl_center_freq_energy(FrequencyPeak::UPPER_SHOULDER, _update_axis) * FFT_HARMONIC_FIT_MULT) {
+            && get_tl_center_freq_energy(FrequencyPeak::CENTER, pipeline) < get_tl_center_freq_energy(FrequencyPeak::UPPER_SHOULDER, pipeline) * FFT_HARMONIC_FIT_MULT) {
             tracked_peak = FrequencyPeak::UPPER_SHOULDER;
         }
     }
 
-    _thread_state._tracked_peak[_update_axis] = tracked_peak;
+    thread_state._tracked_peak[axis] = tracked_peak;
 
     // if targetting more than one harmonic then make sure we get the fundamental
     // on larger copters the second harmonic often has more energy
     // if the highest peak is above the second highest then check for harmonic fit
     // comparisons are made using filter, normalised data
-    if (_thread_state._tracked_peak[_update_axis] != FrequencyPeak::CENTER) {
+    if (thread_state._tracked_peak[axis] != FrequencyPeak::CENTER) {
         // calculate the fit and filter at 10hz
-        const float harmonic_fit = 100.0f * fabsf(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis)
-            - get_tl_noise_center_freq_hz(tracked_peak, _update_axis) * _harmonic_multiplier)
-            / get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis);
+        const float harmonic_fit = 100.0f * fabsf(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline)
+            - get_tl_noise_center_freq_hz(tracked_peak, pipeline) * _harmonic_multiplier)
+            / get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline);
 
         // calculate the fit and filter at 10hz
         if (isfinite(harmonic_fit)) {
-            _thread_state._harmonic_fit[_update_axis] = _harmonic_fit_filter[_update_axis].apply(harmonic_fit);
+            thread_state._harmonic_fit[axis] = _harmonic_fit_filter[pipeline._imu][axis].apply(harmonic_fit);
         }
     } else {
-        _thread_state._harmonic_fit[_update_axis] = 100.0f;
+        thread_state._harmonic_fit[axis] = 100.0f;
     }
 #if DEBUG_FFT
     WITH_SEMAPHORE(_sem);
     _debug_state = _thread_state;
-    _debug_max_freq_bin = _state->get_freq_bin(_state->_peak_data[FrequencyPeak::CENTER]._bin);
-    _debug_max_bin_freq = _state->_peak_data[FrequencyPeak::CENTER]._freq_hz;
+    _debug_max_freq_bin = pipeline._state->get_freq_bin(pipeline._state->_peak_data[FrequencyPeak::CENTER]._bin);
+    _debug_max_bin_freq = pipeline._state->_peak_data[FrequencyPeak::CENTER]._freq_hz;
     _debug_snr = snr;
-    _debug_max_bin = _state->_peak_data[FrequencyPeak::CENTER]._bin;
+    _debug_max_bin = pipeline._state->_peak_data[FrequencyPeak::CENTER]._bin;
 #endif
 }
 
 
 // calculate noise peaks based on the frequencies closest to the recent historical average, switching peaks around as necessary
-uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, bool calibrating, const EngineConfig& config)
+uint8_t AP_GyroFFT::calculate_tracking_peaks(const Pipeline& pipeline, float& weighted_center_freq_hz, bool calibrating, const EngineConfig& config)
 {
     uint8_t num_peaks = 0;
-    FrequencyData freqs(*this, config);
+    FrequencyData freqs(*this, pipeline, config);
 
     // the noise peaks are returned by the HAL in decreasing order of magnitude, however each peak can temporarily
     // switch places with another depending on a whole host of hardware and software factors
     // thus we must be able to temporarily reassign the peaks so that the filtered values track
     // a continuous frequency
     DistanceMatrix distance_matrix;
-    find_distance_matrix(distance_matrix, freqs, config);
+    find_distance_matrix(pipeline, distance_matrix, freqs, config);
 
     FrequencyPeak center = find_closest_peak(FrequencyPeak::CENTER, distance_matrix);
     FrequencyPeak lower = find_closest_peak(FrequencyPeak::LOWER_SHOULDER, distance_matrix, 1 << center);
     FrequencyPeak upper = find_closest_peak(FrequencyPeak::UPPER_SHOULDER, distance_matrix, 1 << center | 1 << lower);
 
     // if we have had the maximum number of swapped cycles, force a full calculation
-    if (calibrating || _distorted_cycles[_update_axis] == 0) {
-        num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, freqs, config);
+    if (calibrating || _distorted_cycles[pipeline._imu][pipeline._axis] == 0) {
+        num_peaks = calculate_tracking_peaks(pipeline, weighted_center_freq_hz, freqs, config);
 #if DEBUG_FFT
         printf("Skipped update, order would have been is %d/%.1f(%.1f) %d/%.1f(%.1f) %d/%.1f(%.1f) n = %d\n",
-            center, _state->_peak_data[center]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis),
-            lower, _state->_peak_data[lower]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis),
-            upper, _state->_peak_data[upper]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis), num_peaks);
+            center, pipeline._state->_peak_data[center]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, pipeline),
+            lower, pipeline._state->_peak_data[lower]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, pipeline),
+            upper, pipeline._state->_peak_data[upper]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, pipeline), num_peaks);
 #endif
         return num_peaks;
     }
 
     // another peak is closer to what is currently considered the center frequency
     if (center != FrequencyPeak::CENTER || lower != FrequencyPeak::LOWER_SHOULDER || upper != FrequencyPeak::UPPER_SHOULDER) {
-        if (lower != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::LOWER_SHOULDER, lower, freqs, config)) {
+        if (lower != FrequencyPeak::NONE && calculate_filtered_noise(pipeline, FrequencyPeak::LOWER_SHOULDER, lower, freqs, config)) {
             num_peaks++;
         } else {
             lower = FrequencyPeak::NONE;
         }
-        if (upper != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::UPPER_SHOULDER, upper, freqs, config)) {
+        if (upper != FrequencyPeak::NONE && calculate_filtered_noise(pipeline, FrequencyPeak::UPPER_SHOULDER, upper, freqs, config)) {
             num_peaks++;
         } else {
             upper = FrequencyPeak::NONE;
         }
-        if (center != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::CENTER,  center, freqs, config)) {
+        if (center != FrequencyPeak::NONE && calculate_filtered_noise(pipeline, FrequencyPeak::CENTER,  center, freqs, config)) {
             num_peaks++;
         } else {
             center = FrequencyPeak::NONE;
         }
         weighted_center_freq_hz = freqs.get_weighted_frequency(center);
-        _thread_state._center_peak[_update_axis] = center;
-        update_snr_values(freqs);
+        _thread_state[pipeline._imu]._center_peak[pipeline._axis] = center;
+        update_snr_values(pipeline, freqs);
         // if two adjacent peaks have simply swapped, we will allow this to continue indefinitely
         // as there is no loss of fidelity
         if (!((center == FrequencyPeak::LOWER_SHOULDER && lower == FrequencyPeak::CENTER)
             || (center == FrequencyPeak::UPPER_SHOULDER && upper == FrequencyPeak::CENTER))) {
-            _distorted_cycles[_update_axis]--;
+            _distorted_cycles[pipeline._imu][pipeline._axis]--;
         }
         return num_peaks;
     }
 
-    num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, freqs, config);
+    num_peaks = calculate_tracking_peaks(pipeline, weighted_center_freq_hz, freqs, config);
 
     return num_peaks;
 }
 
 // calculate the noise and whether valid for each peak
-uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config)
+uint8_t AP_GyroFFT::calculate_tracking_peaks(const Pipeline& pipeline, float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config)
 {
     uint8_t num_peaks = 0;
-    if (calculate_filtered_noise(FrequencyPeak::LOWER_SHOULDER, FrequencyPeak::LOWER_SHOULDER, freqs, config)) {
+    if (calculate_filtered_noise(pipeline, FrequencyPeak::LOWER_SHOULDER, FrequencyPeak::LOWER_SHOULDER, freqs, config)) {
         num_peaks++;
     }
-    if (calculate_filtered_noise(FrequencyPeak::UPPER_SHOULDER, FrequencyPeak::UPPER_SHOULDER, freqs, config)) {
+    if (calculate_filtered_noise(pipeline, FrequencyPeak::UPPER_SHOULDER, FrequencyPeak::UPPER_SHOULDER, freqs, config)) {
         num_peaks++;
     }
-    if (calculate_filtered_noise(FrequencyPeak::CENTER, FrequencyPeak::CENTER, freqs, config)) {
+    if (calculate_filtered_noise(pipeline, FrequencyPeak::CENTER, FrequencyPeak::CENTER, freqs, config)) {
         num_peaks++;
     }
     // record the number of cycles where something was tracked
-    _distorted_cycles[_update_axis] = constrain_int16(_distorted_cycles[_update_axis] + 1, 0, FFT_MAX_MISSED_UPDATES);
+    _distorted_cycles[pipeline._imu][pipeline._axis] = constrain_int16(_distorted_cycles[pipeline._imu][pipeline._axis] + 1, 0, FFT_MAX_MISSED_UPDATES);
     weighted_center_freq_hz = freqs.get_weighted_frequency(FrequencyPeak::CENTER);
-    _thread_state._center_peak[_update_axis] = FrequencyPeak::CENTER;
+    _thread_state[pipeline._imu]._center_peak[pipeline._axis] = FrequencyPeak::CENTER;
 
-    update_snr_values(freqs);
+    update_snr_values(pipeline, freqs);
 
     return num_peaks;
 }
@@ -1218,50 +1361,51 @@ uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, con
 // calculate noise frequencies from FFT data provided by the HAL subsystem
 // target_peak is the filtered record we want to apply the new fft data to, source peak is where the fft data is coming from
 // called from FFT thread
-bool AP_GyroFFT::calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config)
+bool AP_GyroFFT::calculate_filtered_noise(const Pipeline& pipeline, FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config)
 {
     if (source_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
         // if we failed to find a signal, carry on using the previous readings
-        if (_missed_cycles[_update_axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
+        if (_missed_cycles[pipeline._imu][pipeline._axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
             return true; // the peak is synthetic
         }
-        update_tl_center_freq_energy(target_peak, _update_axis, 0.0f);
-        update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, _bandwidth_hover_hz);
-        update_tl_noise_center_freq_hz(target_peak, _update_axis, config._fft_min_hz);
+        update_tl_center_freq_energy(target_peak, pipeline, 0.0f);
+        update_tl_noise_center_bandwidth_hz(target_peak, pipeline, _bandwidth_hover_hz);
+        update_tl_noise_center_freq_hz(target_peak, pipeline, config._fft_min_hz);
         return false;
     }
 
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[source_peak];
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &pipeline._state->_peak_data[source_peak];
 
     const uint16_t nb = peak_data->_bin;
 
     if (freqs.is_valid(FrequencyPeak(source_peak))) {
         // total peak energy requires an integration, as an approximation use amplitude * noise width * 5/6
-        update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
-        update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, peak_data->_noise_width_hz);
-        update_tl_noise_center_freq_hz(target_peak, _update_axis, freqs.get_weighted_frequency(FrequencyPeak(source_peak)));
-        _missed_cycles[_update_axis][target_peak] = 0;
+        update_tl_center_freq_energy(target_peak, pipeline, pipeline._state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
+        update_tl_noise_center_bandwidth_hz(target_peak, pipeline, peak_data->_noise_width_hz);
+        update_tl_noise_center_freq_hz(target_peak, pipeline, freqs.get_weighted_frequency(FrequencyPeak(source_peak)));
+        _missed_cycles[pipeline._imu][pipeline._axis][target_peak] = 0;
         return true;
     }
 
     // if we failed to find a signal, carry on using the previous readings
-    if (_missed_cycles[_update_axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
+    if (_missed_cycles[pipeline._imu][pipeline._axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
         return true; // the peak is synthetic
     }
 
     // we failed to find a signal for more than FFT_MAX_MISSED_UPDATES cycles
-    update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
-    update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, _bandwidth_hover_hz);
-    update_tl_noise_center_freq_hz(target_peak, _update_axis, config._fft_min_hz);
+    update_tl_center_freq_energy(target_peak, pipeline, pipeline._state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
+    update_tl_noise_center_bandwidth_hz(target_peak, pipeline, _bandwidth_hover_hz);
+    update_tl_noise_center_freq_hz(target_peak, pipeline, config._fft_min_hz);
 
     return false;
 }
 
-void AP_GyroFFT::update_snr_values(const FrequencyData& freqs)
+void AP_GyroFFT::update_snr_values(const Pipeline& pipeline, const FrequencyData& freqs)
 {
-    _thread_state._center_freq_snr[FrequencyPeak::CENTER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::CENTER);
-    _thread_state._center_freq_snr[FrequencyPeak::LOWER_SHOULDER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::LOWER_SHOULDER);
-    _thread_state._center_freq_snr[FrequencyPeak::UPPER_SHOULDER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::UPPER_SHOULDER);
+    EngineState& thread_state = _thread_state[pipeline._imu];
+    thread_state._center_freq_snr[FrequencyPeak::CENTER][pipeline._axis] = freqs.get_signal_to_noise(FrequencyPeak::CENTER);
+    thread_state._center_freq_snr[FrequencyPeak::LOWER_SHOULDER][pipeline._axis] = freqs.get_signal_to_noise(FrequencyPeak::LOWER_SHOULDER);
+    thread_state._center_freq_snr[FrequencyPeak::UPPER_SHOULDER][pipeline._axis] = freqs.get_signal_to_noise(FrequencyPeak::UPPER_SHOULDER);
 }
 
 
@@ -1279,27 +1423,27 @@ float AP_GyroFFT::MedianLowPassFilter3dFloat::apply(uint8_t axis, float sample)
 }
 
 // initialize a FrequencyData structure with peak frequency information for use in the swapping algorithm
-AP_GyroFFT::FrequencyData::FrequencyData(const AP_GyroFFT& gyrofft, const EngineConfig& config)
+AP_GyroFFT::FrequencyData::FrequencyData(const AP_GyroFFT& gyrofft, const Pipeline& pipeline, const EngineConfig& config)
 {
     for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        valid[i] = gyrofft.get_weighted_frequency(FrequencyPeak(i), frequency[i], snr[i], config);
+        valid[i] = gyrofft.get_weighted_frequency(pipeline, FrequencyPeak(i), frequency[i], snr[i], config);
     }
 }
 
 // calculate noise frequencies from FFT data provided by the HAL subsystem
-bool AP_GyroFFT::get_weighted_frequency(FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const
+bool AP_GyroFFT::get_weighted_frequency(const Pipeline& pipeline, FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const
 {
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[peak];
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &pipeline._state->_peak_data[peak];
 
     const uint16_t bin = peak_data->_bin;
 
     // calculate the SNR and center frequency energy
-    const float max_energy = MAX(1.0f, _state->get_freq_bin(bin));
-    const float ref_energy = MAX(1.0f, _ref_energy[bin][_update_axis]);
+    const float max_energy = MAX(1.0f, pipeline._state->get_freq_bin(bin));
+    const float ref_energy = MAX(1.0f, _ref_energy[pipeline._imu][bin][pipeline._axis]);
     snr = 10.f * (log10f(max_energy) - log10f(ref_energy));
 
     // if the bin energy is above the noise threshold then we have a signal
-    if (!_thread_state._noise_needs_calibration && isfinite(_state->get_freq_bin(bin)) && snr > config._snr_threshold_db) {
+    if (!_thread_state[pipeline._imu]._noise_needs_calibration && isfinite(pipeline._state->get_freq_bin(bin)) && snr > config._snr_threshold_db) {
         weighted_peak_freq_hz = constrain_float(peak_data->_freq_hz, (float)config._fft_min_hz, (float)config._fft_max_hz);
         return true;
     }
@@ -1310,12 +1454,12 @@ bool AP_GyroFFT::get_weighted_frequency(FrequencyPeak peak, float& weighted_peak
 }
 
 // calculate a matrix of distances between the current filtered estimates and instantaneous values from the current cycle
-void AP_GyroFFT::find_distance_matrix(DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const
+void AP_GyroFFT::find_distance_matrix(const Pipeline& pipeline, DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const
 {
     float curr_freqs[FrequencyPeak::MAX_TRACKED_PEAKS];
     // get the current frequency estimate for all peaks
     for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        curr_freqs[i] = get_tl_noise_center_freq_hz(FrequencyPeak(i), _update_axis);
+        curr_freqs[i] = get_tl_noise_center_freq_hz(FrequencyPeak(i), pipeline);
     }
     // calculate the matrix
     for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
@@ -1345,31 +1489,36 @@ AP_GyroFFT::FrequencyPeak AP_GyroFFT::find_closest_peak(const FrequencyPeak targ
 
 // calculate noise baseline from FFT data provided by the HAL subsystem
 // called from FFT thread
-void AP_GyroFFT::update_ref_energy(uint16_t max_bin)
+void AP_GyroFFT::update_ref_energy(Pipeline& pipeline, uint16_t max_bin)
 {
-    if (!_thread_state._noise_needs_calibration) {
+    if (!_thread_state[pipeline._imu]._noise_needs_calibration) {
         return;
     }
 
+    const uint8_t axis = pipeline._axis;
+    Vector3f* ref_energy = _ref_energy[pipeline._imu];
+    uint16_t& noise_calibration_cycles = _noise_calibration_cycles[pipeline._imu][axis];
+    AP_HAL::DSP::FFTWindowState* state = pipeline._state;
+
     // according to https://www.tcd.ie/Physics/research/groups/magnetism/files/lectures/py5021/MagneticSensors3.pdf sensor noise is not necessarily gaussian
     // determine a PS noise reference at each of the possible center frequencies
-    if (_noise_cycles == 0 && _noise_calibration_cycles[_update_axis] > 0) {
-        for (uint16_t i = 1; i < _state->_bin_count; i++) {
-            _ref_energy[i][_update_axis] += _state->get_freq_bin(i);
+    if (pipeline._noise_cycles == 0 && noise_calibration_cycles > 0) {
+        for (uint16_t i = 1; i < state->_bin_count; i++) {
+            ref_energy[i][axis] += state->get_freq_bin(i);
         }
-        if (--_noise_calibration_cycles[_update_axis] == 0) {
-            for (uint16_t i = 1; i < _state->_bin_count; i++) {
+        if (--noise_calibration_cycles == 0) {
+            for (uint16_t i = 1; i < state->_bin_count; i++) {
                 const float cycles = (static_cast<float>(_window_size) / static_cast<float>(_samples_per_frame)) * 2;
                 // overall random noise is reduced by sqrt(N) when averaging periodigrams so adjust for that
-                _ref_energy[i][_update_axis] = (_ref_energy[i][_update_axis] / cycles) * sqrtf(cycles);
+                ref_energy[i][axis] = (ref_energy[i][axis] / cycles) * sqrtf(cycles);
             }
 
             WITH_SEMAPHORE(_sem);
-            _thread_state._noise_needs_calibration &= ~(1 << _update_axis);
+            _thread_state[pipeline._imu]._noise_needs_calibration &= ~(1 << axis);
         }
     }
-    else if (_noise_cycles > 0) {
-        _noise_cycles--;
+    else if (pipeline._noise_cycles > 0) {
+        pipeline._noise_cycles--;
     }
 }
 
@@ -1412,7 +1561,8 @@ float AP_GyroFFT::self_test(float frequency, FloatBuffer& test_window)
         }
     }
 
-    _update_axis = 0;
+    // the self-test uses the first pipeline, analysis is paused until the self-test completes
+    Pipeline& pipeline = _pipelines[0];
 
     // if using averaging we need to process _num_frames in order to not bias the result
     for (uint8_t i = 1; i < _num_frames; i++) {
@@ -1427,17 +1577,18 @@ float AP_GyroFFT::self_test(float frequency, FloatBuffer& test_window)
         gcs().send_text(MAV_SEVERITY_WARNING, "FFT: self-test failed, failed to find frequency %.1f", frequency);
     }
 
-    calculate_noise(true, _config);
+    calculate_noise(pipeline, true, _config);
 
     float max_divergence = 0;
     // make sure the selected frequencies are in the right bin
-    max_divergence = MAX(max_divergence, fabsf(frequency - _thread_state._center_freq_hz[0]));
-    if (_thread_state._center_freq_hz[0] < (frequency - MAX(_state->_bin_resolution * 0.5f, 1)) || _thread_state._center_freq_hz[0] > (frequency + MAX(_state->_bin_resolution * 0.5f, 1))) {
-        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: self-test failed: wanted %.1f, had %.1f", frequency, _thread_state._center_freq_hz[0]);
+    const float center_freq_hz = _thread_state[pipeline._imu]._center_freq_hz[pipeline._axis];
+    max_divergence = MAX(max_divergence, fabsf(frequency - center_freq_hz));
+    if (center_freq_hz < (frequency - MAX(_state->_bin_resolution * 0.5f, 1)) || center_freq_hz > (frequency + MAX(_state->_bin_resolution * 0.5f, 1))) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: self-test failed: wanted %.1f, had %.1f", frequency, center_freq_hz);
     }
 #if DEBUG_FFT
     else {
-        gcs().send_text(MAV_SEVERITY_INFO, "FFT: self-test succeeded: wanted %.1f, had %.1f", frequency, _thread_state._center_freq_hz[0]);
+        gcs().send_text(MAV_SEVERITY_INFO, "FFT: self-test succeeded: wanted %.1f, had %.1f", frequency, center_freq_hz);
     }
 #endif
 
@@ -22,6 +22,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/utility/RingBuffer.h>
+#include <AP_HAL/utility/SlidingDFT.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_InertialSensor/AP_InertialSensor.h>
@@ -30,6 +31,13 @@
 
 #define DEBUG_FFT   0
 
+// maximum number of IMUs that can be analysed independently
+#if HAL_GYROFFT_PARALLEL_ENABLED
+#define FFT_MAX_IMUS    INS_MAX_INSTANCES
+#else
+#define FFT_MAX_IMUS    1
+#endif
+
 // a library that leverages the HAL DSP support to perform FFT analysis on gyro samples
 class AP_GyroFFT
 {
@@ -40,7 +48,10 @@ public:
 
     enum class Options : uint32_t {
         FFTPostFilter = 1 << 0,
-        ESCNoiseCheck = 1 << 1
+        ESCNoiseCheck = 1 << 1,
+        ParallelAxes = 1 << 2,
+        MultiIMU = 1 << 3,
+        SlidingDFT = 1 << 4
     };
 
     AP_GyroFFT();
@@ -60,6 +71,8 @@ public:
     void update_parameters() { update_parameters(false); }
     // thread for processing gyro data via FFT
     void update_thread();
+    // thread for processing a single pipeline of gyro data via FFT
+    void update_pipeline_thread();
     // start the update thread
     bool start_update_thread();
     // is the subsystem enabled
@@ -81,28 +94,34 @@ public:
 
     // detected peak frequency filtered at 1/3 the update rate
     const Vector3f& get_noise_center_freq_hz() const { return get_noise_center_freq_hz(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_center_freq_hz(FrequencyPeak peak) const { return _global_state._center_freq_hz_filtered[peak]; }
+    const Vector3f& get_noise_center_freq_hz(FrequencyPeak peak) const { return _global_state[primary_imu()]._center_freq_hz_filtered[peak]; }
     // frequency values
     float get_weighted_freq_hz(FrequencyPeak peak) const;
     // energy of the background noise at the detected center frequency
     const Vector3f& get_noise_signal_to_noise_db() const { return get_noise_signal_to_noise_db(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_signal_to_noise_db(FrequencyPeak peak) const { return _global_state._center_freq_snr[peak];; }
+    const Vector3f& get_noise_signal_to_noise_db(FrequencyPeak peak) const { return _global_state[primary_imu()]._center_freq_snr[peak];; }
     // detected peak frequency weighted by energy
-    float get_weighted_noise_center_freq_hz() const;
+    float get_weighted_noise_center_freq_hz() const { return get_weighted_noise_center_freq_hz(primary_imu()); }
+    float get_weighted_noise_center_freq_hz(uint8_t imu) const;
     // all detected peak frequencies weighted by energy
-    uint8_t get_weighted_noise_center_frequencies_hz(uint8_t num_freqs, float* freqs) const;
+    uint8_t get_weighted_noise_center_frequencies_hz(uint8_t num_freqs, float* freqs) const {
+        return get_weighted_noise_center_frequencies_hz(primary_imu(), num_freqs, freqs);
+    }
+    uint8_t get_weighted_noise_center_frequencies_hz(uint8_t imu, uint8_t num_freqs, float* freqs) const;
+    // number of IMUs analysed independently, IMU indexes are the same as the gyro instance when more than one
+    uint8_t get_num_imus() const { return _num_imus; }
     // detected peak frequency
-    const Vector3f& get_raw_noise_center_freq_hz() const { return _global_state._center_freq_hz; }
+    const Vector3f& get_raw_noise_center_freq_hz() const { return _global_state[primary_imu()]._center_freq_hz; }
     // match between first and second harmonics
-    const Vector3f& get_raw_noise_harmonic_fit() const { return _global_state._harmonic_fit; }
+    const Vector3f& get_raw_noise_harmonic_fit() const { return _global_state[primary_imu()]._harmonic_fit; }
     // energy of the detected peak frequency
     const Vector3f& get_center_freq_energy() const { return get_center_freq_energy(FrequencyPeak::CENTER); }
-    const Vector3f& get_center_freq_energy(FrequencyPeak peak) const { return _global_state._center_freq_energy_filtered[peak]; }
+    const Vector3f& get_center_freq_energy(FrequencyPeak peak) const { return _global_state[primary_imu()]._center_freq_energy_filtered[peak]; }
     // index of the FFT bin containing the detected peak frequency
-    const Vector3<uint16_t>& get_center_freq_bin() const { return _global_state._center_freq_bin; }
+    const Vector3<uint16_t>& get_center_freq_bin() const { return _global_state[primary_imu()]._center_freq_bin; }
     // detected peak bandwidth
     const Vector3f& get_noise_center_bandwidth_hz() const { return get_noise_center_bandwidth_hz(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_center_bandwidth_hz(FrequencyPeak peak) const { return _global_state._center_bandwidth_hz_filtered[peak]; };
+    const Vector3f& get_noise_center_bandwidth_hz(FrequencyPeak peak) const { return _global_state[primary_imu()]._center_bandwidth_hz_filtered[peak]; };
     // weighted detected peak bandwidth
     float get_weighted_noise_center_bandwidth_hz() const;
     // log gyro fft messages
@@ -141,6 +160,24 @@ private:
         float _snr_threshold_db;
     } _config;
 
+    // FFT analysis of one axis of one IMU. Each pipeline has its own DSP state when
+    // pipelines are run in parallel, otherwise they share a single DSP state and
+    // are run in turn
+    struct Pipeline {
+        // state of the FFT engine
+        AP_HAL::DSP::FFTWindowState* _state;
+        // sliding DFT of the gyro samples, replacing the windowed FFT when enabled
+        SlidingDFT* _sdft;
+        // index of the analysed IMU
+        uint8_t _imu;
+        // analysed axis
+        uint8_t _axis;
+        // whether the analyzer is mid-cycle
+        bool _analysis_started;
+        // the number of cycles required to have a proper noise reference
+        uint16_t _noise_cycles;
+    };
+
     // smoothing filter that first takes the median from a sliding window and then
     // applies a low pass filter to the result
     class MedianLowPassFilter3dFloat {
@@ -164,7 +201,7 @@ private:
     // structure for holding noise peak data while calculating swaps
     class FrequencyData {
     public:
-        FrequencyData(const AP_GyroFFT& gyrofft, const EngineConfig& config);
+        FrequencyData(const AP_GyroFFT& gyrofft, const Pipeline& pipeline, const EngineConfig& config);
         float get_weighted_frequency(FrequencyPeak i) const { return frequency[i]; }
         float get_signal_to_noise(FrequencyPeak i) const { return snr[i]; }
         bool is_valid(FrequencyPeak i) const { return valid[i]; }
@@ -177,41 +214,47 @@ private:
     typedef float DistanceMatrix[FrequencyPeak::MAX_TRACKED_PEAKS][FrequencyPeak::MAX_TRACKED_PEAKS];
 
     // thread-local accessors of filtered state
-    float get_tl_noise_center_freq_hz(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_freq_hz_filtered[peak][axis]; }
-    float get_tl_center_freq_energy(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_freq_energy_filtered[peak][axis]; }
-    float get_tl_noise_center_bandwidth_hz(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_bandwidth_hz_filtered[peak][axis]; };
+    float get_tl_noise_center_freq_hz(FrequencyPeak peak, const Pipeline& p) const { return _thread_state[p._imu]._center_freq_hz_filtered[peak][p._axis]; }
+    float get_tl_center_freq_energy(FrequencyPeak peak, const Pipeline& p) const { return _thread_state[p._imu]._center_freq_energy_filtered[peak][p._axis]; }
+    float get_tl_noise_center_bandwidth_hz(FrequencyPeak peak, const Pipeline& p) const { return _thread_state[p._imu]._center_bandwidth_hz_filtered[peak][p._axis]; };
     // thread-local mutators of filtered state
-    float update_tl_noise_center_freq_hz(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_freq_hz_filtered[peak][axis] = _center_freq_filter[peak].apply(axis, value));
+    float update_tl_noise_center_freq_hz(FrequencyPeak peak, const Pipeline& p, float value) {
+        return (_thread_state[p._imu]._center_freq_hz_filtered[peak][p._axis] = _center_freq_filter[p._imu][peak].apply(p._axis, value));
     }
-    float update_tl_center_freq_energy(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_freq_energy_filtered[peak][axis] = _center_freq_energy_filter[peak].apply(axis, value));
+    float update_tl_center_freq_energy(FrequencyPeak peak, const Pipeline& p, float value) {
+        return (_thread_state[p._imu]._center_freq_energy_filtered[peak][p._axis] = _center_freq_energy_filter[p._imu][peak].apply(p._axis, value));
     }
-    float update_tl_noise_center_bandwidth_hz(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_bandwidth_hz_filtered[peak][axis] = _center_bandwidth_filter[peak].apply(axis, value));
+    float update_tl_noise_center_bandwidth_hz(FrequencyPeak peak, const Pipeline& p, float value) {
+        return (_thread_state[p._imu]._center_bandwidth_hz_filtered[peak][p._axis] = _center_bandwidth_filter[p._imu][peak].apply(p._axis, value));
     }
     // write single log messages
     void log_noise_peak(uint8_t id, FrequencyPeak peak) const;
+    // run a single FFT cycle on a pipeline, returns true if a frame was processed
+    bool run_cycle(Pipeline& pipeline);
+    // delay the calling FFT thread until another frame is likely to be available
+    void wait_for_samples(uint16_t remaining_samples) const;
     // calculate the peak noise frequency
-    void calculate_noise(bool calibrating, const EngineConfig& config);
+    void calculate_noise(const Pipeline& pipeline, bool calibrating, const EngineConfig& config);
     // calculate noise peaks based on energy and history
-    uint8_t calculate_tracking_peaks(float& weighted_peak_freq_hz, bool calibrating, const EngineConfig& config);
-    uint8_t calculate_tracking_peaks(float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config);
+    uint8_t calculate_tracking_peaks(const Pipeline& pipeline, float& weighted_peak_freq_hz, bool calibrating, const EngineConfig& config);
+    uint8_t calculate_tracking_peaks(const Pipeline& pipeline, float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config);
     // calculate noise peak frequency characteristics
-    bool calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config);
-    void update_snr_values(const FrequencyData& freqs);
+    bool calculate_filtered_noise(const Pipeline& pipeline, FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config);
+    void update_snr_values(const Pipeline& pipeline, const FrequencyData& freqs);
     // get the weighted frequency
-    bool get_weighted_frequency(FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const;
+    bool get_weighted_frequency(const Pipeline& pipeline, FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const;
+    // frequency values of an IMU
+    float get_weighted_freq_hz(uint8_t imu, FrequencyPeak peak) const;
     // return the tracked noise peak
-    FrequencyPeak get_tracked_noise_peak() const;
+    FrequencyPeak get_tracked_noise_peak(uint8_t imu) const;
     // calculate the distance matrix between the current estimates and the current cycle
-    void find_distance_matrix(DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const;
+    void find_distance_matrix(const Pipeline& pipeline, DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const;
     // return the instantaneous peak that is closest to the target estimate peak
     FrequencyPeak find_closest_peak(const FrequencyPeak target, const DistanceMatrix& distance_matrix, uint8_t ignore = 0) const;
     // detected peak frequency weighted by energy
     float calculate_weighted_freq_hz(const Vector3f& energy, const Vector3f& freq) const;
     // update the estimation of the background noise energy
-    void update_ref_energy(uint16_t max_bin);
+    void update_ref_energy(Pipeline& pipeline, uint16_t max_bin);
     // test frequency detection for all of the allowable bins
     float self_test_bin_frequencies();
     // detect the provided frequency
@@ -219,10 +262,28 @@ private:
     // whether to run analysis or not
     bool analysis_enabled() const { return _initialized && _analysis_enabled && _thread_created; };
     // whether analysis can be run again or not
-    bool start_analysis();
+    bool start_analysis(Pipeline& pipeline);
+    // whether any pipeline is mid-cycle
+    bool analysis_in_progress() const;
+    // index of the analysed IMU providing the vehicle-wide outputs
+    uint8_t primary_imu() const {
+        return _num_imus > 1 ? MIN(_ins->get_primary_gyro(), uint8_t(_num_imus - 1)) : 0;
+    }
+    // gyro instance analysed for an IMU
+    uint8_t gyro_instance(uint8_t imu) const {
+        return _num_imus > 1 ? imu : _ins->get_primary_gyro();
+    }
+    // return the gyro window of a pipeline
+    FloatBuffer& get_gyro_window(const Pipeline& pipeline) {
+        return _sample_mode == 0 ? _ins->get_raw_gyro_window(gyro_instance(pipeline._imu), pipeline._axis) : _downsampled_gyro_data[pipeline._imu][pipeline._axis];
+    }
     // return samples available in the gyro window
-    uint16_t get_available_samples(uint8_t axis) {
-        return _sample_mode == 0 ?_ins->get_raw_gyro_window(axis).available() : _downsampled_gyro_data[axis].available();
+    uint16_t get_available_samples(const Pipeline& pipeline) {
+        return get_gyro_window(pipeline).available();
+    }
+    // number of samples needed to start a cycle, a sliding DFT consumes the samples as they arrive
+    uint16_t get_frame_samples() const {
+        return _sliding_dft ? _samples_per_frame : _state->_window_size;
     }
     void update_parameters(bool force);
     // semaphore for access to shared FFT data
@@ -258,15 +319,15 @@ private:
         // filtered detected peak width
         Vector3f _center_bandwidth_hz_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
         // axes that still require noise calibration
-        uint8_t _noise_needs_calibration : 3;
-        // whether the analyzer is mid-cycle
-        bool _analysis_started;
+        uint8_t _noise_needs_calibration;
     };
 
-    // Shared FFT engine state local to the FFT thread
-    EngineState _thread_state;
+    // Shared FFT engine state local to the FFT threads
+    EngineState _thread_state[FFT_MAX_IMUS];
     // Shared FFT engine state accessible by the main thread
-    EngineState _global_state;
+    EngineState _global_state[FFT_MAX_IMUS];
+    // whether any IMU still requires noise calibration
+    bool noise_needs_calibration(const EngineState* state) const;
 
     // number of samples needed before a new frame can be processed
     uint16_t _samples_per_frame;
@@ -275,22 +336,32 @@ private:
     // last cycle time
     uint32_t _output_cycle_micros;
     // downsampled gyro data circular buffer for frequency analysis
-    FloatBuffer _downsampled_gyro_data[XYZ_AXIS_COUNT];
+    FloatBuffer _downsampled_gyro_data[FFT_MAX_IMUS][XYZ_AXIS_COUNT];
     // accumulator for sampled gyro data
-    Vector3f _oversampled_gyro_accum;
+    Vector3f _oversampled_gyro_accum[FFT_MAX_IMUS];
     // count of oversamples
     uint16_t _oversampled_gyro_count;
 
-    // state of the FFT engine
+    // analysis pipelines, one per axis of each analysed IMU
+    Pipeline _pipelines[FFT_MAX_IMUS * XYZ_AXIS_COUNT];
+    // number of analysis pipelines
+    uint8_t _num_pipelines;
+    // number of IMUs analysed
+    uint8_t _num_imus;
+    // whether each pipeline is run in its own thread
+    bool _parallel_pipelines;
+    // whether the pipelines use a sliding DFT rather than a windowed FFT
+    bool _sliding_dft;
+    // number of pipeline threads that have started
+    uint8_t _pipeline_threads;
+    // state of the FFT engine of the first pipeline, used for configuration and self-test
     AP_HAL::DSP::FFTWindowState* _state;
     // update state machine step information
-    uint8_t _update_axis;
+    uint8_t _update_pipeline;
     // noise base of the gyros
-    Vector3f* _ref_energy;
-    // the number of cycles required to have a proper noise reference
-    uint16_t _noise_cycles;
+    Vector3f* _ref_energy[FFT_MAX_IMUS];
     // number of cycles over which to generate noise ensemble averages
-    uint16_t _noise_calibration_cycles[XYZ_AXIS_COUNT];
+    uint16_t _noise_calibration_cycles[FFT_MAX_IMUS][XYZ_AXIS_COUNT];
     // current _sample_mode
     uint8_t _current_sample_mode : 3;
     // harmonic multiplier for two highest peaks
@@ -298,27 +369,27 @@ private:
     // number of tracked peaks
     uint8_t _tracked_peaks;
     // engine health in tracked peaks per axis
-    Vector3<uint8_t> _health;
+    Vector3<uint8_t> _health[FFT_MAX_IMUS];
     // engine health on roll/pitch/yaw
-    Vector3<uint8_t> _rpy_health;
+    Vector3<uint8_t> _rpy_health[FFT_MAX_IMUS];
     // averaged throttle output over averaging period
     float _avg_throttle_out;
 
     // smoothing filter on the output
-    MedianLowPassFilter3dFloat _center_freq_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    MedianLowPassFilter3dFloat _center_freq_filter[FFT_MAX_IMUS][FrequencyPeak::MAX_TRACKED_PEAKS];
     // smoothing filter on the energy
-    MedianLowPassFilter3dFloat _center_freq_energy_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    MedianLowPassFilter3dFloat _center_freq_energy_filter[FFT_MAX_IMUS][FrequencyPeak::MAX_TRACKED_PEAKS];
     // smoothing filter on the bandwidth
-    MedianLowPassFilter3dFloat _center_bandwidth_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    MedianLowPassFilter3dFloat _center_bandwidth_filter[FFT_MAX_IMUS][FrequencyPeak::MAX_TRACKED_PEAKS];
     // smoothing filter on the frequency fit
-    LowPassFilterFloat _harmonic_fit_filter[XYZ_AXIS_COUNT];
+    LowPassFilterFloat _harmonic_fit_filter[FFT_MAX_IMUS][XYZ_AXIS_COUNT];
 
     // configured sampling rate
     uint16_t _fft_sampling_rate_hz;
     // number of cycles without a detected signal
-    uint8_t _missed_cycles[XYZ_AXIS_COUNT][FrequencyPeak::MAX_TRACKED_PEAKS];
+    uint8_t _missed_cycles[FFT_MAX_IMUS][XYZ_AXIS_COUNT][FrequencyPeak::MAX_TRACKED_PEAKS];
     // number of cycles where peaks have swapped places
-    uint8_t _distorted_cycles[XYZ_AXIS_COUNT];
+    uint8_t _distorted_cycles[FFT_MAX_IMUS][XYZ_AXIS_COUNT];
     // whether the analyzer initialized correctly
     bool _initialized;
 
@@ -0,0 +1,169 @@
+/*
+  benchmark of the board DSP driver as used by AP_GyroFFT, giving the
+  frames per second of a complete analysis (window, FFT, magnitudes
+  and peak detection) for each supported window size
+
+  The windowed FFT is then compared with the sliding DFT engine
+  (FFT_OPTIONS bit 4) over the default FFT_MINHZ to FFT_MAXHZ range,
+  giving the CPU used to analyse one second of gyro samples and the
+  interval between frequency estimates
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SlidingDFT.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+
+static const uint16_t sample_rate_hz = 1000;
+static const uint16_t max_window_size = 512;
+static const float test_freq_hz = 123;
+static const float attenuation_power_db = 15;
+// length of each benchmark run
+static const uint32_t run_time_us = 2000000;
+// default FFT_MINHZ, FFT_MAXHZ and FFT_WINDOW_OLAP
+static const float min_hz = 50;
+static const float max_hz = 450;
+static const float window_overlap = 0.75f;
+// samples per frame of the sliding DFT engine
+static const uint16_t sdft_samples_per_frame = 4;
+
+static FloatBuffer samples {max_window_size};
+
+// test signal at sample i
+static float test_sample(uint32_t i, uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    const float noise = ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+    return sinf(2.0f * M_PI * test_freq_hz * (i % sample_rate_hz) / sample_rate_hz) * 20 + noise * 5;
+}
+
+static void benchmark(uint16_t window_size)
+{
+    AP_HAL::DSP::FFTWindowState* fft = hal.dsp->fft_init(window_size, sample_rate_hz);
+    if (fft == nullptr) {
+        hal.console->printf("%4u: failed to allocate\n", window_size);
+        return;
+    }
+    const float attenuation_cutoff = powf(10.0f, -attenuation_power_db / 10.0f);
+    const uint16_t end_bin = fft->_bin_count - 1;
+
+    // the samples are not advanced so every frame analyses the same
+    // window
+    uint32_t frames = 0;
+    uint16_t peak_bin = 0;
+    const uint32_t start_us = AP_HAL::micros();
+    uint32_t elapsed_us;
+    do {
+        hal.dsp->fft_start(fft, samples, 0);
+        peak_bin = hal.dsp->fft_analyse(fft, 1, end_bin, attenuation_cutoff);
+        frames++;
+        elapsed_us = AP_HAL::micros() - start_us;
+    } while (elapsed_us < run_time_us);
+
+    hal.console->printf("%4u: %8.0f frames/s %7.2fus/frame peak %.1fHz (bin %u)\n",
+                        window_size,
+                        frames * 1.0e6f / elapsed_us,
+                        float(elapsed_us) / frames,
+                        fft->_peak_data[AP_HAL::DSP::CENTER]._freq_hz,
+                        peak_bin);
+    delete fft;
+}
+
+/*
+  analyse a stream of samples as AP_GyroFFT does, with a windowed FFT
+  or a sliding DFT
+ */
+static void compare(uint16_t window_size, bool sliding)
+{
+    AP_HAL::DSP::FFTWindowState* fft = hal.dsp->fft_init(window_size, sample_rate_hz);
+    SlidingDFT sdft;
+    if (fft == nullptr || !sdft.init(window_size)) {
+        hal.console->printf("%4u: failed to allocate\n", window_size);
+        delete fft;
+        return;
+    }
+    const float attenuation_cutoff = powf(10.0f, -attenuation_power_db / 10.0f);
+    const uint16_t start_bin = MAX(floorf(min_hz / fft->_bin_resolution), 1);
+    const uint16_t end_bin = MIN(ceilf(max_hz / fft->_bin_resolution), fft->_bin_count);
+    const uint16_t samples_per_frame = sliding ? sdft_samples_per_frame : uint16_t((1.0f - window_overlap) * window_size);
+
+    FloatBuffer stream {uint32_t(window_size + samples_per_frame)};
+    uint32_t seed = 1;
+    uint32_t sample = 0;
+    uint32_t frames = 0;
+    uint64_t busy_us = 0;
+    const uint32_t start_us = AP_HAL::micros();
+    while (AP_HAL::micros() - start_us < run_time_us) {
+        // a sliding DFT consumes its samples, a windowed FFT keeps the window in the buffer
+        while (stream.available() < (sliding ? samples_per_frame : window_size)) {
+            stream.push(test_sample(sample++, seed));
+        }
+        const uint32_t frame_start_us = AP_HAL::micros();
+        if (sliding) {
+            hal.dsp->sdft_update(sdft, stream, start_bin, end_bin);
+            hal.dsp->sdft_analyse(fft, sdft, start_bin, end_bin, attenuation_cutoff);
+        } else {
+            hal.dsp->fft_start(fft, stream, samples_per_frame);
+            hal.dsp->fft_analyse(fft, start_bin, end_bin, attenuation_cutoff);
+        }
+        busy_us += AP_HAL::micros() - frame_start_us;
+        frames++;
+    }
+
+    const float frame_us = float(busy_us) / frames;
+    hal.console->printf("%4u %s: %7.2fus/frame, %6.2fms CPU per second of samples, estimate every %5.1fms, peak %.1fHz\n",
+                        window_size, sliding ? "sliding DFT " : "windowed FFT",
+                        frame_us,
+                        frame_us * sample_rate_hz / samples_per_frame * 1.0e-3f,
+                        samples_per_frame * 1000.0f / sample_rate_hz,
+                        fft->_peak_data[AP_HAL::DSP::CENTER]._freq_hz);
+    delete fft;
+}
+
+void setup()
+{
+    hal.console->printf("DSP FFT benchmark, %.0fHz test signal at %uHz\n", test_freq_hz, sample_rate_hz);
+
+    uint32_t seed = 1;
+    for (uint16_t i = 0; i < max_window_size; i++) {
+        samples.push(test_sample(i, seed));
+    }
+
+    for (uint16_t window_size = 32; window_size <= max_window_size; window_size *= 2) {
+        benchmark(window_size);
+    }
+
+    hal.console->printf("Windowed FFT and sliding DFT, %.0fHz to %.0fHz\n", min_hz, max_hz);
+    for (uint16_t window_size = 32; window_size <= max_window_size; window_size *= 2) {
+        compare(window_size, false);
+        compare(window_size, true);
+    }
+}
+
+#else
+
+void setup()
+{
+    hal.console->printf("Board not currently supported\n");
+}
+
+#endif // HAL_WITH_DSP
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+const struct AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
@@ -0,0 +1,280 @@
+/*
+  compare frequency tracking latency and accuracy of the sequential FFT
+  analysis with parallel per-axis and per-IMU analysis (FFT_OPTIONS
+  bits 2 and 3)
+
+  Both analysers are run side by side on the same simulated gyro data
+  using loop rate sampling so that each has its own copy of the
+  samples. The simulated vibration frequency is stepped part way
+  through and the time each analyser takes to track the new frequency
+  is reported along with the steady state error either side of the step
+ */
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Arming/AP_Arming.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_Baro/AP_Baro.h>
+#include <AP_ExternalAHRS/AP_ExternalAHRS.h>
+#include <AP_Scheduler/AP_Scheduler.h>
+#include <SITL/SITL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && HAL_GYROFFT_PARALLEL_ENABLED
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+static const uint32_t LOOP_RATE_HZ = 400;
+static const uint32_t LOOP_DELTA_US = 1000000 / LOOP_RATE_HZ;
+// vibration frequency before and after the step
+static const float START_FREQ_HZ = 150;
+static const float STEP_FREQ_HZ = 250;
+// time after arming at which the frequency is stepped, and the end of the run
+static const uint32_t STEP_MS = 20000;
+static const uint32_t END_MS = 40000;
+// period over which the steady state error is measured either side of the step
+static const uint32_t SETTLE_MS = 10000;
+// tolerance for the tracked frequency to be considered to have reached the step frequency
+static const float TRACKING_TOLERANCE = 0.05f;
+
+void setup();
+void loop();
+
+static AP_SerialManager serial_manager;
+static AP_BoardConfig board_config;
+static AP_InertialSensor ins;
+static AP_Baro baro;
+AP_Int32 logger_bitmask;
+static AP_Logger logger{logger_bitmask};
+#if HAL_EXTERNAL_AHRS_ENABLED
+static AP_ExternalAHRS external_ahrs;
+#endif
+static SITL::SIM sitl;
+static AP_Scheduler scheduler;
+
+// create fake gcs object
+GCS_Dummy _gcs;
+
+const struct LogStructure log_structure[] = {
+    LOG_COMMON_STRUCTURES
+};
+
+const AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+class Arming : public AP_Arming {
+public:
+    Arming() : AP_Arming() {}
+    bool arm(AP_Arming::Method method, bool do_arming_checks=true) override {
+        armed = true;
+        return true;
+    }
+};
+
+static Arming arming;
+
+class ReplayGyroFFT {
+public:
+    // tracking results for a single analyser
+    struct Result {
+        const char *name;
+        AP_GyroFFT *fft;
+        uint32_t latency_ms;
+        float error_sum[2];
+        uint32_t error_count[2];
+        float imu_error_sum[INS_MAX_INSTANCES];
+        uint32_t imu_error_count;
+    };
+
+    void init() {
+        // only one AP_GyroFFT is allowed, so clear the singleton between the two analysers
+        sequential.fft = new AP_GyroFFT();
+        AP_GyroFFT::_singleton = nullptr;
+        parallel.fft = new AP_GyroFFT();
+        if (sequential.fft == nullptr || parallel.fft == nullptr) {
+            AP_HAL::panic("Unable to allocate AP_GyroFFT");
+        }
+        sequential.name = "sequential";
+        parallel.name = "parallel";
+        setup_fft(*sequential.fft, 0);
+        setup_fft(*parallel.fft, uint32_t(AP_GyroFFT::Options::ParallelAxes) | uint32_t(AP_GyroFFT::Options::MultiIMU));
+    }
+
+    void setup_fft(AP_GyroFFT& fft, uint32_t options) {
+        fft._enable.set(1);             // FFT_ENABLE
+        fft._window_size.set(256);      // FFT_WINDOW_SIZE
+        fft._window_overlap.set(0.75f); // FFT_WINDOW_OLAP
+        fft._sample_mode.set(1);        // FFT_SAMPLE_MODE
+        fft._snr_threshold_db.set(10);  // FFT_SNR_REF
+        fft._fft_min_hz.set(50);        // FFT_MINHZ
+        fft._fft_max_hz.set(300);       // FFT_MAXHZ
+        fft._options.set(options);      // FFT_OPTIONS
+
+        fft.init(LOOP_RATE_HZ);
+        fft.update_parameters();
+    }
+
+    void loop() {
+        const uint32_t now = AP_HAL::millis();
+        Result* results[] { &sequential, &parallel };
+
+        for (Result* r : results) {
+            r->fft->sample_gyros();
+            r->fft->update();
+        }
+
+        if (!arming.is_armed()) {
+            char buf[32];
+            bool calibrated = true;
+            for (Result* r : results) {
+                if (!r->fft->pre_arm_check(buf, 32)) {
+                    if (now - last_output_ms > 1000) {
+                        hal.console->printf("%s: %s\n", r->name, buf);
+                        last_output_ms = now;
+                    }
+                    calibrated = false;
+                }
+            }
+            if (calibrated) {
+                arming.arm(AP_Arming::Method::RUDDER);
+                // apply throttle values to motors to make sure the fake IMU generates energetic enough data
+                for (uint8_t i=0; i<4; i++) {
+                    hal.rcout->write(i, 1500);
+                }
+                armed_ms = now;
+            }
+            return;
+        }
+
+        const uint32_t run_ms = now - armed_ms;
+        if (run_ms >= END_MS) {
+            if (!reported) {
+                report();
+                reported = true;
+            }
+            return;
+        }
+
+        const bool stepped = run_ms >= STEP_MS;
+        if (stepped && !step_applied) {
+            sitl.vibe_freq.set(Vector3f(STEP_FREQ_HZ, STEP_FREQ_HZ, STEP_FREQ_HZ));
+            step_applied = true;
+        }
+        const float target_hz = stepped ? STEP_FREQ_HZ : START_FREQ_HZ;
+
+        for (Result* r : results) {
+            const Vector3f& freq = r->fft->get_noise_center_freq_hz();
+            const bool tracking = fabsf(freq.x - target_hz) < target_hz * TRACKING_TOLERANCE
+                && fabsf(freq.y - target_hz) < target_hz * TRACKING_TOLERANCE;
+            if (stepped && r->latency_ms == 0 && tracking) {
+                r->latency_ms = run_ms - STEP_MS;
+            }
+            // steady state error at the end of each half of the run
+            const uint32_t phase_ms = stepped ? run_ms - STEP_MS : run_ms;
+            if (phase_ms + SETTLE_MS >= STEP_MS) {
+                const uint8_t phase = stepped ? 1 : 0;
+                r->error_sum[phase] += fabsf(r->fft->get_weighted_noise_center_freq_hz() - target_hz);
+                r->error_count[phase]++;
+                if (stepped) {
+                    for (uint8_t imu = 0; imu < r->fft->get_num_imus(); imu++) {
+                        r->imu_error_sum[imu] += fabsf(r->fft->get_weighted_noise_center_freq_hz(imu) - target_hz);
+                    }
+                    r->imu_error_count++;
+                }
+            }
+        }
+
+        if (now - last_output_ms > 1000) {
+            hal.console->printf(".");
+            last_output_ms = now;
+        }
+    }
+
+    void report() {
+        hal.console->printf("\nStep %.0fHz -> %.0fHz, window %u, %u samples per frame\n",
+                            START_FREQ_HZ, STEP_FREQ_HZ,
+                            unsigned(sequential.fft->_window_size.get()), unsigned(sequential.fft->_samples_per_frame));
+        for (const Result* r : { &sequential, &parallel }) {
+            hal.console->printf("%-10s: pipelines %u latency %ums error before %.2fHz after %.2fHz\n",
+                                r->name, unsigned(r->fft->_num_pipelines), unsigned(r->latency_ms),
+                                r->error_sum[0] / MAX(r->error_count[0], 1U),
+                                r->error_sum[1] / MAX(r->error_count[1], 1U));
+            for (uint8_t imu = 0; r->fft->get_num_imus() > 1 && imu < r->fft->get_num_imus(); imu++) {
+                hal.console->printf("%-10s  IMU%u error after %.2fHz\n", "", imu,
+                                    r->imu_error_sum[imu] / MAX(r->imu_error_count, 1U));
+            }
+        }
+    }
+
+    Result sequential;
+    Result parallel;
+    uint32_t last_output_ms;
+    uint32_t armed_ms;
+    bool step_applied;
+    bool reported;
+};
+
+static ReplayGyroFFT replay;
+
+void setup()
+{
+    hal.console->printf("ReplayGyroFFTLatency\n");
+    board_config.init();
+    serial_manager.init();
+
+    sitl.vibe_freq.set(Vector3f(START_FREQ_HZ, START_FREQ_HZ, START_FREQ_HZ));  // SIM_VIB_FREQ
+    sitl.drift_speed.set(0);    // SIM_DRIFT_SPEED
+    sitl.drift_time.set(0);     // SIM_DRIFT_TIME
+    sitl.gyro_noise[0].set(20); // SIM_GYR1_RND
+    sitl.gyro_noise[1].set(20); // SIM_GYR2_RND
+
+    logger.Init(log_structure, ARRAY_SIZE(log_structure));
+    ins.init(LOOP_RATE_HZ);
+    baro.init();
+
+    replay.init();
+}
+
+void loop()
+{
+    if (!hal.console->is_initialized()) {
+        return;
+    }
+
+    ins.wait_for_sample();
+    uint32_t sample_time_us = AP_HAL::micros();
+
+    ins.update();
+    ins.periodic();
+    logger.periodic_tasks();
+    replay.loop();
+
+    uint32_t elapsed = AP_HAL::micros() - sample_time_us;
+    if (elapsed < LOOP_DELTA_US) {
+        hal.scheduler->delay_microseconds(LOOP_DELTA_US - elapsed);
+    }
+
+    if (replay.reported) {
+        exit(0);
+    }
+}
+
+AP_HAL_MAIN();
+
+#else
+
+#include <stdio.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static void loop() { }
+static void setup()
+{
+    printf("Board not currently supported\n");
+}
+
+AP_HAL_MAIN();
+
+#endif
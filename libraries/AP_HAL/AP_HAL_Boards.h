@@ -199,6 +199,17 @@
 #define HAL_WITH_DSP HAL_GYROFFT_ENABLED
 #endif
 
+// vectorised real FFT used by the DSP drivers of native builds
+#ifndef HAL_WITH_NATIVE_FFT
+#define HAL_WITH_NATIVE_FFT (HAL_WITH_DSP && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
+// gyro FFT analysis of each axis and IMU in parallel threads, SITL
+// only until a latency gain over the sequential analysis is shown
+#ifndef HAL_GYROFFT_PARALLEL_ENABLED
+#define HAL_GYROFFT_PARALLEL_ENABLED (HAL_GYROFFT_ENABLED && CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
 #ifndef HAL_OS_FATFS_IO
 #define HAL_OS_FATFS_IO 0
 #endif
@@ -18,6 +18,7 @@
 #include <AP_Math/AP_Math.h>
 #include "AP_HAL.h"
 #include "DSP.h"
+#include "utility/SlidingDFT.h"
 #ifndef HAL_NO_UARTDRIVER
 #include <GCS_MAVLink/GCS.h>
 #endif
@@ -371,6 +372,37 @@ uint16_t DSP::fft_stop_average(FFTWindowState* fft, uint16_t start_bin, uint16_t
     return numpeaks;
 }
 
+// slide a DFT over all of the samples in a buffer
+void DSP::sdft_update(SlidingDFT& sdft, FloatBuffer& samples, uint16_t start_bin, uint16_t end_bin)
+{
+    // the Hann window needs the bins either side of those analysed, which
+    // reach one bin below start_bin and three above end_bin for peak detection
+    sdft.set_bin_range(start_bin > 2 ? start_bin - 2 : 0, end_bin + 4);
+
+    float block[32];
+    uint32_t n;
+    while ((n = samples.peek(block, ARRAY_SIZE(block))) > 0) {
+        samples.advance(n);
+        sdft.update(block, n);
+    }
+}
+
+// perform the analysis steps of an FFT using the output of a sliding DFT
+uint16_t DSP::sdft_analyse(FFTWindowState* fft, const SlidingDFT& sdft, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    // only the analysed bins have energy, the rest are left empty for averaging and noise calibration
+    memset(fft->_freq_bins, 0, sizeof(float) * fft->_num_stored_freqs);
+    const uint16_t first_bin = start_bin > 0 ? start_bin - 1 : 0;
+    const uint16_t last_bin = MIN(end_bin + 3, fft->_bin_count);
+    // window and store the complex bins where step_calc_frequencies() expects the FFT output
+    sdft.hann(fft->_rfft_data, first_bin, last_bin);
+    for (uint16_t k = first_bin; k <= last_bin; k++) {
+        fft->_freq_bins[k] = sq(fft->_rfft_data[2*k]) + sq(fft->_rfft_data[2*k+1]);
+    }
+    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(fft, start_bin, end_bin);
+}
+
 // find all the peaks in the fft window using https://terpconnect.umd.edu/~toh/spectrum/PeakFindingandMeasurement.htm
 // in general peakgrup > 2 is only good for very broad noisy peaks, <= 2 better for spikey peaks, although 1 will miss
 // a true spike 50% of the time
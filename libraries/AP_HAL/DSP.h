@@ -27,6 +27,8 @@
 // Maximum tolerated number of cycles with missing signal
 #define FFT_MAX_MISSED_UPDATES 5
 
+class SlidingDFT;
+
 class AP_HAL::DSP {
 #if HAL_WITH_DSP
 public:
@@ -100,6 +102,10 @@ public:
     bool fft_start_average(FFTWindowState* fft);
     // finish the averaging process
     uint16_t fft_stop_average(FFTWindowState* fft, uint16_t start_bin, uint16_t end_bin, float* peaks);
+    // slide a DFT over all of the samples in a buffer, tracking the bins needed to analyse start_bin to end_bin
+    void sdft_update(SlidingDFT& sdft, FloatBuffer& samples, uint16_t start_bin, uint16_t end_bin);
+    // perform the analysis steps of an FFT using the output of a sliding DFT with the same window size
+    uint16_t sdft_analyse(FFTWindowState* state, const SlidingDFT& sdft, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff);
 
 protected:
     // step 3: find the magnitudes of the complex data
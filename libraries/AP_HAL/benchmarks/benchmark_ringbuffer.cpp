@@ -0,0 +1,121 @@
+/*
+  throughput of the semaphore protected ObjectBuffer_TS against the
+  lock free single producer/single consumer ObjectBuffer_SPSC
+ */
+#include <AP_gbenchmark.h>
+
+#include <thread>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint32_t buffer_size = 1024;
+static const uint32_t block_size = 64;
+
+/*
+  push and pop one object at a time from a single thread, which
+  measures the per-call overhead
+ */
+static void BM_ObjectBufferTSPushPop(benchmark::State& state)
+{
+    ObjectBuffer_TS<uint32_t> buf{buffer_size};
+    uint32_t v = 0;
+    while (state.KeepRunning()) {
+        buf.push(v);
+        if (!buf.pop(v)) {
+            state.SkipWithError("pop failed");
+        }
+        gbenchmark_escape(&v);
+    }
+}
+BENCHMARK(BM_ObjectBufferTSPushPop);
+
+static void BM_ObjectBufferSPSCPushPop(benchmark::State& state)
+{
+    ObjectBuffer_SPSC<uint32_t> buf{buffer_size};
+    uint32_t v = 0;
+    while (state.KeepRunning()) {
+        buf.push(v);
+        if (!buf.pop(v)) {
+            state.SkipWithError("pop failed");
+        }
+        gbenchmark_escape(&v);
+    }
+}
+BENCHMARK(BM_ObjectBufferSPSCPushPop);
+
+/*
+  bulk transfer of bytes as done by the UART drivers
+ */
+static void BM_ByteBufferBulk(benchmark::State& state)
+{
+    ByteBuffer buf{buffer_size};
+    uint8_t data[block_size] {};
+    while (state.KeepRunning()) {
+        buf.write(data, sizeof(data));
+        buf.read(data, sizeof(data));
+        gbenchmark_escape(data);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(data));
+}
+BENCHMARK(BM_ByteBufferBulk);
+
+static void BM_ByteBufferSPSCBulk(benchmark::State& state)
+{
+    ByteBuffer_SPSC buf{buffer_size};
+    uint8_t data[block_size] {};
+    while (state.KeepRunning()) {
+        buf.push(data, sizeof(data));
+        buf.pop(data, sizeof(data));
+        gbenchmark_escape(data);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(data));
+}
+BENCHMARK(BM_ByteBufferSPSCBulk);
+
+/*
+  one producer thread and one consumer thread moving objects through
+  the buffer, reporting the number of objects moved per second
+ */
+template <class Buffer>
+static void producer_consumer(benchmark::State& state)
+{
+    const uint32_t count = 100000;
+    while (state.KeepRunning()) {
+        Buffer buf{buffer_size};
+        std::thread producer([&buf, count]() {
+            for (uint32_t i=0; i<count; ) {
+                if (buf.push(i)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (uint32_t i=0; i<count; ) {
+            uint32_t v;
+            if (buf.pop(v)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * count);
+}
+
+static void BM_ObjectBufferTSThreads(benchmark::State& state)
+{
+    producer_consumer<ObjectBuffer_TS<uint32_t>>(state);
+}
+BENCHMARK(BM_ObjectBufferTSThreads)->UseRealTime();
+
+static void BM_ObjectBufferSPSCThreads(benchmark::State& state)
+{
+    producer_consumer<ObjectBuffer_SPSC<uint32_t>>(state);
+}
+BENCHMARK(BM_ObjectBufferSPSCThreads)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,343 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#pragma GCC optimize("O2")
+#endif
+
+#include "RealFFT.h"
+
+#if HAL_WITH_NATIVE_FFT
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  four floats operated on together. The compiler turns arithmetic on
+  this type into SSE instructions on x86 and NEON on ARM
+ */
+typedef float vec4 __attribute__((vector_size(16)));
+typedef int32_t vec4i __attribute__((vector_size(16)));
+
+static inline void load(float &v, const float* p) { v = *p; }
+static inline void load(vec4 &v, const float* p) { memcpy(&v, p, sizeof(v)); }
+static inline void store(float* p, const float &v) { *p = v; }
+static inline void store(float* p, const vec4 &v) { memcpy(p, &v, sizeof(v)); }
+
+RealFFT::~RealFFT()
+{
+    free(_mem);
+}
+
+/*
+  The real FFT of N samples is calculated from a complex FFT of N/2
+  samples, the even samples forming the real part and the odd samples
+  the imaginary part.
+
+  The complex FFT is a decimation in frequency radix-4 FFT, with a
+  final radix-2 stage if N/2 is an odd power of 2. Each radix-4 stage
+  of span L has L/4 butterflies per block, using twiddles W^j, W^2j
+  and W^3j where W = exp(-2*pi*i/L). These are stored for each stage
+  in turn as L/4 cosines and sines for each of the three twiddles, so
+  that the butterflies of a block can be done four at a time with
+  contiguous loads.
+ */
+bool RealFFT::init(uint16_t length)
+{
+    if (length < 8 || (length & (length - 1)) != 0) {
+        return false;
+    }
+    if (length == _length) {
+        return true;
+    }
+    free(_mem);
+    _mem = nullptr;
+    _length = 0;
+
+    const uint16_t half = length / 2;
+    uint32_t num_twiddles = 0;
+    for (uint16_t span = half; span >= 4; span /= 4) {
+        num_twiddles += 6 * (span / 4);
+    }
+    const uint32_t num_floats = 2 * half + num_twiddles + 2 * (half + 1);
+    _mem = calloc(1, num_floats * sizeof(float) + half * sizeof(uint16_t));
+    if (_mem == nullptr) {
+        return false;
+    }
+    float* f = (float*)_mem;
+    _re = f;
+    _im = _re + half;
+    _twiddles = _im + half;
+    _post_cos = _twiddles + num_twiddles;
+    _post_sin = _post_cos + half + 1;
+    _bitrev = (uint16_t*)(_post_sin + half + 1);
+
+    float* tw = _twiddles;
+    for (uint16_t span = half; span >= 4; span /= 4) {
+        const uint16_t q = span / 4;
+        for (uint16_t j = 0; j < q; j++) {
+            for (uint8_t m = 1; m <= 3; m++) {
+                const double angle = -2.0 * M_PI * m * j / span;
+                tw[(m-1)*2*q + j] = cos(angle);
+                tw[(m-1)*2*q + q + j] = sin(angle);
+            }
+        }
+        tw += 6 * q;
+    }
+
+    for (uint16_t k = 0; k <= half; k++) {
+        _post_cos[k] = cos(2.0 * M_PI * k / length);
+        _post_sin[k] = sin(2.0 * M_PI * k / length);
+    }
+
+    uint8_t bits = 0;
+    while ((1U << bits) < half) {
+        bits++;
+    }
+    for (uint16_t k = 0; k < half; k++) {
+        uint16_t r = 0;
+        for (uint8_t b = 0; b < bits; b++) {
+            if (k & (1U << b)) {
+                r |= 1U << (bits - 1 - b);
+            }
+        }
+        _bitrev[k] = r;
+    }
+
+    _length = length;
+    _half_length = half;
+    return true;
+}
+
+/*
+  radix-4 butterflies for every block of one stage, a float or vec4 at
+  a time
+ */
+template <typename T>
+void RealFFT::radix4_stage(uint16_t span, const float* twiddles)
+{
+    const uint16_t q = span / 4;
+    const uint8_t step = sizeof(T) / sizeof(float);
+    const float* w1r = twiddles;
+    const float* w1i = w1r + q;
+    const float* w2r = w1i + q;
+    const float* w2i = w2r + q;
+    const float* w3r = w2i + q;
+    const float* w3i = w3r + q;
+
+    for (uint16_t b = 0; b < _half_length; b += span) {
+        float* re = &_re[b];
+        float* im = &_im[b];
+        for (uint16_t j = 0; j < q; j += step) {
+            T a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i;
+            load(a0r, &re[j]);       load(a0i, &im[j]);
+            load(a1r, &re[j+q]);     load(a1i, &im[j+q]);
+            load(a2r, &re[j+2*q]);   load(a2i, &im[j+2*q]);
+            load(a3r, &re[j+3*q]);   load(a3i, &im[j+3*q]);
+
+            const T t0r = a0r + a2r, t0i = a0i + a2i;
+            const T t1r = a0r - a2r, t1i = a0i - a2i;
+            const T t2r = a1r + a3r, t2i = a1i + a3i;
+            // -i * (a1 - a3)
+            const T t3r = a1i - a3i, t3i = a3r - a1r;
+
+            store(&re[j], t0r + t2r);
+            store(&im[j], t0i + t2i);
+
+            T wr, wi, xr, xi;
+            // outputs are stored in bit reversed order
+            xr = t0r - t2r; xi = t0i - t2i;
+            load(wr, &w2r[j]); load(wi, &w2i[j]);
+            store(&re[j+q], xr*wr - xi*wi);
+            store(&im[j+q], xr*wi + xi*wr);
+
+            xr = t1r + t3r; xi = t1i + t3i;
+            load(wr, &w1r[j]); load(wi, &w1i[j]);
+            store(&re[j+2*q], xr*wr - xi*wi);
+            store(&im[j+2*q], xr*wi + xi*wr);
+
+            xr = t1r - t3r; xi = t1i - t3i;
+            load(wr, &w3r[j]); load(wi, &w3i[j]);
+            store(&re[j+3*q], xr*wr - xi*wi);
+            store(&im[j+3*q], xr*wi + xi*wr);
+        }
+    }
+}
+
+// final radix-2 stage, with twiddles of 1
+void RealFFT::radix2_stage()
+{
+    for (uint16_t b = 0; b < _half_length; b += 2) {
+        const float pr = _re[b], pi = _im[b];
+        const float qr = _re[b+1], qi = _im[b+1];
+        _re[b] = pr + qr;
+        _im[b] = pi + qi;
+        _re[b+1] = pr - qr;
+        _im[b+1] = pi - qi;
+    }
+}
+
+void RealFFT::forward(const float* input, float* output)
+{
+    const uint16_t half = _half_length;
+    for (uint16_t n = 0; n < half; n++) {
+        _re[n] = input[2*n];
+        _im[n] = input[2*n+1];
+    }
+
+    const float* tw = _twiddles;
+    uint16_t span = half;
+    for (; span >= 4; span /= 4) {
+        if (span >= 16) {
+            radix4_stage<vec4>(span, tw);
+        } else {
+            radix4_stage<float>(span, tw);
+        }
+        tw += 6 * (span / 4);
+    }
+    if (span == 2) {
+        radix2_stage();
+    }
+
+    /*
+      separate the FFTs of the even and odd samples, E and O, from
+      the complex FFT Z, then combine them:
+        E[k] = (Z[k] + conj(Z[N/2-k])) / 2
+        O[k] = (Z[k] - conj(Z[N/2-k])) / 2i
+        X[k] = E[k] + exp(-2*pi*i*k/N) * O[k]
+     */
+    const float z0r = _re[0], z0i = _im[0];
+    output[0] = z0r + z0i;
+    output[1] = 0;
+    output[2*half] = z0r - z0i;
+    output[2*half+1] = 0;
+    for (uint16_t k = 1; k < half; k++) {
+        const uint16_t a = _bitrev[k], b = _bitrev[half - k];
+        const float zkr = _re[a], zki = _im[a];
+        const float zmr = _re[b], zmi = _im[b];
+        const float er = 0.5f * (zkr + zmr);
+        const float ei = 0.5f * (zki - zmi);
+        const float orr = 0.5f * (zki + zmi);
+        const float oi = 0.5f * (zmr - zkr);
+        const float c = _post_cos[k], s = _post_sin[k];
+        output[2*k] = er + c*orr + s*oi;
+        output[2*k+1] = ei + c*oi - s*orr;
+    }
+}
+
+void RealFFT::vector_mul(const float* v1, const float* v2, float* vout, uint16_t len)
+{
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        vec4 a, b;
+        load(a, &v1[i]);
+        load(b, &v2[i]);
+        store(&vout[i], a * b);
+    }
+    for (; i < len; i++) {
+        vout[i] = v1[i] * v2[i];
+    }
+}
+
+void RealFFT::vector_scale(const float* vin, float scale, float* vout, uint16_t len)
+{
+    const vec4 s { scale, scale, scale, scale };
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        vec4 a;
+        load(a, &vin[i]);
+        store(&vout[i], a * s);
+    }
+    for (; i < len; i++) {
+        vout[i] = vin[i] * scale;
+    }
+}
+
+void RealFFT::vector_add(const float* vin1, const float* vin2, float* vout, uint16_t len)
+{
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        vec4 a, b;
+        load(a, &vin1[i]);
+        load(b, &vin2[i]);
+        store(&vout[i], a + b);
+    }
+    for (; i < len; i++) {
+        vout[i] = vin1[i] + vin2[i];
+    }
+}
+
+float RealFFT::vector_sum(const float* vin, uint16_t len)
+{
+    vec4 sum {};
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        vec4 a;
+        load(a, &vin[i]);
+        sum += a;
+    }
+    float total = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < len; i++) {
+        total += vin[i];
+    }
+    return total;
+}
+
+void RealFFT::vector_max(const float* vin, uint16_t len, float* max_value, uint16_t* max_index)
+{
+    // find the maximum four lanes at a time, then the first index
+    // holding it
+    float m = vin[0];
+    uint16_t i = 0;
+    if (len >= 4) {
+        vec4 vmax;
+        load(vmax, &vin[0]);
+        for (i = 4; i + 4 <= len; i += 4) {
+            vec4 a;
+            load(a, &vin[i]);
+            const vec4i greater = a > vmax;
+            vmax = (vec4)((greater & (vec4i)a) | (~greater & (vec4i)vmax));
+        }
+        for (uint8_t l = 0; l < 4; l++) {
+            if (vmax[l] > m) {
+                m = vmax[l];
+            }
+        }
+    }
+    for (; i < len; i++) {
+        if (vin[i] > m) {
+            m = vin[i];
+        }
+    }
+    *max_value = m;
+    *max_index = 0;
+    for (i = 0; i < len; i++) {
+        if (vin[i] == m) {
+            *max_index = i;
+            break;
+        }
+    }
+}
+
+void RealFFT::complex_mag_squared(const float* cmplx, float* vout, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        const float re = cmplx[2*i], im = cmplx[2*i+1];
+        vout[i] = re*re + im*im;
+    }
+}
+
+#endif // HAL_WITH_NATIVE_FFT
@@ -0,0 +1,79 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  real FFT and vector operations for the DSP drivers of native
+  (SITL and Linux) builds, vectorised four floats at a time with SSE on
+  x86 and NEON on ARM
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#if HAL_WITH_NATIVE_FFT
+
+#include <stdint.h>
+
+class RealFFT {
+public:
+    RealFFT() {}
+    ~RealFFT();
+
+    RealFFT(const RealFFT &other) = delete;
+    RealFFT &operator=(const RealFFT&) = delete;
+
+    // prepare the tables for a power of 2 length of at least 8 samples
+    bool init(uint16_t length);
+
+    uint16_t length() const { return _length; }
+
+    // FFT of length real samples. The output holds the length/2 + 1
+    // bins from DC to nyquist as real, imaginary pairs
+    void forward(const float* input, float* output);
+
+    // vector operations, any of the outputs may be the same as an input
+    static void vector_mul(const float* v1, const float* v2, float* vout, uint16_t len);
+    static void vector_scale(const float* vin, float scale, float* vout, uint16_t len);
+    static void vector_add(const float* vin1, const float* vin2, float* vout, uint16_t len);
+    static float vector_sum(const float* vin, uint16_t len);
+    // value and first index of the maximum
+    static void vector_max(const float* vin, uint16_t len, float* max_value, uint16_t* max_index);
+    // squared magnitudes of len complex values held as real, imaginary pairs
+    static void complex_mag_squared(const float* cmplx, float* vout, uint16_t len);
+
+private:
+    template <typename T>
+    void radix4_stage(uint16_t span, const float* twiddles);
+    void radix2_stage();
+
+    // number of real samples, and the length of the complex FFT
+    // used to calculate it
+    uint16_t _length = 0;
+    uint16_t _half_length = 0;
+
+    // complex FFT data held as separate real and imaginary arrays
+    float* _re = nullptr;
+    float* _im = nullptr;
+    // radix-4 twiddles for each stage, see init()
+    float* _twiddles = nullptr;
+    // twiddles combining the complex FFT into the real FFT
+    float* _post_cos = nullptr;
+    float* _post_sin = nullptr;
+    // bit reversed index of each complex FFT bin
+    uint16_t* _bitrev = nullptr;
+    // all of the above in one allocation
+    void* _mem = nullptr;
+};
+
+#endif // HAL_WITH_NATIVE_FFT
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <stdint.h>
+#include <string.h>
 #include <AP_HAL/AP_HAL_Boards.h>
 #include <AP_HAL/AP_HAL_Macros.h>
 #include <AP_HAL/Semaphores.h>
@@ -461,6 +462,243 @@ private:
     HAL_Semaphore sem;
 };
 
+/*
+  lock free ring buffer class for objects of fixed size, for use when
+  exactly one thread pushes and exactly one thread pops. This avoids
+  the semaphore of ObjectBuffer_TS on paths such as UART and CAN
+  receive where a driver thread fills the buffer and a single reader
+  drains it.
+
+  Only the producer thread may call push(), reserve() and commit().
+  Only the consumer thread may call pop(), peek(), readptr(), advance()
+  and clear(). There is no push_force() or set_size() as those would
+  need the producer to move the read pointer.
+ */
+template <class T>
+class ObjectBuffer_SPSC {
+public:
+    ObjectBuffer_SPSC(uint32_t _size) {
+        // one slot is always left empty so that a full buffer can be
+        // told apart from an empty one
+        buffer = new T[_size+1];
+        size = buffer ? _size+1 : 0;
+    }
+    ~ObjectBuffer_SPSC(void) {
+        delete[] buffer;
+    }
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const {
+        return size>0?size-1:0;
+    }
+
+    // return number of objects available to be read from the front of the queue
+    uint32_t available(void) const {
+        return used(head.load(std::memory_order_acquire), tail.load(std::memory_order_acquire));
+    }
+
+    // return number of objects that could be written to the back of the queue
+    uint32_t space(void) const {
+        return free_space(head.load(std::memory_order_acquire), tail.load(std::memory_order_acquire));
+    }
+
+    // true is available() == 0
+    bool is_empty(void) const WARN_IF_UNUSED {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    /*
+      producer methods
+     */
+
+    // push one object onto the back of the queue
+    bool push(const T &object) {
+        const uint32_t _tail = tail.load(std::memory_order_relaxed);
+        if (free_space(head_cache, _tail) == 0) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (free_space(head_cache, _tail) == 0) {
+                return false;
+            }
+        }
+        buffer[_tail] = object;
+        tail.store(wrap(_tail + 1), std::memory_order_release);
+        return true;
+    }
+
+    // push N objects onto the back of the queue. Either all of the
+    // objects are pushed or none are
+    bool push(const T *object, uint32_t n) {
+        IoVec vec[2];
+        const uint8_t nvec = reserve(vec, n);
+        if (nvec == 0 || vec[0].len + (nvec>1?vec[1].len:0) != n) {
+            return false;
+        }
+        for (uint8_t i=0; i<nvec; i++) {
+            memcpy((void*)vec[i].data, object, vec[i].len * sizeof(T));
+            object += vec[i].len;
+        }
+        return commit(n);
+    }
+
+    // Reserve up to n objects at the back of the queue and fill out
+    // vec with one or two contiguous parts to be written in place.
+    // Returns the number of vec elements filled out. The objects only
+    // become visible to the consumer once commit() is called.
+    struct IoVec {
+        T *data;
+        uint32_t len;
+    };
+    uint8_t reserve(IoVec vec[2], uint32_t n) {
+        const uint32_t _tail = tail.load(std::memory_order_relaxed);
+        head_cache = head.load(std::memory_order_acquire);
+        const uint32_t _space = free_space(head_cache, _tail);
+        if (n > _space) {
+            n = _space;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t n1 = n < size - _tail ? n : size - _tail;
+        vec[0].data = &buffer[_tail];
+        vec[0].len = n1;
+        if (n1 == n) {
+            return 1;
+        }
+        vec[1].data = &buffer[0];
+        vec[1].len = n - n1;
+        return 2;
+    }
+
+    // make n objects written into the space returned by reserve()
+    // available to the consumer
+    bool commit(uint32_t n) {
+        const uint32_t _tail = tail.load(std::memory_order_relaxed);
+        if (n > free_space(head_cache, _tail)) {
+            return false;
+        }
+        tail.store(wrap(_tail + n), std::memory_order_release);
+        return true;
+    }
+
+    /*
+      consumer methods
+     */
+
+    // pop earliest object off the front of the queue
+    bool pop(T &object) WARN_IF_UNUSED {
+        if (!peek(object)) {
+            return false;
+        }
+        head.store(wrap(head.load(std::memory_order_relaxed) + 1), std::memory_order_release);
+        return true;
+    }
+
+    // pop up to n objects off the front of the queue, returning the
+    // number of objects popped
+    uint32_t pop(T *object, uint32_t n) {
+        uint32_t ret = 0;
+        while (ret < n) {
+            uint32_t avail;
+            const T *ptr = readptr(avail);
+            if (ptr == nullptr) {
+                break;
+            }
+            if (avail > n - ret) {
+                avail = n - ret;
+            }
+            memcpy((void*)&object[ret], ptr, avail * sizeof(T));
+            advance(avail);
+            ret += avail;
+        }
+        return ret;
+    }
+
+    // throw away an object from the front of the queue
+    bool pop(void) {
+        return advance(1);
+    }
+
+    // peek copies an object out from the front of the queue without
+    // advancing the read pointer
+    bool peek(T &object) WARN_IF_UNUSED {
+        const uint32_t _head = head.load(std::memory_order_relaxed);
+        if (used(_head, tail_cache) == 0) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (used(_head, tail_cache) == 0) {
+                return false;
+            }
+        }
+        object = buffer[_head];
+        return true;
+    }
+
+    /*
+      return a pointer to first contiguous array of available
+      objects. Return nullptr if none available
+     */
+    const T *readptr(uint32_t &n) {
+        const uint32_t _head = head.load(std::memory_order_relaxed);
+        tail_cache = tail.load(std::memory_order_acquire);
+        const uint32_t avail = used(_head, tail_cache);
+        if (avail == 0) {
+            return nullptr;
+        }
+        n = avail < size - _head ? avail : size - _head;
+        return &buffer[_head];
+    }
+
+    // advance the read pointer (discarding objects)
+    bool advance(uint32_t n) {
+        const uint32_t _head = head.load(std::memory_order_relaxed);
+        if (n > used(_head, tail_cache)) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (n > used(_head, tail_cache)) {
+                return false;
+            }
+        }
+        head.store(wrap(_head + n), std::memory_order_release);
+        return true;
+    }
+
+    // Discards the buffer content, emptying it
+    void clear(void) {
+        tail_cache = tail.load(std::memory_order_acquire);
+        head.store(tail_cache, std::memory_order_release);
+    }
+
+private:
+    uint32_t wrap(uint32_t idx) const {
+        return idx >= size ? idx - size : idx;
+    }
+    uint32_t used(uint32_t _head, uint32_t _tail) const {
+        return _tail >= _head ? _tail - _head : size + _tail - _head;
+    }
+    uint32_t free_space(uint32_t _head, uint32_t _tail) const {
+        return size>0 ? size - 1 - used(_head, _tail) : 0;
+    }
+
+    // the indices are kept on separate cache lines from each other
+    // and from the shared read-only members, so the producer and
+    // consumer threads don't keep stealing the same line. Each side
+    // also keeps a cached copy of the other side's index to avoid
+    // touching the other line on every access
+    static const uint8_t cache_line_size = 64;
+
+    T *buffer;
+    uint32_t size;
+    uint8_t _pad0[cache_line_size];
+
+    // written by the consumer
+    std::atomic<uint32_t> head{0};
+    uint32_t tail_cache = 0;
+    uint8_t _pad1[cache_line_size - 2*sizeof(uint32_t)];
+
+    // written by the producer
+    std::atomic<uint32_t> tail{0};
+    uint32_t head_cache = 0;
+    uint8_t _pad2[cache_line_size - 2*sizeof(uint32_t)];
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
@@ -591,4 +829,5 @@ private:
 
 typedef ObjectBuffer<float> FloatBuffer;
 typedef ObjectBuffer_TS<float> FloatBuffer_TS;
+typedef ObjectBuffer_SPSC<uint8_t> ByteBuffer_SPSC;
 typedef ObjectArray<float> FloatArray;
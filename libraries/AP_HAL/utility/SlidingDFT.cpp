@@ -0,0 +1,193 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SlidingDFT.h"
+
+#if HAL_WITH_DSP
+
+#include <math.h>
+#include <stdlib.h>
+
+// number of samples processed a bin at a time by update()
+#define SDFT_BLOCK_SIZE 32
+
+SlidingDFT::~SlidingDFT()
+{
+    free(_mem);
+}
+
+bool SlidingDFT::init(uint16_t window_size)
+{
+    if (window_size < 8 || (window_size & (window_size - 1)) != 0) {
+        return false;
+    }
+    const uint16_t num_bins = window_size / 2 + 1;
+    void* mem = calloc(window_size + 4 * num_bins, sizeof(float));
+    if (mem == nullptr) {
+        return false;
+    }
+    free(_mem);
+    _mem = mem;
+    _window = (float*)mem;
+    _bins = _window + window_size;
+    _twiddles = _bins + 2 * num_bins;
+    _window_size = window_size;
+    _head = 0;
+    _tracking = false;
+
+    for (uint16_t k = 0; k < num_bins; k++) {
+        const double angle = 2 * M_PI * k / window_size;
+        _twiddles[2*k] = cos(angle);
+        _twiddles[2*k+1] = sin(angle);
+    }
+    return true;
+}
+
+/*
+  calculate a bin directly from the window, which takes window_size
+  steps
+ */
+void SlidingDFT::calculate_bin(uint16_t bin)
+{
+    const uint16_t mask = _window_size - 1;
+    const uint16_t half = _window_size / 2;
+    float re = 0, im = 0;
+    uint16_t idx = 0;
+    for (uint16_t m = 0; m < _window_size; m++) {
+        // exp(-2*pi*i*idx/N) from the twiddles of the first half of the circle
+        float c, s;
+        if (idx <= half) {
+            c = _twiddles[2*idx];
+            s = -_twiddles[2*idx+1];
+        } else {
+            c = _twiddles[2*(_window_size - idx)];
+            s = _twiddles[2*(_window_size - idx)+1];
+        }
+        const float x = _window[(_head + m) & mask];
+        re += x * c;
+        im += x * s;
+        idx = (idx + bin) & mask;
+    }
+    _bins[2*bin] = re;
+    _bins[2*bin+1] = im;
+}
+
+void SlidingDFT::set_bin_range(uint16_t start_bin, uint16_t end_bin)
+{
+    if (_window_size == 0) {
+        return;
+    }
+    end_bin = end_bin < _window_size / 2 ? end_bin : _window_size / 2;
+    start_bin = start_bin < end_bin ? start_bin : end_bin;
+    if (_tracking && start_bin == _start_bin && end_bin == _end_bin) {
+        return;
+    }
+    for (uint16_t k = start_bin; k <= end_bin; k++) {
+        if (!_tracking || k < _start_bin || k > _end_bin) {
+            calculate_bin(k);
+        }
+    }
+    _start_bin = start_bin;
+    _end_bin = end_bin;
+    _tracking = true;
+    if (_refresh_bin < _start_bin || _refresh_bin > _end_bin) {
+        _refresh_bin = _start_bin;
+    }
+}
+
+/*
+  Removing the oldest sample x(n-N) and adding x(n) gives
+
+    X'(k) = exp(2*pi*i*k/N) * (X(k) + x(n) - x(n-N))
+
+  Rounding error in the recurrence can build up without limit, so one
+  bin is recalculated from the window each time the window has been
+  completely replaced. This costs window_size steps once per
+  window_size samples, and refreshes every bin well before the error
+  becomes significant.
+ */
+void SlidingDFT::update(const float* samples, uint16_t count)
+{
+    if (!_tracking) {
+        return;
+    }
+    const uint16_t mask = _window_size - 1;
+    float delta[SDFT_BLOCK_SIZE];
+
+    while (count > 0) {
+        const uint16_t n = count < SDFT_BLOCK_SIZE ? count : SDFT_BLOCK_SIZE;
+        const uint16_t old_head = _head;
+        for (uint16_t i = 0; i < n; i++) {
+            delta[i] = samples[i] - _window[_head];
+            _window[_head] = samples[i];
+            _head = (_head + 1) & mask;
+        }
+
+        for (uint16_t k = _start_bin; k <= _end_bin; k++) {
+            const float c = _twiddles[2*k];
+            const float s = _twiddles[2*k+1];
+            float re = _bins[2*k];
+            float im = _bins[2*k+1];
+            for (uint16_t i = 0; i < n; i++) {
+                const float r = re + delta[i];
+                re = r * c - im * s;
+                im = r * s + im * c;
+            }
+            _bins[2*k] = re;
+            _bins[2*k+1] = im;
+        }
+
+        // the window has wrapped
+        if (_head <= old_head) {
+            calculate_bin(_refresh_bin);
+            _refresh_bin = _refresh_bin < _end_bin ? _refresh_bin + 1 : _start_bin;
+        }
+        samples += n;
+        count -= n;
+    }
+}
+
+void SlidingDFT::get_bin(int16_t bin, float& re, float& im) const
+{
+    // the DFT of real data is conjugate symmetric
+    if (bin < 0) {
+        re = _bins[-2*bin];
+        im = -_bins[-2*bin+1];
+    } else if (bin > _window_size / 2) {
+        re = _bins[2*(_window_size - bin)];
+        im = -_bins[2*(_window_size - bin)+1];
+    } else {
+        re = _bins[2*bin];
+        im = _bins[2*bin+1];
+    }
+}
+
+/*
+  a Hann window of 0.5 - 0.5*cos(2*pi*n/N) is applied in the frequency
+  domain, where it is a convolution with (-0.25, 0.5, -0.25)
+ */
+void SlidingDFT::hann(float* output, uint16_t start_bin, uint16_t end_bin) const
+{
+    for (uint16_t k = start_bin; k <= end_bin; k++) {
+        float re_m1, im_m1, re, im, re_p1, im_p1;
+        get_bin(int16_t(k) - 1, re_m1, im_m1);
+        get_bin(k, re, im);
+        get_bin(k + 1, re_p1, im_p1);
+        output[2*k] = 0.5f * re - 0.25f * (re_m1 + re_p1);
+        output[2*k+1] = 0.5f * im - 0.25f * (im_m1 + im_p1);
+    }
+}
+
+#endif // HAL_WITH_DSP
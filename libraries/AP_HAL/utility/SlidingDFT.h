@@ -0,0 +1,86 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  sliding DFT of a range of bins, updated a sample at a time at a cost
+  proportional to the number of bins rather than the window size
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#if HAL_WITH_DSP
+
+#include <stdint.h>
+
+class SlidingDFT {
+public:
+    SlidingDFT() {}
+    ~SlidingDFT();
+
+    SlidingDFT(const SlidingDFT &other) = delete;
+    SlidingDFT &operator=(const SlidingDFT&) = delete;
+
+    // prepare for a power of 2 window of at least 8 samples. The
+    // window starts full of zeros
+    bool init(uint16_t window_size);
+
+    uint16_t window_size() const { return _window_size; }
+    uint16_t start_bin() const { return _start_bin; }
+    uint16_t end_bin() const { return _end_bin; }
+
+    // track bins start_bin to end_bin, at most window_size/2. Bins
+    // that were not already tracked are calculated from the window
+    void set_bin_range(uint16_t start_bin, uint16_t end_bin);
+
+    // slide the window on by count samples
+    void update(const float* samples, uint16_t count);
+
+    // DFT of the window, the same as an FFT of the window with the
+    // oldest sample first. Bins are real, imaginary pairs and only the
+    // tracked bins are valid
+    const float* bins() const { return _bins; }
+
+    // DFT of the window with a Hann window applied, for bins
+    // start_bin to end_bin as real, imaginary pairs indexed by bin. The
+    // neighbours of each bin must be tracked, apart from those beyond
+    // DC and nyquist
+    void hann(float* output, uint16_t start_bin, uint16_t end_bin) const;
+
+private:
+    void calculate_bin(uint16_t bin);
+    // real and imaginary part of a tracked bin, reflecting bins beyond
+    // DC and nyquist
+    void get_bin(int16_t bin, float& re, float& im) const;
+
+    uint16_t _window_size = 0;
+    // the last window_size samples, oldest first from _head
+    float* _window = nullptr;
+    uint16_t _head = 0;
+    // window_size/2 + 1 bins from DC to nyquist as real, imaginary pairs
+    float* _bins = nullptr;
+    // exp(2*pi*i*k/N) for each bin k as real, imaginary pairs
+    float* _twiddles = nullptr;
+    // tracked bins
+    uint16_t _start_bin = 0;
+    uint16_t _end_bin = 0;
+    bool _tracking = false;
+    // next bin to be recalculated from the window, clearing rounding
+    // error built up by the recurrence
+    uint16_t _refresh_bin = 0;
+    // all of the above in one allocation
+    void* _mem = nullptr;
+};
+
+#endif // HAL_WITH_DSP
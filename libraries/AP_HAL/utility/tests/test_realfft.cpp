@@ -0,0 +1,123 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/RealFFT.h>
+#include <math.h>
+
+#if HAL_WITH_NATIVE_FFT
+
+// repeatable random value in the range -1 to 1
+static float rand_value(uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+TEST(RealFFTTest, Init)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(4));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_EQ(fft.length(), 0U);
+    EXPECT_TRUE(fft.init(64));
+    EXPECT_EQ(fft.length(), 64U);
+    EXPECT_TRUE(fft.init(32));
+    EXPECT_EQ(fft.length(), 32U);
+}
+
+/*
+  compare every supported length, covering both odd and even numbers
+  of radix-4 stages, with a double precision DFT
+ */
+TEST(RealFFTTest, MatchesDFT)
+{
+    static float input[1024];
+    static float output[1024 + 2];
+    uint32_t seed = 1;
+
+    for (uint16_t n = 8; n <= 1024; n *= 2) {
+        RealFFT fft;
+        ASSERT_TRUE(fft.init(n));
+        for (uint16_t i = 0; i < n; i++) {
+            input[i] = rand_value(seed);
+        }
+        fft.forward(input, output);
+
+        for (uint16_t k = 0; k <= n/2; k++) {
+            double re = 0, im = 0;
+            for (uint16_t t = 0; t < n; t++) {
+                const double angle = -2 * M_PI * k * t / n;
+                re += input[t] * cos(angle);
+                im += input[t] * sin(angle);
+            }
+            // error grows with the number of stages
+            EXPECT_NEAR(output[2*k], re, 1.0e-5 * n) << "n=" << n << " k=" << k;
+            EXPECT_NEAR(output[2*k+1], im, 1.0e-5 * n) << "n=" << n << " k=" << k;
+        }
+    }
+}
+
+TEST(RealFFTTest, Sine)
+{
+    const uint16_t n = 256;
+    float input[n];
+    float output[n + 2];
+    float mag[n / 2];
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(n));
+
+    for (uint16_t i = 0; i < n; i++) {
+        input[i] = sinf(2 * M_PI * 37 * i / n);
+    }
+    fft.forward(input, output);
+    RealFFT::complex_mag_squared(output, mag, n / 2);
+
+    float max_value;
+    uint16_t max_index;
+    RealFFT::vector_max(mag, n / 2, &max_value, &max_index);
+    EXPECT_EQ(max_index, 37U);
+    EXPECT_NEAR(sqrtf(max_value), n / 2, 1.0e-3);
+}
+
+TEST(RealFFTTest, VectorOps)
+{
+    // odd length to cover the tail after the vectorised loop
+    const uint16_t n = 37;
+    float v1[n], v2[n], vout[n];
+    uint32_t seed = 5;
+    double sum = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        v1[i] = rand_value(seed);
+        v2[i] = rand_value(seed);
+        sum += v1[i];
+    }
+
+    RealFFT::vector_mul(v1, v2, vout, n);
+    for (uint16_t i = 0; i < n; i++) {
+        EXPECT_FLOAT_EQ(vout[i], v1[i] * v2[i]);
+    }
+    RealFFT::vector_add(v1, v2, vout, n);
+    for (uint16_t i = 0; i < n; i++) {
+        EXPECT_FLOAT_EQ(vout[i], v1[i] + v2[i]);
+    }
+    RealFFT::vector_scale(v1, 3.0f, vout, n);
+    for (uint16_t i = 0; i < n; i++) {
+        EXPECT_FLOAT_EQ(vout[i], v1[i] * 3.0f);
+    }
+    EXPECT_NEAR(RealFFT::vector_sum(v1, n), sum, 1.0e-5);
+
+    // the first of equal maxima is reported, wherever it falls
+    for (uint16_t m = 0; m < n; m++) {
+        float v[n] {};
+        v[m] = 2;
+        v[n - 1] = 2;
+        float max_value;
+        uint16_t max_index;
+        RealFFT::vector_max(v, n, &max_value, &max_index);
+        EXPECT_EQ(max_index, m);
+        EXPECT_FLOAT_EQ(max_value, 2);
+    }
+}
+
+#endif // HAL_WITH_NATIVE_FFT
+
+AP_GTEST_MAIN()
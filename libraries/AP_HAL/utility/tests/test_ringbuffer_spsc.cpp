@@ -0,0 +1,177 @@
+#include <AP_gtest.h>
+
+#include <thread>
+#include <AP_HAL/utility/RingBuffer.h>
+
+TEST(ObjectBufferSPSCTest, Basic)
+{
+    const uint32_t size = 16;
+    ObjectBuffer_SPSC<uint32_t> x{size};
+    EXPECT_EQ(x.get_size(), size);
+    EXPECT_EQ(x.available(), 0U);
+    EXPECT_EQ(x.space(), size);
+    EXPECT_TRUE(x.is_empty());
+
+    uint32_t v;
+    EXPECT_FALSE(x.pop(v));
+    EXPECT_FALSE(x.peek(v));
+
+    for (uint32_t i=0; i<size; i++) {
+        EXPECT_TRUE(x.push(i));
+    }
+    EXPECT_FALSE(x.push(99U));
+    EXPECT_EQ(x.available(), size);
+    EXPECT_EQ(x.space(), 0U);
+
+    EXPECT_TRUE(x.peek(v));
+    EXPECT_EQ(v, 0U);
+    for (uint32_t i=0; i<size; i++) {
+        EXPECT_TRUE(x.pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_TRUE(x.is_empty());
+
+    EXPECT_TRUE(x.push(7U));
+    x.clear();
+    EXPECT_TRUE(x.is_empty());
+    EXPECT_EQ(x.space(), size);
+}
+
+TEST(ObjectBufferSPSCTest, Wraparound)
+{
+    ObjectBuffer_SPSC<uint32_t> x{10};
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    for (uint8_t loop=0; loop<50; loop++) {
+        // push and pop odd sized blocks so both indices wrap at
+        // varying offsets
+        const uint32_t objs[7] {next_push, next_push+1, next_push+2, next_push+3,
+                                next_push+4, next_push+5, next_push+6};
+        EXPECT_TRUE(x.push(objs, 7));
+        next_push += 7;
+        EXPECT_FALSE(x.push(objs, 4));
+
+        uint32_t got[7];
+        EXPECT_EQ(x.pop(got, 7), 7U);
+        for (uint8_t i=0; i<7; i++) {
+            EXPECT_EQ(got[i], next_pop++);
+        }
+    }
+    uint32_t got[3];
+    EXPECT_EQ(x.pop(got, 3), 0U);
+}
+
+TEST(ObjectBufferSPSCTest, ReserveCommit)
+{
+    ObjectBuffer_SPSC<uint8_t> x{32};
+    uint8_t expected = 0;
+    uint8_t next = 0;
+    for (uint8_t loop=0; loop<100; loop++) {
+        ObjectBuffer_SPSC<uint8_t>::IoVec vec[2];
+        const uint8_t nvec = x.reserve(vec, 11);
+        ASSERT_GT(nvec, 0U);
+        uint32_t reserved = 0;
+        for (uint8_t i=0; i<nvec; i++) {
+            for (uint32_t j=0; j<vec[i].len; j++) {
+                vec[i].data[j] = next++;
+            }
+            reserved += vec[i].len;
+        }
+        EXPECT_EQ(reserved, 11U);
+
+        // nothing is visible until committed
+        EXPECT_TRUE(x.is_empty());
+        EXPECT_TRUE(x.commit(reserved));
+        EXPECT_EQ(x.available(), 11U);
+
+        // drain through readptr()/advance()
+        while (!x.is_empty()) {
+            uint32_t n = 0;
+            const uint8_t *ptr = x.readptr(n);
+            ASSERT_NE(ptr, nullptr);
+            for (uint32_t j=0; j<n; j++) {
+                EXPECT_EQ(ptr[j], expected++);
+            }
+            EXPECT_TRUE(x.advance(n));
+        }
+    }
+
+    // reserve is limited by the free space and commit can't exceed it
+    ObjectBuffer_SPSC<uint8_t>::IoVec vec[2] {};
+    const uint8_t nvec = x.reserve(vec, 100);
+    EXPECT_EQ(vec[0].len + (nvec>1?vec[1].len:0), 32U);
+    EXPECT_FALSE(x.commit(33));
+    EXPECT_FALSE(x.advance(1));
+}
+
+/*
+  one thread pushes a counting sequence using a mix of single and
+  bulk writes while the other drains it, checking nothing is lost,
+  duplicated or reordered
+ */
+TEST(ObjectBufferSPSCTest, Stress)
+{
+    ObjectBuffer_SPSC<uint32_t> x{61};
+    const uint32_t count = 1000000;
+
+    std::thread producer([&x, count]() {
+        uint32_t i = 0;
+        while (i < count) {
+            if (i % 3 == 0 && i + 4 <= count) {
+                const uint32_t objs[4] {i, i+1, i+2, i+3};
+                if (x.push(objs, 4)) {
+                    i += 4;
+                    continue;
+                }
+            } else if (i % 3 == 1) {
+                ObjectBuffer_SPSC<uint32_t>::IoVec vec[2];
+                const uint8_t nvec = x.reserve(vec, 5);
+                uint32_t n = 0;
+                for (uint8_t v=0; v<nvec; v++) {
+                    for (uint32_t j=0; j<vec[v].len && i+n < count; j++) {
+                        vec[v].data[j] = i + n++;
+                    }
+                }
+                if (n > 0) {
+                    x.commit(n);
+                    i += n;
+                    continue;
+                }
+            } else if (x.push(i)) {
+                i++;
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 0;
+    bool in_order = true;
+    while (expected < count) {
+        uint32_t objs[9];
+        uint32_t n;
+        if (expected % 2) {
+            n = x.pop(objs, 9);
+        } else {
+            n = x.pop(objs[0]) ? 1 : 0;
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (uint32_t i=0; i<n; i++) {
+            if (objs[i] != expected) {
+                // resync so the producer can always finish
+                in_order = false;
+                expected = objs[i];
+            }
+            expected++;
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(expected, count);
+    EXPECT_TRUE(x.is_empty());
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,131 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/SlidingDFT.h>
+#include <AP_Math/AP_Math.h>
+#include <math.h>
+
+#if HAL_WITH_DSP
+
+// repeatable random value in the range -1 to 1
+static float rand_value(uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+// double precision DFT of a bin of the last n samples
+static void dft_bin(const float* samples, uint16_t n, uint16_t k, double& re, double& im)
+{
+    re = im = 0;
+    for (uint16_t t = 0; t < n; t++) {
+        const double angle = -2 * M_PI * k * t / n;
+        re += samples[t] * cos(angle);
+        im += samples[t] * sin(angle);
+    }
+}
+
+TEST(SlidingDFTTest, Init)
+{
+    SlidingDFT sdft;
+    EXPECT_FALSE(sdft.init(4));
+    EXPECT_FALSE(sdft.init(48));
+    EXPECT_EQ(sdft.window_size(), 0U);
+    EXPECT_TRUE(sdft.init(64));
+    EXPECT_EQ(sdft.window_size(), 64U);
+    sdft.set_bin_range(10, 40);
+    EXPECT_EQ(sdft.start_bin(), 10U);
+    EXPECT_EQ(sdft.end_bin(), 32U);
+}
+
+/*
+  slide over a long run of samples and compare the tracked bins with a
+  double precision DFT of the final window
+ */
+TEST(SlidingDFTTest, MatchesDFT)
+{
+    static float samples[20000];
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        samples[i] = sinf(2 * M_PI * 0.13f * i) * 20 + rand_value(seed) * 5;
+    }
+
+    for (uint16_t n = 8; n <= 512; n *= 2) {
+        SlidingDFT sdft;
+        ASSERT_TRUE(sdft.init(n));
+        sdft.set_bin_range(0, n/2);
+        // uneven blocks so that the window wraps part way through
+        for (uint32_t i = 0; i < ARRAY_SIZE(samples); ) {
+            const uint16_t count = MIN(uint32_t(37), ARRAY_SIZE(samples) - i);
+            sdft.update(&samples[i], count);
+            i += count;
+        }
+
+        const float* window = &samples[ARRAY_SIZE(samples) - n];
+        for (uint16_t k = 0; k <= n/2; k++) {
+            double re, im;
+            dft_bin(window, n, k, re, im);
+            EXPECT_NEAR(sdft.bins()[2*k], re, 2e-3 * n) << "n=" << n << " k=" << k;
+            EXPECT_NEAR(sdft.bins()[2*k+1], im, 2e-3 * n) << "n=" << n << " k=" << k;
+        }
+    }
+}
+
+/*
+  changing the tracked bins calculates the new bins from the window
+ */
+TEST(SlidingDFTTest, BinRange)
+{
+    const uint16_t n = 64;
+    float samples[3 * n];
+    uint32_t seed = 2;
+    for (uint16_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        samples[i] = rand_value(seed);
+    }
+
+    SlidingDFT sdft;
+    ASSERT_TRUE(sdft.init(n));
+    sdft.set_bin_range(4, 8);
+    sdft.update(samples, 2 * n + 5);
+    sdft.set_bin_range(6, 20);
+    sdft.update(&samples[2 * n + 5], n - 5);
+
+    for (uint16_t k = 6; k <= 20; k++) {
+        double re, im;
+        dft_bin(&samples[2 * n], n, k, re, im);
+        EXPECT_NEAR(sdft.bins()[2*k], re, 1e-4 * n);
+        EXPECT_NEAR(sdft.bins()[2*k+1], im, 1e-4 * n);
+    }
+}
+
+/*
+  the frequency domain Hann window matches windowing the samples
+ */
+TEST(SlidingDFTTest, Hann)
+{
+    const uint16_t n = 32;
+    float samples[n];
+    float windowed[n];
+    uint32_t seed = 3;
+    for (uint16_t i = 0; i < n; i++) {
+        samples[i] = rand_value(seed);
+        windowed[i] = samples[i] * (0.5f - 0.5f * cosf(2 * M_PI * i / n));
+    }
+
+    SlidingDFT sdft;
+    ASSERT_TRUE(sdft.init(n));
+    sdft.set_bin_range(0, n/2);
+    sdft.update(samples, n);
+    float output[n + 2];
+    sdft.hann(output, 0, n/2);
+
+    for (uint16_t k = 0; k <= n/2; k++) {
+        double re, im;
+        dft_bin(windowed, n, k, re, im);
+        EXPECT_NEAR(output[2*k], re, 1e-4 * n);
+        EXPECT_NEAR(output[2*k+1], im, 1e-4 * n);
+    }
+}
+
+#endif // HAL_WITH_DSP
+
+AP_GTEST_MAIN()
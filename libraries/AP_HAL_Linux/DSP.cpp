@@ -0,0 +1,109 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_WITH_DSP
+
+#include <GCS_MAVLink/GCS.h>
+#include "DSP.h"
+
+using namespace Linux;
+
+extern const AP_HAL::HAL& hal;
+
+// The analysis follows the ChibiOS and SITL drivers, see the references there
+
+// initialize the FFT state machine
+AP_HAL::DSP::FFTWindowState* DSP::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+{
+    DSP::FFTWindowStateLinux* fft = new DSP::FFTWindowStateLinux(window_size, sample_rate, sliding_window_size);
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr
+        || fft->rfft.length() != window_size) {
+        delete fft;
+        return nullptr;
+    }
+    return fft;
+}
+
+// start an FFT analysis
+void DSP::fft_start(AP_HAL::DSP::FFTWindowState* state, FloatBuffer& samples, uint16_t advance)
+{
+    step_hanning((FFTWindowStateLinux*)state, samples, advance);
+}
+
+// perform remaining steps of an FFT analysis
+uint16_t DSP::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    FFTWindowStateLinux* fft = (FFTWindowStateLinux*)state;
+    step_fft(fft);
+    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(fft, start_bin, end_bin);
+}
+
+// create an instance of the FFT state machine
+DSP::FFTWindowStateLinux::FFTWindowStateLinux(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+    : AP_HAL::DSP::FFTWindowState::FFTWindowState(window_size, sample_rate, sliding_window_size)
+{
+    if (_freq_bins == nullptr || _hanning_window == nullptr || _rfft_data == nullptr || _derivative_freq_bins == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for DSP");
+        return;
+    }
+
+    if (!rfft.init(window_size)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate FFT for DSP");
+    }
+}
+
+// step 1: filter the incoming samples through a Hanning window
+void DSP::step_hanning(FFTWindowStateLinux* fft, FloatBuffer& samples, uint16_t advance)
+{
+    uint32_t read_window = samples.peek(&fft->_freq_bins[0], fft->_window_size);
+    if (read_window != fft->_window_size) {
+        return;
+    }
+    samples.advance(advance);
+    RealFFT::vector_mul(&fft->_freq_bins[0], &fft->_hanning_window[0], &fft->_freq_bins[0], fft->_window_size);
+}
+
+// step 2: perform an FFT on the windowed data
+void DSP::step_fft(FFTWindowStateLinux* fft)
+{
+    // the nyquist bin is only stored in _rfft_data
+    fft->rfft.forward(fft->_freq_bins, fft->_rfft_data);
+    RealFFT::complex_mag_squared(fft->_rfft_data, fft->_freq_bins, fft->_bin_count);
+}
+
+void DSP::vector_max_float(const float* vin, uint16_t len, float* maxValue, uint16_t* maxIndex) const
+{
+    RealFFT::vector_max(vin, len, maxValue, maxIndex);
+}
+
+void DSP::vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const
+{
+    RealFFT::vector_scale(vin, scale, vout, len);
+}
+
+void DSP::vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
+{
+    RealFFT::vector_add(vin1, vin2, vout, len);
+}
+
+float DSP::vector_mean_float(const float* vin, uint16_t len) const
+{
+    return RealFFT::vector_sum(vin, len) / len;
+}
+
+#endif // HAL_WITH_DSP
@@ -23,8 +23,6 @@
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS.h>
 #include "DSP.h"
-#include <cmath>
-#include <assert.h>
 
 using namespace HALSITL;
 
@@ -40,7 +38,8 @@ extern const AP_HAL::HAL& hal;
 AP_HAL::DSP::FFTWindowState* DSP::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
 {
     DSP::FFTWindowStateSITL* fft = new DSP::FFTWindowStateSITL(window_size, sample_rate, sliding_window_size);
-    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr) {
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr
+        || fft->rfft.length() != window_size) {
         delete fft;
         return nullptr;
     }
@@ -71,12 +70,9 @@ DSP::FFTWindowStateSITL::FFTWindowStateSITL(uint16_t window_size, uint16_t sampl
         return;
     }
 
-    buf = new complexf[window_size];
-}
-
-DSP::FFTWindowStateSITL::~FFTWindowStateSITL()
-{
-    delete[] buf;
+    if (!rfft.init(window_size)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate FFT for DSP");
+    }
 }
 
 // step 1: filter the incoming samples through a Hanning window
@@ -93,123 +89,37 @@ void DSP::step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t a
     mult_f32(&fft->_freq_bins[0], &fft->_hanning_window[0], &fft->_freq_bins[0], fft->_window_size);
 }
 
-// step 2: perform an in-place FFT on the windowed data
+// step 2: perform an FFT on the windowed data
 void DSP::step_fft(FFTWindowStateSITL* fft)
 {
-    for (uint16_t i = 0; i < fft->_window_size; i++) {
-        fft->buf[i] = complexf(fft->_freq_bins[i], 0);
-    }
-
-    calculate_fft(fft->buf, fft->_window_size);
-
-    for (uint16_t i = 0; i < fft->_bin_count; i++) {
-        fft->_freq_bins[i] = std::norm(fft->buf[i]);
-    }
-
-    // components at the nyquist frequency are real only
-    for (uint16_t i = 0, j = 0; i <= fft->_bin_count; i++, j += 2) {
-        fft->_rfft_data[j] = fft->buf[i].real();
-        fft->_rfft_data[j+1] = fft->buf[i].imag();
-    }
+    // the nyquist bin is only stored in _rfft_data
+    fft->rfft.forward(fft->_freq_bins, fft->_rfft_data);
+    RealFFT::complex_mag_squared(fft->_rfft_data, fft->_freq_bins, fft->_bin_count);
 }
 
 void DSP::mult_f32(const float* v1, const float* v2, float* vout, uint16_t len)
 {
-    for (uint16_t i = 0; i < len; i++) {
-        vout[i] = v1[i] * v2[i];
-    }
+    RealFFT::vector_mul(v1, v2, vout, len);
 }
 
 void DSP::vector_max_float(const float* vin, uint16_t len, float* maxValue, uint16_t* maxIndex) const
 {
-    *maxValue = vin[0];
-    *maxIndex = 0;
-    for (uint16_t i = 1; i < len; i++) {
-        if (vin[i] > *maxValue) {
-            *maxValue = vin[i];
-            *maxIndex = i;
-        }
-    }
+    RealFFT::vector_max(vin, len, maxValue, maxIndex);
 }
 
 void DSP::vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const
 {
-    for (uint16_t i = 0; i < len; i++) {
-        vout[i] = vin[i] * scale;
-    }
+    RealFFT::vector_scale(vin, scale, vout, len);
 }
 
 void DSP::vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
 {
-    for (uint16_t i = 0; i < len; i++) {
-        vout[i] = vin1[i] + vin2[i];
-    }
+    RealFFT::vector_add(vin1, vin2, vout, len);
 }
 
 float DSP::vector_mean_float(const float* vin, uint16_t len) const
 {
-    float mean_value = 0.0f;
-    for (uint16_t i = 0; i < len; i++) {
-        mean_value += vin[i];
-    }
-    mean_value /= len;
-    return mean_value;
-}
-
-// simple integer log2
-static uint16_t fft_log2(uint16_t n)
-{
-    uint16_t k = n, i = 0;
-    while (k) {
-        k >>= 1;
-        i++;
-    }
-    return i - 1;
-}
-
-// calculate the in-place FFT of the input using the Cooley–Tukey algorithm
-// this is a translation of Ron Nicholson's version in http://www.nicholson.com/dsp.fft1.html
-void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
-{
-    uint16_t m = fft_log2(fftlen);
-    // shuffle data using bit reversed addressing ***
-    for (uint16_t k = 0; k < fftlen; k++) {
-        // generate a bit reversed address for samples[k] ***
-        uint16_t ki = k, kr = 0;
-        for (uint16_t i=1; i<=m; i++) {
-            kr <<= 1; //  left shift result kr by 1 bit
-            if (ki % 2 == 1) {
-                kr++;
-            }
-            ki >>= 1; // right shift temp ki by 1 bit
-        }
-        // swap data samples[k] to bit reversed address samples[kr]
-        if (kr > k) {
-            complexf t = samples[kr];
-            samples[kr] = samples[k];
-            samples[k] = t;
-        }
-    }
-
-    // do fft butterflys in place
-    uint16_t istep = 2;
-    while (istep <= fftlen) {// layers 2,4,8,16, ... ,n
-        uint16_t is2 = istep / 2;
-        uint16_t astep = fftlen / istep;
-        for (uint16_t km = 0; km < is2; km++) { // outer row loop
-            uint16_t a  = km * astep; // twiddle angle index
-            complexf w(sinf(2 * M_PI * (a+(fftlen/4)) / fftlen), sinf(2 * M_PI * a / fftlen));
-            for (uint16_t ki = 0; ki <= (fftlen - istep); ki += istep) { // inner column loop
-                uint16_t i = km + ki;
-                uint16_t j = is2 + i;
-                complexf t = w * samples[j];
-                complexf q = samples[i];
-                samples[j] = q - t;
-                samples[i] = q + t;
-            }
-        }
-        istep <<= 1;
-    }
+    return RealFFT::vector_sum(vin, len) / len;
 }
 
 #endif
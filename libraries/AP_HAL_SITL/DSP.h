@@ -21,10 +21,7 @@
 #if HAL_WITH_DSP
 
 #include "AP_HAL_SITL.h"
-
-#include <complex>
-
-typedef std::complex<float> complexf;
+#include <AP_HAL/utility/RealFFT.h>
 
 // ChibiOS implementation of FFT analysis to run on STM32 processors
 class HALSITL::DSP : public AP_HAL::DSP {
@@ -42,10 +39,9 @@ public:
 
     public:
         FFTWindowStateSITL(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
-        virtual ~FFTWindowStateSITL();
 
     private:
-        complexf* buf;
+        RealFFT rfft;
     };
 
 private:
@@ -56,7 +52,6 @@ private:
     void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
     float vector_mean_float(const float* vin, uint16_t len) const override;
     void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
-    void calculate_fft(complexf* f, uint16_t length);
 };
 
 #endif
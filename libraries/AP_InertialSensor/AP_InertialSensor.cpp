@@ -747,6 +747,16 @@ bool AP_InertialSensor::register_gyro(uint8_t &instance, uint16_t raw_sample_rat
 
     _gyro_id(_gyro_count).set((int32_t) id);
 
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    // without a ring the backend falls back to the semaphore
+    _gyro_ring[_gyro_count].samples = new ObjectBuffer_SPSC<GyroSample>(AP_INERTIALSENSOR_SAMPLE_RING_LENGTH);
+    if (_gyro_ring[_gyro_count].samples != nullptr &&
+        _gyro_ring[_gyro_count].samples->get_size() == 0) {
+        delete _gyro_ring[_gyro_count].samples;
+        _gyro_ring[_gyro_count].samples = nullptr;
+    }
+#endif
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     if (!saved) {
         // assume this is the same sensor and save its ID to allow seamless
@@ -812,6 +822,23 @@ bool AP_InertialSensor::register_accel(uint8_t &instance, uint16_t raw_sample_ra
 
     _accel_id(_accel_count).set((int32_t) id);
 
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    _accel_ring[_accel_count].samples = new ObjectBuffer_SPSC<AccelSample>(AP_INERTIALSENSOR_SAMPLE_RING_LENGTH);
+    if (_accel_ring[_accel_count].samples != nullptr &&
+        _accel_ring[_accel_count].samples->get_size() == 0) {
+        delete _accel_ring[_accel_count].samples;
+        _accel_ring[_accel_count].samples = nullptr;
+    }
+#endif
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    _vibe_stats[_accel_count] = new AP_InertialSensor_VibeStats(AP_INERTIALSENSOR_VIBE_STATS_RING_LENGTH);
+    if (_vibe_stats[_accel_count] != nullptr && !_vibe_stats[_accel_count]->valid()) {
+        delete _vibe_stats[_accel_count];
+        _vibe_stats[_accel_count] = nullptr;
+    }
+#endif
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || (CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS && AP_SIM_ENABLED)
         // assume this is the same sensor and save its ID to allow seamless
         // transition from when we didn't have the IDs.
@@ -990,6 +1017,9 @@ AP_InertialSensor::init(uint16_t loop_rate)
             notch.calculated_notch_freq_hz[i] = notch.params.center_freq_hz();
         }
         notch.num_calculated_notch_frequencies = 1;
+#if HAL_GYROFFT_PARALLEL_ENABLED
+        notch.clear_instance_frequencies();
+#endif
         notch.num_dynamic_notches = 1;
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         if (notch.params.hasOption(HarmonicNotchFilterParams::Options::DynamicHarmonic)) {
@@ -1762,12 +1792,63 @@ void AP_InertialSensor::_save_gyro_calibration()
     }
 }
 
+/*
+  current harmonic notch frequencies for an IMU
+ */
+uint8_t AP_InertialSensor::HarmonicNotch::get_frequencies_hz(uint8_t instance, float freqs[INS_MAX_NOTCHES]) const
+{
+    const float *calculated = calculated_notch_freq_hz;
+    uint8_t num_freqs = num_calculated_notch_frequencies;
+#if HAL_GYROFFT_PARALLEL_ENABLED
+    if (num_calculated_instance_frequencies[instance] > 0) {
+        calculated = calculated_instance_freq_hz[instance];
+        num_freqs = num_calculated_instance_frequencies[instance];
+    }
+#endif
+    num_freqs = constrain_int16(num_freqs, 1, INS_MAX_NOTCHES);
+    memcpy(freqs, calculated, num_freqs * sizeof(float));
+    return num_freqs;
+}
+
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+void AP_InertialSensor::HarmonicNotch::publish_frequencies(uint8_t instance)
+{
+    auto &p = published[instance];
+    const uint32_t seq = p.seq.load(std::memory_order_relaxed);
+    p.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    p.num_freqs = get_frequencies_hz(instance, p.freq_hz);
+    p.seq.store(seq + 2, std::memory_order_release);
+}
+
+uint8_t AP_InertialSensor::HarmonicNotch::get_published_frequencies_hz(uint8_t instance, float freqs[INS_MAX_NOTCHES]) const
+{
+    const auto &p = published[instance];
+    // don't spin waiting for the frontend, which may be preempted by
+    // this thread. It publishes again on its next update
+    for (uint8_t tries = 0; tries < 3; tries++) {
+        const uint32_t seq = p.seq.load(std::memory_order_acquire);
+        if (seq & 1U) {
+            // the frontend is part way through publishing
+            continue;
+        }
+        const uint8_t num_freqs = MIN(p.num_freqs, INS_MAX_NOTCHES);
+        memcpy(freqs, p.freq_hz, num_freqs * sizeof(float));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (p.seq.load(std::memory_order_relaxed) == seq) {
+            return num_freqs;
+        }
+    }
+    return 0;
+}
+#endif
+
 /*
   update harmonic notch parameters
  */
-void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool converging, float gyro_rate)
+void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool converging, float gyro_rate, uint8_t num_freqs, const float freqs[])
 {
-    const float center_freq = calculated_notch_freq_hz[0];
+    const float center_freq = freqs[0];
     if (!is_equal(last_bandwidth_hz[instance], params.bandwidth_hz()) ||
         !is_equal(last_attenuation_dB[instance], params.attenuation_dB()) ||
         (params.tracking_mode() == HarmonicNotchDynamicMode::Fixed && !is_equal(last_center_freq_hz[instance], center_freq)) ||
@@ -1780,8 +1861,8 @@ void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool conv
         last_bandwidth_hz[instance] = params.bandwidth_hz();
         last_attenuation_dB[instance] = params.attenuation_dB();
     } else if (params.tracking_mode() != HarmonicNotchDynamicMode::Fixed) {
-        if (num_calculated_notch_frequencies > 1) {
-            filter[instance].update(num_calculated_notch_frequencies, calculated_notch_freq_hz);
+        if (num_freqs > 1) {
+            filter[instance].update(num_freqs, freqs);
         } else {
             filter[instance].update(center_freq);
         }
@@ -1789,6 +1870,32 @@ void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool conv
     }
 }
 
+/*
+  return true if a backend has a gyro sample waiting for update()
+ */
+bool AP_InertialSensor::new_gyro_data(uint8_t instance) const
+{
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    if (_gyro_ring[instance].samples != nullptr) {
+        return !_gyro_ring[instance].samples->is_empty();
+    }
+#endif
+    return _new_gyro_data[instance];
+}
+
+/*
+  return true if a backend has an accel sample waiting for update()
+ */
+bool AP_InertialSensor::new_accel_data(uint8_t instance) const
+{
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    if (_accel_ring[instance].samples != nullptr) {
+        return !_accel_ring[instance].samples->is_empty();
+    }
+#endif
+    return _new_accel_data[instance];
+}
+
 /*
   update gyro and accel values from backends
  */
@@ -1875,6 +1982,10 @@ void AP_InertialSensor::update(void)
     
     _have_sample = false;
 
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    update_vibration_stats();
+#endif
+
 #if HAL_INS_TEMPERATURE_CAL_ENABLE
     if (tcal_learning && !temperature_cal_running()) {
         AP_Notify::flags.temp_cal_running = false;
@@ -1965,7 +2076,7 @@ check_sample:
             }
 
             for (uint8_t i=0; i<_gyro_count; i++) {
-                if (_new_gyro_data[i]) {
+                if (new_gyro_data(i)) {
                     const uint8_t imask = (1U<<i);
                     gyro_available_mask |= imask;
                     if (_use(i)) {
@@ -1976,7 +2087,7 @@ check_sample:
                 }
             }
             for (uint8_t i=0; i<_accel_count; i++) {
-                if (_new_accel_data[i]) {
+                if (new_accel_data(i)) {
                     const uint8_t imask = (1U<<i);
                     accel_available_mask |= imask;
                     if (_use(i)) {
@@ -2126,6 +2237,31 @@ void AP_InertialSensor::calc_vibration_and_clipping(uint8_t instance, const Vect
     }
 }
 
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+/*
+  add the accel samples gathered since the last loop to the vibration
+  statistics
+ */
+void AP_InertialSensor::update_vibration_stats()
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint8_t i=0; i<_accel_count; i++) {
+        if (_vibe_stats[i] == nullptr || _backends[i] == nullptr) {
+            continue;
+        }
+        _vibe_stats[i]->update(_backends[i]->get_clip_limit(), now_ms);
+    }
+}
+
+bool AP_InertialSensor::get_vibration_stats(uint8_t instance, AP_InertialSensor_VibeStats::Stats &stats) const
+{
+    if (instance >= INS_MAX_INSTANCES || _vibe_stats[instance] == nullptr) {
+        return false;
+    }
+    return _vibe_stats[instance]->get_stats(stats);
+}
+#endif
+
 // peak hold detector for slower mechanisms to detect spikes
 void AP_InertialSensor::set_accel_peak_hold(uint8_t instance, const Vector3f &accel)
 {
@@ -2244,6 +2380,34 @@ void AP_InertialSensor::HarmonicNotch::update_frequencies_hz(uint8_t num_freqs,
     num_calculated_notch_frequencies = num_freqs;
 }
 
+#if HAL_GYROFFT_PARALLEL_ENABLED
+// Update the harmonic notch frequencies of a single IMU
+void AP_InertialSensor::HarmonicNotch::update_frequencies_hz(uint8_t instance, uint8_t num_freqs, const float scaled_freq[])
+{
+    if (instance >= INS_MAX_INSTANCES) {
+        return;
+    }
+    // protect against zero as the scaled frequency
+    for (uint8_t i = 0; i < num_freqs; i++) {
+        if (is_positive(scaled_freq[i])) {
+            calculated_instance_freq_hz[instance][i] = scaled_freq[i];
+        }
+    }
+    num_calculated_instance_frequencies[instance] = num_freqs;
+}
+
+// Revert every IMU to the shared harmonic notch frequencies
+void AP_InertialSensor::HarmonicNotch::clear_instance_frequencies()
+{
+    for (uint8_t i = 0; i < INS_MAX_INSTANCES; i++) {
+        for (uint8_t j = 0; j < INS_MAX_NOTCHES; j++) {
+            calculated_instance_freq_hz[i][j] = params.center_freq_hz();
+        }
+        num_calculated_instance_frequencies[i] = 0;
+    }
+}
+#endif
+
 // setup the notch for throttle based tracking, called from FFT based tuning
 bool AP_InertialSensor::setup_throttle_gyro_harmonic_notch(float center_freq_hz, float lower_freq_hz, float ref, uint8_t harmonics)
 {
@@ -22,6 +22,7 @@
 #include <AP_SerialManager/AP_SerialManager_config.h>
 #include "AP_InertialSensor_Params.h"
 #include "AP_InertialSensor_tempcal.h"
+#include "AP_InertialSensor_VibeStats.h"
 
 #ifndef AP_SIM_INS_ENABLED
 #define AP_SIM_INS_ENABLED AP_SIM_ENABLED
@@ -157,6 +158,7 @@ public:
     // FFT support access
 #if HAL_GYROFFT_ENABLED
     const Vector3f& get_gyro_for_fft(void) const { return _gyro_for_fft[_primary_gyro]; }
+    const Vector3f& get_gyro_for_fft(uint8_t instance) const { return _gyro_for_fft[instance]; }
     FloatBuffer&  get_raw_gyro_window(uint8_t instance, uint8_t axis) { return _gyro_window[instance][axis]; }
     FloatBuffer&  get_raw_gyro_window(uint8_t axis) { return get_raw_gyro_window(_primary_gyro, axis); }
     uint16_t get_raw_gyro_rate_hz() const { return get_raw_gyro_rate_hz(_primary_gyro); }
@@ -250,6 +252,12 @@ public:
     // retrieve and clear accelerometer clipping count
     uint32_t get_accel_clip_count(uint8_t instance) const;
 
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    // retrieve the vibration statistics of the last completed window,
+    // false if there are none
+    bool get_vibration_stats(uint8_t instance, AP_InertialSensor_VibeStats::Stats &stats) const;
+#endif
+
     // check for vibration movement. True when all axis show nearly zero movement
     bool is_still();
 
@@ -336,6 +344,11 @@ public:
 
         bool doing_sensor_rate_logging() const { return _doing_sensor_rate_logging; }
         bool doing_post_filter_logging() const {
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+            if (stream != nullptr) {
+                return _doing_post_filter_logging;
+            }
+#endif
             return (_doing_post_filter_logging && (post_filter || !_doing_sensor_rate_logging))
                 || (_doing_pre_post_filter_logging && post_filter);
         }
@@ -373,6 +386,7 @@ public:
             BATCH_OPT_SENSOR_RATE = (1<<0),
             BATCH_OPT_POST_FILTER = (1<<1),
             BATCH_OPT_PRE_POST_FILTER = (1<<2),
+            BATCH_OPT_STREAM = (1<<3),
         };
 
         void rotate_to_next_sensor();
@@ -408,6 +422,22 @@ public:
         // all samples are multiplied by this
         uint16_t multiplier; // initialised as part of init()
 
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+        // continuous streaming of all sensors to a file, see
+        // BatchSampler_Stream.cpp
+        struct StreamBuffer;
+        struct StreamState;
+        StreamState *stream;
+
+        bool stream_init();
+        void stream_periodic();
+        void stream_sample(uint8_t instance, IMU_SENSOR_TYPE type, uint64_t sample_us, const Vector3f &sample) __RAMFUNC__;
+        void stream_io();
+        bool stream_open();
+        void stream_write_blocks(bool close_file);
+        bool stream_filling() const;
+#endif
+
         const AP_InertialSensor &_imu;
     };
     BatchSampler batchsampler{*this};
@@ -441,6 +471,11 @@ public:
         // the current center frequency for the notch
         float calculated_notch_freq_hz[INS_MAX_NOTCHES];
         uint8_t num_calculated_notch_frequencies;
+#if HAL_GYROFFT_PARALLEL_ENABLED
+        // center frequencies calculated for individual IMUs, used in place of the shared frequencies when set
+        float calculated_instance_freq_hz[INS_MAX_INSTANCES][INS_MAX_NOTCHES];
+        uint8_t num_calculated_instance_frequencies[INS_MAX_INSTANCES];
+#endif
 
         // Update the harmonic notch frequency
         void update_notch_freq_hz(float scaled_freq);
@@ -448,12 +483,33 @@ public:
         // Update the harmonic notch frequencies
         void update_notch_frequencies_hz(uint8_t num_freqs, const float scaled_freq[]);
 
+        // current center frequencies for an IMU, returning how many
+        uint8_t get_frequencies_hz(uint8_t instance, float freqs[INS_MAX_NOTCHES]) const;
+
         // runtime update of notch parameters
-        void update_params(uint8_t instance, bool converging, float gyro_rate);
+        void update_params(uint8_t instance, bool converging, float gyro_rate, uint8_t num_freqs, const float freqs[]);
+
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+        // hand the current frequencies for an IMU to its backend
+        // thread. Called by the frontend, which is the only thread
+        // that changes them
+        void publish_frequencies(uint8_t instance);
+
+        // the last frequencies published for an IMU, returning how
+        // many, or zero if none could be read. Called by the backend
+        // thread
+        uint8_t get_published_frequencies_hz(uint8_t instance, float freqs[INS_MAX_NOTCHES]) const;
+#endif
 
         // Update the harmonic notch frequencies
         void update_freq_hz(float scaled_freq);
         void update_frequencies_hz(uint8_t num_freqs, const float scaled_freq[]);
+#if HAL_GYROFFT_PARALLEL_ENABLED
+        // Update the harmonic notch frequencies of a single IMU, zero frequencies reverts to the shared frequencies
+        void update_frequencies_hz(uint8_t instance, uint8_t num_freqs, const float scaled_freq[]);
+        // revert every IMU to the shared frequencies
+        void clear_instance_frequencies();
+#endif
 
         // enable/disable the notch
         void set_inactive(bool _inactive) {
@@ -465,6 +521,16 @@ public:
         }
 
     private:
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+        // frequencies copied for the backend thread, guarded by a
+        // sequence count which is odd while they are being written
+        struct {
+            std::atomic<uint32_t> seq;
+            float freq_hz[INS_MAX_NOTCHES];
+            uint8_t num_freqs;
+        } published[INS_MAX_INSTANCES];
+#endif
+
         // support for updating harmonic filter at runtime
         float last_center_freq_hz[INS_MAX_INSTANCES];
         float last_bandwidth_hz[INS_MAX_INSTANCES];
@@ -548,6 +614,48 @@ private:
     Vector3f _last_delta_angle[INS_MAX_INSTANCES];
     Vector3f _last_raw_gyro[INS_MAX_INSTANCES];
 
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    /*
+      samples handed from a backend thread to the frontend without
+      taking the backend semaphore. The backend filters each sample
+      and works out its delta angle or velocity, and the frontend
+      accumulates them (including the coning correction) when it
+      drains the ring in update_gyro() and update_accel()
+     */
+    struct GyroSample {
+        Vector3f delta_angle;
+        Vector3f filtered;
+#if HAL_GYROFFT_ENABLED
+        Vector3f gyro_for_fft;
+#endif
+        float dt;
+        // sensor was unhealthy for 0.1s, zero the accumulator
+        bool reset;
+    };
+    struct AccelSample {
+        Vector3f delta_velocity;
+        Vector3f filtered;
+        float dt;
+        bool reset;
+    };
+    template <class T>
+    struct SampleRing {
+        ObjectBuffer_SPSC<T> *samples;
+        // samples that didn't fit in the ring, merged by the producer
+        T carry;
+        bool have_carry;
+        // set by the frontend to have the backend thread update its
+        // filter parameters before filtering the next sample
+        std::atomic<bool> update_filters;
+    };
+    SampleRing<GyroSample> _gyro_ring[INS_MAX_INSTANCES];
+    SampleRing<AccelSample> _accel_ring[INS_MAX_INSTANCES];
+#endif
+
+    // true if a backend has a sample ready for the frontend
+    bool new_gyro_data(uint8_t instance) const;
+    bool new_accel_data(uint8_t instance) const;
+
     // bitmask indicating if a sensor is doing sensor-rate sampling:
     uint8_t _accel_sensor_rate_sampling_enabled;
     uint8_t _gyro_sensor_rate_sampling_enabled;
@@ -702,6 +810,10 @@ private:
     uint32_t _accel_clip_count[INS_MAX_INSTANCES];
     LowPassFilterVector3f _accel_vibe_floor_filter[INS_VIBRATION_CHECK_INSTANCES];
     LowPassFilterVector3f _accel_vibe_filter[INS_VIBRATION_CHECK_INSTANCES];
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    AP_InertialSensor_VibeStats *_vibe_stats[INS_MAX_INSTANCES];
+    void update_vibration_stats();
+#endif
 
     // peak hold detector state for primary accel
     struct PeakHoldState {
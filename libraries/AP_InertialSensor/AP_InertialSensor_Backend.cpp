@@ -4,6 +4,7 @@
 #include <AP_AHRS/AP_AHRS.h>
 #include "AP_InertialSensor.h"
 #include "AP_InertialSensor_Backend.h"
+#include "AP_InertialSensor_SampleCorrection.h"
 #include <AP_Logger/AP_Logger.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #if AP_MODULE_SUPPORTED
@@ -159,6 +160,71 @@ void AP_InertialSensor_Backend::_rotate_and_correct_gyro(uint8_t instance, Vecto
     gyro.rotate(_imu._board_orientation);
 }
 
+/*
+  rotate and correct a burst of accel samples. The sensor
+  orientation, calibration and temperature don't change within a
+  burst, so the corrections are combined into a single transform
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_accel_burst(uint8_t instance, Vector3f *accel, uint16_t n, float raw_scale)
+{
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+    if (_imu.tcal_learning) {
+        // learning needs each sample in the sensor frame
+        for (uint16_t i=0; i<n; i++) {
+            accel[i] *= raw_scale;
+            _rotate_and_correct_accel(instance, accel[i]);
+        }
+        return;
+    }
+#endif
+
+    Vector3f offset;
+    Vector3f scale{1, 1, 1};
+    if (!_imu._calibrating_accel && (_imu._acal == nullptr
+#if HAL_INS_ACCELCAL_ENABLED
+        || !_imu._acal->running()
+#endif
+    )) {
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+        offset = _imu.tcal(instance).accel_correction(_imu.get_temperature(instance), _imu.caltemp_accel(instance));
+#endif
+        offset += _imu._accel_offset(instance);
+        scale = _imu._accel_scale(instance).get();
+    }
+
+    AP_InertialSensor_SampleCorrection correction;
+    correction.setup(_imu._accel_orientation[instance], _imu._board_orientation, raw_scale, offset, scale);
+    correction.apply(accel, n);
+}
+
+/*
+  rotate and correct a burst of gyro samples
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_gyro_burst(uint8_t instance, Vector3f *gyro, uint16_t n, float raw_scale)
+{
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+    if (_imu.tcal_learning) {
+        for (uint16_t i=0; i<n; i++) {
+            gyro[i] *= raw_scale;
+            _rotate_and_correct_gyro(instance, gyro[i]);
+        }
+        return;
+    }
+#endif
+
+    Vector3f offset;
+    if (!_imu._calibrating_gyro) {
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+        offset = _imu.tcal(instance).gyro_correction(_imu.get_temperature(instance), _imu.caltemp_gyro(instance));
+#endif
+        offset += _imu._gyro_offset(instance);
+    }
+
+    AP_InertialSensor_SampleCorrection correction;
+    correction.setup(_imu._gyro_orientation[instance], _imu._board_orientation, raw_scale, offset, Vector3f{1, 1, 1});
+    correction.apply(gyro, n);
+}
+
 /*
   rotate gyro vector and add the gyro offset
  */
@@ -255,6 +321,129 @@ void AP_InertialSensor_Backend::apply_gyro_filters(const uint8_t instance, const
     }
 }
 
+/*
+  add a delta angle to the frontend accumulator with coning
+  correction. Called with _sem held, or by the frontend when draining
+  the sample ring
+ */
+void AP_InertialSensor_Backend::accumulate_delta_angle(uint8_t instance, Vector3f delta_angle, float dt, bool reset)
+{
+    // compute coning correction
+    // see page 26 of:
+    // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
+    // Available: http://www.sage.unsw.edu.au/snap/publications/tian_etal2010b.pdf
+    // see also examples/coning.py
+    Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
+                             _imu._last_delta_angle[instance] * (1.0f / 6.0f));
+    delta_coning = delta_coning % delta_angle;
+    delta_coning *= 0.5f;
+
+    if (reset) {
+        // zero accumulator if sensor was unhealthy for 0.1s
+        _imu._delta_angle_acc[instance].zero();
+        _imu._delta_angle_acc_dt[instance] = 0;
+        dt = 0;
+        delta_angle.zero();
+    }
+
+    // integrate delta angle accumulator
+    // the angles and coning corrections are accumulated separately in the
+    // referenced paper, but in simulation little difference was found between
+    // integrating together and integrating separately (see examples/coning.py)
+    _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
+    _imu._delta_angle_acc_dt[instance] += dt;
+
+    // save previous delta angle for coning correction
+    _imu._last_delta_angle[instance] = delta_angle;
+}
+
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+/*
+  queue a sample for the frontend. If the ring is full the sample is
+  merged into one held back until there is space, so no delta angle
+  or velocity is lost, but the coning correction between the merged
+  samples is. That only happens if the frontend stops calling update()
+ */
+template <class T>
+void AP_InertialSensor_Backend::push_sample(AP_InertialSensor::SampleRing<T> &ring, const T &sample)
+{
+    if (ring.have_carry) {
+        merge_sample(ring.carry, sample);
+        ring.have_carry = !ring.samples->push(ring.carry);
+    } else if (!ring.samples->push(sample)) {
+        ring.carry = sample;
+        ring.have_carry = true;
+    }
+}
+
+void AP_InertialSensor_Backend::merge_sample(AP_InertialSensor::GyroSample &carry, const AP_InertialSensor::GyroSample &sample)
+{
+    if (sample.reset) {
+        // the frontend would discard everything before this sample
+        carry = sample;
+        return;
+    }
+    carry.delta_angle += sample.delta_angle;
+    carry.dt += sample.dt;
+    carry.filtered = sample.filtered;
+#if HAL_GYROFFT_ENABLED
+    carry.gyro_for_fft = sample.gyro_for_fft;
+#endif
+}
+
+void AP_InertialSensor_Backend::merge_sample(AP_InertialSensor::AccelSample &carry, const AP_InertialSensor::AccelSample &sample)
+{
+    if (sample.reset) {
+        carry = sample;
+        return;
+    }
+    carry.delta_velocity += sample.delta_velocity;
+    carry.dt += sample.dt;
+    carry.filtered = sample.filtered;
+}
+#endif // AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+
+/*
+  filter a gyro sample and hand it to the frontend along with its
+  delta angle
+ */
+void AP_InertialSensor_Backend::push_gyro_sample(uint8_t instance, const Vector3f &gyro, const Vector3f &delta_angle, float dt, uint64_t last_sample_us)
+{
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    auto &ring = _imu._gyro_ring[instance];
+    if (ring.samples != nullptr) {
+        // the filters are only used by this thread, so parameter
+        // changes asked for by the frontend are made here
+        if (ring.update_filters.exchange(false)) {
+            update_gyro_filters(instance);
+        }
+
+        // apply gyro filters and sample for FFT
+        apply_gyro_filters(instance, gyro);
+
+        AP_InertialSensor::GyroSample sample;
+        sample.delta_angle = delta_angle;
+        sample.filtered = _imu._gyro_filtered[instance];
+#if HAL_GYROFFT_ENABLED
+        sample.gyro_for_fft = _imu._last_gyro_for_fft[instance];
+#endif
+        sample.dt = dt;
+        sample.reset = AP_HAL::micros64() - last_sample_us > 100000U;
+        push_sample(ring, sample);
+        return;
+    }
+#endif
+
+    WITH_SEMAPHORE(_sem);
+
+    accumulate_delta_angle(instance, delta_angle, dt, AP_HAL::micros64() - last_sample_us > 100000U);
+
+    // apply gyro filters and sample for FFT
+    apply_gyro_filters(instance, gyro);
+
+    _imu._new_gyro_data[instance] = true;
+}
+
 void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
                                                             const Vector3f &gyro,
                                                             uint64_t sample_us)
@@ -302,46 +491,10 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     }
     
     // compute delta angle
-    Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
-
-    // compute coning correction
-    // see page 26 of:
-    // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
-    // Available: http://www.sage.unsw.edu.au/snap/publications/tian_etal2010b.pdf
-    // see also examples/coning.py
-    Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
-                             _imu._last_delta_angle[instance] * (1.0f / 6.0f));
-    delta_coning = delta_coning % delta_angle;
-    delta_coning *= 0.5f;
-
-    {
-        WITH_SEMAPHORE(_sem);
-        uint64_t now = AP_HAL::micros64();
-
-        if (now - last_sample_us > 100000U) {
-            // zero accumulator if sensor was unhealthy for 0.1s
-            _imu._delta_angle_acc[instance].zero();
-            _imu._delta_angle_acc_dt[instance] = 0;
-            dt = 0;
-            delta_angle.zero();
-        }
-
-        // integrate delta angle accumulator
-        // the angles and coning corrections are accumulated separately in the
-        // referenced paper, but in simulation little difference was found between
-        // integrating together and integrating separately (see examples/coning.py)
-        _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
-        _imu._delta_angle_acc_dt[instance] += dt;
-
-        // save previous delta angle for coning correction
-        _imu._last_delta_angle[instance] = delta_angle;
-        _imu._last_raw_gyro[instance] = gyro;
-
-        // apply gyro filters and sample for FFT
-        apply_gyro_filters(instance, gyro);
+    const Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
+    _imu._last_raw_gyro[instance] = gyro;
 
-        _imu._new_gyro_data[instance] = true;
-    }
+    push_gyro_sample(instance, gyro, delta_angle, dt, last_sample_us);
 
     // 5us
     log_gyro_raw(instance, sample_us, gyro, _imu._gyro_filtered[instance]);
@@ -390,46 +543,10 @@ void AP_InertialSensor_Backend::_notify_new_delta_angle(uint8_t instance, const
     }
     
     // compute delta angle, including corrections
-    Vector3f delta_angle = gyro * dt;
-
-    // compute coning correction
-    // see page 26 of:
-    // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
-    // Available: http://www.sage.unsw.edu.au/snap/publications/tian_etal2010b.pdf
-    // see also examples/coning.py
-    Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
-                             _imu._last_delta_angle[instance] * (1.0f / 6.0f));
-    delta_coning = delta_coning % delta_angle;
-    delta_coning *= 0.5f;
-
-    {
-        WITH_SEMAPHORE(_sem);
-        uint64_t now = AP_HAL::micros64();
+    const Vector3f delta_angle = gyro * dt;
+    _imu._last_raw_gyro[instance] = gyro;
 
-        if (now - last_sample_us > 100000U) {
-            // zero accumulator if sensor was unhealthy for 0.1s
-            _imu._delta_angle_acc[instance].zero();
-            _imu._delta_angle_acc_dt[instance] = 0;
-            dt = 0;
-            delta_angle.zero();
-        }
-
-        // integrate delta angle accumulator
-        // the angles and coning corrections are accumulated separately in the
-        // referenced paper, but in simulation little difference was found between
-        // integrating together and integrating separately (see examples/coning.py)
-        _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
-        _imu._delta_angle_acc_dt[instance] += dt;
-
-        // save previous delta angle for coning correction
-        _imu._last_delta_angle[instance] = delta_angle;
-        _imu._last_raw_gyro[instance] = gyro;
-
-        // apply gyro filters and sample for FFT
-        apply_gyro_filters(instance, gyro);
-
-        _imu._new_gyro_data[instance] = true;
-    }
+    push_gyro_sample(instance, gyro, delta_angle, dt, last_sample_us);
 
     log_gyro_raw(instance, sample_us, gyro, _imu._gyro_filtered[instance]);
 }
@@ -508,6 +625,73 @@ void AP_InertialSensor_Backend::_publish_accel(uint8_t instance, const Vector3f
     }
 }
 
+/*
+  add a delta velocity to the frontend accumulator. Called with _sem
+  held, or by the frontend when draining the sample ring
+ */
+void AP_InertialSensor_Backend::accumulate_delta_velocity(uint8_t instance, const Vector3f &delta_velocity, float dt, bool reset)
+{
+    if (reset) {
+        // zero accumulator if sensor was unhealthy for 0.1s
+        _imu._delta_velocity_acc[instance].zero();
+        _imu._delta_velocity_acc_dt[instance] = 0;
+    }
+    _imu._delta_velocity_acc[instance] += delta_velocity;
+    _imu._delta_velocity_acc_dt[instance] += dt;
+}
+
+/*
+  apply the accel low pass filter
+ */
+void AP_InertialSensor_Backend::apply_accel_filters(const uint8_t instance, const Vector3f &accel)
+{
+    _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
+    if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
+        _imu._accel_filter[instance].reset();
+    }
+
+    _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
+}
+
+/*
+  filter an accel sample and hand it to the frontend along with its
+  delta velocity
+ */
+void AP_InertialSensor_Backend::push_accel_sample(uint8_t instance, const Vector3f &accel, float dt, uint64_t last_sample_us)
+{
+    const bool reset = AP_HAL::micros64() - last_sample_us > 100000U;
+    if (reset) {
+        dt = 0;
+    }
+
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    auto &ring = _imu._accel_ring[instance];
+    if (ring.samples != nullptr) {
+        if (ring.update_filters.exchange(false)) {
+            update_accel_filters(instance);
+        }
+
+        apply_accel_filters(instance, accel);
+
+        AP_InertialSensor::AccelSample sample;
+        sample.delta_velocity = accel * dt;
+        sample.filtered = _imu._accel_filtered[instance];
+        sample.dt = dt;
+        sample.reset = reset;
+        push_sample(ring, sample);
+        return;
+    }
+#endif
+
+    WITH_SEMAPHORE(_sem);
+
+    accumulate_delta_velocity(instance, accel * dt, dt, reset);
+
+    apply_accel_filters(instance, accel);
+
+    _imu._new_accel_data[instance] = true;
+}
+
 void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
                                                              const Vector3f &accel,
                                                              uint64_t sample_us,
@@ -551,32 +735,13 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
 #endif    
     
     _imu.calc_vibration_and_clipping(instance, accel, dt);
-
-    {
-        WITH_SEMAPHORE(_sem);
-
-        uint64_t now = AP_HAL::micros64();
-
-        if (now - last_sample_us > 100000U) {
-            // zero accumulator if sensor was unhealthy for 0.1s
-            _imu._delta_velocity_acc[instance].zero();
-            _imu._delta_velocity_acc_dt[instance] = 0;
-            dt = 0;
-        }
-        
-        // delta velocity
-        _imu._delta_velocity_acc[instance] += accel * dt;
-        _imu._delta_velocity_acc_dt[instance] += dt;
-
-        _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
-        if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
-            _imu._accel_filter[instance].reset();
-        }
-
-        _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
-
-        _imu._new_accel_data[instance] = true;
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    if (_imu._vibe_stats[instance] != nullptr) {
+        _imu._vibe_stats[instance]->push(accel);
     }
+#endif
+
+    push_accel_sample(instance, accel, dt, last_sample_us);
 
     // 5us
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
@@ -629,32 +794,13 @@ void AP_InertialSensor_Backend::_notify_new_delta_velocity(uint8_t instance, con
 #endif    
     
     _imu.calc_vibration_and_clipping(instance, accel, dt);
-
-    {
-        WITH_SEMAPHORE(_sem);
-
-        uint64_t now = AP_HAL::micros64();
-
-        if (now - last_sample_us > 100000U) {
-            // zero accumulator if sensor was unhealthy for 0.1s
-            _imu._delta_velocity_acc[instance].zero();
-            _imu._delta_velocity_acc_dt[instance] = 0;
-            dt = 0;
-        }
-        
-        // delta velocity including corrections
-        _imu._delta_velocity_acc[instance] += accel * dt;
-        _imu._delta_velocity_acc_dt[instance] += dt;
-
-        _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
-        if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
-            _imu._accel_filter[instance].reset();
-        }
-
-        _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
-
-        _imu._new_accel_data[instance] = true;
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+    if (_imu._vibe_stats[instance] != nullptr) {
+        _imu._vibe_stats[instance]->push(accel);
     }
+#endif
+
+    push_accel_sample(instance, accel, dt, last_sample_us);
 
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -758,11 +904,94 @@ void AP_InertialSensor_Backend::_publish_temperature(uint8_t instance, float tem
 #endif
 }
 
+/*
+  update the gyro lowpass and notch filter frequencies. Called by the
+  frontend with _sem held, or by the backend thread when using the
+  sample ring, in which case the notch frequencies are the copy last
+  published by the frontend
+ */
+void AP_InertialSensor_Backend::update_gyro_filters(uint8_t instance)
+{
+    // possibly update filter frequency
+    const float gyro_rate = _gyro_raw_sample_rate(instance);
+
+    if (_last_gyro_filter_hz != _gyro_filter_cutoff() || sensors_converging()) {
+        _imu._gyro_filter[instance].set_cutoff_frequency(gyro_rate, _gyro_filter_cutoff());
+#if HAL_GYROFFT_ENABLED
+        _imu._post_filter_gyro_filter[instance].set_cutoff_frequency(gyro_rate, _gyro_filter_cutoff());
+#endif
+        _last_gyro_filter_hz = _gyro_filter_cutoff();
+    }
+
+    for (auto &notch : _imu.harmonic_notches) {
+        if (!notch.params.enabled()) {
+            continue;
+        }
+        float freqs[INS_MAX_NOTCHES];
+        uint8_t num_freqs;
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+        if (_imu._gyro_ring[instance].samples != nullptr) {
+            num_freqs = notch.get_published_frequencies_hz(instance, freqs);
+        } else
+#endif
+        {
+            num_freqs = notch.get_frequencies_hz(instance, freqs);
+        }
+        if (num_freqs > 0) {
+            notch.update_params(instance, sensors_converging(), gyro_rate, num_freqs, freqs);
+        }
+    }
+}
+
+/*
+  update the accel lowpass filter frequency
+ */
+void AP_InertialSensor_Backend::update_accel_filters(uint8_t instance)
+{
+    // possibly update filter frequency
+    if (_last_accel_filter_hz != _accel_filter_cutoff()) {
+        _imu._accel_filter[instance].set_cutoff_frequency(_accel_raw_sample_rate(instance), _accel_filter_cutoff());
+        _last_accel_filter_hz = _accel_filter_cutoff();
+    }
+}
+
 /*
   common gyro update function for all backends
  */
 void AP_InertialSensor_Backend::update_gyro(uint8_t instance) /* front end */
 {    
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    auto &ring = _imu._gyro_ring[instance];
+    if (ring.samples != nullptr) {
+        AP_InertialSensor::GyroSample sample;
+        if ((1U<<instance) & _imu.imu_kill_mask) {
+            // discard samples so the ring doesn't fill while killed
+            while (ring.samples->pop(sample)) {}
+            return;
+        }
+        bool have_sample = false;
+        while (ring.samples->pop(sample)) {
+            accumulate_delta_angle(instance, sample.delta_angle, sample.dt, sample.reset);
+            have_sample = true;
+        }
+        if (have_sample) {
+            _publish_gyro(instance, sample.filtered);
+#if HAL_GYROFFT_ENABLED
+            // copy the gyro samples from the backend to the frontend window for FFTs sampling at less than IMU rate
+            _imu._gyro_for_fft[instance] = sample.gyro_for_fft;
+#endif
+        }
+        // filter frequencies are updated by the backend thread
+        for (auto &notch : _imu.harmonic_notches) {
+            if (notch.params.enabled()) {
+                notch.publish_frequencies(instance);
+            }
+        }
+        ring.update_filters.store(true);
+        return;
+    }
+#endif
+
     WITH_SEMAPHORE(_sem);
 
     if ((1U<<instance) & _imu.imu_kill_mask) {
@@ -777,22 +1006,7 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance) /* front end */
         _imu._new_gyro_data[instance] = false;
     }
 
-    // possibly update filter frequency
-    const float gyro_rate = _gyro_raw_sample_rate(instance);
-
-    if (_last_gyro_filter_hz != _gyro_filter_cutoff() || sensors_converging()) {
-        _imu._gyro_filter[instance].set_cutoff_frequency(gyro_rate, _gyro_filter_cutoff());
-#if HAL_GYROFFT_ENABLED
-        _imu._post_filter_gyro_filter[instance].set_cutoff_frequency(gyro_rate, _gyro_filter_cutoff());
-#endif
-        _last_gyro_filter_hz = _gyro_filter_cutoff();
-    }
-
-    for (auto &notch : _imu.harmonic_notches) {
-        if (notch.params.enabled()) {
-            notch.update_params(instance, sensors_converging(), gyro_rate);
-        }
-    }
+    update_gyro_filters(instance);
 }
 
 /*
@@ -800,6 +1014,28 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance) /* front end */
  */
 void AP_InertialSensor_Backend::update_accel(uint8_t instance) /* front end */
 {    
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    auto &ring = _imu._accel_ring[instance];
+    if (ring.samples != nullptr) {
+        AP_InertialSensor::AccelSample sample;
+        if ((1U<<instance) & _imu.imu_kill_mask) {
+            // discard samples so the ring doesn't fill while killed
+            while (ring.samples->pop(sample)) {}
+            return;
+        }
+        bool have_sample = false;
+        while (ring.samples->pop(sample)) {
+            accumulate_delta_velocity(instance, sample.delta_velocity, sample.dt, sample.reset);
+            have_sample = true;
+        }
+        if (have_sample) {
+            _publish_accel(instance, sample.filtered);
+        }
+        ring.update_filters.store(true);
+        return;
+    }
+#endif
+
     WITH_SEMAPHORE(_sem);
 
     if ((1U<<instance) & _imu.imu_kill_mask) {
@@ -810,11 +1046,7 @@ void AP_InertialSensor_Backend::update_accel(uint8_t instance) /* front end */
         _imu._new_accel_data[instance] = false;
     }
     
-    // possibly update filter frequency
-    if (_last_accel_filter_hz != _accel_filter_cutoff()) {
-        _imu._accel_filter[instance].set_cutoff_frequency(_accel_raw_sample_rate(instance), _accel_filter_cutoff());
-        _last_accel_filter_hz = _accel_filter_cutoff();
-    }
+    update_accel_filters(instance);
 }
 
 #if HAL_LOGGING_ENABLED
@@ -144,6 +144,11 @@ protected:
     void _rotate_and_correct_accel(uint8_t instance, Vector3f &accel) __RAMFUNC__;
     void _rotate_and_correct_gyro(uint8_t instance, Vector3f &gyro) __RAMFUNC__;
 
+    // rotate and correct a burst of raw samples from a FIFO read in
+    // place. raw_scale converts the raw values to m/s/s or rad/s
+    void _rotate_and_correct_accel_burst(uint8_t instance, Vector3f *accel, uint16_t n, float raw_scale) __RAMFUNC__;
+    void _rotate_and_correct_gyro_burst(uint8_t instance, Vector3f *gyro, uint16_t n, float raw_scale) __RAMFUNC__;
+
     // rotate gyro vector, offset and publish
     void _publish_gyro(uint8_t instance, const Vector3f &gyro) __RAMFUNC__; /* front end */
 
@@ -151,6 +156,28 @@ protected:
     void apply_gyro_filters(const uint8_t instance, const Vector3f &gyro);
     void save_gyro_window(const uint8_t instance, const Vector3f &gyro, uint8_t phase);
 
+    // apply the accel lowpass filter
+    void apply_accel_filters(const uint8_t instance, const Vector3f &accel);
+
+    // update filter frequencies from parameters and notch tracking
+    void update_gyro_filters(uint8_t instance);
+    void update_accel_filters(uint8_t instance);
+
+    // filter a sample and hand it to the frontend with its delta angle or velocity
+    void push_gyro_sample(uint8_t instance, const Vector3f &gyro, const Vector3f &delta_angle, float dt, uint64_t last_sample_us) __RAMFUNC__;
+    void push_accel_sample(uint8_t instance, const Vector3f &accel, float dt, uint64_t last_sample_us) __RAMFUNC__;
+
+    // add a delta angle or velocity to the frontend accumulators
+    void accumulate_delta_angle(uint8_t instance, Vector3f delta_angle, float dt, bool reset) __RAMFUNC__;
+    void accumulate_delta_velocity(uint8_t instance, const Vector3f &delta_velocity, float dt, bool reset) __RAMFUNC__;
+
+#if AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+    template <class T>
+    static void push_sample(AP_InertialSensor::SampleRing<T> &ring, const T &sample);
+    static void merge_sample(AP_InertialSensor::GyroSample &carry, const AP_InertialSensor::GyroSample &sample);
+    static void merge_sample(AP_InertialSensor::AccelSample &carry, const AP_InertialSensor::AccelSample &sample);
+#endif
+
     // this should be called every time a new gyro raw sample is
     // available - be it published or not the sample is raw in the
     // sense that it's not filtered yet, but it must be rotated and
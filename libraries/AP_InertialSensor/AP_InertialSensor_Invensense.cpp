@@ -27,6 +27,7 @@
 #include <AP_Logger/AP_Logger.h>
 
 #include "AP_InertialSensor_Invensense.h"
+#include "AP_InertialSensor_InvensenseFIFO.h"
 #include <GCS_MAVLink/GCS.h>
 
 extern const AP_HAL::HAL& hal;
@@ -581,47 +582,42 @@ void AP_InertialSensor_Invensense::_check_register_change(void)
 
 bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_samples)
 {
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
-        Vector3f accel, gyro;
-        bool fsync_set = false;
+    Vector3f accel[MPU_FIFO_BUFFER_LEN];
+    Vector3f gyro[MPU_FIFO_BUFFER_LEN];
+    int16_t temp[MPU_FIFO_BUFFER_LEN];
+    AP_InertialSensor_InvensenseFIFO::decode<AP_InertialSensor_InvensenseFIFO::MPU6000Layout>(samples, n_samples, accel, gyro, temp);
+
+    // use temperature to detect FIFO corruption, keeping the samples
+    // before it
+    uint8_t n_valid = 0;
+    while (n_valid < n_samples && _check_raw_temp(temp[n_valid])) {
+        n_valid++;
+    }
 
+    _rotate_and_correct_accel_burst(_accel_instance, accel, n_valid, _accel_scale);
+    _rotate_and_correct_gyro_burst(_gyro_instance, gyro, n_valid, _gyro_scale);
+
+    for (uint8_t i = 0; i < n_valid; i++) {
+        bool fsync_set = false;
 #if INVENSENSE_EXT_SYNC_ENABLE
-        fsync_set = (int16_val(data, 2) & 1U) != 0;
+        fsync_set = (int16_val((samples + MPU_SAMPLE_SIZE * i), 2) & 1U) != 0;
 #endif
-        
-        accel = Vector3f(int16_val(data, 1),
-                         int16_val(data, 0),
-                         -int16_val(data, 2));
-        accel *= _accel_scale;
+        _notify_new_accel_raw_sample(_accel_instance, accel[i], 0, fsync_set);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro[i]);
 
-        int16_t t2 = int16_val(data, 3);
-        if (!_check_raw_temp(t2)) {
-            if (_enable_fast_fifo_reset) {
-                _fast_fifo_reset();
-                return false;
-            } else {
-                if (!hal.scheduler->in_expected_delay()) {
-                    debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, t2);
-                }
-                _fifo_reset(true);
-                return false;
+        _temp_filtered = _temp_filter.apply(temp[i] * temp_sensitivity + temp_zero);
+    }
+
+    if (n_valid < n_samples) {
+        if (_enable_fast_fifo_reset) {
+            _fast_fifo_reset();
+        } else {
+            if (!hal.scheduler->in_expected_delay()) {
+                debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, temp[n_valid]);
             }
+            _fifo_reset(true);
         }
-        float temp = t2 * temp_sensitivity + temp_zero;
-        
-        gyro = Vector3f(int16_val(data, 5),
-                        int16_val(data, 4),
-                        -int16_val(data, 6));
-        gyro *= _gyro_scale;
-
-        _rotate_and_correct_accel(_accel_instance, accel);
-        _rotate_and_correct_gyro(_gyro_instance, gyro);
-
-        _notify_new_accel_raw_sample(_accel_instance, accel, 0, fsync_set);
-        _notify_new_gyro_raw_sample(_gyro_instance, gyro);
-
-        _temp_filtered = _temp_filter.apply(temp);
+        return false;
     }
     return true;
 }
@@ -640,12 +636,15 @@ bool AP_InertialSensor_Invensense::_accumulate_sensor_rate_sampling(uint8_t *sam
     const int32_t unscaled_clip_limit = _clip_limit / _accel_scale;
     bool clipped = false;
     bool ret = true;
+
+    Vector3f accel[MPU_FIFO_BUFFER_LEN];
+    Vector3f gyro[MPU_FIFO_BUFFER_LEN];
+    int16_t temp[MPU_FIFO_BUFFER_LEN];
+    AP_InertialSensor_InvensenseFIFO::decode<AP_InertialSensor_InvensenseFIFO::MPU6000Layout>(samples, n_samples, accel, gyro, temp);
     
     for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
-
         // use temperature to detect FIFO corruption
-        int16_t t2 = int16_val(data, 3);
+        const int16_t t2 = temp[i];
         if (!_check_raw_temp(t2)) {
             if (_enable_fast_fifo_reset) {
                 _fast_fifo_reset();
@@ -663,12 +662,8 @@ bool AP_InertialSensor_Invensense::_accumulate_sensor_rate_sampling(uint8_t *sam
 
         if (_accum.gyro_count % _gyro_to_accel_sample_ratio == 0) {
             // accel data is at 4kHz or 1kHz
-            Vector3f a(int16_val(data, 1),
-                       int16_val(data, 0),
-                       -int16_val(data, 2));
-            if (fabsf(a.x) > unscaled_clip_limit ||
-                fabsf(a.y) > unscaled_clip_limit ||
-                fabsf(a.z) > unscaled_clip_limit) {
+            const Vector3f &a = accel[i];
+            if (AP_InertialSensor_InvensenseFIFO::clipped(a, unscaled_clip_limit)) {
                 clipped = true;
             }
             _accum.accel += _accum.accel_filter.apply(a);
@@ -691,9 +686,7 @@ bool AP_InertialSensor_Invensense::_accumulate_sensor_rate_sampling(uint8_t *sam
 
         _accum.gyro_count++;
 
-        Vector3f g(int16_val(data, 5),
-                   int16_val(data, 4),
-                   -int16_val(data, 6));
+        const Vector3f &g = gyro[i];
 
         Vector3f g2 = g * _gyro_scale;
         _notify_new_gyro_sensor_rate_sample(_gyro_instance, g2);
@@ -0,0 +1,120 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  decoding of Invensense FIFO bursts, shared by the Invensense,
+  Invensensev2 and Invensensev3 backends
+
+  A burst is decoded in one pass into unscaled accel and gyro vectors
+  in the driver frame and raw temperatures. The layout of each sample
+  is a compile time parameter, so the loop has no data dependent
+  branches other than the header check and can be unrolled by the
+  compiler. Checks that need the device, such as
+  the temperature based corruption check, stay in the backends
+ */
+class AP_InertialSensor_InvensenseFIFO {
+public:
+    /*
+      MPU6000, MPU9250 and ICM20xxx: big-endian accel, temperature
+      then gyro, with X and Y swapped and Z negated
+     */
+    struct MPU6000Layout {
+        static constexpr uint8_t sample_size = 14;
+        static constexpr bool big_endian = true;
+        static constexpr bool swap_xy = true;
+        static constexpr uint8_t header_mask = 0;
+        static constexpr uint8_t header_value = 0;
+        static constexpr uint8_t accel_ofs = 0;
+        static constexpr uint8_t gyro_ofs = 8;
+        static constexpr uint8_t temp_ofs = 6;
+        static constexpr uint8_t temp_bytes = 2;
+    };
+
+    /*
+      ICM20948 and ICM20649: as above with the temperature last
+     */
+    struct ICM20948Layout {
+        static constexpr uint8_t sample_size = 14;
+        static constexpr bool big_endian = true;
+        static constexpr bool swap_xy = true;
+        static constexpr uint8_t header_mask = 0;
+        static constexpr uint8_t header_value = 0;
+        static constexpr uint8_t accel_ofs = 0;
+        static constexpr uint8_t gyro_ofs = 6;
+        static constexpr uint8_t temp_ofs = 12;
+        static constexpr uint8_t temp_bytes = 2;
+    };
+
+    /*
+      ICM426xx and ICM4xxxx 16 byte packets: a header, little-endian
+      accel and gyro, 8 bit temperature and a timestamp
+     */
+    struct ICM426xxLayout {
+        static constexpr uint8_t sample_size = 16;
+        static constexpr bool big_endian = false;
+        static constexpr bool swap_xy = false;
+        static constexpr uint8_t header_mask = 0xFC;
+        static constexpr uint8_t header_value = 0x68;  // ACCEL_EN | GYRO_EN | TMST_FIELD_EN
+        static constexpr uint8_t accel_ofs = 1;
+        static constexpr uint8_t gyro_ofs = 7;
+        static constexpr uint8_t temp_ofs = 13;
+        static constexpr uint8_t temp_bytes = 1;
+    };
+
+    /*
+      decode n samples from a FIFO read. Returns the number of samples
+      decoded, which is less than n if a sample has a bad header
+     */
+    template <class Layout>
+    static uint8_t decode(const uint8_t *fifo, uint8_t n, Vector3f *accel, Vector3f *gyro, int16_t *temp);
+
+    // true if any axis of an unscaled accel sample is over the limit
+    static bool clipped(const Vector3f &accel, float limit) {
+        return fabsf(accel.x) > limit || fabsf(accel.y) > limit || fabsf(accel.z) > limit;
+    }
+
+private:
+    template <bool big_endian>
+    static int16_t int16_val(const uint8_t *p) {
+        return big_endian ? int16_t((uint16_t(p[0]) << 8) | p[1]) : int16_t((uint16_t(p[1]) << 8) | p[0]);
+    }
+
+    template <class Layout>
+    static Vector3f vector_val(const uint8_t *p) {
+        const float x = int16_val<Layout::big_endian>(&p[0]);
+        const float y = int16_val<Layout::big_endian>(&p[2]);
+        const float z = int16_val<Layout::big_endian>(&p[4]);
+        return Layout::swap_xy ? Vector3f{y, x, -z} : Vector3f{x, y, z};
+    }
+};
+
+template <class Layout>
+uint8_t AP_InertialSensor_InvensenseFIFO::decode(const uint8_t *fifo, uint8_t n, Vector3f *accel, Vector3f *gyro, int16_t *temp)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t *d = &fifo[i * Layout::sample_size];
+        if (Layout::header_mask != 0 && (d[0] & Layout::header_mask) != Layout::header_value) {
+            // no or bad data
+            return i;
+        }
+        accel[i] = vector_val<Layout>(&d[Layout::accel_ofs]);
+        gyro[i] = vector_val<Layout>(&d[Layout::gyro_ofs]);
+        temp[i] = Layout::temp_bytes == 1 ? int16_t(int8_t(d[Layout::temp_ofs])) : int16_val<Layout::big_endian>(&d[Layout::temp_ofs]);
+    }
+    return n;
+}
@@ -24,6 +24,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "AP_InertialSensor_Invensensev2.h"
+#include "AP_InertialSensor_InvensenseFIFO.h"
 
 extern const AP_HAL::HAL& hal;
 
@@ -324,42 +325,38 @@ void AP_InertialSensor_Invensensev2::_poll_data()
 
 bool AP_InertialSensor_Invensensev2::_accumulate(uint8_t *samples, uint8_t n_samples)
 {
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + INV2_SAMPLE_SIZE * i;
-        Vector3f accel, gyro;
-        bool fsync_set = false;
+    Vector3f accel[INV2_FIFO_BUFFER_LEN];
+    Vector3f gyro[INV2_FIFO_BUFFER_LEN];
+    int16_t temp[INV2_FIFO_BUFFER_LEN];
+    AP_InertialSensor_InvensenseFIFO::decode<AP_InertialSensor_InvensenseFIFO::ICM20948Layout>(samples, n_samples, accel, gyro, temp);
 
-#if INVENSENSE_EXT_SYNC_ENABLE
-        fsync_set = (int16_val(data, 2) & 1U) != 0;
-#endif
-        
-        accel = Vector3f(int16_val(data, 1),
-                         int16_val(data, 0),
-                         -int16_val(data, 2));
-        accel *= _accel_scale;
+    // use temperature to detect FIFO corruption, keeping the samples
+    // before it
+    uint8_t n_valid = 0;
+    while (n_valid < n_samples && _check_raw_temp(temp[n_valid])) {
+        n_valid++;
+    }
 
-        int16_t t2 = int16_val(data, 6);
-        if (!_check_raw_temp(t2)) {
-            if (!hal.scheduler->in_expected_delay()) {
-                debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, t2);
-            }
-            _fifo_reset();
-            return false;
-        }
-        float temp = t2 * temp_sensitivity + temp_zero;
-        
-        gyro = Vector3f(int16_val(data, 4),
-                        int16_val(data, 3),
-                        -int16_val(data, 5));
-        gyro *= GYRO_SCALE;
+    _rotate_and_correct_accel_burst(_accel_instance, accel, n_valid, _accel_scale);
+    _rotate_and_correct_gyro_burst(_gyro_instance, gyro, n_valid, GYRO_SCALE);
 
-        _rotate_and_correct_accel(_accel_instance, accel);
-        _rotate_and_correct_gyro(_gyro_instance, gyro);
+    for (uint8_t i = 0; i < n_valid; i++) {
+        bool fsync_set = false;
+#if INVENSENSE_EXT_SYNC_ENABLE
+        fsync_set = (int16_val((samples + INV2_SAMPLE_SIZE * i), 2) & 1U) != 0;
+#endif
+        _notify_new_accel_raw_sample(_accel_instance, accel[i], 0, fsync_set);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro[i]);
 
-        _notify_new_accel_raw_sample(_accel_instance, accel, 0, fsync_set);
-        _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+        _temp_filtered = _temp_filter.apply(temp[i] * temp_sensitivity + temp_zero);
+    }
 
-        _temp_filtered = _temp_filter.apply(temp);
+    if (n_valid < n_samples) {
+        if (!hal.scheduler->in_expected_delay()) {
+            debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, temp[n_valid]);
+        }
+        _fifo_reset();
+        return false;
     }
     return true;
 }
@@ -379,11 +376,14 @@ bool AP_InertialSensor_Invensensev2::_accumulate_sensor_rate_sampling(uint8_t *s
     bool clipped = false;
     bool ret = true;
 
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + INV2_SAMPLE_SIZE * i;
+    Vector3f accel[INV2_FIFO_BUFFER_LEN];
+    Vector3f gyro[INV2_FIFO_BUFFER_LEN];
+    int16_t temp[INV2_FIFO_BUFFER_LEN];
+    AP_InertialSensor_InvensenseFIFO::decode<AP_InertialSensor_InvensenseFIFO::ICM20948Layout>(samples, n_samples, accel, gyro, temp);
 
+    for (uint8_t i = 0; i < n_samples; i++) {
         // use temperature to detect FIFO corruption
-        int16_t t2 = int16_val(data, 6);
+        const int16_t t2 = temp[i];
         if (!_check_raw_temp(t2)) {
             if (!hal.scheduler->in_expected_delay()) {
                 debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, t2);
@@ -395,12 +395,8 @@ bool AP_InertialSensor_Invensensev2::_accumulate_sensor_rate_sampling(uint8_t *s
         tsum += t2;
         if (_accum.gyro_count % 2 == 0) {
             // accel data is at 4kHz or 1kHz
-            Vector3f a(int16_val(data, 1),
-                       int16_val(data, 0),
-                       -int16_val(data, 2));
-            if (fabsf(a.x) > unscaled_clip_limit ||
-                fabsf(a.y) > unscaled_clip_limit ||
-                fabsf(a.z) > unscaled_clip_limit) {
+            const Vector3f &a = accel[i];
+            if (AP_InertialSensor_InvensenseFIFO::clipped(a, unscaled_clip_limit)) {
                 clipped = true;
             }
             _accum.accel += _accum.accel_filter.apply(a);
@@ -423,9 +419,7 @@ bool AP_InertialSensor_Invensensev2::_accumulate_sensor_rate_sampling(uint8_t *s
 
         _accum.gyro_count++;
 
-        Vector3f g(int16_val(data, 4),
-                   int16_val(data, 3),
-                   -int16_val(data, 5));
+        const Vector3f &g = gyro[i];
 
         Vector3f g2 = g * GYRO_SCALE;
         _notify_new_gyro_sensor_rate_sample(_gyro_instance, g2);
@@ -32,6 +32,7 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include "AP_InertialSensor_Invensensev3.h"
+#include "AP_InertialSensor_InvensenseFIFO.h"
 #include <utility>
 #include <stdio.h>
 #include <GCS_MAVLink/GCS.h>
@@ -407,43 +408,36 @@ void AP_InertialSensor_Invensensev3::accumulate()
 
 bool AP_InertialSensor_Invensensev3::accumulate_samples(const FIFOData *data, uint8_t n_samples)
 {
-#if INV3_ENABLE_FIFO_LOGGING
-    const uint64_t tstart = AP_HAL::micros64();
-#endif
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const FIFOData &d = data[i];
-
-        // we have a header to confirm we don't have FIFO corruption! no more mucking
-        // about with the temperature registers
-        // ICM45686 - TMST_FIELD_EN bit 3 : 1
-        // ICM42688 - HEADER_TIMESTAMP_FSYNC bit 2-3 : 10
-        if ((d.header & 0xFC) != 0x68) { // ACCEL_EN | GYRO_EN | TMST_FIELD_EN
-            // no or bad data
-            return false;
-        }
-
-        Vector3f accel{float(d.accel[0]), float(d.accel[1]), float(d.accel[2])};
-        Vector3f gyro{float(d.gyro[0]), float(d.gyro[1]), float(d.gyro[2])};
-
-        accel *= accel_scale;
-        gyro *= gyro_scale;
+    Vector3f accel[INV3_FIFO_BUFFER_LEN];
+    Vector3f gyro[INV3_FIFO_BUFFER_LEN];
+    int16_t temp[INV3_FIFO_BUFFER_LEN];
+
+    // we have a header to confirm we don't have FIFO corruption! no more mucking
+    // about with the temperature registers. Samples before a bad header are used
+    // ICM45686 - TMST_FIELD_EN bit 3 : 1
+    // ICM42688 - HEADER_TIMESTAMP_FSYNC bit 2-3 : 10
+    static_assert(sizeof(FIFOData) == AP_InertialSensor_InvensenseFIFO::ICM426xxLayout::sample_size, "FIFO layout");
+    const uint8_t n_valid = AP_InertialSensor_InvensenseFIFO::decode<AP_InertialSensor_InvensenseFIFO::ICM426xxLayout>(
+        (const uint8_t *)data, n_samples, accel, gyro, temp);
 
 #if INV3_ENABLE_FIFO_LOGGING
-        Write_GYR(gyro_instance, tstart+(i*backend_period_us), gyro, true);
+    const uint64_t tstart = AP_HAL::micros64();
+    for (uint8_t i = 0; i < n_valid; i++) {
+        Write_GYR(gyro_instance, tstart+(i*backend_period_us), gyro[i]*gyro_scale, true);
+    }
 #endif
 
-        const float temp = d.temperature * temp_sensitivity + temp_zero;
-
-        // these four calls are about 40us
-        _rotate_and_correct_accel(accel_instance, accel);
-        _rotate_and_correct_gyro(gyro_instance, gyro);
+    // correct the whole burst in one pass, then notify the samples
+    _rotate_and_correct_accel_burst(accel_instance, accel, n_valid, accel_scale);
+    _rotate_and_correct_gyro_burst(gyro_instance, gyro, n_valid, gyro_scale);
 
-        _notify_new_accel_raw_sample(accel_instance, accel, 0);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro);
+    for (uint8_t i = 0; i < n_valid; i++) {
+        _notify_new_accel_raw_sample(accel_instance, accel[i], 0);
+        _notify_new_gyro_raw_sample(gyro_instance, gyro[i]);
 
-        temp_filtered = temp_filter.apply(temp);
+        temp_filtered = temp_filter.apply(temp[i] * temp_sensitivity + temp_zero);
     }
-    return true;
+    return n_valid == n_samples;
 }
 
 #if HAL_INS_HIGHRES_SAMPLE
@@ -468,6 +462,9 @@ static inline float uint20_to_float(uint8_t msb, uint8_t bits, uint8_t lsb)
 
 bool AP_InertialSensor_Invensensev3::accumulate_highres_samples(const FIFODataHighRes *data, uint8_t n_samples)
 {
+    Vector3f accel[INV3_FIFO_BUFFER_LEN];
+    Vector3f gyro[INV3_FIFO_BUFFER_LEN];
+    uint8_t n_valid = 0;
     for (uint8_t i = 0; i < n_samples; i++) {
         const FIFODataHighRes &d = data[i];
 
@@ -475,31 +472,29 @@ bool AP_InertialSensor_Invensensev3::accumulate_highres_samples(const FIFODataHi
         // about with the temperature registers
         if ((d.header & 0xFC) != 0x78) { // ACCEL_EN | GYRO_EN | HIRES_EN | TMST_FIELD_EN
             // no or bad data
-            return false;
+            break;
         }
 
-        Vector3f accel{uint20_to_float(d.accel[1], d.accel[0], d.ax),
+        accel[i] = Vector3f{uint20_to_float(d.accel[1], d.accel[0], d.ax),
             uint20_to_float(d.accel[3], d.accel[2], d.ay),
             uint20_to_float(d.accel[5], d.accel[4], d.az)};
-        Vector3f gyro{uint20_to_float(d.gyro[1], d.gyro[0], d.gx),
+        gyro[i] = Vector3f{uint20_to_float(d.gyro[1], d.gyro[0], d.gx),
             uint20_to_float(d.gyro[3], d.gyro[2], d.gy),
             uint20_to_float(d.gyro[5], d.gyro[4], d.gz)};
+        n_valid++;
+    }
 
-        accel *= accel_scale;
-        gyro *= gyro_scale;
-
-        const float temp = d.temperature * temp_sensitivity + temp_zero;
-
-        // these four calls are about 40us
-        _rotate_and_correct_accel(accel_instance, accel);
-        _rotate_and_correct_gyro(gyro_instance, gyro);
+    _rotate_and_correct_accel_burst(accel_instance, accel, n_valid, accel_scale);
+    _rotate_and_correct_gyro_burst(gyro_instance, gyro, n_valid, gyro_scale);
 
-        _notify_new_accel_raw_sample(accel_instance, accel, 0);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro);
+    for (uint8_t i = 0; i < n_valid; i++) {
+        _notify_new_accel_raw_sample(accel_instance, accel[i], 0);
+        _notify_new_gyro_raw_sample(gyro_instance, gyro[i]);
 
+        const float temp = data[i].temperature * temp_sensitivity + temp_zero;
         temp_filtered = temp_filter.apply(temp);
     }
-    return true;
+    return n_valid == n_samples;
 }
 #endif
 
@@ -10,8 +10,14 @@
 // Write ACC data packet: raw accel data
 void AP_InertialSensor_Backend::Write_ACC(const uint8_t instance, const uint64_t sample_us, const Vector3f &accel) const
 {
+        // logged at the sensor rate, so build the message in place
+        AP_Logger &logger = AP::logger();
+        struct log_ACC *pkt = (struct log_ACC *)logger.ReserveBlock(LOG_ACC_MSG, sizeof(struct log_ACC));
+        if (pkt == nullptr) {
+            return;
+        }
         const uint64_t now = AP_HAL::micros64();
-        const struct log_ACC pkt {
+        *pkt = log_ACC {
             LOG_PACKET_HEADER_INIT(LOG_ACC_MSG),
             time_us   : now,
             instance  : instance,
@@ -20,14 +26,20 @@ void AP_InertialSensor_Backend::Write_ACC(const uint8_t instance, const uint64_t
             AccY      : accel.y,
             AccZ      : accel.z
         };
-        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+        logger.CommitBlock();
 }
 
 // Write GYR data packet: raw gyro data
 void AP_InertialSensor_Backend::Write_GYR(const uint8_t instance, const uint64_t sample_us, const Vector3f &gyro, bool use_sample_timestamp) const
 {
+        // logged at the sensor rate, so build the message in place
+        AP_Logger &logger = AP::logger();
+        struct log_GYR *pkt = (struct log_GYR *)logger.ReserveBlock(LOG_GYR_MSG, sizeof(struct log_GYR));
+        if (pkt == nullptr) {
+            return;
+        }
         const uint64_t now = use_sample_timestamp?sample_us:AP_HAL::micros64();
-        const struct log_GYR pkt{
+        *pkt = log_GYR {
             LOG_PACKET_HEADER_INIT(LOG_GYR_MSG),
             time_us   : now,
             instance  : instance,
@@ -36,15 +48,20 @@ void AP_InertialSensor_Backend::Write_GYR(const uint8_t instance, const uint64_t
             GyrY      : gyro.y,
             GyrZ      : gyro.z
         };
-        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+        logger.CommitBlock();
 }
 
 // Write IMU data packet: raw accel/gyro data
 void AP_InertialSensor::Write_IMU_instance(const uint64_t time_us, const uint8_t imu_instance) const
 {
+    AP_Logger &logger = AP::logger();
+    struct log_IMU *pkt = (struct log_IMU *)logger.ReserveBlock(LOG_IMU_MSG, sizeof(struct log_IMU));
+    if (pkt == nullptr) {
+        return;
+    }
     const Vector3f &gyro = get_gyro(imu_instance);
     const Vector3f &accel = get_accel(imu_instance);
-    const struct log_IMU pkt{
+    *pkt = log_IMU {
         LOG_PACKET_HEADER_INIT(LOG_IMU_MSG),
         time_us : time_us,
         instance: imu_instance,
@@ -62,7 +79,7 @@ void AP_InertialSensor::Write_IMU_instance(const uint64_t time_us, const uint8_t
         gyro_rate : get_gyro_rate_hz(imu_instance),
         accel_rate : get_accel_rate_hz(imu_instance),
     };
-    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    logger.CommitBlock();
 }
 
 // Write IMU data packet for all instances
@@ -96,6 +113,31 @@ void AP_InertialSensor::Write_Vibration() const
             clipping    : get_accel_clip_count(i)
         };
         AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+        // statistics are written once for each completed window
+        AP_InertialSensor_VibeStats::Stats stats;
+        if (_vibe_stats[i] != nullptr && _vibe_stats[i]->get_new_stats(stats)) {
+            const struct log_VibeStats spkt{
+                LOG_PACKET_HEADER_INIT(LOG_VIBS_MSG),
+                time_us     : time_us,
+                imu         : i,
+                rms_x       : stats.rms.x,
+                rms_y       : stats.rms.y,
+                rms_z       : stats.rms.z,
+                kurtosis_x  : stats.kurtosis.x,
+                kurtosis_y  : stats.kurtosis.y,
+                kurtosis_z  : stats.kurtosis.z,
+                crest_x     : stats.crest_factor.x,
+                crest_y     : stats.crest_factor.y,
+                crest_z     : stats.crest_factor.z,
+                samples     : stats.samples,
+                clips       : stats.clips,
+                dropped     : stats.dropped,
+            };
+            AP::logger().WriteBlock(&spkt, sizeof(spkt));
+        }
+#endif
     }
 }
 
@@ -0,0 +1,56 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define AP_INLINE_VECTOR_OPS
+
+#include "AP_InertialSensor_SampleCorrection.h"
+
+void AP_InertialSensor_SampleCorrection::setup(enum Rotation sensor_rotation, enum Rotation board_rotation,
+                                               float raw_scale, const Vector3f &offset, const Vector3f &scale)
+{
+    Matrix3f sensor;
+    sensor.from_rotation(sensor_rotation);
+    Matrix3f board;
+    board.from_rotation(board_rotation);
+
+    // board * diag(scale)
+    Matrix3f board_scaled = board;
+    for (uint8_t i=0; i<3; i++) {
+        board_scaled[i].x *= scale.x;
+        board_scaled[i].y *= scale.y;
+        board_scaled[i].z *= scale.z;
+    }
+
+    mat = board_scaled * sensor * raw_scale;
+    ofs = -(board_scaled * offset);
+}
+
+void AP_InertialSensor_SampleCorrection::apply(Vector3f *samples, uint16_t n) const
+{
+    // copy to locals so the compiler knows the samples don't alias
+    // the transform
+    const float m00 = mat.a.x, m01 = mat.a.y, m02 = mat.a.z;
+    const float m10 = mat.b.x, m11 = mat.b.y, m12 = mat.b.z;
+    const float m20 = mat.c.x, m21 = mat.c.y, m22 = mat.c.z;
+    const float o0 = ofs.x, o1 = ofs.y, o2 = ofs.z;
+
+    for (uint16_t i=0; i<n; i++) {
+        Vector3f &v = samples[i];
+        const float x = v.x, y = v.y, z = v.z;
+        v.x = m00*x + m01*y + m02*z + o0;
+        v.y = m10*x + m11*y + m12*z + o1;
+        v.z = m20*x + m21*y + m22*z + o2;
+    }
+}
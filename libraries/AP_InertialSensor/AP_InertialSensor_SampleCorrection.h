@@ -0,0 +1,51 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  correction of a burst of raw IMU samples in a single pass
+
+  The per-sample path rotates for the sensor orientation, applies the
+  temperature correction, offsets and scale factors and then rotates
+  to the body frame. Within a FIFO burst the orientations,
+  calibration and temperature are all fixed, so the whole chain is an
+  affine transform
+
+     out = board * diag(scale) * (sensor * raw_scale * in - offset)
+
+  which is folded into one matrix and offset per burst.
+ */
+class AP_InertialSensor_SampleCorrection {
+public:
+    /*
+      setup the transform. The offset is in the sensor frame after the
+      sensor rotation, and includes any temperature correction
+     */
+    void setup(enum Rotation sensor_rotation, enum Rotation board_rotation,
+               float raw_scale, const Vector3f &offset, const Vector3f &scale);
+
+    // correct n samples in place
+    void apply(Vector3f *samples, uint16_t n) const __RAMFUNC__;
+
+    const Matrix3f &get_matrix() const { return mat; }
+    const Vector3f &get_offset() const { return ofs; }
+
+private:
+    Matrix3f mat;
+    Vector3f ofs;
+};
@@ -0,0 +1,222 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma GCC optimize("O2")
+
+#include "AP_InertialSensor_VibeStats.h"
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+#include <float.h>
+
+AP_InertialSensor_VibeStats::AP_InertialSensor_VibeStats(uint16_t ring_length) :
+    samples(ring_length),
+    dropped(0),
+    have_ref(false),
+    window_start_ms(0),
+    dropped_at_start(0),
+    last{},
+    have_stats(false),
+    new_stats(false)
+{
+    sums.reset();
+}
+
+void AP_InertialSensor_VibeStats::Sums::reset()
+{
+    s1.zero();
+    s2.zero();
+    s3.zero();
+    s4.zero();
+    max = Vector3f{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    min = Vector3f{FLT_MAX, FLT_MAX, FLT_MAX};
+    count = 0;
+    clips = 0;
+}
+
+/*
+  add a batch of samples to the sums. Samples are taken relative to
+  ref, which is close to the mean, so the sums of powers stay well
+  conditioned in single precision.
+
+  The samples are taken four at a time as twelve floats, each with
+  its own partial sums, maximum and minimum. The lanes don't depend
+  on each other, so the compiler can use SIMD instructions where
+  there are any and the FPU pipeline where there aren't
+ */
+void AP_InertialSensor_VibeStats::accumulate(const Vector3f *v, uint32_t n, const Vector3f &ref, float clip_limit, Sums &sums)
+{
+    static_assert(sizeof(Vector3f) == 3*sizeof(float), "Vector3f must be three packed floats");
+    const uint8_t lanes = 12;
+    float r[lanes];
+    float p1[lanes] {}, p2[lanes] {}, p3[lanes] {}, p4[lanes] {};
+    float pmax[lanes], pmin[lanes];
+    for (uint8_t k=0; k<lanes; k++) {
+        r[k] = ref[k % 3];
+        pmax[k] = -FLT_MAX;
+        pmin[k] = FLT_MAX;
+    }
+
+    const float *f = &v[0].x;
+    uint32_t clips = 0;
+    for (uint32_t b=0; b<n/4; b++, f+=lanes) {
+        float mag[lanes];
+        for (uint8_t k=0; k<lanes; k++) {
+            const float d = f[k] - r[k];
+            const float d2 = d*d;
+            p1[k] += d;
+            p2[k] += d2;
+            p3[k] += d2*d;
+            p4[k] += d2*d2;
+            pmax[k] = d > pmax[k] ? d : pmax[k];
+            pmin[k] = d < pmin[k] ? d : pmin[k];
+            mag[k] = fabsf(f[k]);
+        }
+        for (uint8_t k=0; k<lanes; k+=3) {
+            if (MAX(mag[k], MAX(mag[k+1], mag[k+2])) > clip_limit) {
+                clips++;
+            }
+        }
+    }
+
+    // the last few samples go into the first lanes
+    for (uint32_t i=0; i<n%4; i++, f+=3) {
+        if (fabsf(f[0]) > clip_limit ||
+            fabsf(f[1]) > clip_limit ||
+            fabsf(f[2]) > clip_limit) {
+            clips++;
+        }
+        for (uint8_t a=0; a<3; a++) {
+            const float d = f[a] - r[a];
+            const float d2 = d*d;
+            p1[a] += d;
+            p2[a] += d2;
+            p3[a] += d2*d;
+            p4[a] += d2*d2;
+            pmax[a] = MAX(d, pmax[a]);
+            pmin[a] = MIN(d, pmin[a]);
+        }
+    }
+
+    for (uint8_t k=0; k<lanes; k++) {
+        const uint8_t a = k % 3;
+        sums.s1[a] += p1[k];
+        sums.s2[a] += p2[k];
+        sums.s3[a] += p3[k];
+        sums.s4[a] += p4[k];
+        sums.max[a] = MAX(sums.max[a], pmax[k]);
+        sums.min[a] = MIN(sums.min[a], pmin[k]);
+    }
+    sums.clips += clips;
+    sums.count += n;
+}
+
+/*
+  turn the sums into central moments
+ */
+void AP_InertialSensor_VibeStats::calculate(const Sums &sums, Stats &stats)
+{
+    stats.samples = MIN(sums.count, uint32_t(UINT16_MAX));
+    stats.clips = MIN(sums.clips, uint32_t(UINT16_MAX));
+    stats.rms.zero();
+    stats.kurtosis.zero();
+    stats.crest_factor.zero();
+    if (sums.count < 2) {
+        return;
+    }
+    const float inv_n = 1.0f / sums.count;
+    for (uint8_t a=0; a<3; a++) {
+        const float m = sums.s1[a] * inv_n;
+        const float e2 = sums.s2[a] * inv_n;
+        const float e3 = sums.s3[a] * inv_n;
+        const float e4 = sums.s4[a] * inv_n;
+        const float m2 = m*m;
+        const float var = MAX(e2 - m2, 0);
+        const float c4 = e4 - 4*m*e3 + 6*m2*e2 - 3*m2*m2;
+        const float rms = sqrtf(var);
+        stats.rms[a] = rms;
+        if (var > FLT_EPSILON) {
+            stats.kurtosis[a] = MAX(c4, 0) / (var*var);
+            stats.crest_factor[a] = MAX(sums.max[a] - m, m - sums.min[a]) / rms;
+        }
+    }
+}
+
+/*
+  take the samples from the ring and finish the window if it is time
+ */
+void AP_InertialSensor_VibeStats::update(float clip_limit, uint32_t now_ms)
+{
+    // the ring can wrap, so the samples come in at most two arrays
+    for (uint8_t part=0; part<2; part++) {
+        uint32_t n;
+        const Vector3f *v = samples.readptr(n);
+        if (v == nullptr) {
+            break;
+        }
+        if (!have_ref) {
+            // take the first window about its first sample
+            ref = v[0];
+            have_ref = true;
+        }
+        accumulate(v, n, ref, clip_limit, sums);
+        samples.advance(n);
+    }
+
+    const uint32_t total_dropped = dropped.load(std::memory_order_relaxed);
+    if (window_start_ms == 0) {
+        window_start_ms = now_ms;
+        dropped_at_start = total_dropped;
+        return;
+    }
+    if (now_ms - window_start_ms < AP_INERTIALSENSOR_VIBE_STATS_WINDOW_MS) {
+        return;
+    }
+
+    calculate(sums, last);
+    last.end_ms = now_ms;
+    last.dropped = MIN(total_dropped - dropped_at_start, uint32_t(UINT16_MAX));
+    have_stats = true;
+    new_stats = true;
+
+    // take the next window about the mean of this one
+    if (sums.count > 0) {
+        ref += sums.s1 / sums.count;
+    }
+    sums.reset();
+    window_start_ms = now_ms;
+    dropped_at_start = total_dropped;
+}
+
+bool AP_InertialSensor_VibeStats::get_stats(Stats &stats) const
+{
+    if (!have_stats) {
+        return false;
+    }
+    stats = last;
+    return true;
+}
+
+bool AP_InertialSensor_VibeStats::get_new_stats(Stats &stats)
+{
+    if (!new_stats) {
+        return false;
+    }
+    new_stats = false;
+    stats = last;
+    return true;
+}
+
+#endif // AP_INERTIALSENSOR_VIBE_STATS_ENABLED
@@ -0,0 +1,104 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "AP_InertialSensor_config.h"
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+#include <atomic>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  vibration statistics for one accelerometer
+
+  The backend thread pushes each corrected sensor rate sample into a
+  ring. Once per loop the frontend takes the samples as arrays and
+  adds them to per-axis sums of powers, so the statistics cost a copy
+  per sample on the backend thread and a loop per batch on the main
+  thread. At the end of each window the sums are turned into
+  RMS, kurtosis and crest factor about the window mean.
+ */
+class AP_InertialSensor_VibeStats {
+public:
+    AP_InertialSensor_VibeStats(uint16_t ring_length);
+
+    CLASS_NO_COPY(AP_InertialSensor_VibeStats);
+
+    // true if the ring was allocated
+    bool valid() const { return samples.get_size() != 0; }
+
+    struct Stats {
+        uint32_t end_ms;        // time the window finished
+        Vector3f rms;           // m/s/s about the window mean
+        Vector3f kurtosis;      // 3 for gaussian vibration, higher when impulsive
+        Vector3f crest_factor;  // largest deviation from the mean over rms
+        uint16_t samples;       // samples in the window
+        uint16_t clips;         // samples with any axis over the clip limit
+        uint16_t dropped;       // samples lost because the ring was full
+    };
+
+    /*
+      sums of powers of the samples about a reference, used to
+      calculate the central moments at the end of the window
+     */
+    struct Sums {
+        Vector3f s1, s2, s3, s4;
+        Vector3f max, min;
+        uint32_t count;
+        uint32_t clips;
+        void reset();
+    };
+
+    // add a batch of samples to sums, relative to ref. Called from
+    // update(), and public for testing and benchmarking
+    static void accumulate(const Vector3f *v, uint32_t n, const Vector3f &ref, float clip_limit, Sums &sums);
+
+    // calculate the statistics of the samples in sums
+    static void calculate(const Sums &sums, Stats &stats);
+
+    // called from the backend thread for each sample
+    void push(const Vector3f &accel) {
+        if (!samples.push(accel)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // called once per loop by the frontend
+    void update(float clip_limit, uint32_t now_ms);
+
+    // latest completed window, false if there isn't one yet
+    bool get_stats(Stats &stats) const;
+
+    // latest completed window if it hasn't been returned before
+    bool get_new_stats(Stats &stats);
+
+private:
+    ObjectBuffer_SPSC<Vector3f> samples;
+    std::atomic<uint32_t> dropped;
+
+    Sums sums;
+    Vector3f ref;
+    bool have_ref;
+    uint32_t window_start_ms;
+    uint32_t dropped_at_start;
+
+    Stats last;
+    bool have_stats;
+    bool new_stats;
+};
+
+#endif // AP_INERTIALSENSOR_VIBE_STATS_ENABLED
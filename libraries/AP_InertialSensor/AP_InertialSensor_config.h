@@ -60,6 +60,37 @@
 #define AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED (AP_INERTIALSENSOR_ENABLED && HAL_LOGGING_ENABLED)
 #endif
 
+// streaming of batch samples from every IMU to a separate file
+#ifndef AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+#define AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED (AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
 #ifndef AP_INERTIALSENSOR_KILL_IMU_ENABLED
 #define AP_INERTIALSENSOR_KILL_IMU_ENABLED 1
 #endif
+
+// hand samples from backend threads to the frontend through a lock
+// free ring instead of taking the backend semaphore for every sample
+#ifndef AP_INERTIALSENSOR_SAMPLE_RING_ENABLED
+#define AP_INERTIALSENSOR_SAMPLE_RING_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// samples held per instance, enough for an 8kHz IMU with a 50Hz loop
+#ifndef AP_INERTIALSENSOR_SAMPLE_RING_LENGTH
+#define AP_INERTIALSENSOR_SAMPLE_RING_LENGTH 160
+#endif
+
+// per-axis vibration statistics (RMS, kurtosis, crest factor and
+// clipping) calculated in batches from the sensor rate accel samples
+#ifndef AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+#define AP_INERTIALSENSOR_VIBE_STATS_ENABLED (HAL_LOGGING_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
+// accel samples held per instance between main loop updates
+#ifndef AP_INERTIALSENSOR_VIBE_STATS_RING_LENGTH
+#define AP_INERTIALSENSOR_VIBE_STATS_RING_LENGTH 256
+#endif
+
+#ifndef AP_INERTIALSENSOR_VIBE_STATS_WINDOW_MS
+#define AP_INERTIALSENSOR_VIBE_STATS_WINDOW_MS 1000
+#endif
@@ -231,6 +231,30 @@ void AP_InertialSensor_TCal::correct_sensor(float temperature, float cal_temp, c
     v += polynomial_eval(cal_temp - TEMP_REFERENCE, coeff);
 }
 
+/*
+  get the correction for a single sensor as a single offset, for
+  correcting a burst of samples at the same temperature
+ */
+Vector3f AP_InertialSensor_TCal::sensor_correction(float temperature, float cal_temp, const AP_Vector3f coeff[3]) const
+{
+    if (enable != Enable::Enabled) {
+        return Vector3f();
+    }
+    temperature = constrain_float(temperature, temp_min, temp_max);
+    cal_temp = constrain_float(cal_temp, temp_min, temp_max);
+    return polynomial_eval(temperature - TEMP_REFERENCE, coeff) - polynomial_eval(cal_temp - TEMP_REFERENCE, coeff);
+}
+
+Vector3f AP_InertialSensor_TCal::accel_correction(float temperature, float cal_temp) const
+{
+    return sensor_correction(temperature, cal_temp, accel_coeff);
+}
+
+Vector3f AP_InertialSensor_TCal::gyro_correction(float temperature, float cal_temp) const
+{
+    return sensor_correction(temperature, cal_temp, gyro_coeff);
+}
+
 void AP_InertialSensor_TCal::correct_accel(float temperature, float cal_temp, Vector3f &accel) const
 {
     correct_sensor(temperature, cal_temp, accel_coeff, accel);
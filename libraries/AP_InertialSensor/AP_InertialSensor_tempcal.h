@@ -11,6 +11,10 @@ public:
     static const struct AP_Param::GroupInfo var_info[];
     void correct_accel(float temperature, float cal_temp, Vector3f &accel) const;
     void correct_gyro(float temperature, float cal_temp, Vector3f &accel) const;
+
+    // the amount subtracted by correct_accel() and correct_gyro()
+    Vector3f accel_correction(float temperature, float cal_temp) const;
+    Vector3f gyro_correction(float temperature, float cal_temp) const;
     void sitl_apply_accel(float temperature, Vector3f &accel) const;
     void sitl_apply_gyro(float temperature, Vector3f &accel) const;
 
@@ -74,6 +78,7 @@ private:
     Learn *learn;
 
     void correct_sensor(float temperature, float cal_temp, const AP_Vector3f coeff[3], Vector3f &v) const;
+    Vector3f sensor_correction(float temperature, float cal_temp, const AP_Vector3f coeff[3]) const;
     Vector3f polynomial_eval(float temperature, const AP_Vector3f coeff[3]) const;
 
     // get instance number
@@ -25,7 +25,7 @@ const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
     // @Param: BAT_OPT
     // @DisplayName: Batch Logging Options Mask
     // @Description: Options for the BatchSampler.
-    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter
+    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter, 3: Stream all sensors to a separate file (Linux and SITL only)
     // @User: Advanced
     AP_GROUPINFO("BAT_OPT",  3, AP_InertialSensor::BatchSampler, _batch_options_mask, 0),
 
@@ -56,6 +56,13 @@ void AP_InertialSensor::BatchSampler::init()
         return;
     }
 
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+    if (has_option(BATCH_OPT_STREAM)) {
+        initialised = stream_init();
+        return;
+    }
+#endif
+
     _required_count.set(_required_count - (_required_count % 32)); // round down to nearest multiple of 32
 
     _real_required_count = _required_count;
@@ -87,6 +94,12 @@ void AP_InertialSensor::BatchSampler::periodic()
     if (_sensor_mask == 0) {
         return;
     }
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+    if (stream != nullptr) {
+        stream_periodic();
+        return;
+    }
+#endif
     push_data_to_log();
 }
 
@@ -270,6 +283,12 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
 void AP_InertialSensor::BatchSampler::sample(uint8_t _instance, AP_InertialSensor::IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
 {
 #if HAL_LOGGING_ENABLED
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+    if (stream != nullptr) {
+        stream_sample(_instance, _type, sample_us, _sample);
+        return;
+    }
+#endif
     if (!should_log(_instance, _type)) {
         return;
     }
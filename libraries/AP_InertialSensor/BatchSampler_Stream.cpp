@@ -0,0 +1,414 @@
+/*
+  streaming of batch samples to a file
+
+  With bit 3 of INS_LOG_BAT_OPT set the batch sampler no longer
+  cycles through one sensor at a time sending ISBH/ISBD log
+  messages. Instead it captures every sample from the gyro and accel
+  of each IMU in INS_LOG_BAT_MASK while logging is active. The samples
+  are packed into fixed size blocks by the backend threads, and the
+  IO thread writes the blocks to a file next to the dataflash logs,
+  named after the current log, e.g. logs/00000012.ISB
+
+  File format, all little endian:
+    struct stream_file_header
+    struct stream_info, one per stream
+    struct stream_block, repeated in the order the blocks filled
+
+  Tools/scripts/isb_stream.py reads these files
+ */
+
+#include "AP_InertialSensor.h"
+
+#if AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Logger/AP_Logger.h>
+#include <GCS_MAVLink/GCS.h>
+
+extern const AP_HAL::HAL& hal;
+
+#define MASK_LOG_ANY 0xFFFF
+
+// samples in each block, per axis
+#define STREAM_BLOCK_SAMPLES 256
+
+// blocks buffered per stream, about 0.25s of 8kHz samples
+#define STREAM_NUM_BLOCKS 8
+
+// time to wait for the backends to hand over their partly filled
+// blocks when logging stops
+#define STREAM_CLOSE_TIMEOUT_MS 100
+
+static const uint32_t stream_magic = 0x53425349; // "ISBS"
+static const uint16_t stream_version = 1;
+static const uint16_t stream_block_magic = 0x4b42; // "BK"
+
+struct PACKED stream_file_header {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t num_streams;
+    uint8_t post_filter;        // 1 if samples were taken after the filters
+    uint16_t block_samples;
+    uint16_t reserved;
+    uint64_t start_us;          // time the file was opened
+};
+
+struct PACKED stream_info {
+    uint8_t sensor_type;        // 0 accel, 1 gyro
+    uint8_t instance;
+    uint16_t multiplier;        // samples are value*multiplier, in m/s/s or rad/s
+    float sample_rate_hz;       // rate at the time the file was opened
+};
+
+struct PACKED stream_block {
+    uint16_t magic;
+    uint8_t stream;             // index into the stream_info array
+    uint8_t session;            // used to discard blocks filled for an earlier file
+    uint16_t count;             // number of valid samples
+    uint16_t dropped;           // samples dropped before this block, saturating
+    uint32_t seqnum;            // block number within the stream
+    uint64_t first_sample_us;
+    uint64_t last_sample_us;
+    int16_t data[STREAM_BLOCK_SAMPLES][3];
+};
+
+/*
+  blocks for one sensor. Each is filled by a single backend thread and
+  emptied by the IO thread
+ */
+struct AP_InertialSensor::BatchSampler::StreamBuffer {
+    StreamBuffer(uint8_t _index, uint16_t _multiplier) :
+        index(_index),
+        multiplier(_multiplier) {}
+
+    ObjectBuffer_SPSC<stream_block> blocks{STREAM_NUM_BLOCKS};
+    const uint8_t index;
+    const uint16_t multiplier;
+
+    // producer state
+    stream_block *fill;
+    uint32_t seqnum;
+    uint32_t dropped;
+    uint8_t session;
+
+    // true while fill is reserved and not yet committed
+    std::atomic<bool> filling;
+
+    // finish the block being filled and pass it to the IO thread
+    void commit_fill() {
+        fill->magic = stream_block_magic;
+        fill->stream = index;
+        fill->session = session;
+        fill->seqnum = seqnum++;
+        fill->dropped = MIN(dropped, uint32_t(UINT16_MAX));
+        dropped = 0;
+        blocks.commit(1);
+        fill = nullptr;
+        filling.store(false, std::memory_order_release);
+    }
+};
+
+struct AP_InertialSensor::BatchSampler::StreamState {
+    StreamBuffer *buffers[INS_MAX_INSTANCES][2];
+    uint8_t num_streams;
+
+    // set by the main thread while logging is active
+    std::atomic<bool> want_stream;
+    // set by the IO thread while a file is open
+    std::atomic<bool> active;
+    // incremented by the IO thread for each new file
+    std::atomic<uint8_t> session;
+
+    // IO thread state
+    int fd = -1;
+    bool open_failed;
+    bool write_error;
+    // waiting for the last blocks before closing the file
+    bool closing;
+    uint32_t close_start_ms;
+};
+
+/*
+  allocate a buffer for each sensor and start the IO callback
+ */
+bool AP_InertialSensor::BatchSampler::stream_init()
+{
+    StreamState *state = new StreamState;
+    if (state == nullptr) {
+        return false;
+    }
+    const uint8_t count = MIN(_imu._accel_count, _imu._gyro_count);
+    for (uint8_t i=0; i<count; i++) {
+        if (!(_sensor_mask & (1U<<i))) {
+            continue;
+        }
+        state->buffers[i][IMU_SENSOR_TYPE_ACCEL] = new StreamBuffer(state->num_streams++, _imu._accel_raw_sampling_multiplier[i]);
+        state->buffers[i][IMU_SENSOR_TYPE_GYRO] = new StreamBuffer(state->num_streams++, _imu._gyro_raw_sampling_multiplier[i]);
+        if (state->buffers[i][IMU_SENSOR_TYPE_ACCEL] == nullptr ||
+            state->buffers[i][IMU_SENSOR_TYPE_GYRO] == nullptr ||
+            state->buffers[i][IMU_SENSOR_TYPE_ACCEL]->blocks.get_size() == 0 ||
+            state->buffers[i][IMU_SENSOR_TYPE_GYRO]->blocks.get_size() == 0) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate IMU stream buffers");
+            for (auto &b : state->buffers) {
+                delete b[IMU_SENSOR_TYPE_ACCEL];
+                delete b[IMU_SENSOR_TYPE_GYRO];
+            }
+            delete state;
+            return false;
+        }
+    }
+    if (state->num_streams == 0) {
+        delete state;
+        return false;
+    }
+
+    // streams always capture at the rate the filters see, either
+    // before or after the filters
+    _doing_sensor_rate_logging = false;
+    _doing_post_filter_logging = has_option(BATCH_OPT_POST_FILTER);
+
+    stream = state;
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor::BatchSampler::stream_io, void));
+    return true;
+}
+
+/*
+  called at loop rate by the main thread
+ */
+void AP_InertialSensor::BatchSampler::stream_periodic()
+{
+    const AP_Logger *logger = AP_Logger::get_singleton();
+    stream->want_stream = logger != nullptr && logger->should_log(MASK_LOG_ANY);
+}
+
+/*
+  add a sample to the block being filled for a sensor. Called by the
+  backend thread of the sensor
+ */
+void AP_InertialSensor::BatchSampler::stream_sample(uint8_t _instance, IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
+{
+    if (_instance >= INS_MAX_INSTANCES) {
+        return;
+    }
+    StreamBuffer *b = stream->buffers[_instance][_type];
+    if (b == nullptr) {
+        return;
+    }
+    if (!stream->active.load(std::memory_order_acquire)) {
+        if (b->fill != nullptr) {
+            // logging has stopped, pass on the partly filled block so
+            // the end of the capture is written before the file closes
+            b->commit_fill();
+        }
+        return;
+    }
+
+    const uint8_t session = stream->session.load(std::memory_order_acquire);
+    if (b->session != session) {
+        // new file, forget any partly filled block
+        b->session = session;
+        b->fill = nullptr;
+        b->filling.store(false, std::memory_order_release);
+        b->seqnum = 0;
+        b->dropped = 0;
+    }
+
+    if (b->fill == nullptr) {
+        // fill the next free block in place
+        ObjectBuffer_SPSC<stream_block>::IoVec vec[2];
+        if (b->blocks.reserve(vec, 1) == 0) {
+            // the IO thread has fallen behind
+            b->dropped++;
+            return;
+        }
+        b->fill = vec[0].data;
+        b->fill->count = 0;
+        b->fill->first_sample_us = sample_us;
+        b->filling.store(true, std::memory_order_release);
+    }
+
+    stream_block &blk = *b->fill;
+    blk.data[blk.count][0] = b->multiplier*_sample.x;
+    blk.data[blk.count][1] = b->multiplier*_sample.y;
+    blk.data[blk.count][2] = b->multiplier*_sample.z;
+    blk.last_sample_us = sample_us;
+    blk.count++;
+
+    if (blk.count == STREAM_BLOCK_SAMPLES) {
+        b->commit_fill();
+    }
+}
+
+/*
+  open a new stream file and write its header. Called from the IO
+  thread
+ */
+bool AP_InertialSensor::BatchSampler::stream_open()
+{
+    AP_Logger *logger = AP_Logger::get_singleton();
+    if (logger == nullptr) {
+        return false;
+    }
+
+    // blocks left over from the last file are discarded from the
+    // consumer side, as a backend which was still filling when the
+    // last file closed may commit at any time. Anything it commits
+    // after this carries the old session and is dropped by
+    // stream_write_blocks()
+    for (auto &b : stream->buffers) {
+        for (auto *buf : b) {
+            if (buf == nullptr) {
+                continue;
+            }
+            uint32_t n;
+            while (buf->blocks.readptr(n) != nullptr) {
+                buf->blocks.advance(n);
+            }
+        }
+    }
+    stream->session++;
+
+    char filename[64];
+    hal.util->snprintf(filename, sizeof(filename), "%s/%08u.ISB",
+                       HAL_BOARD_LOG_DIRECTORY, (unsigned)logger->find_last_log());
+    const int fd = AP::FS().open(filename, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        return false;
+    }
+
+    const struct stream_file_header hdr {
+        magic : stream_magic,
+        version : stream_version,
+        num_streams : stream->num_streams,
+        post_filter : uint8_t(_doing_post_filter_logging ? 1 : 0),
+        block_samples : STREAM_BLOCK_SAMPLES,
+        reserved : 0,
+        start_us : AP_HAL::micros64(),
+    };
+    bool ok = AP::FS().write(fd, &hdr, sizeof(hdr)) == sizeof(hdr);
+
+    for (uint8_t i=0; i<INS_MAX_INSTANCES && ok; i++) {
+        for (uint8_t t=0; t<2 && ok; t++) {
+            const StreamBuffer *buf = stream->buffers[i][t];
+            if (buf == nullptr) {
+                continue;
+            }
+            const float sample_rate = t == IMU_SENSOR_TYPE_GYRO ?
+                _imu._gyro_raw_sample_rates[i] : _imu._accel_raw_sample_rates[i];
+            const struct stream_info info {
+                sensor_type : t,
+                instance : i,
+                multiplier : buf->multiplier,
+                sample_rate_hz : sample_rate,
+            };
+            ok = AP::FS().write(fd, &info, sizeof(info)) == sizeof(info);
+        }
+    }
+    if (!ok) {
+        AP::FS().close(fd);
+        return false;
+    }
+
+    stream->fd = fd;
+    stream->write_error = false;
+    stream->active.store(true, std::memory_order_release);
+    return true;
+}
+
+/*
+  write all filled blocks to the file, and close it if asked
+ */
+void AP_InertialSensor::BatchSampler::stream_write_blocks(bool close_file)
+{
+    const uint8_t session = stream->session;
+    for (auto &b : stream->buffers) {
+        for (auto *buf : b) {
+            if (buf == nullptr) {
+                continue;
+            }
+            uint32_t n;
+            const stream_block *blocks;
+            while ((blocks = buf->blocks.readptr(n)) != nullptr) {
+                // blocks are contiguous, so write runs of them at once
+                uint32_t i = 0;
+                while (i < n) {
+                    if (blocks[i].session != session) {
+                        i++;
+                        continue;
+                    }
+                    uint32_t run = 1;
+                    while (i+run < n && blocks[i+run].session == session) {
+                        run++;
+                    }
+                    const uint32_t len = run * sizeof(stream_block);
+                    if (!stream->write_error &&
+                        AP::FS().write(stream->fd, &blocks[i], len) != int32_t(len)) {
+                        stream->write_error = true;
+                        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "IMU stream write failed");
+                    }
+                    i += run;
+                }
+                buf->blocks.advance(n);
+            }
+        }
+    }
+
+    if (close_file) {
+        AP::FS().close(stream->fd);
+        stream->fd = -1;
+    }
+}
+
+/*
+  true if any backend still holds a partly filled block
+ */
+bool AP_InertialSensor::BatchSampler::stream_filling() const
+{
+    for (const auto &b : stream->buffers) {
+        for (const auto *buf : b) {
+            if (buf != nullptr && buf->filling.load(std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*
+  IO thread callback, opening, writing and closing the stream file as
+  logging starts and stops
+ */
+void AP_InertialSensor::BatchSampler::stream_io()
+{
+    const bool want_stream = stream->want_stream;
+    if (stream->fd == -1) {
+        if (!want_stream) {
+            stream->open_failed = false;
+        } else if (!stream->open_failed && !stream_open()) {
+            // don't retry until logging restarts
+            stream->open_failed = true;
+        }
+        return;
+    }
+    if (!want_stream && !stream->closing) {
+        // stop the backends filling blocks. Each passes on its partly
+        // filled block with its next sample
+        stream->active.store(false, std::memory_order_release);
+        stream->closing = true;
+        stream->close_start_ms = AP_HAL::millis();
+    }
+    if (stream->closing) {
+        // close once the last blocks are written, or if a sensor has
+        // stopped sending samples
+        const bool close_file = !stream_filling() ||
+            AP_HAL::millis() - stream->close_start_ms > STREAM_CLOSE_TIMEOUT_MS;
+        stream_write_blocks(close_file);
+        if (close_file) {
+            stream->closing = false;
+        }
+        return;
+    }
+    stream_write_blocks(false);
+}
+
+#endif // AP_INERTIALSENSOR_BATCHSAMPLER_STREAM_ENABLED
@@ -8,7 +8,8 @@
     LOG_IMU_MSG, \
     LOG_ISBH_MSG, \
     LOG_ISBD_MSG, \
-    LOG_VIBE_MSG
+    LOG_VIBE_MSG, \
+    LOG_VIBS_MSG
 
 // @LoggerMessage: ACC
 // @Description: IMU accelerometer data
@@ -111,6 +112,34 @@ struct PACKED log_Vibe {
     uint32_t clipping;
 };
 
+// @LoggerMessage: VIBS
+// @Description: Accelerometer vibration statistics over a window of sensor rate samples
+// @Field: TimeUS: Time since system startup
+// @Field: IMU: accelerometer instance number
+// @Field: RMSX: RMS vibration about the window mean, x-axis
+// @Field: RMSY: RMS vibration about the window mean, y-axis
+// @Field: RMSZ: RMS vibration about the window mean, z-axis
+// @Field: KurX: kurtosis, x-axis. 3 for random vibration, higher when there are impulses
+// @Field: KurY: kurtosis, y-axis
+// @Field: KurZ: kurtosis, z-axis
+// @Field: CrX: crest factor (peak deviation from the mean over RMS), x-axis
+// @Field: CrY: crest factor, y-axis
+// @Field: CrZ: crest factor, z-axis
+// @Field: N: number of samples in the window
+// @Field: Clip: number of samples in the window with any axis over the clip limit
+// @Field: Drop: number of samples not included because the main loop fell behind
+struct PACKED log_VibeStats {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t imu;
+    float rms_x, rms_y, rms_z;
+    float kurtosis_x, kurtosis_y, kurtosis_z;
+    float crest_x, crest_y, crest_z;
+    uint16_t samples;
+    uint16_t clips;
+    uint16_t dropped;
+};
+
 #define LOG_STRUCTURE_FROM_INERTIALSENSOR        \
     { LOG_ACC_MSG, sizeof(log_ACC), \
       "ACC", "QBQfff",        "TimeUS,I,SampleUS,AccX,AccY,AccZ", "s#sooo", "F-F000" , true }, \
@@ -120,6 +149,8 @@ struct PACKED log_Vibe {
       "IMU",  "QBffffffIIfBBHH", "TimeUS,I,GyrX,GyrY,GyrZ,AccX,AccY,AccZ,EG,EA,T,GH,AH,GHz,AHz", "s#EEEooo--O--zz", "F-000000-----00" , true }, \
     { LOG_VIBE_MSG, sizeof(log_Vibe), \
       "VIBE", "QBfffI", "TimeUS,IMU,VibeX,VibeY,VibeZ,Clip", "s#ooo-", "F-000-" , true }, \
+    { LOG_VIBS_MSG, sizeof(log_VibeStats), \
+      "VIBS", "QBfffffffffHHH", "TimeUS,IMU,RMSX,RMSY,RMSZ,KurX,KurY,KurZ,CrX,CrY,CrZ,N,Clip,Drop", "s#ooo---------", "F-000---------" , true }, \
     { LOG_ISBH_MSG, sizeof(log_ISBH), \
       "ISBH", "QHBBHHQf", "TimeUS,N,type,instance,mul,smp_cnt,SampleUS,smp_rate", "s-----sz", "F-----F-" },  \
     { LOG_ISBD_MSG, sizeof(log_ISBD), \
@@ -0,0 +1,138 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_InvensenseFIFO.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+typedef AP_InertialSensor_InvensenseFIFO FIFO;
+
+/*
+  decode throughput of FIFO bursts. These are synthetic FIFO dumps,
+  not captures from a sensor. They are built in the
+  byte layout each sensor produces, from a 1g accel with 180Hz and
+  360Hz motor vibration sampled at 8kHz and a slowly varying
+  temperature. The per-sample decode matches the loops the backends
+  used before the shared decoder
+ */
+
+static const uint8_t burst_len = 8;
+static const uint16_t dump_samples = 512;
+
+#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+
+static int16_t vibration(uint16_t i, uint8_t axis, float amplitude, float offset)
+{
+    const float t = i / 8000.0f;
+    return int16_t(offset + amplitude * (sinf(M_2PI * 180 * t + axis) + 0.5f * sinf(M_2PI * 360 * t + 2*axis)));
+}
+
+static void fill_be_dump(uint8_t *dump, uint8_t sample_size, uint8_t accel_word, uint8_t temp_word, uint8_t gyro_word)
+{
+    for (uint16_t i=0; i<dump_samples; i++) {
+        uint8_t *d = &dump[i * sample_size];
+        for (uint8_t a=0; a<3; a++) {
+            const int16_t acc = vibration(i, a, 1500, a == 2 ? -2048 : 0);
+            const int16_t gyr = vibration(i, a, 300, 5);
+            d[2*(accel_word+a)] = uint16_t(acc) >> 8;
+            d[2*(accel_word+a)+1] = uint16_t(acc) & 0xFF;
+            d[2*(gyro_word+a)] = uint16_t(gyr) >> 8;
+            d[2*(gyro_word+a)+1] = uint16_t(gyr) & 0xFF;
+        }
+        const int16_t temp = 3000 + i/64;
+        d[2*temp_word] = uint16_t(temp) >> 8;
+        d[2*temp_word+1] = uint16_t(temp) & 0xFF;
+    }
+}
+
+static void fill_icm426xx_dump(uint8_t *dump)
+{
+    for (uint16_t i=0; i<dump_samples; i++) {
+        uint8_t *d = &dump[i * FIFO::ICM426xxLayout::sample_size];
+        d[0] = 0x68;
+        for (uint8_t a=0; a<3; a++) {
+            const int16_t acc = vibration(i, a, 1500, a == 2 ? -2048 : 0);
+            const int16_t gyr = vibration(i, a, 300, 5);
+            d[1+2*a] = uint16_t(acc) & 0xFF;
+            d[2+2*a] = uint16_t(acc) >> 8;
+            d[7+2*a] = uint16_t(gyr) & 0xFF;
+            d[8+2*a] = uint16_t(gyr) >> 8;
+        }
+        d[13] = 20 + i/128;
+        d[14] = i & 0xFF;
+        d[15] = i >> 8;
+    }
+}
+
+static void BM_DecodePerSampleMPU6000(benchmark::State& state)
+{
+    static uint8_t dump[dump_samples * FIFO::MPU6000Layout::sample_size];
+    fill_be_dump(dump, FIFO::MPU6000Layout::sample_size, 0, 3, 4);
+    Vector3f accel[burst_len], gyro[burst_len];
+    int16_t temp[burst_len];
+    uint16_t ofs = 0;
+
+    while (state.KeepRunning()) {
+        const uint8_t *samples = &dump[ofs * FIFO::MPU6000Layout::sample_size];
+        for (uint8_t i = 0; i < burst_len; i++) {
+            const uint8_t *data = samples + FIFO::MPU6000Layout::sample_size * i;
+            accel[i] = Vector3f(int16_val(data, 1),
+                                int16_val(data, 0),
+                                -int16_val(data, 2));
+            temp[i] = int16_val(data, 3);
+            gyro[i] = Vector3f(int16_val(data, 5),
+                               int16_val(data, 4),
+                               -int16_val(data, 6));
+        }
+        gbenchmark_escape(accel);
+        gbenchmark_escape(gyro);
+        gbenchmark_escape(temp);
+        ofs = (ofs + burst_len) % dump_samples;
+    }
+    state.SetBytesProcessed(state.iterations() * burst_len * FIFO::MPU6000Layout::sample_size);
+}
+
+template <class Layout>
+static void decode_bursts(benchmark::State& state, const uint8_t *dump)
+{
+    Vector3f accel[burst_len], gyro[burst_len];
+    int16_t temp[burst_len];
+    uint16_t ofs = 0;
+
+    while (state.KeepRunning()) {
+        uint8_t n = FIFO::decode<Layout>(&dump[ofs * Layout::sample_size], burst_len, accel, gyro, temp);
+        gbenchmark_escape(&n);
+        gbenchmark_escape(accel);
+        gbenchmark_escape(gyro);
+        gbenchmark_escape(temp);
+        ofs = (ofs + burst_len) % dump_samples;
+    }
+    state.SetBytesProcessed(state.iterations() * burst_len * Layout::sample_size);
+}
+
+static void BM_DecodeMPU6000(benchmark::State& state)
+{
+    static uint8_t dump[dump_samples * FIFO::MPU6000Layout::sample_size];
+    fill_be_dump(dump, FIFO::MPU6000Layout::sample_size, 0, 3, 4);
+    decode_bursts<FIFO::MPU6000Layout>(state, dump);
+}
+
+static void BM_DecodeICM20948(benchmark::State& state)
+{
+    static uint8_t dump[dump_samples * FIFO::ICM20948Layout::sample_size];
+    fill_be_dump(dump, FIFO::ICM20948Layout::sample_size, 0, 6, 3);
+    decode_bursts<FIFO::ICM20948Layout>(state, dump);
+}
+
+static void BM_DecodeICM426xx(benchmark::State& state)
+{
+    static uint8_t dump[dump_samples * FIFO::ICM426xxLayout::sample_size];
+    fill_icm426xx_dump(dump);
+    decode_bursts<FIFO::ICM426xxLayout>(state, dump);
+}
+
+BENCHMARK(BM_DecodePerSampleMPU6000);
+BENCHMARK(BM_DecodeMPU6000);
+BENCHMARK(BM_DecodeICM20948);
+BENCHMARK(BM_DecodeICM426xx);
+
+BENCHMARK_MAIN();
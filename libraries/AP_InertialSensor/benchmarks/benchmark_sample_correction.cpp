@@ -0,0 +1,85 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_SampleCorrection.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  compare correcting a FIFO burst one sample at a time, as
+  _rotate_and_correct_accel() does, with correcting the whole burst
+  with AP_InertialSensor_SampleCorrection. Bursts are 8, 16 and 32
+  samples
+ */
+
+static const uint16_t max_burst = 32;
+static const float raw_scale = 16.0f * GRAVITY_MSS / 32768.0f;
+static const enum Rotation sensor_rotation = ROTATION_YAW_270;
+static const enum Rotation board_rotation = ROTATION_ROLL_180_YAW_45;
+static const Vector3f offset { 0.3f, -0.2f, 0.15f };
+static const Vector3f scale { 1.01f, 0.98f, 1.02f };
+
+// temperature calibration polynomial, as in AP_InertialSensor_TCal
+static const Vector3f tcal_coeff[3] {
+    { 1.0e3f, -2.0e3f, 5.0e2f },
+    { 3.0e1f, 1.0e1f, -2.0e1f },
+    { -0.5f, 0.2f, 0.1f },
+};
+
+static Vector3f tcal_eval(float tdiff)
+{
+    return (tcal_coeff[0] + (tcal_coeff[1] + tcal_coeff[2]*tdiff)*tdiff)*tdiff*1.0e-6f;
+}
+
+static void fill_burst(Vector3f *v, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        v[i] = Vector3f{float(100+i), float(-200+3*i), float(2048-i)};
+    }
+}
+
+static void BM_CorrectPerSample(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    Vector3f burst[max_burst];
+    float temperature = 45;
+
+    while (state.KeepRunning()) {
+        fill_burst(burst, n);
+        for (uint16_t i=0; i<n; i++) {
+            Vector3f &v = burst[i];
+            v *= raw_scale;
+            v.rotate(sensor_rotation);
+            v -= tcal_eval(temperature - 35);
+            v += tcal_eval(25 - 35);
+            v -= offset;
+            v.x *= scale.x;
+            v.y *= scale.y;
+            v.z *= scale.z;
+            v.rotate(board_rotation);
+        }
+        gbenchmark_escape(burst);
+        temperature = 90 - temperature;
+    }
+}
+
+static void BM_CorrectBurst(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    Vector3f burst[max_burst];
+    float temperature = 45;
+
+    while (state.KeepRunning()) {
+        fill_burst(burst, n);
+        AP_InertialSensor_SampleCorrection correction;
+        const Vector3f burst_offset = tcal_eval(temperature - 35) - tcal_eval(25 - 35) + offset;
+        correction.setup(sensor_rotation, board_rotation, raw_scale, burst_offset, scale);
+        correction.apply(burst, n);
+        gbenchmark_escape(burst);
+        temperature = 90 - temperature;
+    }
+}
+
+BENCHMARK(BM_CorrectPerSample)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK(BM_CorrectBurst)->Arg(8)->Arg(16)->Arg(32);
+
+BENCHMARK_MAIN();
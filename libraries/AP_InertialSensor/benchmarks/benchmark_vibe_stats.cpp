@@ -0,0 +1,105 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_VibeStats.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+/*
+  compare keeping the window statistics up to date one sample at a
+  time on the backend thread with pushing the samples into the ring
+  and adding them as a batch once per loop. 20 samples is an 8kHz IMU
+  with a 400Hz loop, 160 an 8kHz IMU with a 50Hz loop
+ */
+
+static const uint16_t max_samples = 160;
+
+static void fill_samples(Vector3f *v, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        const float phase = M_2PI * i / 64.0f;
+        v[i] = Vector3f{2 * sinf(phase), 3 * sinf(phase + 1), -GRAVITY_MSS + 5 * sinf(phase + 2)};
+    }
+}
+
+static void add_sample(const Vector3f &s, const Vector3f &ref, float clip_limit, AP_InertialSensor_VibeStats::Sums &sums)
+{
+    if (fabsf(s.x) > clip_limit ||
+        fabsf(s.y) > clip_limit ||
+        fabsf(s.z) > clip_limit) {
+        sums.clips++;
+    }
+    for (uint8_t a=0; a<3; a++) {
+        const float d = s[a] - ref[a];
+        sums.s1[a] += d;
+        sums.s2[a] += d*d;
+        sums.s3[a] += d*d*d;
+        sums.s4[a] += d*d*d*d;
+        if (d > sums.max[a]) {
+            sums.max[a] = d;
+        }
+        if (d < sums.min[a]) {
+            sums.min[a] = d;
+        }
+    }
+    sums.count++;
+}
+
+static void BM_VibeStatsPerSample(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    Vector3f v[max_samples];
+    fill_samples(v, n);
+    const Vector3f ref { 0, 0, -GRAVITY_MSS };
+    AP_InertialSensor_VibeStats::Sums sums;
+    sums.reset();
+
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<n; i++) {
+            add_sample(v[i], ref, 15.5f * GRAVITY_MSS, sums);
+        }
+        gbenchmark_escape(&sums);
+    }
+}
+
+// the main thread's share of the batched path
+static void BM_VibeStatsAccumulate(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    Vector3f v[max_samples];
+    fill_samples(v, n);
+    const Vector3f ref { 0, 0, -GRAVITY_MSS };
+    AP_InertialSensor_VibeStats::Sums sums;
+    sums.reset();
+
+    while (state.KeepRunning()) {
+        AP_InertialSensor_VibeStats::accumulate(v, n, ref, 15.5f * GRAVITY_MSS, sums);
+        gbenchmark_escape(&sums);
+    }
+}
+
+// both shares of the batched path
+static void BM_VibeStatsBatch(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    Vector3f v[max_samples];
+    fill_samples(v, n);
+    AP_InertialSensor_VibeStats vs(AP_INERTIALSENSOR_VIBE_STATS_RING_LENGTH);
+    uint32_t now_ms = 1;
+
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<n; i++) {
+            vs.push(v[i]);
+        }
+        vs.update(15.5f * GRAVITY_MSS, now_ms++);
+    }
+}
+
+BENCHMARK(BM_VibeStatsPerSample)->Arg(20)->Arg(160);
+BENCHMARK(BM_VibeStatsAccumulate)->Arg(20)->Arg(160);
+BENCHMARK(BM_VibeStatsBatch)->Arg(20)->Arg(160);
+
+#endif // AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+BENCHMARK_MAIN();
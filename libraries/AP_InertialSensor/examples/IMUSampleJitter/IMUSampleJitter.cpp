@@ -0,0 +1,190 @@
+/*
+  benchmark of the handoff of IMU samples from backend threads to the
+  frontend. Three synthetic IMUs each push 8kHz gyro and accel samples
+  from their own thread while the main loop collects them at 400Hz,
+  reporting main loop jitter, the time spent in the backend update()
+  and the time taken by each sample notify.
+
+  Build with --define AP_INERTIALSENSOR_SAMPLE_RING_ENABLED=0 to
+  compare against the semaphore protected handoff
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_InertialSensor/AP_InertialSensor_Backend.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t sample_rate_hz = 8000;
+static const uint16_t loop_rate_hz = 400;
+static const uint8_t num_imus = 3;
+static const uint32_t report_interval_ms = 5000;
+
+static AP_InertialSensor ins;
+
+/*
+  timing statistics, reset on each report
+ */
+struct Timing {
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+
+    void add(uint32_t us) {
+        count++;
+        total_us += us;
+        max_us = MAX(max_us, us);
+    }
+    float avg_us() const {
+        return count ? float(total_us) / count : 0;
+    }
+};
+
+class AP_InertialSensor_Bench : public AP_InertialSensor_Backend
+{
+public:
+    AP_InertialSensor_Bench(AP_InertialSensor &imu) :
+        AP_InertialSensor_Backend(imu) {}
+
+    void start() override {
+        if (!_imu.register_gyro(gyro_instance, sample_rate_hz, 0) ||
+            !_imu.register_accel(accel_instance, sample_rate_hz, 0)) {
+            hal.console->printf("Failed to register IMU\n");
+            return;
+        }
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_Bench::sample_thread, void),
+                                          "imu_bench", 2048, AP_HAL::Scheduler::PRIORITY_SPI, 0)) {
+            hal.console->printf("Failed to create IMU thread\n");
+        }
+    }
+
+    bool update() override {
+        update_accel(accel_instance);
+        update_gyro(gyro_instance);
+        return true;
+    }
+
+    // notify timing, swapped out by the main thread for reporting
+    Timing take_notify_timing() {
+        WITH_SEMAPHORE(timing_sem);
+        Timing ret = notify_timing;
+        notify_timing = Timing {};
+        return ret;
+    }
+
+private:
+    void sample_thread(void) {
+        const uint32_t period_us = 1000000UL / sample_rate_hz;
+        uint64_t next_us = AP_HAL::micros64();
+        uint32_t n = 0;
+        while (true) {
+            const float t = n++ * (1.0f / sample_rate_hz);
+            const Vector3f gyro(0.1f * sinf(t * 2 * M_PI * 3), 0.05f * cosf(t * 2 * M_PI * 2), 0.02f);
+            const Vector3f accel(0.3f * sinf(t * 2 * M_PI * 120), 0.1f, -GRAVITY_MSS);
+
+            const uint32_t start_us = AP_HAL::micros();
+            _notify_new_gyro_raw_sample(gyro_instance, gyro);
+            _notify_new_accel_raw_sample(accel_instance, accel);
+            const uint32_t notify_us = AP_HAL::micros() - start_us;
+            {
+                WITH_SEMAPHORE(timing_sem);
+                notify_timing.add(notify_us);
+            }
+
+            next_us += period_us;
+            const uint64_t now = AP_HAL::micros64();
+            if (next_us > now) {
+                hal.scheduler->delay_microseconds(next_us - now);
+            } else if (now - next_us > 100000U) {
+                // fallen well behind, don't try to catch up
+                next_us = now;
+            }
+        }
+    }
+
+    uint8_t gyro_instance;
+    uint8_t accel_instance;
+
+    HAL_Semaphore timing_sem;
+    Timing notify_timing;
+};
+
+static AP_InertialSensor_Bench *imus[num_imus];
+
+static Timing update_timing;
+static Timing jitter_timing;
+static uint64_t next_loop_us;
+static uint64_t last_loop_us;
+static uint32_t last_report_ms;
+
+void setup(void)
+{
+    hal.console->printf("IMU sample handoff benchmark, %u IMUs at %uHz, loop at %uHz, %s\n",
+                        (unsigned)num_imus, (unsigned)sample_rate_hz, (unsigned)loop_rate_hz,
+                        AP_INERTIALSENSOR_SAMPLE_RING_ENABLED ? "sample ring" : "semaphore");
+    for (uint8_t i=0; i<num_imus; i++) {
+        imus[i] = new AP_InertialSensor_Bench(ins);
+        imus[i]->start();
+    }
+    last_report_ms = AP_HAL::millis();
+    next_loop_us = AP_HAL::micros64();
+}
+
+void loop(void)
+{
+    const uint32_t period_us = 1000000UL / loop_rate_hz;
+
+    // wait for the next loop tick
+    next_loop_us += period_us;
+    const uint64_t wait_start_us = AP_HAL::micros64();
+    if (next_loop_us > wait_start_us) {
+        hal.scheduler->delay_microseconds(next_loop_us - wait_start_us);
+    } else {
+        next_loop_us = wait_start_us;
+    }
+
+    const uint64_t loop_start_us = AP_HAL::micros64();
+    if (last_loop_us != 0) {
+        const uint64_t period = loop_start_us - last_loop_us;
+        jitter_timing.add(period > period_us ? period - period_us : period_us - period);
+    }
+    last_loop_us = loop_start_us;
+
+    for (uint8_t i=0; i<num_imus; i++) {
+        imus[i]->update();
+    }
+    update_timing.add(AP_HAL::micros64() - loop_start_us);
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_report_ms < report_interval_ms) {
+        return;
+    }
+    last_report_ms = now_ms;
+
+    Timing notify_timing {};
+    for (uint8_t i=0; i<num_imus; i++) {
+        const Timing t = imus[i]->take_notify_timing();
+        notify_timing.count += t.count;
+        notify_timing.total_us += t.total_us;
+        notify_timing.max_us = MAX(notify_timing.max_us, t.max_us);
+    }
+
+    hal.console->printf("loop jitter avg=%.1fus max=%uus update avg=%.1fus max=%uus notify avg=%.2fus max=%uus samples=%u\n",
+                        (double)jitter_timing.avg_us(), (unsigned)jitter_timing.max_us,
+                        (double)update_timing.avg_us(), (unsigned)update_timing.max_us,
+                        (double)notify_timing.avg_us(), (unsigned)notify_timing.max_us,
+                        (unsigned)notify_timing.count);
+    update_timing = Timing {};
+    jitter_timing = Timing {};
+}
+
+const struct AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
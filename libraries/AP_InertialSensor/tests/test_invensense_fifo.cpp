@@ -0,0 +1,117 @@
+#include <AP_gtest.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_InvensenseFIFO.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+typedef AP_InertialSensor_InvensenseFIFO FIFO;
+
+static void put_be16(uint8_t *p, int16_t v)
+{
+    p[0] = uint16_t(v) >> 8;
+    p[1] = uint16_t(v) & 0xFF;
+}
+
+static void put_le16(uint8_t *p, int16_t v)
+{
+    p[0] = uint16_t(v) & 0xFF;
+    p[1] = uint16_t(v) >> 8;
+}
+
+// raw values for sample i, covering the int16 extremes
+static int16_t raw_value(uint8_t i, uint8_t axis)
+{
+    static const int16_t values[] { 0, 1, -1, 1000, -1000, 32767, -32768, 12345, -23456 };
+    return values[(i*7 + axis) % ARRAY_SIZE(values)];
+}
+
+TEST(InvensenseFIFO, MPU6000)
+{
+    const uint8_t n = 8;
+    uint8_t fifo[n * FIFO::MPU6000Layout::sample_size];
+    for (uint8_t i=0; i<n; i++) {
+        uint8_t *d = &fifo[i * FIFO::MPU6000Layout::sample_size];
+        for (uint8_t j=0; j<7; j++) {
+            put_be16(&d[2*j], raw_value(i, j));
+        }
+    }
+    Vector3f accel[n], gyro[n];
+    int16_t temp[n];
+    EXPECT_EQ(FIFO::decode<FIFO::MPU6000Layout>(fifo, n, accel, gyro, temp), n);
+    for (uint8_t i=0; i<n; i++) {
+        // X and Y swapped, Z negated
+        EXPECT_FLOAT_EQ(accel[i].x, raw_value(i, 1));
+        EXPECT_FLOAT_EQ(accel[i].y, raw_value(i, 0));
+        EXPECT_FLOAT_EQ(accel[i].z, -raw_value(i, 2));
+        EXPECT_EQ(temp[i], raw_value(i, 3));
+        EXPECT_FLOAT_EQ(gyro[i].x, raw_value(i, 5));
+        EXPECT_FLOAT_EQ(gyro[i].y, raw_value(i, 4));
+        EXPECT_FLOAT_EQ(gyro[i].z, -raw_value(i, 6));
+    }
+}
+
+TEST(InvensenseFIFO, ICM20948)
+{
+    const uint8_t n = 8;
+    uint8_t fifo[n * FIFO::ICM20948Layout::sample_size];
+    for (uint8_t i=0; i<n; i++) {
+        uint8_t *d = &fifo[i * FIFO::ICM20948Layout::sample_size];
+        for (uint8_t j=0; j<7; j++) {
+            put_be16(&d[2*j], raw_value(i, j));
+        }
+    }
+    Vector3f accel[n], gyro[n];
+    int16_t temp[n];
+    EXPECT_EQ(FIFO::decode<FIFO::ICM20948Layout>(fifo, n, accel, gyro, temp), n);
+    for (uint8_t i=0; i<n; i++) {
+        EXPECT_FLOAT_EQ(accel[i].x, raw_value(i, 1));
+        EXPECT_FLOAT_EQ(accel[i].y, raw_value(i, 0));
+        EXPECT_FLOAT_EQ(accel[i].z, -raw_value(i, 2));
+        EXPECT_FLOAT_EQ(gyro[i].x, raw_value(i, 4));
+        EXPECT_FLOAT_EQ(gyro[i].y, raw_value(i, 3));
+        EXPECT_FLOAT_EQ(gyro[i].z, -raw_value(i, 5));
+        EXPECT_EQ(temp[i], raw_value(i, 6));
+    }
+}
+
+TEST(InvensenseFIFO, ICM426xx)
+{
+    const uint8_t n = 8;
+    uint8_t fifo[n * FIFO::ICM426xxLayout::sample_size] {};
+    for (uint8_t i=0; i<n; i++) {
+        uint8_t *d = &fifo[i * FIFO::ICM426xxLayout::sample_size];
+        d[0] = 0x68 | (i & 3);
+        for (uint8_t j=0; j<6; j++) {
+            put_le16(&d[1+2*j], raw_value(i, j));
+        }
+        d[13] = uint8_t(int8_t(-20 + 5*i));
+    }
+    Vector3f accel[n], gyro[n];
+    int16_t temp[n];
+    EXPECT_EQ(FIFO::decode<FIFO::ICM426xxLayout>(fifo, n, accel, gyro, temp), n);
+    for (uint8_t i=0; i<n; i++) {
+        EXPECT_FLOAT_EQ(accel[i].x, raw_value(i, 0));
+        EXPECT_FLOAT_EQ(accel[i].y, raw_value(i, 1));
+        EXPECT_FLOAT_EQ(accel[i].z, raw_value(i, 2));
+        EXPECT_FLOAT_EQ(gyro[i].x, raw_value(i, 3));
+        EXPECT_FLOAT_EQ(gyro[i].y, raw_value(i, 4));
+        EXPECT_FLOAT_EQ(gyro[i].z, raw_value(i, 5));
+        EXPECT_EQ(temp[i], -20 + 5*i);
+    }
+
+    // a bad header stops the decode
+    fifo[5 * FIFO::ICM426xxLayout::sample_size] = 0x80;
+    EXPECT_EQ(FIFO::decode<FIFO::ICM426xxLayout>(fifo, n, accel, gyro, temp), 5);
+    fifo[0] = 0;
+    EXPECT_EQ(FIFO::decode<FIFO::ICM426xxLayout>(fifo, n, accel, gyro, temp), 0);
+}
+
+TEST(InvensenseFIFO, Clipped)
+{
+    EXPECT_FALSE(FIFO::clipped(Vector3f{100, -100, 100}, 100));
+    EXPECT_TRUE(FIFO::clipped(Vector3f{101, 0, 0}, 100));
+    EXPECT_TRUE(FIFO::clipped(Vector3f{0, -101, 0}, 100));
+    EXPECT_TRUE(FIFO::clipped(Vector3f{0, 0, 101}, 100));
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,87 @@
+#include <AP_gtest.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_SampleCorrection.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// repeatable random value in the range -1 to 1
+static float rand_value(uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+/*
+  the per-sample correction as done by
+  AP_InertialSensor_Backend::_rotate_and_correct_accel()
+ */
+static Vector3f correct_sample(Vector3f v, enum Rotation sensor_rotation, enum Rotation board_rotation,
+                               float raw_scale, const Vector3f &offset, const Vector3f &scale)
+{
+    v *= raw_scale;
+    v.rotate(sensor_rotation);
+    v -= offset;
+    v.x *= scale.x;
+    v.y *= scale.y;
+    v.z *= scale.z;
+    v.rotate(board_rotation);
+    return v;
+}
+
+/*
+  a burst corrected in one pass matches correcting each sample, for
+  every pair of sensor and board rotations
+ */
+TEST(SampleCorrection, MatchesPerSample)
+{
+    const uint16_t n = 32;
+    const float raw_scale = 16.0f * GRAVITY_MSS / 32768.0f;
+    const Vector3f offset { 0.3f, -0.2f, 0.15f };
+    const Vector3f scale { 1.01f, 0.98f, 1.02f };
+    uint32_t seed = 1;
+
+    for (enum Rotation s = ROTATION_NONE; s < ROTATION_MAX; s = (enum Rotation)((uint8_t)s+1)) {
+        for (enum Rotation b = ROTATION_NONE; b < ROTATION_MAX; b = (enum Rotation)((uint8_t)b+1)) {
+            Vector3f raw[n];
+            Vector3f burst[n];
+            for (uint16_t i=0; i<n; i++) {
+                raw[i] = Vector3f{rand_value(seed), rand_value(seed), rand_value(seed)} * 20000.0f;
+                burst[i] = raw[i];
+            }
+
+            AP_InertialSensor_SampleCorrection correction;
+            correction.setup(s, b, raw_scale, offset, scale);
+            correction.apply(burst, n);
+
+            for (uint16_t i=0; i<n; i++) {
+                const Vector3f expected = correct_sample(raw[i], s, b, raw_scale, offset, scale);
+                EXPECT_LE((burst[i] - expected).length(), 1.0e-4f) << "sensor " << s << " board " << b;
+            }
+        }
+    }
+}
+
+/*
+  with no rotation and unit scale the correction is just the raw
+  scale and offset
+ */
+TEST(SampleCorrection, Identity)
+{
+    AP_InertialSensor_SampleCorrection correction;
+    correction.setup(ROTATION_NONE, ROTATION_NONE, 2.0f, Vector3f{1, 2, 3}, Vector3f{1, 1, 1});
+
+    Vector3f v[2] { {1, 1, 1}, {-4, 0, 2} };
+    correction.apply(v, 2);
+    EXPECT_FLOAT_EQ(v[0].x, 1);
+    EXPECT_FLOAT_EQ(v[0].y, 0);
+    EXPECT_FLOAT_EQ(v[0].z, -1);
+    EXPECT_FLOAT_EQ(v[1].x, -9);
+    EXPECT_FLOAT_EQ(v[1].y, -2);
+    EXPECT_FLOAT_EQ(v[1].z, 1);
+
+    // an empty burst is left alone
+    correction.apply(v, 0);
+    EXPECT_FLOAT_EQ(v[0].x, 1);
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,139 @@
+#include <AP_gtest.h>
+
+#include <AP_InertialSensor/AP_InertialSensor_VibeStats.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+typedef AP_InertialSensor_VibeStats VibeStats;
+
+// sine vibration on each axis on top of gravity
+static Vector3f sine_sample(uint32_t i, const Vector3f &amplitude)
+{
+    // 8kHz samples of 125Hz vibration, a whole number of cycles per 64 samples
+    const float phase = M_2PI * (i % 64) / 64.0f;
+    return Vector3f{amplitude.x * sinf(phase),
+                    amplitude.y * sinf(phase + 1),
+                    -GRAVITY_MSS + amplitude.z * sinf(phase + 2)};
+}
+
+/*
+  a sine has an RMS of amplitude/sqrt(2), kurtosis of 1.5 and crest
+  factor of sqrt(2)
+ */
+TEST(VibeStats, Sine)
+{
+    const Vector3f amplitude { 2, 5, 10 };
+    Vector3f v[640];
+    for (uint32_t i=0; i<ARRAY_SIZE(v); i++) {
+        v[i] = sine_sample(i, amplitude);
+    }
+
+    VibeStats::Sums sums;
+    sums.reset();
+    // batches of different sizes, about a reference away from the mean
+    const Vector3f ref { 0.5f, -0.5f, -9.0f };
+    VibeStats::accumulate(&v[0], 17, ref, 100, sums);
+    VibeStats::accumulate(&v[17], 300, ref, 100, sums);
+    VibeStats::accumulate(&v[317], 323, ref, 100, sums);
+
+    VibeStats::Stats stats;
+    VibeStats::calculate(sums, stats);
+    EXPECT_EQ(stats.samples, 640);
+    EXPECT_EQ(stats.clips, 0);
+    for (uint8_t a=0; a<3; a++) {
+        EXPECT_NEAR(stats.rms[a], amplitude[a] / sqrtf(2), 1.0e-3f * amplitude[a]);
+        EXPECT_NEAR(stats.kurtosis[a], 1.5f, 1.0e-3f);
+        EXPECT_NEAR(stats.crest_factor[a], sqrtf(2), 2.0e-3f);
+    }
+}
+
+/*
+  occasional impulses raise the kurtosis and crest factor well above
+  those of a sine
+ */
+TEST(VibeStats, Impulses)
+{
+    Vector3f v[1000];
+    for (uint32_t i=0; i<ARRAY_SIZE(v); i++) {
+        v[i] = sine_sample(i, Vector3f{1, 1, 1});
+        if (i % 250 == 0) {
+            v[i].x += 40;
+        }
+    }
+
+    VibeStats::Sums sums;
+    sums.reset();
+    VibeStats::accumulate(v, ARRAY_SIZE(v), Vector3f{0, 0, -GRAVITY_MSS}, 30, sums);
+
+    VibeStats::Stats stats;
+    VibeStats::calculate(sums, stats);
+    EXPECT_EQ(stats.clips, 4);
+    EXPECT_GT(stats.kurtosis.x, 20);
+    EXPECT_GT(stats.crest_factor.x, 10);
+    EXPECT_NEAR(stats.kurtosis.y, 1.5f, 0.01f);
+}
+
+TEST(VibeStats, Empty)
+{
+    VibeStats::Sums sums;
+    sums.reset();
+    VibeStats::Stats stats;
+    VibeStats::calculate(sums, stats);
+    EXPECT_EQ(stats.samples, 0);
+    EXPECT_FLOAT_EQ(stats.rms.length(), 0);
+    EXPECT_FLOAT_EQ(stats.kurtosis.length(), 0);
+
+    // constant samples have no vibration
+    const Vector3f v[3] { {1, 2, 3}, {1, 2, 3}, {1, 2, 3} };
+    VibeStats::accumulate(v, 3, Vector3f{}, 100, sums);
+    VibeStats::calculate(sums, stats);
+    EXPECT_EQ(stats.samples, 3);
+    EXPECT_FLOAT_EQ(stats.rms.length(), 0);
+    EXPECT_FLOAT_EQ(stats.crest_factor.length(), 0);
+}
+
+/*
+  samples pushed through the ring are reported once per window, and
+  samples that don't fit in the ring are counted as dropped
+ */
+TEST(VibeStats, Windows)
+{
+    VibeStats vs(128);
+    ASSERT_TRUE(vs.valid());
+    VibeStats::Stats stats;
+    EXPECT_FALSE(vs.get_stats(stats));
+
+    uint32_t now_ms = 1000;
+    uint32_t n = 0;
+    vs.update(100, now_ms);
+    for (uint16_t loop=0; loop<400; loop++) {
+        // 20 samples per 2.5ms loop
+        for (uint8_t i=0; i<20; i++) {
+            vs.push(sine_sample(n++, Vector3f{3, 3, 3}));
+        }
+        now_ms += 2 + (loop & 1);
+        vs.update(100, now_ms);
+    }
+    EXPECT_TRUE(vs.get_new_stats(stats));
+    EXPECT_FALSE(vs.get_new_stats(stats));
+    EXPECT_TRUE(vs.get_stats(stats));
+    EXPECT_NEAR(stats.samples, 8000, 40);
+    EXPECT_EQ(stats.dropped, 0);
+    EXPECT_NEAR(stats.rms.z, 3 / sqrtf(2), 0.01f);
+    EXPECT_NEAR(stats.kurtosis.z, 1.5f, 0.01f);
+
+    // the main loop stalls
+    for (uint16_t i=0; i<200; i++) {
+        vs.push(sine_sample(n++, Vector3f{3, 3, 3}));
+    }
+    now_ms += 1000;
+    vs.update(100, now_ms);
+    EXPECT_TRUE(vs.get_new_stats(stats));
+    EXPECT_EQ(stats.dropped, 200 - 128);
+}
+
+#endif // AP_INERTIALSENSOR_VIBE_STATS_ENABLED
+
+AP_GTEST_MAIN()
@@ -779,6 +779,49 @@ void AP_Logger::WriteCriticalBlock(const void *pBuffer, uint16_t size) {
     FOR_EACH_BACKEND(WriteCriticalBlock(pBuffer, size));
 }
 
+/*
+  reserve space for a message. With a single backend the message is
+  constructed directly in that backend's buffer
+ */
+void *AP_Logger::ReserveBlock(uint8_t msg_type, uint16_t size)
+{
+    if (_next_backend == 1) {
+        return backends[0]->ReserveBlock(msg_type, size, false);
+    }
+    if (_next_backend == 0 || size > sizeof(_reserved.staging)) {
+        return nullptr;
+    }
+    _reserved.sem.take_blocking();
+    // apply the same checks as WriteBlock() now, remembering which
+    // backends want the message
+    _reserved.backend_mask = 0;
+    for (uint8_t i=0; i<_next_backend; i++) {
+        if (backends[i]->ShouldWriteBlock(msg_type, false, false)) {
+            _reserved.backend_mask |= 1U<<i;
+        }
+    }
+    if (_reserved.backend_mask == 0) {
+        _reserved.sem.give();
+        return nullptr;
+    }
+    _reserved.size = size;
+    return _reserved.staging;
+}
+
+void AP_Logger::CommitBlock(void)
+{
+    if (_next_backend == 1) {
+        backends[0]->CommitBlock();
+        return;
+    }
+    for (uint8_t i=0; i<_next_backend; i++) {
+        if (_reserved.backend_mask & (1U<<i)) {
+            backends[i]->WriteCheckedBlock(_reserved.staging, _reserved.size, false);
+        }
+    }
+    _reserved.sem.give();
+}
+
 void AP_Logger::WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) {
     FOR_EACH_BACKEND(WritePrioritisedBlock(pBuffer, size, is_critical));
 }
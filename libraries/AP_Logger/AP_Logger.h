@@ -221,6 +221,16 @@ public:
     /* Write an *important* block of data at current offset */
     void WriteCriticalBlock(const void *pBuffer, uint16_t size);
 
+    /*
+      reserve space to construct a message of msg_type in place,
+      avoiding the copy made by WriteBlock(). Returns nullptr if the
+      message should not be written. Otherwise the caller must fill
+      in the whole message, including the header, and then call
+      CommitBlock() without making any other logging calls in between
+     */
+    void *ReserveBlock(uint8_t msg_type, uint16_t size);
+    void CommitBlock(void);
+
     /* Write a block of replay data at current offset */
     bool WriteReplayBlock(uint8_t msg_id, const void *pBuffer, uint16_t size);
 
@@ -426,6 +436,15 @@ private:
     #define LOGGER_MAX_BACKENDS 2
     uint8_t _next_backend;
     AP_Logger_Backend *backends[LOGGER_MAX_BACKENDS];
+
+    // with more than one backend a reserved message is constructed
+    // here and then copied to each backend by CommitBlock()
+    struct {
+        HAL_Semaphore sem;
+        uint16_t size;
+        uint8_t backend_mask;
+        uint8_t staging[255];
+    } _reserved;
     const AP_Int32 &_log_bitmask;
 
     enum class Backend_Type : uint8_t {
@@ -221,9 +221,8 @@ bool AP_Logger_Backend::Write_Emit_FMT(uint8_t msg_type)
 
 bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_critical, bool is_streaming)
 {
-    // stack-allocate a buffer so we can WriteBlock(); this could be
-    // 255 bytes!  If we were willing to lose the WriteBlock
-    // abstraction we could do WriteBytes() here instead?
+    // the message is constructed directly in the space reserved by
+    // the backend, avoiding a copy
     const char *fmt  = nullptr;
     uint8_t msg_len;
     AP_Logger::log_write_fmt *f;
@@ -242,7 +241,10 @@ bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_
         return false;
     }
 
-    uint8_t buffer[msg_len];
+    uint8_t *buffer = (uint8_t *)ReserveBlock(msg_type, msg_len, is_critical, is_streaming);
+    if (buffer == nullptr) {
+        return false;
+    }
     uint8_t offset = 0;
     buffer[offset++] = HEAD_BYTE1;
     buffer[offset++] = HEAD_BYTE2;
@@ -342,7 +344,7 @@ bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_
         }
     }
 
-    return WritePrioritisedBlock(buffer, msg_len, is_critical, is_streaming);
+    return CommitBlock();
 }
 
 bool AP_Logger_Backend::StartNewLogOK() const
@@ -412,11 +414,9 @@ void AP_Logger_Backend::validate_WritePrioritisedBlock(const void *pBuffer,
 }
 #endif
 
-bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical, bool writev_streaming)
+// checks common to WritePrioritisedBlock() and ReserveBlock()
+bool AP_Logger_Backend::ShouldWriteBlock(uint8_t msg_type, bool is_critical, bool writev_streaming)
 {
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
-    validate_WritePrioritisedBlock(pBuffer, size);
-#endif
     if (!ShouldLog(is_critical)) {
         return false;
     }
@@ -428,15 +428,80 @@ bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size
     }
 
     if (!is_critical && rate_limiter != nullptr) {
-        const uint8_t *msgbuf = (const uint8_t *)pBuffer;
-        if (!rate_limiter->should_log(msgbuf[2], writev_streaming)) {
+        if (!rate_limiter->should_log(msg_type, writev_streaming)) {
             return false;
         }
     }
+    return true;
+}
+
+bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical, bool writev_streaming)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    validate_WritePrioritisedBlock(pBuffer, size);
+#endif
+    if (!ShouldWriteBlock(((const uint8_t *)pBuffer)[2], is_critical, writev_streaming)) {
+        return false;
+    }
 
     return _WritePrioritisedBlock(pBuffer, size, is_critical);
 }
 
+bool AP_Logger_Backend::WriteCheckedBlock(const void *pBuffer, uint16_t size, bool is_critical)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    validate_WritePrioritisedBlock(pBuffer, size);
+#endif
+    return _WritePrioritisedBlock(pBuffer, size, is_critical);
+}
+
+void *AP_Logger_Backend::ReserveBlock(uint8_t msg_type, uint16_t size, bool is_critical, bool writev_streaming)
+{
+    if (size > sizeof(_reserved.staging)) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return nullptr;
+    }
+    if (!ShouldWriteBlock(msg_type, is_critical, writev_streaming)) {
+        return nullptr;
+    }
+
+    _reserved.sem.take_blocking();
+    uint8_t *ptr = _ReserveBlock(size, is_critical);
+    if (ptr == nullptr) {
+        _reserved.sem.give();
+        return nullptr;
+    }
+    _reserved.ptr = ptr;
+    _reserved.size = size;
+    _reserved.is_critical = is_critical;
+    return ptr;
+}
+
+bool AP_Logger_Backend::CommitBlock(void)
+{
+    if (_reserved.ptr == nullptr) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return false;
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    validate_WritePrioritisedBlock(_reserved.ptr, _reserved.size);
+#endif
+    const bool ret = _CommitBlock();
+    _reserved.ptr = nullptr;
+    _reserved.sem.give();
+    return ret;
+}
+
+uint8_t *AP_Logger_Backend::_ReserveBlock(uint16_t size, bool is_critical)
+{
+    return _reserved.staging;
+}
+
+bool AP_Logger_Backend::_CommitBlock(void)
+{
+    return _WritePrioritisedBlock(_reserved.ptr, _reserved.size, _reserved.is_critical);
+}
+
 bool AP_Logger_Backend::ShouldLog(bool is_critical)
 {
     if (!_front.WritesEnabled()) {
@@ -647,6 +712,8 @@ bool AP_Logger_Backend::logging_enabled() const
 
 void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats)
 {
+    const uint32_t dt_ms = AP_HAL::millis() - _stats.start_ms;
+    const uint32_t write_rate = dt_ms > 0 ? uint64_t(_io_bytes_written - _stats.io_bytes_start) * 1000U / dt_ms : 0;
     const struct log_DSF pkt {
         LOG_PACKET_HEADER_INIT(LOG_DF_FILE_STATS),
         time_us         : AP_HAL::micros64(),
@@ -656,6 +723,7 @@ void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats
         buf_space_min   : _stats.buf_space_min,
         buf_space_max   : _stats.buf_space_max,
         buf_space_avg   : (_stats.blocks) ? (_stats.buf_space_sigma / _stats.blocks) : 0,
+        write_rate      : write_rate,
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
@@ -677,6 +745,8 @@ void AP_Logger_Backend::df_stats_gather(const uint16_t bytes_written, uint32_t s
 void AP_Logger_Backend::df_stats_clear() {
     memset(&stats, '\0', sizeof(stats));
     stats.buf_space_min = -1;
+    stats.start_ms = AP_HAL::millis();
+    stats.io_bytes_start = _io_bytes_written;
 }
 
 void AP_Logger_Backend::df_stats_log() {
@@ -70,6 +70,23 @@ public:
 
     bool WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical, bool writev_streaming=false);
 
+    /*
+      reserve space for a single message of msg_type so that the
+      caller can construct it in place rather than copying it in with
+      WritePrioritisedBlock(). Returns nullptr if the message should
+      not be written. Otherwise the caller must fill in the whole
+      message, including the header, and then call CommitBlock()
+      without making any other logging calls in between.
+     */
+    void *ReserveBlock(uint8_t msg_type, uint16_t size, bool is_critical, bool writev_streaming=false);
+    bool CommitBlock(void);
+
+    // checks common to WritePrioritisedBlock() and ReserveBlock()
+    bool ShouldWriteBlock(uint8_t msg_type, bool is_critical, bool writev_streaming);
+
+    // write a block which has already passed ShouldWriteBlock()
+    bool WriteCheckedBlock(const void *pBuffer, uint16_t size, bool is_critical);
+
     // high level interface, indexed by the position in the list of logs
     virtual uint16_t find_last_log() = 0;
     virtual void get_log_boundaries(uint16_t list_entry, uint32_t & start_page, uint32_t & end_page) = 0;
@@ -237,6 +254,27 @@ protected:
 
     virtual bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) = 0;
 
+    // backend part of ReserveBlock()/CommitBlock(). By default the
+    // message is constructed in _reserved.staging and then passed to
+    // _WritePrioritisedBlock()
+    virtual uint8_t *_ReserveBlock(uint16_t size, bool is_critical);
+    virtual bool _CommitBlock(void);
+
+    // the block between ReserveBlock() and CommitBlock(). The
+    // semaphore is held from the reserve to the commit
+    struct {
+        HAL_Semaphore sem;
+        uint8_t *ptr;
+        uint16_t size;
+        bool is_critical;
+        uint8_t staging[255];
+    } _reserved;
+
+    // bytes written to storage by the IO thread of the File and Block
+    // backends, for the write rate in the DSF message. The MAVLink
+    // backend logs MAV rather than DSF
+    uint32_t _io_bytes_written;
+
     bool _initialised;
 
     void df_stats_gather(uint16_t bytes_written, uint32_t space_remaining);
@@ -253,6 +291,8 @@ private:
         uint32_t buf_space_min;
         uint32_t buf_space_max;
         uint32_t buf_space_sigma;
+        uint32_t start_ms;
+        uint32_t io_bytes_start;
     };
     struct df_stats stats;
 
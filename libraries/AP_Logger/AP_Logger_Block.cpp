@@ -934,6 +934,7 @@ void AP_Logger_Block::write_log_page()
     }
     FinishWrite();
     df_Write_FilePage++;
+    _io_bytes_written += df_PageSize;
 }
 
 void AP_Logger_Block::flash_test()
@@ -486,7 +486,68 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
     return true;
 #endif
 
+    if (!have_space_for_block(size, is_critical)) {
+        return false;
+    }
+
+    _writebuf.write((uint8_t*)pBuffer, size);
+    df_stats_gather(size, _writebuf.space());
+    return true;
+}
+
+/*
+  reserve space for a message in the write buffer. The semaphore is
+  held until _CommitBlock()
+ */
+uint8_t *AP_Logger_File::_ReserveBlock(uint16_t size, bool is_critical)
+{
+    semaphore.take_blocking();
+
+    if (! WriteBlockCheckStartupMessages()) {
+        _dropped++;
+        semaphore.give();
+        return nullptr;
+    }
+
+#if APM_BUILD_TYPE(APM_BUILD_Replay)
+    // written straight to the file by _CommitBlock()
+    return _reserved.staging;
+#endif
+
+    if (!have_space_for_block(size, is_critical)) {
+        semaphore.give();
+        return nullptr;
+    }
 
+    ByteBuffer::IoVec vec[2];
+    if (_writebuf.reserve(vec, size) == 1) {
+        return vec[0].data;
+    }
+    // the message would wrap around the end of the buffer
+    return _reserved.staging;
+}
+
+bool AP_Logger_File::_CommitBlock(void)
+{
+    bool ret = true;
+#if APM_BUILD_TYPE(APM_BUILD_Replay)
+    if (AP::FS().write(_write_fd, _reserved.ptr, _reserved.size) != _reserved.size) {
+        AP_HAL::panic("Short write");
+    }
+#else
+    if (_reserved.ptr == _reserved.staging) {
+        _writebuf.write(_reserved.staging, _reserved.size);
+    } else {
+        ret = _writebuf.commit(_reserved.size);
+    }
+    df_stats_gather(_reserved.size, _writebuf.space());
+#endif
+    semaphore.give();
+    return ret;
+}
+
+bool AP_Logger_File::have_space_for_block(uint16_t size, bool is_critical)
+{
     uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
@@ -516,9 +577,6 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         _dropped++;
         return false;
     }
-
-    _writebuf.write((uint8_t*)pBuffer, size);
-    df_stats_gather(size, _writebuf.space());
     return true;
 }
 
@@ -986,13 +1044,21 @@ void AP_Logger_File::io_timer(void)
 
     _last_write_time = tnow;
     if (nbytes > _writebuf_chunk) {
-        // be kind to the filesystem layer
-        nbytes = _writebuf_chunk;
+        // be kind to the filesystem layer, but if we have fallen
+        // behind then write whole chunks together to catch up
+        const uint32_t max_bytes = _writebuf_chunk * HAL_LOGGER_WRITE_MAX_CHUNKS;
+        nbytes = MIN(nbytes, max_bytes);
+        nbytes -= nbytes % _writebuf_chunk;
+    }
+
+    // the data may wrap around the end of the buffer, in which case
+    // both parts go out in a single write
+    ByteBuffer::IoVec vec[2];
+    const uint8_t nvec = _writebuf.peekiovec(vec, nbytes);
+    if (nvec == 0) {
+        return;
     }
-
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    nbytes = vec[0].len + (nvec > 1 ? vec[1].len : 0);
 
     // try to align writes on a 512 byte boundary to avoid filesystem reads
     if ((nbytes + _write_offset) % 512 != 0) {
@@ -1001,6 +1067,15 @@ void AP_Logger_File::io_timer(void)
             nbytes -= ofs;
         }
     }
+    AP_Filesystem_Backend::IoVec iov[2];
+    uint8_t iovcnt = 0;
+    uint32_t remaining = nbytes;
+    for (uint8_t i=0; i<nvec && remaining > 0; i++) {
+        iov[iovcnt].data = vec[i].data;
+        iov[iovcnt].len = MIN(vec[i].len, remaining);
+        remaining -= iov[iovcnt].len;
+        iovcnt++;
+    }
 
     last_io_operation = "write";
     if (!write_fd_semaphore.take(1)) {
@@ -1010,7 +1085,7 @@ void AP_Logger_File::io_timer(void)
         write_fd_semaphore.give();
         return;
     }
-    ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
+    ssize_t nwritten = AP::FS().writev(_write_fd, iov, iovcnt);
     last_io_operation = "";
     if (nwritten <= 0) {
         if ((tnow - _last_write_ms)/1000U > unsigned(_front._params.file_timeout)) {
@@ -1028,6 +1103,7 @@ void AP_Logger_File::io_timer(void)
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
+        _io_bytes_written += nwritten;
         _writebuf.advance(nwritten);
         /*
           the best strategy for minimizing corruption on microSD cards
@@ -17,6 +17,16 @@
 #define HAL_LOGGER_WRITE_CHUNK_SIZE 4096
 #endif
 
+// maximum number of chunks the IO thread may coalesce into a single
+// write when the buffer is backed up
+#ifndef HAL_LOGGER_WRITE_MAX_CHUNKS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define HAL_LOGGER_WRITE_MAX_CHUNKS 8
+#else
+#define HAL_LOGGER_WRITE_MAX_CHUNKS 1
+#endif
+#endif
+
 class AP_Logger_File : public AP_Logger_Backend
 {
 public:
@@ -38,6 +48,8 @@ public:
 
     /* Write a block of data at current offset */
     bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) override;
+    uint8_t *_ReserveBlock(uint16_t size, bool is_critical) override;
+    bool _CommitBlock(void) override;
     uint32_t bufferspace_available() override;
 
     // high level interface
@@ -104,6 +116,10 @@ private:
     bool dirent_to_log_num(const dirent *de, uint16_t &log_num) const;
     bool write_lastlog_file(uint16_t log_num);
 
+    // check there is room in the write buffer for a message, with
+    // the semaphore held
+    bool have_space_for_block(uint16_t size, bool is_critical);
+
     // write buffer
     ByteBuffer _writebuf{0};
     const uint16_t _writebuf_chunk = HAL_LOGGER_WRITE_CHUNK_SIZE;
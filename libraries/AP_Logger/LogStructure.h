@@ -142,6 +142,7 @@ const struct MultiplierStructure log_Multipliers[] = {
 #include <AP_HAL_ChibiOS/LogStructure.h>
 #include <AP_RPM/LogStructure.h>
 #include <AC_Fence/LogStructure.h>
+#include <AP_Scheduler/LogStructure.h>
 #include <AP_Landing/LogStructure.h>
 
 // structure used to define logging format
@@ -221,6 +222,7 @@ struct PACKED log_DSF {
     uint32_t buf_space_min;
     uint32_t buf_space_max;
     uint32_t buf_space_avg;
+    uint32_t write_rate;
 };
 
 struct PACKED log_Event {
@@ -782,6 +784,7 @@ struct PACKED log_VER {
 // @Field: FMn: Minimum free space in write buffer in last time period
 // @Field: FMx: Maximum free space in write buffer in last time period
 // @Field: FAv: Average free space in write buffer in last time period
+// @Field: WRt: Rate at which data was written to storage in last time period, in bytes per second. For flash logging this counts whole pages
 
 // @LoggerMessage: ERR
 // @Description: Specifically coded error messages
@@ -1300,8 +1303,9 @@ LOG_STRUCTURE_FROM_AHRS \
 LOG_STRUCTURE_FROM_HAL_CHIBIOS \
 LOG_STRUCTURE_FROM_RPM \
 LOG_STRUCTURE_FROM_FENCE \
+LOG_STRUCTURE_FROM_SCHEDULER \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
-      "DSF", "QIHIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv", "s--b---", "F--0---" }, \
+      "DSF", "QIHIIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv,WRt", "s--b----", "F--0----" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
@@ -1425,6 +1429,7 @@ enum LogMessages : uint8_t {
     LOG_RCOUT2_MSG,
     LOG_RCOUT3_MSG,
     LOG_IDS_FROM_FENCE,
+    LOG_IDS_FROM_SCHEDULER,
 
     _LOG_LAST_MSG_
 };
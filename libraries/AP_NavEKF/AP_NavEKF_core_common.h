@@ -20,6 +20,7 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
 #include "AP_Nav_Common.h"
+#include "EKF_SymMatrix.h"
 
 /*
   this declares a common parent class for AP_NavEKF2 and
@@ -40,11 +41,12 @@ public:
     typedef ftype Vector28[28];
     typedef ftype Matrix24[24][24];
 #endif
+    typedef EKF_SymMatrix<ftype,24> SymMatrix24;
 
 protected:
     static Matrix24 KH;                   // intermediate result used for covariance updates
     static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
+    static SymMatrix24 nextP;             // Predicted covariance matrix before addition of process noise to diagonals
     static Vector28 Kfusion;              // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
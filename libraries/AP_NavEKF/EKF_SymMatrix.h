@@ -0,0 +1,171 @@
+/*
+  packed storage for the symmetric covariance matrices used by the
+  EKF. Only the upper triangle (row <= col) is stored, column by
+  column, so element (row,col) lives at col*(col+1)/2 + row. This
+  halves the memory footprint of the matrix and means that the first
+  n columns are a contiguous block, which is the layout the auto-coded
+  covariance prediction fills in.
+
+  Element access through m[row][col] works for both triangles, with
+  (row,col) and (col,row) referring to the same storage. Code which
+  loops over the whole matrix must therefore only visit the upper
+  triangle when modifying elements.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef MATH_CHECK_INDEXES
+# define MATH_CHECK_INDEXES 0
+#endif
+
+#if MATH_CHECK_INDEXES
+#include <assert.h>
+#endif
+
+template <typename T, uint8_t N>
+class EKF_SymMatrix
+{
+public:
+    // number of unique elements in the matrix
+    static constexpr uint16_t num_elements = uint16_t(N) * (N + 1) / 2;
+
+    // packed index of element (row,col) where row <= col
+    static constexpr uint16_t upper_index(uint8_t row, uint8_t col) {
+        return uint16_t(col) * (col + 1) / 2 + row;
+    }
+
+    // packed index of element (row,col) from either triangle
+    static constexpr uint16_t index(uint8_t row, uint8_t col) {
+        return row <= col ? upper_index(row, col) : upper_index(col, row);
+    }
+
+    // proxy allowing the matrix to be used with m[row][col] syntax
+    class Row {
+    public:
+        Row(T *elements, uint8_t row) : _elements(elements), _row(row) {}
+        T &operator[](uint8_t col) const {
+#if MATH_CHECK_INDEXES
+            assert(_row < N && col < N);
+#endif
+            return _elements[index(_row, col)];
+        }
+    private:
+        T *_elements;
+        const uint8_t _row;
+    };
+
+    class ConstRow {
+    public:
+        ConstRow(const T *elements, uint8_t row) : _elements(elements), _row(row) {}
+        const T &operator[](uint8_t col) const {
+#if MATH_CHECK_INDEXES
+            assert(_row < N && col < N);
+#endif
+            return _elements[index(_row, col)];
+        }
+    private:
+        const T *_elements;
+        const uint8_t _row;
+    };
+
+    Row operator[](uint8_t row) {
+        return Row(_elements, row);
+    }
+
+    ConstRow operator[](uint8_t row) const {
+        return ConstRow(_elements, row);
+    }
+
+    // access element (row,col) where row <= col without the triangle check
+    T &upper(uint8_t row, uint8_t col) {
+#if MATH_CHECK_INDEXES
+        assert(row <= col && col < N);
+#endif
+        return _elements[upper_index(row, col)];
+    }
+
+    const T &upper(uint8_t row, uint8_t col) const {
+#if MATH_CHECK_INDEXES
+        assert(row <= col && col < N);
+#endif
+        return _elements[upper_index(row, col)];
+    }
+
+    // upper part of column col (rows 0 to col), stored contiguously
+    T *column(uint8_t col) {
+        return &_elements[upper_index(0, col)];
+    }
+
+    const T *column(uint8_t col) const {
+        return &_elements[upper_index(0, col)];
+    }
+
+    // pointer to the packed storage
+    T *data() { return _elements; }
+    const T *data() const { return _elements; }
+
+    void zero() {
+        memset(_elements, 0, sizeof(_elements));
+    }
+
+    // zero the rows and columns in the index range [first,last]
+    void zero_rows_cols(uint8_t first, uint8_t last) {
+        for (uint8_t col = 0; col < N; col++) {
+            T *c = column(col);
+            if (col >= first && col <= last) {
+                // whole column lies in the zeroed range
+                memset(c, 0, sizeof(T) * (col + 1));
+            } else if (col > last) {
+                memset(&c[first], 0, sizeof(T) * (1 + last - first));
+            }
+        }
+    }
+
+    // copy the leading block of rows and columns [0,last] from another matrix
+    void copy_leading(const EKF_SymMatrix &other, uint8_t last) {
+        memcpy(_elements, other._elements, sizeof(T) * (upper_index(last, last) + 1));
+    }
+
+    /*
+      apply the correction M = M - K*H*M for a scalar observation to
+      the leading block [0,last]. H is given as the h_count non-zero
+      elements h_value at indexes h_index, so H*M costs O(n*k). The two
+      triangles of the rank one K*(H*M) product are averaged, giving
+      the same result as correcting the full matrix and then forcing
+      symmetry. If check_variances is set the correction is skipped
+      and false returned when it would drive any of the diagonal
+      elements negative
+     */
+    bool scalar_correction(const T *K, const uint8_t *h_index, const T *h_value, uint8_t h_count, uint8_t last, bool check_variances) {
+        T HM[N];
+        for (uint8_t j = 0; j <= last; j++) {
+            T res = 0;
+            for (uint8_t k = 0; k < h_count; k++) {
+                res += h_value[k] * (*this)[h_index[k]][j];
+            }
+            HM[j] = res;
+        }
+
+        if (check_variances) {
+            for (uint8_t i = 0; i <= last; i++) {
+                if (K[i] * HM[i] > upper(i, i)) {
+                    return false;
+                }
+            }
+        }
+
+        for (uint8_t j = 0; j <= last; j++) {
+            T *c = column(j);
+            for (uint8_t i = 0; i < j; i++) {
+                c[i] -= T(0.5) * (K[i] * HM[j] + K[j] * HM[i]);
+            }
+            c[j] -= K[j] * HM[j];
+        }
+        return true;
+    }
+
+private:
+    T _elements[num_elements];
+};
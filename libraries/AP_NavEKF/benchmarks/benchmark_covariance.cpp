@@ -0,0 +1,199 @@
+/*
+  benchmarks comparing the full 24x24 covariance matrix handling used
+  by EKF3 with the packed upper triangle storage in EKF_SymMatrix.h
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF/EKF_SymMatrix.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+typedef ftype Matrix24[24][24];
+typedef EKF_SymMatrix<ftype,24> SymMatrix24;
+
+static const uint8_t stateIndexLim = 23;
+
+static void fill_full(Matrix24 &m)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            m[i][j] = m[j][i] = 0.01f * (1 + i + j);
+        }
+    }
+}
+
+static void fill_packed(SymMatrix24 &m)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            m.upper(i,j) = 0.01f * (1 + i + j);
+        }
+    }
+}
+
+/*
+  copy of the upper triangle predicted by CovariancePrediction() back
+  into the state covariance matrix
+ */
+static void BM_PredictionCopyFull(benchmark::State& state)
+{
+    static Matrix24 P, nextP;
+    fill_full(nextP);
+    while (state.KeepRunning()) {
+        for (uint8_t row = 0; row <= stateIndexLim; row++) {
+            P[row][row] = nextP[row][row];
+            for (uint8_t column = 0 ; column < row; column++) {
+                P[row][column] = P[column][row] = nextP[column][row];
+            }
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_PredictionCopyFull);
+
+static void BM_PredictionCopyPacked(benchmark::State& state)
+{
+    static SymMatrix24 P, nextP;
+    fill_packed(nextP);
+    while (state.KeepRunning()) {
+        P.copy_leading(nextP, stateIndexLim);
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_PredictionCopyPacked);
+
+/*
+  the covariance handling of a whole CovariancePrediction() call. The
+  auto-coded terms can't be built outside of a vehicle, so a cheap
+  expression stands in for them, filling the upper triangle of nextP
+  in the same column order. Then the process noise is added, the
+  result is copied back into P and the variances are constrained
+ */
+static void BM_PredictionStepFull(benchmark::State& state)
+{
+    static Matrix24 P, nextP;
+    fill_full(P);
+    while (state.KeepRunning()) {
+        for (uint8_t j=0; j<=stateIndexLim; j++) {
+            for (uint8_t i=0; i<=j; i++) {
+                nextP[i][j] = 0.9999f * P[i][j] + 1.0e-6f;
+            }
+        }
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            nextP[i][i] += 1.0e-6f;
+        }
+        for (uint8_t row = 0; row <= stateIndexLim; row++) {
+            P[row][row] = nextP[row][row];
+            for (uint8_t column = 0 ; column < row; column++) {
+                P[row][column] = P[column][row] = nextP[column][row];
+            }
+        }
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            P[i][i] = constrain_ftype(P[i][i], 0.0f, 1.0e3f);
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_PredictionStepFull);
+
+static void BM_PredictionStepPacked(benchmark::State& state)
+{
+    static SymMatrix24 P, nextP;
+    fill_packed(P);
+    while (state.KeepRunning()) {
+        for (uint8_t j=0; j<=stateIndexLim; j++) {
+            ftype *nextPcol = nextP.column(j);
+            const ftype *Pcol = P.column(j);
+            for (uint8_t i=0; i<=j; i++) {
+                nextPcol[i] = 0.9999f * Pcol[i] + 1.0e-6f;
+            }
+        }
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            nextP.upper(i,i) += 1.0e-6f;
+        }
+        P.copy_leading(nextP, stateIndexLim);
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            P.upper(i,i) = constrain_ftype(P.upper(i,i), 0.0f, 1.0e3f);
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_PredictionStepPacked);
+
+/*
+  covariance correction P = P - KHP followed by forcing symmetry
+ */
+static void BM_CorrectionFull(benchmark::State& state)
+{
+    static Matrix24 P, KHP;
+    fill_full(P);
+    fill_full(KHP);
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            for (uint8_t j=0; j<=stateIndexLim; j++) {
+                P[i][j] = P[i][j] - 1.0e-6f * KHP[i][j];
+            }
+        }
+        for (uint8_t i=1; i<=stateIndexLim; i++) {
+            for (uint8_t j=0; j<=i-1; j++) {
+                const ftype temp = 0.5f*(P[i][j] + P[j][i]);
+                P[i][j] = temp;
+                P[j][i] = temp;
+            }
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_CorrectionFull);
+
+static void BM_CorrectionPacked(benchmark::State& state)
+{
+    static SymMatrix24 P;
+    static Matrix24 KHP;
+    fill_packed(P);
+    fill_full(KHP);
+    while (state.KeepRunning()) {
+        for (uint8_t j=0; j<=stateIndexLim; j++) {
+            ftype *Pcol = P.column(j);
+            for (uint8_t i=0; i<j; i++) {
+                Pcol[i] -= 0.5e-6f*(KHP[i][j] + KHP[j][i]);
+            }
+            Pcol[j] -= 1.0e-6f * KHP[j][j];
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_CorrectionPacked);
+
+/*
+  zeroing of the rows and columns of a group of states
+ */
+static void BM_ZeroRowsColsFull(benchmark::State& state)
+{
+    static Matrix24 P;
+    fill_full(P);
+    while (state.KeepRunning()) {
+        for (uint8_t row=10; row<=15; row++) {
+            memset(&P[row][0], 0, sizeof(P[0]));
+        }
+        for (uint8_t row=0; row<=23; row++) {
+            memset(&P[row][10], 0, sizeof(ftype)*6);
+        }
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_ZeroRowsColsFull);
+
+static void BM_ZeroRowsColsPacked(benchmark::State& state)
+{
+    static SymMatrix24 P;
+    fill_packed(P);
+    while (state.KeepRunning()) {
+        P.zero_rows_cols(10, 15);
+        gbenchmark_escape(&P);
+    }
+}
+BENCHMARK(BM_ZeroRowsColsPacked);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,199 @@
+#include <AP_gtest.h>
+
+/*
+  tests for AP_NavEKF/EKF_SymMatrix.h
+ */
+
+#include <AP_NavEKF/EKF_SymMatrix.h>
+#include <stdlib.h>
+#include <math.h>
+
+typedef EKF_SymMatrix<float,24> SymMatrix24;
+
+static void fill_random(SymMatrix24 &m, float full[24][24])
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            const float v = float(rand() % 1000) * 0.01f;
+            m[i][j] = v;
+            full[i][j] = full[j][i] = v;
+        }
+    }
+}
+
+TEST(EKF_SymMatrix, Size)
+{
+    EXPECT_EQ(SymMatrix24::num_elements, 300U);
+    EXPECT_EQ(sizeof(SymMatrix24), 300U * sizeof(float));
+    EXPECT_EQ(SymMatrix24::upper_index(0, 0), 0U);
+    EXPECT_EQ(SymMatrix24::upper_index(23, 23), 299U);
+    EXPECT_EQ(SymMatrix24::index(5, 2), SymMatrix24::index(2, 5));
+}
+
+TEST(EKF_SymMatrix, Symmetric)
+{
+    SymMatrix24 m;
+    float full[24][24];
+    fill_random(m, full);
+
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            EXPECT_FLOAT_EQ(m[i][j], full[i][j]);
+        }
+    }
+
+    // writing the lower triangle updates the upper one
+    m[7][3] = 42.0f;
+    EXPECT_FLOAT_EQ(m[3][7], 42.0f);
+    EXPECT_FLOAT_EQ(m.upper(3, 7), 42.0f);
+    EXPECT_FLOAT_EQ(m.column(7)[3], 42.0f);
+}
+
+TEST(EKF_SymMatrix, ZeroRowsCols)
+{
+    SymMatrix24 m;
+    float full[24][24];
+    fill_random(m, full);
+
+    m.zero_rows_cols(10, 15);
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            const bool zeroed = (i >= 10 && i <= 15) || (j >= 10 && j <= 15);
+            EXPECT_FLOAT_EQ(m[i][j], zeroed ? 0.0f : full[i][j]);
+        }
+    }
+}
+
+TEST(EKF_SymMatrix, CopyLeading)
+{
+    SymMatrix24 m, n;
+    float full[24][24];
+    fill_random(m, full);
+    n.zero();
+
+    n.copy_leading(m, 3);
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            EXPECT_FLOAT_EQ(n[i][j], (i <= 3 && j <= 3) ? full[i][j] : 0.0f);
+        }
+    }
+}
+
+/*
+  the dense correction the scalar fusion code used before the sparse
+  update: build KH and KHP in full, subtract and force symmetry
+ */
+static void dense_correction(float P[24][24], const float K[24], const float H[24], uint8_t last)
+{
+    static float KH[24][24];
+    static float KHP[24][24];
+    for (uint8_t i=0; i<=last; i++) {
+        for (uint8_t j=0; j<=last; j++) {
+            KH[i][j] = K[i] * H[j];
+        }
+    }
+    for (uint8_t i=0; i<=last; i++) {
+        for (uint8_t j=0; j<=last; j++) {
+            float res = 0;
+            for (uint8_t k=0; k<=last; k++) {
+                res += KH[i][k] * P[k][j];
+            }
+            KHP[i][j] = res;
+        }
+    }
+    for (uint8_t i=0; i<=last; i++) {
+        for (uint8_t j=0; j<=last; j++) {
+            P[i][j] -= KHP[i][j];
+        }
+    }
+    for (uint8_t i=0; i<=last; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            P[i][j] = P[j][i] = 0.5f * (P[i][j] + P[j][i]);
+        }
+    }
+}
+
+/*
+  a random covariance with a dominant diagonal and a scalar
+  observation of a few states with its Kalman gain
+ */
+static void fill_observation(SymMatrix24 &m, float full[24][24], float K[24], float H[24],
+                             uint8_t h_index[], float h_value[], uint8_t h_count)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            const float v = (i == j) ? 1.0f + float(rand() % 1000) * 0.01f : float(rand() % 200 - 100) * 1.0e-3f;
+            m[i][j] = v;
+            full[i][j] = full[j][i] = v;
+        }
+    }
+    memset(H, 0, 24 * sizeof(float));
+    for (uint8_t k=0; k<h_count; k++) {
+        h_index[k] = rand() % 24;
+        h_value[k] = float(rand() % 2000 - 1000) * 1.0e-3f;
+        H[h_index[k]] += h_value[k];
+    }
+    // K = P*H' / (H*P*H' + R)
+    float PHt[24];
+    float innov_var = 0.5f;
+    for (uint8_t i=0; i<24; i++) {
+        PHt[i] = 0;
+        for (uint8_t j=0; j<24; j++) {
+            PHt[i] += full[i][j] * H[j];
+        }
+        innov_var += H[i] * PHt[i];
+    }
+    for (uint8_t i=0; i<24; i++) {
+        K[i] = PHt[i] / innov_var;
+    }
+}
+
+TEST(EKF_SymMatrix, ScalarCorrection)
+{
+    for (uint8_t last : { 23, 21, 15 }) {
+        for (uint8_t h_count=1; h_count<=7; h_count++) {
+            SymMatrix24 m;
+            float full[24][24];
+            float K[24], H[24], h_value[7];
+            uint8_t h_index[7];
+            fill_observation(m, full, K, H, h_index, h_value, h_count);
+            // only the leading block is observed
+            for (uint8_t k=0; k<h_count; k++) {
+                if (h_index[k] > last) {
+                    H[h_index[k]] = 0;
+                    h_value[k] = 0;
+                }
+            }
+            for (uint8_t i=last+1; i<24; i++) {
+                K[i] = 0;
+            }
+
+            EXPECT_TRUE(m.scalar_correction(K, h_index, h_value, h_count, last, false));
+            dense_correction(full, K, H, last);
+            for (uint8_t i=0; i<24; i++) {
+                for (uint8_t j=0; j<24; j++) {
+                    EXPECT_NEAR(m[i][j], full[i][j], 1.0e-5f * (1 + fabsf(full[i][j])));
+                }
+            }
+        }
+    }
+}
+
+TEST(EKF_SymMatrix, ScalarCorrectionVarianceCheck)
+{
+    SymMatrix24 m;
+    float full[24][24];
+    float K[24], H[24], h_value[3];
+    uint8_t h_index[3];
+    fill_observation(m, full, K, H, h_index, h_value, 3);
+
+    // a gain far too large would make the variances negative
+    for (uint8_t i=0; i<24; i++) {
+        K[i] *= 100;
+    }
+    SymMatrix24 before = m;
+    EXPECT_FALSE(m.scalar_correction(K, h_index, h_value, 3, 23, true));
+    EXPECT_EQ(memcmp(m.data(), before.data(), sizeof(float) * SymMatrix24::num_elements), 0);
+}
+
+AP_GTEST_MAIN()
@@ -164,7 +164,7 @@ void NavEKF2_core::InitialiseVariables()
     memset(&P[0][0], 0, sizeof(P));
     memset(&KH[0][0], 0, sizeof(KH));
     memset(&KHP[0][0], 0, sizeof(KHP));
-    memset(&nextP[0][0], 0, sizeof(nextP));
+    nextP.zero();
     flowDataValid = false;
     rangeDataToFuse  = false;
     Popt = 0.0f;
@@ -1371,14 +1371,8 @@ void NavEKF2_core::CovariancePrediction()
         }
     }
 
-    // Copy upper diagonal to lower diagonal taking advantage of symmetry
-    for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++)
-    {
-        for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++)
-        {
-            nextP[colIndex][rowIndex] = nextP[rowIndex][colIndex];
-        }
-    }
+    // nextP is shared with EKF3 and only stores the upper diagonal, so
+    // the lower diagonal needs no copy
 
     // add the general state process noise variances
     for (uint8_t i=0; i<=stateIndexLim; i++)
@@ -1392,12 +1386,17 @@ void NavEKF2_core::CovariancePrediction()
     // without GPS
     if ((P[6][6] + P[7][7]) > 1e4f)
     {
+        // copy the stored part of columns 6 and 7 and then the rest of
+        // rows 6 and 7
         for (uint8_t i=6; i<=7; i++)
         {
-            for (uint8_t j=0; j<=stateIndexLim; j++)
+            for (uint8_t j=0; j<=i; j++)
+            {
+                nextP.upper(j,i) = P[j][i];
+            }
+            for (uint8_t j=8; j<=stateIndexLim; j++)
             {
-                nextP[i][j] = P[i][j];
-                nextP[j][i] = P[j][i];
+                nextP.upper(i,j) = P[i][j];
             }
         }
     }
@@ -88,16 +88,14 @@ void NavEKF3_core::setWindMagStateLearningMode()
             }
 
             // set the wind state variances to the measurement uncertainty
-            zeroCols(P, 22, 23);
-            zeroRows(P, 22, 23);
+            zeroRowsCols(P, 22, 23);
             P[22][22] = P[23][23] = trueAirspeedVariance;
 
             windStatesAligned = true;
 
         } else {
             // set the variances using a typical max wind speed for small UAV operation
-            zeroCols(P, 22, 23);
-            zeroRows(P, 22, 23);
+            zeroRowsCols(P, 22, 23);
             for (uint8_t index=22; index<=23; index++) {
                 P[index][index] = sq(WIND_VEL_VARIANCE_MAX);
             }
@@ -239,12 +237,7 @@ void NavEKF3_core::setAidingMode()
         // preserve quaternion 4x4 covariances, but zero the other rows and columns
         for (uint8_t row=0; row<4; row++) {
             for (uint8_t col=4; col<24; col++) {
-                P[row][col] = 0.0f;
-            }
-        }
-        for (uint8_t col=0; col<4; col++) {
-            for (uint8_t row=4; row<24; row++) {
-                P[row][col] = 0.0f;
+                P.upper(row,col) = 0.0f;
             }
         }
         // keep the IMU bias state variances, but zero the covariances
@@ -252,8 +245,7 @@ void NavEKF3_core::setAidingMode()
         for (uint8_t row=0; row<6; row++) {
             oldBiasVariance[row] = P[row+10][row+10];
         }
-        zeroCols(P,10,15);
-        zeroRows(P,10,15);
+        zeroRowsCols(P,10,15);
         for (uint8_t row=0; row<6; row++) {
             P[row+10][row+10] = oldBiasVariance[row];
         }
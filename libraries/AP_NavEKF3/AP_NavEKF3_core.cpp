@@ -241,10 +241,10 @@ void NavEKF3_core::InitialiseVariables()
     lastKnownPositionNE.zero();
     lastKnownPositionD = 0;
     prevTnb.zero();
-    memset(&P[0][0], 0, sizeof(P));
+    P.zero();
     memset(&KH[0][0], 0, sizeof(KH));
     memset(&KHP[0][0], 0, sizeof(KHP));
-    memset(&nextP[0][0], 0, sizeof(nextP));
+    nextP.zero();
     flowDataValid = false;
     rangeDataToFuse  = false;
     Popt = 0.0f;
@@ -596,7 +596,7 @@ bool NavEKF3_core::InitialiseFilterBootstrap(void)
 void NavEKF3_core::CovarianceInit()
 {
     // zero the matrix
-    memset(&P[0][0], 0, sizeof(P));
+    P.zero();
 
     // define the initial angle uncertainty as variances for a rotation vector
     Vector3F rot_vec_var;
@@ -1087,8 +1087,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     if (needMagBodyVarReset) {
         // reset body mag variances
         needMagBodyVarReset = false;
-        zeroCols(P,19,21);
-        zeroRows(P,19,21);
+        zeroRowsCols(P,19,21);
         P[19][19] = sq(frontend->_magNoise);
         P[20][20] = P[19][19];
         P[21][21] = P[19][19];
@@ -1097,8 +1096,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     if (needEarthBodyVarReset) {
         // reset mag earth field variances
         needEarthBodyVarReset = false;
-        zeroCols(P,16,18);
-        zeroRows(P,16,18);
+        zeroRowsCols(P,16,18);
         P[16][16] = sq(frontend->_magNoise);
         P[17][17] = P[16][16];
         P[18][18] = P[16][16];
@@ -1166,8 +1164,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
         dayVar = R_bf.b.y;
         dazVar = R_bf.c.z;
         quatCovResetOnly = true;
-        zeroRows(P,0,3);
-        zeroCols(P,0,3);
+        zeroRowsCols(P,0,3);
     } else {
         ftype _gyrNoise = constrain_ftype(frontend->_gyrNoise, 0.0f, 1.0f);
         daxVar = dayVar = dazVar = sq(dt*_gyrNoise);
@@ -1194,7 +1191,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     }
 
     // calculate the predicted covariance due to inertial sensor error propagation
-    // we calculate the lower diagonal and copy to take advantage of symmetry
+    // we calculate the upper diagonal only to take advantage of symmetry
 
     // intermediate calculations
     const ftype PS0 = sq(q1);
@@ -1433,15 +1430,11 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     nextP[3][3] = PS0*PS3 + PS1*PS2 - PS11*PS156 + PS12*PS152 + PS13*PS153 + PS151*PS7 - PS154*PS34 - PS155*PS6 + PS157 + PS5*PS95;
 
     if (quatCovResetOnly) {
-        // covariance matrix is symmetrical, so copy diagonals and copy lower half in nextP
-        // to lower and upper half in P
+        // covariance matrices only store the upper triangle, so the quaternion
+        // block is the leading 10 elements of nextP
+        P.copy_leading(nextP, 3);
         for (uint8_t row = 0; row <= 3; row++) {
-            // copy diagonals
-            P[row][row] = constrain_ftype(nextP[row][row], 0.0f, 1.0f);
-            // copy off diagonals
-            for (uint8_t column = 0 ; column < row; column++) {
-                P[row][column] = P[column][row] = nextP[column][row];
-            }
+            P[row][row] = constrain_ftype(P[row][row], 0.0f, 1.0f);
         }
         calcTiltErrorVariance();
         return;
@@ -1763,7 +1756,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
         for (uint8_t index=0; index<3; index++) {
             const uint8_t stateIndex = index + 13;
             if (dvelBiasAxisInhibit[index]) {
-                zeroCols(nextP,stateIndex,stateIndex);
+                zeroRowsCols(nextP,stateIndex,stateIndex);
                 nextP[stateIndex][stateIndex] = dvelBiasAxisVarPrev[index];
             }
         }
@@ -1774,26 +1767,19 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     // This prevent an ill conditioned matrix from occurring for long periods
     // without GPS
     if ((P[7][7] + P[8][8]) > 1e4f) {
-        for (uint8_t i=7; i<=8; i++)
-        {
-            for (uint8_t j=0; j<=stateIndexLim; j++)
-            {
-                nextP[i][j] = P[i][j];
-                nextP[j][i] = P[j][i];
+        // the rows and columns share storage, so copy the stored part
+        // of columns 7 and 8 and then the rest of rows 7 and 8
+        for (uint8_t i=7; i<=8; i++) {
+            memcpy(nextP.column(i), P.column(i), sizeof(ftype)*(i+1));
+            for (uint8_t j=9; j<=stateIndexLim; j++) {
+                nextP.upper(i,j) = P.upper(i,j);
             }
         }
     }
 
-    // covariance matrix is symmetrical, so copy diagonals and copy lower half in nextP
-    // to lower and upper half in P
-    for (uint8_t row = 0; row <= stateIndexLim; row++) {
-        // copy diagonals
-        P[row][row] = nextP[row][row];
-        // copy off diagonals
-        for (uint8_t column = 0 ; column < row; column++) {
-            P[row][column] = P[column][row] = nextP[column][row];
-        }
-    }
+    // covariance matrix is symmetrical and only the upper triangle is
+    // stored, so the active states are a contiguous block at the start of nextP
+    P.copy_leading(nextP, stateIndexLim);
 
     // constrain values to prevent ill-conditioning
     ConstrainVariances();
@@ -1809,24 +1795,11 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
 #endif
 }
 
-// zero specified range of rows in the state covariance matrix
-void NavEKF3_core::zeroRows(Matrix24 &covMat, uint8_t first, uint8_t last)
+// zero specified range of rows and columns in the state covariance matrix
+// only the unique elements are stored, so this also zeroes the matching columns
+void NavEKF3_core::zeroRowsCols(SymMatrix24 &covMat, uint8_t first, uint8_t last)
 {
-    uint8_t row;
-    for (row=first; row<=last; row++)
-    {
-        zero_range(&covMat[row][0], 0, 23);
-    }
-}
-
-// zero specified range of columns in the state covariance matrix
-void NavEKF3_core::zeroCols(Matrix24 &covMat, uint8_t first, uint8_t last)
-{
-    uint8_t row;
-    for (row=0; row<=23; row++)
-    {
-        zero_range(&covMat[row][0], first, last);
-    }
+    covMat.zero_rows_cols(first, last);
 }
 
 // reset the output data to the current EKF state
@@ -1867,18 +1840,16 @@ void NavEKF3_core::StoreQuatRotate(const QuaternionF &deltaQuat)
     outputDataDelayed.quat = outputDataDelayed.quat*deltaQuat;
 }
 
-// force symmetry on the covariance matrix to prevent ill-conditioning
-void NavEKF3_core::ForceSymmetry()
+// apply the covariance correction P = P - K*H*P for a scalar observation using the
+// Kalman gains in Kfusion. The observation Jacobian H is given as the hCount non-zero
+// elements hValue at state indexes hIndex, so H*P costs O(n*k) and the rank one K*(H*P)
+// product is applied directly to the unique elements of P, averaging its two triangles
+// so the result is the same as correcting the full matrix and then forcing symmetry.
+// If checkVariances is true the correction is skipped and false returned when it
+// would drive any of the variances negative.
+bool NavEKF3_core::SparseCovarianceUpdate(const uint8_t *hIndex, const ftype *hValue, uint8_t hCount, bool checkVariances)
 {
-    for (uint8_t i=1; i<=stateIndexLim; i++)
-    {
-        for (uint8_t j=0; j<=i-1; j++)
-        {
-            ftype temp = 0.5f*(P[i][j] + P[j][i]);
-            P[i][j] = temp;
-            P[j][i] = temp;
-        }
-    }
+    return P.scalar_correction(&Kfusion[0], hIndex, hValue, hCount, stateIndexLim, checkVariances);
 }
 
 // constrain variances (diagonal terms) in the state covariance matrix to  prevent ill-conditioning
@@ -1901,8 +1872,7 @@ void NavEKF3_core::ConstrainVariances()
         vertVelVarClipCounter += EKF_TARGET_RATE_HZ;
         if (vertVelVarClipCounter > VERT_VEL_VAR_CLIP_COUNT_LIM) {
             // reset the corresponding covariances
-            zeroRows(P,6,6);
-            zeroCols(P,6,6);
+            zeroRowsCols(P,6,6);
 
             // set the variances to the measurement variance
         #if EK3_FEATURE_EXTERNAL_NAV
@@ -1922,8 +1892,7 @@ void NavEKF3_core::ConstrainVariances()
     if (!inhibitDelAngBiasStates) {
         for (uint8_t i=10; i<=12; i++) P[i][i] = constrain_ftype(P[i][i],0.0f,sq(0.175 * dtEkfAvg));
     } else {
-        zeroCols(P,10,12);
-        zeroRows(P,10,12);
+        zeroRowsCols(P,10,12);
     }
 
     const ftype minSafeStateVar = 5E-9;
@@ -1950,8 +1919,7 @@ void NavEKF3_core::ConstrainVariances()
         // If any one axis has fallen below the safe minimum, all delta velocity covariance terms must be reset to zero
         if (resetRequired) {
             // reset all delta velocity bias covariances
-            zeroCols(P,13,15);
-            zeroRows(P,13,15);
+            zeroRowsCols(P,13,15);
             // set all delta velocity bias variances to initial values and zero bias states
             P[13][13] = sq(ACCEL_BIAS_LIM_SCALER * frontend->_accBiasLim * dtEkfAvg);
             P[14][14] = P[13][13];
@@ -1960,8 +1928,7 @@ void NavEKF3_core::ConstrainVariances()
         }
 
     } else {
-        zeroCols(P,13,15);
-        zeroRows(P,13,15);
+        zeroRowsCols(P,13,15);
         // set all delta velocity bias variances to a margin above the minimum safe value
         for (uint8_t i=0; i<=2; i++) {
             const uint8_t stateIndex = i + 13;
@@ -1973,15 +1940,13 @@ void NavEKF3_core::ConstrainVariances()
         for (uint8_t i=16; i<=18; i++) P[i][i] = constrain_ftype(P[i][i],0.0f,0.01f); // earth magnetic field
         for (uint8_t i=19; i<=21; i++) P[i][i] = constrain_ftype(P[i][i],0.0f,0.01f); // body magnetic field
     } else {
-        zeroCols(P,16,21);
-        zeroRows(P,16,21);
+        zeroRowsCols(P,16,21);
     }
 
     if (!inhibitWindStates) {
         for (uint8_t i=22; i<=23; i++) P[i][i] = constrain_ftype(P[i][i],0.0f,WIND_VEL_VARIANCE_MAX);
     } else {
-        zeroCols(P,22,23);
-        zeroRows(P,22,23);
+        zeroRowsCols(P,22,23);
     }
 }
 
@@ -2097,8 +2062,7 @@ void NavEKF3_core::resetMagFieldStates()
     alignMagStateDeclination();
 
     // set the remaining variances and covariances
-    zeroRows(P,18,21);
-    zeroCols(P,18,21);
+    zeroRowsCols(P,18,21);
     P[18][18] = sq(frontend->_magNoise);
     P[19][19] = P[18][18];
     P[20][20] = P[18][18];
@@ -2115,8 +2079,7 @@ void NavEKF3_core::zeroAttCovOnly()
     for (uint8_t index=0; index<=3; index++) {
         varTemp[index] = P[index][index];
     }
-    zeroCols(P,0,3);
-    zeroRows(P,0,3);
+    zeroRowsCols(P,0,3);
     for (uint8_t index=0; index<=3; index++) {
         P[index][index] = varTemp[index];
     }
@@ -695,8 +695,10 @@ private:
     // used to perform a reset of the quaternion state covariances only. Set to null for normal operation.
     void CovariancePrediction(Vector3F *rotVarVecPtr);
 
-    // force symmetry on the state covariance matrix
-    void ForceSymmetry();
+    // apply the covariance correction P = P - K*H*P for a scalar observation with a sparse Jacobian
+    // hIndex and hValue hold the hCount non-zero elements of H, and Kfusion holds the Kalman gains
+    // returns false without modifying P if checkVariances is set and any variance would go negative
+    bool SparseCovarianceUpdate(const uint8_t *hIndex, const ftype *hValue, uint8_t hCount, bool checkVariances);
 
     // constrain variances (diagonal terms) in the state covariance matrix
     void ConstrainVariances();
@@ -733,11 +735,8 @@ private:
     // fuse synthetic sideslip measurement of zero
     void FuseSideslip();
 
-    // zero specified range of rows in the state covariance matrix
-    void zeroRows(Matrix24 &covMat, uint8_t first, uint8_t last);
-
-    // zero specified range of columns in the state covariance matrix
-    void zeroCols(Matrix24 &covMat, uint8_t first, uint8_t last);
+    // zero specified range of rows and columns in the state covariance matrix
+    void zeroRowsCols(SymMatrix24 &covMat, uint8_t first, uint8_t last);
 
     // Reset the stored output history to current data
     void StoreOutputReset(void);
@@ -1042,7 +1041,7 @@ private:
     uint32_t vertVelVarClipCounter; // counter used to control reset of vertical velocity variance following collapse against the lower limit
 
     ftype gpsNoiseScaler;           // Used to scale the  GPS measurement noise and consistency gates to compensate for operation with small satellite counts
-    Matrix24 P;                     // covariance matrix
+    SymMatrix24 P;                  // covariance matrix, upper triangle only
     EKF_IMU_buffer_t<imu_elements> storedIMU;      // IMU data buffer
     EKF_obs_buffer_t<gps_elements> storedGPS;      // GPS data buffer
     EKF_obs_buffer_t<mag_elements> storedMag;      // Magnetometer data buffer
@@ -24,9 +24,11 @@
 #include "AP_Param.h"
 
 #include <cmath>
+#include <ctype.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS.h>
@@ -104,6 +106,16 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_INDEX_ENABLED
+AP_Param::IndexEntry *AP_Param::_index;
+uint16_t *AP_Param::_index_by_name;
+uint16_t AP_Param::_index_len;
+uint16_t AP_Param::_index_size;
+uint16_t AP_Param::_index_count;
+uint16_t AP_Param::_index_marker;
+HAL_Semaphore AP_Param::_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -112,8 +124,14 @@ uint16_t AP_Param::param_overrides_len;
 uint16_t AP_Param::num_param_overrides;
 uint16_t AP_Param::num_read_only;
 
-ObjectBuffer_TS<AP_Param::param_save> AP_Param::save_queue{30};
+struct AP_Param::param_save AP_Param::save_queue[AP_Param::save_queue_size];
+uint8_t AP_Param::save_queue_len;
+volatile uint8_t AP_Param::save_batch_len;
+struct AP_Param::param_save AP_Param::save_batch[AP_Param::save_batch_size];
+struct AP_Param::pending_save AP_Param::save_batch_pending[AP_Param::save_batch_size];
+HAL_Semaphore AP_Param::save_queue_sem;
 bool AP_Param::registered_save_handler;
+struct AP_Param::save_stats AP_Param::_save_stats;
 
 AP_Param::defaults_list *AP_Param::default_list;
 
@@ -149,6 +167,8 @@ uint16_t AP_Param::_frame_type_flags;
 void AP_Param::eeprom_write_check(const void *ptr, uint16_t ofs, uint8_t size)
 {
     _storage.write_block(ofs, ptr, size);
+    _save_stats.writes++;
+    _save_stats.bytes += size;
 #if AP_PARAM_STORAGE_BAK_ENABLED
     _storage_bak.write_block(ofs, ptr, size);
 #endif
@@ -907,6 +927,26 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
+#if AP_PARAM_INDEX_ENABLED
+    ParamToken token;
+    AP_Param *ap = find_in_index(name, ptype, &token);
+    if (ap != nullptr) {
+        if (flags != nullptr) {
+            uint32_t group_element = 0;
+            const struct GroupInfo *ginfo = nullptr;
+            struct GroupNesting group_nesting {};
+            uint8_t idx;
+            ap->find_var_info_token(token, &group_element, ginfo, group_nesting, &idx);
+            if (ginfo != nullptr) {
+                *flags = ginfo->flags;
+            }
+        }
+        return ap;
+    }
+    // the index only holds the scalars that are visible, so fall
+    // back to walking the tree for everything else
+#endif
+
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         uint8_t type = info.type;
@@ -948,11 +988,31 @@ AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Without the index this is quite slow.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_INDEX_ENABLED
+    // the index is built by the IO thread. While it is being rebuilt
+    // or is out of date we walk the tree
+    if (_index_sem.take_nonblocking()) {
+        if (index_current() && _index_len == _index_count) {
+            AP_Param *ap = nullptr;
+            if (idx < _index_len) {
+                const auto &e = _index[idx];
+                *token = e.token;
+                if (ptype != nullptr) {
+                    *ptype = (enum ap_var_type)e.type;
+                }
+                ap = find_by_token(e.token, (enum ap_var_type)e.type);
+            }
+            _index_sem.give();
+            return ap;
+        }
+        _index_sem.give();
+    }
+#endif
     AP_Param *ap;
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
@@ -967,6 +1027,12 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
+#if AP_PARAM_INDEX_ENABLED
+    ap = find_in_index(name, ptype, token);
+    if (ap != nullptr) {
+        return ap;
+    }
+#endif
     uint16_t count = 0;
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
@@ -984,6 +1050,195 @@ AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, Para
     return ap;
 }
 
+#if AP_PARAM_INDEX_ENABLED
+/*
+  case insensitive FNV-1a hash of a parameter name, folded to the 24
+  bits kept in the index
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        h ^= uint8_t(toupper(name[i]));
+        h *= 16777619U;
+    }
+    return (h >> 24) ^ (h & 0xFFFFFFU);
+}
+
+/*
+  walk the tree filling in as much of the index as fits, returning
+  the number of parameters
+ */
+uint16_t AP_Param::fill_index(void)
+{
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr;
+         ap = next_scalar(&token, &type)) {
+        if (count < _index_size) {
+            char name[AP_MAX_NAME_SIZE+1];
+            ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, true);
+            name[AP_MAX_NAME_SIZE] = 0;
+            auto &e = _index[count];
+            e.hash = name_hash(name);
+            e.type = type;
+            e.token = token;
+            _index_by_name[count] = count;
+        }
+        count++;
+    }
+    return count;
+}
+
+/*
+  rebuild the index if the tree has changed. This is called from the
+  IO thread so that lookups from the main thread never pay for a walk
+  of the whole tree
+ */
+void AP_Param::update_index(void)
+{
+    WITH_SEMAPHORE(_index_sem);
+
+    // cope with another thread invalidating the index while we are
+    // building it
+    uint8_t limit = 4;
+    while ((_index_count == 0 || _index_marker != _count_marker) && limit--) {
+        _index_marker = _count_marker;
+        uint16_t count = fill_index();
+        if (count > _index_size) {
+            // grow the table and fill it again
+            free(_index);
+            free(_index_by_name);
+            _index = (IndexEntry *)calloc(count, sizeof(IndexEntry));
+            _index_by_name = (uint16_t *)calloc(count, sizeof(uint16_t));
+            if (_index == nullptr || _index_by_name == nullptr) {
+                // lookups will walk the tree
+                free(_index);
+                free(_index_by_name);
+                _index = nullptr;
+                _index_by_name = nullptr;
+                _index_size = 0;
+            } else {
+                _index_size = count;
+                count = MIN(fill_index(), _index_size);
+            }
+        }
+        _index_count = count;
+        _index_len = MIN(count, _index_size);
+        qsort(_index_by_name, _index_len, sizeof(uint16_t), [](const void *a, const void *b) {
+            const uint32_t ha = _index[*(const uint16_t *)a].hash;
+            const uint32_t hb = _index[*(const uint16_t *)b].hash;
+            return ha < hb ? -1 : (ha > hb ? 1 : 0);
+        });
+    }
+}
+
+/*
+  get the scalar for a token from the index. Pointer groups are
+  resolved on each lookup, so only the tree structure is cached
+ */
+AP_Param *AP_Param::find_by_token(const ParamToken &token, enum ap_var_type type)
+{
+    if (token.key >= _num_vars) {
+        return nullptr;
+    }
+    const auto &info = var_info(token.key);
+    // elements of a Vector3f are indexed as floats
+    const enum ap_var_type stored_type = token.idx != 0 ? AP_PARAM_VECTOR3F : type;
+    void *ptr;
+    if (info.type == AP_PARAM_GROUP) {
+        const struct GroupInfo *group_info = get_group_info(info);
+        if (group_info == nullptr) {
+            return nullptr;
+        }
+        struct Param_header phdr {};
+        phdr.type = stored_type;
+        phdr.group_element = token.group_element;
+        if (find_by_header_group(phdr, &ptr, token.key, group_info, 0, 0, 0) == nullptr) {
+            return nullptr;
+        }
+    } else {
+        ptrdiff_t base;
+        if (info.type != stored_type || !get_base(info, base)) {
+            return nullptr;
+        }
+        ptr = (void *)base;
+    }
+    if (token.idx != 0) {
+        ptr = (void *)(((ptrdiff_t)ptr) + sizeof(float)*(token.idx - 1u));
+    }
+    return (AP_Param *)ptr;
+}
+
+/*
+  return true if the index matches the current tree. Must be called
+  with _index_sem held
+ */
+bool AP_Param::index_current(void)
+{
+    return _index_count != 0 && _index_marker == _count_marker;
+}
+
+/*
+  find a scalar by name using the index, returning nullptr if it
+  isn't in the index or the index is out of date
+ */
+AP_Param *AP_Param::find_in_index(const char *name, enum ap_var_type *ptype, ParamToken *token)
+{
+    // don't wait for the IO thread to finish a rebuild, the caller
+    // can walk the tree instead
+    if (!_index_sem.take_nonblocking()) {
+        return nullptr;
+    }
+    AP_Param *ap = nullptr;
+    if (index_current()) {
+        ap = search_index(name, ptype, token);
+    }
+    _index_sem.give();
+    return ap;
+}
+
+/*
+  binary search the index by name. Must be called with _index_sem held
+ */
+AP_Param *AP_Param::search_index(const char *name, enum ap_var_type *ptype, ParamToken *token)
+{
+    const uint32_t hash = name_hash(name);
+
+    // find the first entry with this hash
+    uint16_t lo = 0, hi = _index_len;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_index[_index_by_name[mid]].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // check the name of each entry with the hash
+    for (uint16_t i=lo; i<_index_len && _index[_index_by_name[i]].hash == hash; i++) {
+        const auto &e = _index[_index_by_name[i]];
+        const enum ap_var_type type = (enum ap_var_type)e.type;
+        AP_Param *ap = find_by_token(e.token, type);
+        if (ap == nullptr) {
+            continue;
+        }
+        char buf[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(e.token, buf, AP_MAX_NAME_SIZE, true);
+        buf[AP_MAX_NAME_SIZE] = 0;
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            *ptype = type;
+            *token = e.token;
+            return ap;
+        }
+    }
+    return nullptr;
+}
+#endif // AP_PARAM_INDEX_ENABLED
+
 /*
   Find a variable by pointer, returning key. This is used for loading pointer variables
 */
@@ -1131,111 +1386,260 @@ void AP_Param::notify() const {
 
 
 /*
-  Save the variable to HAL storage, synchronous version
+  work out how the variable is stored, returning false if it can't be
+  saved
 */
-void AP_Param::save_sync(bool force_save, bool send_to_gcs)
+bool AP_Param::prepare_save(struct pending_save &s, bool force_save, bool send_to_gcs)
 {
     uint32_t group_element = 0;
     const struct GroupInfo *ginfo;
     struct GroupNesting group_nesting {};
     uint8_t idx;
     const struct AP_Param::Info *info = find_var_info(&group_element, ginfo, group_nesting, &idx);
-    const AP_Param *ap;
 
     if (info == nullptr) {
         // we don't have any info on how to store it
-        return;
+        return false;
     }
 
-    struct Param_header phdr;
-
     // create the header we will use to store the variable
     if (ginfo != nullptr) {
-        phdr.type = ginfo->type;
+        s.phdr.type = ginfo->type;
         if (ginfo->flags & AP_PARAM_FLAG_HIDDEN) {
             send_to_gcs = false;
         }
     } else {
-        phdr.type = info->type;
+        s.phdr.type = info->type;
         if (info->flags & AP_PARAM_FLAG_HIDDEN) {
             send_to_gcs = false;
         }
     }
-    set_key(phdr, info->key);
-    phdr.group_element = group_element;
+    set_key(s.phdr, info->key);
+    s.phdr.group_element = group_element;
 
-    ap = this;
-    if (phdr.type != AP_PARAM_VECTOR3F && idx != 0) {
+    s.ap = this;
+    if (s.phdr.type != AP_PARAM_VECTOR3F && idx != 0) {
         // only vector3f can have non-zero idx for now
-        return;
+        return false;
     }
     if (idx != 0) {
-        ap = (const AP_Param *)((ptrdiff_t)ap) - (idx*sizeof(float));
+        s.ap = (const AP_Param *)((ptrdiff_t)s.ap) - (idx*sizeof(float));
     }
 
-    if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
+    if (s.phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
         // clear cached parameter count
         invalidate_count();
     }
-    
-    char name[AP_MAX_NAME_SIZE+1];
-    copy_name_info(info, ginfo, group_nesting, idx, name, sizeof(name), true);
 
-    // scan EEPROM to find the right location
-    uint16_t ofs;
-    if (scan(&phdr, &ofs)) {
-        // found an existing copy of the variable
-        eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
-        if (send_to_gcs) {
-            send_parameter(name, (enum ap_var_type)phdr.type, idx);
+    copy_name_info(info, ginfo, group_nesting, idx, s.name, sizeof(s.name), true);
+
+    if (s.phdr.type <= AP_PARAM_FLOAT) {
+        if (ginfo != nullptr) {
+            s.default_value = get_default_value(this, *ginfo);
+        } else {
+            s.default_value = get_default_value(this, *info);
         }
-        return;
     }
-    if (ofs == (uint16_t) ~0) {
-        return;
+
+    s.param = this;
+    s.idx = idx;
+    s.info_type = info->type;
+    s.force_save = force_save;
+    s.send_to_gcs = send_to_gcs;
+    return true;
+}
+
+/*
+  write a batch of variables to HAL storage. Storage is scanned once
+  for the whole batch. Variables already in storage are updated in
+  place, with neighbouring variables combined into one write. New
+  variables are appended as one block: a new sentinel, then the data,
+  then the header of the first of them over the old sentinel
+*/
+void AP_Param::write_saves(struct pending_save *saves, uint8_t n)
+{
+    // find the stored copies and the sentinel
+    uint8_t remaining = n;
+    for (uint8_t i=0; i<n; i++) {
+        saves[i].ofs = 0xFFFF;
+    }
+    uint16_t end_ofs = 0xFFFF;
+    uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    while (remaining > 0 && ofs < _storage.size()) {
+        struct Param_header phdr;
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        for (uint8_t i=0; i<n; i++) {
+            struct pending_save &s = saves[i];
+            if (s.ofs == 0xFFFF &&
+                phdr.type == s.phdr.type &&
+                get_key(phdr) == get_key(s.phdr) &&
+                phdr.group_element == s.phdr.group_element) {
+                s.ofs = ofs;
+                remaining--;
+            }
+        }
+        if (is_sentinal(phdr)) {
+            end_ofs = ofs;
+            sentinal_offset = ofs;
+            break;
+        }
+        ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
-    // if the value is the default value then don't save
-    if (phdr.type <= AP_PARAM_FLOAT) {
-        float v1 = cast_to_float((enum ap_var_type)phdr.type);
-        float v2;
-        if (ginfo != nullptr) {
-            v2 = get_default_value(this, *ginfo);
+    uint8_t buf[save_batch_size * (sizeof(struct Param_header) + 12)];
+
+    // update stored copies in storage order, so neighbours can share a write
+    uint8_t order[save_batch_size];
+    uint8_t num_stored = 0;
+    for (uint8_t i=0; i<n; i++) {
+        if (saves[i].ofs == 0xFFFF) {
+            continue;
+        }
+        uint8_t j = num_stored++;
+        while (j > 0 && saves[order[j-1]].ofs > saves[i].ofs) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+    uint16_t write_ofs = 0;
+    uint8_t write_len = 0;
+    for (uint8_t i=0; i<num_stored; i++) {
+        const struct pending_save &s = saves[order[i]];
+        const uint8_t size = type_size((enum ap_var_type)s.phdr.type);
+        if (i > 0 && saves[order[i-1]].ofs == s.ofs) {
+            // another element of the same vector
+            continue;
+        }
+        const uint16_t data_ofs = s.ofs + sizeof(s.phdr);
+        if (write_len > 0 && data_ofs == write_ofs + write_len + sizeof(s.phdr)) {
+            // the header between the two is already in storage
+            memcpy(&buf[write_len], &s.phdr, sizeof(s.phdr));
+            write_len += sizeof(s.phdr);
         } else {
-            v2 = get_default_value(this, *info);
+            if (write_len > 0) {
+                eeprom_write_check(buf, write_ofs, write_len);
+            }
+            write_ofs = data_ofs;
+            write_len = 0;
+        }
+        memcpy(&buf[write_len], s.ap, size);
+        write_len += size;
+    }
+    if (write_len > 0) {
+        eeprom_write_check(buf, write_ofs, write_len);
+    }
+
+    // append the new variables, unless we ran off the end of storage
+    struct Param_header first_phdr {};
+    uint16_t append_ofs = end_ofs;
+    write_len = 0;
+    for (uint8_t i=0; end_ofs != 0xFFFF && i<n; i++) {
+        struct pending_save &s = saves[i];
+        if (s.ofs != 0xFFFF) {
+            continue;
         }
-        if (is_equal(v1,v2) && !force_save) {
-            if (send_to_gcs) {
-                GCS_SEND_PARAM(name, (enum ap_var_type)info->type, v2);
+
+        // another element of a vector we are already appending
+        bool appended = false;
+        for (uint8_t j=0; j<i; j++) {
+            if (saves[j].ofs != 0xFFFF && saves[j].ofs >= end_ofs &&
+                memcmp(&saves[j].phdr, &s.phdr, sizeof(s.phdr)) == 0) {
+                s.ofs = saves[j].ofs;
+                appended = true;
+                break;
             }
-            return;
         }
-        if (!force_save &&
-            (phdr.type != AP_PARAM_INT32 &&
-             (fabsf(v1-v2) < 0.0001f*fabsf(v1)))) {
+        if (appended) {
+            continue;
+        }
+
+        // if the value is the default value then don't save
+        if (s.phdr.type <= AP_PARAM_FLOAT) {
+            const float v1 = s.param->cast_to_float((enum ap_var_type)s.phdr.type);
+            const float v2 = s.default_value;
             // for other than 32 bit integers, we accept values within
             // 0.01 percent of the current value as being the same
-            if (send_to_gcs) {
-                GCS_SEND_PARAM(name, (enum ap_var_type)info->type, v2);
+            if (!s.force_save &&
+                (is_equal(v1,v2) ||
+                 (s.phdr.type != AP_PARAM_INT32 && fabsf(v1-v2) < 0.0001f*fabsf(v1)))) {
+                if (s.send_to_gcs) {
+                    GCS_SEND_PARAM(s.name, (enum ap_var_type)s.info_type, v2);
+                }
+                continue;
             }
-            return;
         }
+
+        const uint8_t size = type_size((enum ap_var_type)s.phdr.type);
+        if (append_ofs+size+2*sizeof(s.phdr) >= _storage.size()) {
+            // we are out of room for saving variables
+            DEV_PRINTF("EEPROM full\n");
+            break;
+        }
+        if (append_ofs == end_ofs) {
+            first_phdr = s.phdr;
+        } else {
+            memcpy(&buf[write_len], &s.phdr, sizeof(s.phdr));
+            write_len += sizeof(s.phdr);
+        }
+        memcpy(&buf[write_len], s.ap, size);
+        write_len += size;
+        s.ofs = append_ofs;
+        append_ofs += sizeof(s.phdr) + size;
+    }
+    if (append_ofs != end_ofs) {
+        // write a new sentinel, then the data, then the header
+        write_sentinal(append_ofs);
+        eeprom_write_check(buf, end_ofs+sizeof(first_phdr), write_len);
+        eeprom_write_check(&first_phdr, end_ofs, sizeof(first_phdr));
     }
 
-    if (ofs+type_size((enum ap_var_type)phdr.type)+2*sizeof(phdr) >= _storage.size()) {
-        // we are out of room for saving variables
-        DEV_PRINTF("EEPROM full\n");
-        return;
+    for (uint8_t i=0; i<n; i++) {
+        const struct pending_save &s = saves[i];
+        if (s.ofs != 0xFFFF && s.send_to_gcs) {
+            s.param->send_parameter(s.name, (enum ap_var_type)s.phdr.type, s.idx);
+        }
     }
+}
 
-    // write a new sentinal, then the data, then the header
-    write_sentinal(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
-    eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
-    eeprom_write_check(&phdr, ofs, sizeof(phdr));
+/*
+  Save the variable to HAL storage, synchronous version
+*/
+void AP_Param::save_sync(bool force_save, bool send_to_gcs)
+{
+    struct pending_save s;
+    if (prepare_save(s, force_save, send_to_gcs)) {
+        write_saves(&s, 1);
+    }
+}
 
-    if (send_to_gcs) {
-        send_parameter(name, (enum ap_var_type)phdr.type, idx);
+/*
+  put variable into queue to be saved, combining it with an earlier
+  save of the same variable that hasn't been written yet
+*/
+bool AP_Param::queue_save(bool force_save)
+{
+    WITH_SEMAPHORE(save_queue_sem);
+    for (uint8_t i=0; i<save_queue_len; i++) {
+        if (save_queue[i].param == this) {
+            // the value is read when the save is written, so this
+            // catches the case where we are flooding the save queue
+            // with one parameter (eg. mission creation, changing
+            // MIS_TOTAL)
+            save_queue[i].force_save |= force_save;
+            _save_stats.saves++;
+            _save_stats.combined++;
+            return true;
+        }
+    }
+    if (save_queue_len >= save_queue_size) {
+        return false;
     }
+    save_queue[save_queue_len].param = this;
+    save_queue[save_queue_len].force_save = force_save;
+    save_queue_len++;
+    _save_stats.saves++;
+    return true;
 }
 
 /*
@@ -1243,19 +1647,7 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
 */
 void AP_Param::save(bool force_save)
 {
-    struct param_save p, p2;
-    p.param = this;
-    p.force_save = force_save;
-    if (save_queue.peek(p2) &&
-        p2.param == this &&
-        p2.force_save == force_save) {
-        // this one is already at the head of the list to be
-        // saved. This check is cheap and catches the case where we
-        // are flooding the save queue with one parameter (eg. mission
-        // creation, changing MIS_TOTAL)
-        return;
-    }
-    while (!save_queue.push(p)) {
+    while (!queue_save(force_save)) {
         // if we can't save to the queue
         if (hal.util->get_soft_armed() && hal.scheduler->in_main_thread()) {
             // if we are armed in main thread then don't sleep, instead we lose the
@@ -1276,23 +1668,71 @@ void AP_Param::save(bool force_save)
  */
 void AP_Param::save_io_handler(void)
 {
-    struct param_save p;
-    while (save_queue.pop(p)) {
-        p.param->save_sync(p.force_save, true);
+    while (true) {
+        uint8_t n;
+        {
+            WITH_SEMAPHORE(save_queue_sem);
+            n = MIN(save_queue_len, uint8_t(save_batch_size));
+            memcpy(save_batch, save_queue, n*sizeof(save_batch[0]));
+            save_queue_len -= n;
+            memmove(&save_queue[0], &save_queue[n], save_queue_len*sizeof(save_queue[0]));
+            save_batch_len = n;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        const uint32_t start_us = AP_HAL::micros();
+        uint8_t count = 0;
+        for (uint8_t i=0; i<n; i++) {
+            if (save_batch[i].param->prepare_save(save_batch_pending[count], save_batch[i].force_save, true)) {
+                count++;
+            }
+        }
+        write_saves(save_batch_pending, count);
+        const uint32_t dt_us = AP_HAL::micros() - start_us;
+        _save_stats.batches++;
+        _save_stats.last_us = dt_us;
+        _save_stats.max_us = MAX(_save_stats.max_us, dt_us);
+        save_batch_len = 0;
     }
     if (hal.scheduler->is_system_initialized()) {
         // pay the cost of parameter counting in the IO thread
+#if AP_PARAM_INDEX_ENABLED
+        update_index();
+#else
         count_parameters();
+#endif
     }
 }
 
+/*
+  statistics of background parameter saves
+ */
+void AP_Param::save_info(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("ParamSaveV1\n");
+    str.printf("saves=%u combined=%u queued=%u\n",
+               unsigned(_save_stats.saves),
+               unsigned(_save_stats.combined),
+               unsigned(save_queue_len));
+    str.printf("batches=%u writes=%u bytes=%u\n",
+               unsigned(_save_stats.batches),
+               unsigned(_save_stats.writes),
+               unsigned(_save_stats.bytes));
+    str.printf("last_us=%u max_us=%u\n",
+               unsigned(_save_stats.last_us),
+               unsigned(_save_stats.max_us));
+}
+
 /*
   wait for all parameters to save
 */
 void AP_Param::flush(void)
 {
     uint16_t counter = 200; // 2 seconds max
-    while (counter-- && save_queue.available()) {
+    while (counter-- && (save_queue_len != 0 || save_batch_len != 0)) {
         hal.scheduler->expect_delay_ms(10);
         hal.scheduler->delay(10);
         hal.scheduler->expect_delay_ms(0);
@@ -2569,6 +3009,15 @@ void AP_Param::send_parameter(const char *name, enum ap_var_type var_type, uint8
  */
 uint16_t AP_Param::count_parameters(void)
 {
+#if AP_PARAM_INDEX_ENABLED
+    if (_index_sem.take_nonblocking()) {
+        const uint16_t count = index_current() ? _index_count : 0;
+        _index_sem.give();
+        if (count != 0) {
+            return count;
+        }
+    }
+#endif
     // if we haven't cached the parameter count yet...
     WITH_SEMAPHORE(_count_sem);
     if (_parameter_count != 0 &&
@@ -190,6 +190,8 @@ enum ap_var_type {
 ///
 class AP_Param
 {
+    friend class AP_Param_Test;
+
 public:
     // the Info and GroupInfo structures are passed by the main
     // program in setup() to give information on how variables are
@@ -412,6 +414,10 @@ public:
     ///
     void save(bool force_save=false);
 
+    /// statistics of background parameter saves, for @SYS/param_save.txt
+    ///
+    static void save_info(ExpandingString &str);
+
     /// Load the variable from EEPROM.
     ///
     /// @return                True if the variable was loaded successfully.
@@ -544,6 +550,12 @@ public:
     // invalidate parameter count
     static void invalidate_count(void);
 
+#if AP_PARAM_INDEX_ENABLED
+    // rebuild the parameter index if the tree has changed. Called
+    // from the IO thread
+    static void update_index(void);
+#endif
+
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
     // set frame type flags. Used to unhide frame specific parameters
@@ -772,6 +784,35 @@ private:
     static HAL_Semaphore        _count_sem;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_INDEX_ENABLED
+    /*
+      table of the scalar parameters in the order first() and
+      next_scalar() return them, and the order of the table sorted by
+      a hash of the parameter names. It is built by the IO thread and
+      rebuilt after invalidate_count(), which is called whenever the
+      tree or the set of visible parameters changes. Lookups walk the
+      tree while the index is out of date
+     */
+    struct IndexEntry {
+        uint32_t hash : 24;
+        uint32_t type : 8;
+        ParamToken token;
+    };
+    static IndexEntry *         _index;
+    static uint16_t *           _index_by_name;
+    static uint16_t             _index_len;
+    static uint16_t             _index_size;
+    static uint16_t             _index_count;
+    static uint16_t             _index_marker;
+    static HAL_Semaphore        _index_sem;
+    static uint32_t             name_hash(const char *name);
+    static uint16_t             fill_index(void);
+    static bool                 index_current(void);
+    static AP_Param *           find_in_index(const char *name, enum ap_var_type *ptype, ParamToken *token);
+    static AP_Param *           search_index(const char *name, enum ap_var_type *ptype, ParamToken *token);
+    static AP_Param *           find_by_token(const ParamToken &token, enum ap_var_type type);
+#endif
+
 #if AP_PARAM_DYNAMIC_ENABLED
     // allow for a dynamically allocated var table
     static uint16_t             _num_vars_base;
@@ -807,18 +848,60 @@ private:
 
     static bool _hide_disabled_groups;
 
-    // support for background saving of parameters. We pack it to reduce memory for the
-    // queue
+    // support for background saving of parameters. A parameter is
+    // only queued once, so repeated saves of the same parameter
+    // before the IO thread gets to it are combined. We pack it to
+    // reduce memory for the queue
     struct PACKED param_save {
         AP_Param *param;
         bool force_save;
     };
-    static ObjectBuffer_TS<struct param_save> save_queue;
+    static const uint8_t save_queue_size = 30;
+    static struct param_save save_queue[save_queue_size];
+    static uint8_t save_queue_len;
+    static volatile uint8_t save_batch_len;
+    static HAL_Semaphore save_queue_sem;
     static bool registered_save_handler;
 
+    // add to the save queue, false if it is full
+    bool queue_save(bool force_save);
+
     // background function for saving parameters
     void save_io_handler(void);
 
+    // queued saves are written in batches, so storage is scanned once
+    // per batch and new values are appended with one write
+    static const uint8_t save_batch_size = AP_PARAM_SAVE_BATCH_SIZE;
+    struct pending_save {
+        AP_Param *param;
+        const AP_Param *ap;     // start of the stored value
+        struct Param_header phdr;
+        float default_value;
+        uint16_t ofs;           // storage offset of the header
+        uint8_t idx;
+        uint8_t info_type;
+        bool force_save;
+        bool send_to_gcs;
+        char name[AP_MAX_NAME_SIZE+1];
+    };
+    bool prepare_save(struct pending_save &s, bool force_save, bool send_to_gcs);
+    static void write_saves(struct pending_save *saves, uint8_t n);
+    // the batch being written, only used by the IO thread. These are
+    // too big for the IO thread stack on small boards
+    static struct param_save save_batch[save_batch_size];
+    static struct pending_save save_batch_pending[save_batch_size];
+
+    struct save_stats {
+        uint32_t saves;         // calls to save()
+        uint32_t combined;      // saves combined with one already queued
+        uint32_t batches;       // batches written by the IO thread
+        uint32_t writes;        // writes to storage
+        uint32_t bytes;         // bytes written to storage
+        uint32_t last_us;       // time to write the last batch
+        uint32_t max_us;        // longest time to write a batch
+    };
+    static struct save_stats _save_stats;
+
     // Store default values from add_default() calls in linked list
     struct defaults_list {
         AP_Param *ap;
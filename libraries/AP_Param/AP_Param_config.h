@@ -11,3 +11,23 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+/*
+  keep a table of the parameters for find_by_index(), find() and
+  find_by_name(). Costs 10 bytes of RAM per parameter
+ */
+#ifndef AP_PARAM_INDEX_ENABLED
+#define AP_PARAM_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+/*
+  number of queued saves the IO thread writes at a time. Each costs
+  about 40 bytes of RAM and 16 bytes of IO thread stack
+ */
+#ifndef AP_PARAM_SAVE_BATCH_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_300
+#define AP_PARAM_SAVE_BATCH_SIZE 8
+#else
+#define AP_PARAM_SAVE_BATCH_SIZE 1
+#endif
+#endif
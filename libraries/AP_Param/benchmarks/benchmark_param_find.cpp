@@ -0,0 +1,204 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  parameter lookups by name and index in a tree the size of a Copter
+  build: 48 groups of 30 scalars and a Vector3f, about 1,600
+  parameters
+ */
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int8 enable;
+    AP_Float p[29];
+    AP_Vector3f v;
+};
+
+#define BENCH_PARAM(n) AP_GROUPINFO("P" #n, n+1, BenchGroup, p[n], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    AP_GROUPINFO_FLAGS("ENABLE", 0, BenchGroup, enable, 1, AP_PARAM_FLAG_ENABLE),
+    BENCH_PARAM(0),  BENCH_PARAM(1),  BENCH_PARAM(2),  BENCH_PARAM(3),
+    BENCH_PARAM(4),  BENCH_PARAM(5),  BENCH_PARAM(6),  BENCH_PARAM(7),
+    BENCH_PARAM(8),  BENCH_PARAM(9),  BENCH_PARAM(10), BENCH_PARAM(11),
+    BENCH_PARAM(12), BENCH_PARAM(13), BENCH_PARAM(14), BENCH_PARAM(15),
+    BENCH_PARAM(16), BENCH_PARAM(17), BENCH_PARAM(18), BENCH_PARAM(19),
+    BENCH_PARAM(20), BENCH_PARAM(21), BENCH_PARAM(22), BENCH_PARAM(23),
+    BENCH_PARAM(24), BENCH_PARAM(25), BENCH_PARAM(26), BENCH_PARAM(27),
+    BENCH_PARAM(28),
+    AP_GROUPINFO("VEC", 30, BenchGroup, v, 0),
+    AP_GROUPEND
+};
+
+static const uint8_t num_groups = 48;
+static AP_Int16 format_version;
+static BenchGroup groups[num_groups];
+
+#define BENCH_GROUP(n) { "G" #n "_", &groups[n], {group_info : BenchGroup::var_info}, 0, n+1, AP_PARAM_GROUP }
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", &format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    BENCH_GROUP(0),  BENCH_GROUP(1),  BENCH_GROUP(2),  BENCH_GROUP(3),
+    BENCH_GROUP(4),  BENCH_GROUP(5),  BENCH_GROUP(6),  BENCH_GROUP(7),
+    BENCH_GROUP(8),  BENCH_GROUP(9),  BENCH_GROUP(10), BENCH_GROUP(11),
+    BENCH_GROUP(12), BENCH_GROUP(13), BENCH_GROUP(14), BENCH_GROUP(15),
+    BENCH_GROUP(16), BENCH_GROUP(17), BENCH_GROUP(18), BENCH_GROUP(19),
+    BENCH_GROUP(20), BENCH_GROUP(21), BENCH_GROUP(22), BENCH_GROUP(23),
+    BENCH_GROUP(24), BENCH_GROUP(25), BENCH_GROUP(26), BENCH_GROUP(27),
+    BENCH_GROUP(28), BENCH_GROUP(29), BENCH_GROUP(30), BENCH_GROUP(31),
+    BENCH_GROUP(32), BENCH_GROUP(33), BENCH_GROUP(34), BENCH_GROUP(35),
+    BENCH_GROUP(36), BENCH_GROUP(37), BENCH_GROUP(38), BENCH_GROUP(39),
+    BENCH_GROUP(40), BENCH_GROUP(41), BENCH_GROUP(42), BENCH_GROUP(43),
+    BENCH_GROUP(44), BENCH_GROUP(45), BENCH_GROUP(46), BENCH_GROUP(47),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+static const uint16_t max_names = 2048;
+static char names[max_names][AP_MAX_NAME_SIZE+1];
+static uint16_t num_names;
+
+// every scalar name, in a shuffled order like a parameter file from a GCS
+static void setup_names()
+{
+    if (num_names != 0) {
+        return;
+    }
+    for (uint8_t i=0; i<num_groups; i++) {
+        groups[i].enable.set(1);
+    }
+    // the IO thread keeps the index up to date on a vehicle
+    AP_Param::update_index();
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != nullptr && num_names < max_names;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        ap->copy_name_token(token, names[num_names], AP_MAX_NAME_SIZE, true);
+        num_names++;
+    }
+    for (uint16_t i=num_names-1; i>0; i--) {
+        char tmp[AP_MAX_NAME_SIZE+1];
+        const uint16_t j = (i * 7919U) % (i+1);
+        memcpy(tmp, names[i], sizeof(tmp));
+        memcpy(names[i], names[j], sizeof(tmp));
+        memcpy(names[j], tmp, sizeof(tmp));
+    }
+}
+
+// the whole tree walk done by find_by_name() without the index
+static AP_Param *find_by_walk(const char *name, enum ap_var_type *ptype, AP_Param::ParamToken *token)
+{
+    AP_Param *ap;
+    for (ap = AP_Param::first(token, ptype);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(token, ptype)) {
+        char buf[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(*token, buf, AP_MAX_NAME_SIZE, true);
+        buf[AP_MAX_NAME_SIZE] = 0;
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            break;
+        }
+    }
+    return ap;
+}
+
+static void BM_ParamFindByWalk(benchmark::State& state)
+{
+    setup_names();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param::ParamToken token;
+        AP_Param *ap = find_by_walk(names[i], &type, &token);
+        gbenchmark_escape(ap);
+        i = (i + 1) % num_names;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ParamFind(benchmark::State& state)
+{
+    setup_names();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        uint16_t flags = 0;
+        AP_Param *ap = AP_Param::find(names[i], &type, &flags);
+        gbenchmark_escape(ap);
+        i = (i + 1) % num_names;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ParamFindByName(benchmark::State& state)
+{
+    setup_names();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::find_by_name(names[i], &type, &token);
+        gbenchmark_escape(ap);
+        i = (i + 1) % num_names;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ParamFindMissing(benchmark::State& state)
+{
+    setup_names();
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find("NOT_A_PARAM", &type);
+        gbenchmark_escape(ap);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// the walk done by find_by_index() without the index
+static void BM_ParamFindByIndexWalk(benchmark::State& state)
+{
+    setup_names();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::first(&token, &type);
+        for (uint16_t count=0; ap != nullptr && count < i; count++) {
+            ap = AP_Param::next_scalar(&token, &type);
+        }
+        gbenchmark_escape(ap);
+        i = (i + 97) % num_names;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ParamFindByIndex(benchmark::State& state)
+{
+    setup_names();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::find_by_index(i, &type, &token);
+        gbenchmark_escape(ap);
+        i = (i + 97) % num_names;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ParamFindByWalk);
+BENCHMARK(BM_ParamFind);
+BENCHMARK(BM_ParamFindByName);
+BENCHMARK(BM_ParamFindMissing);
+BENCHMARK(BM_ParamFindByIndexWalk);
+BENCHMARK(BM_ParamFindByIndex);
+
+BENCHMARK_MAIN();
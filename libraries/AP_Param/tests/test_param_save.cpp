@@ -0,0 +1,284 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  check that batched parameter saves leave storage byte for byte the
+  same as saving each parameter on its own, the way save_sync() did
+  before saves were batched
+ */
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int8 enable;
+    AP_Int16 i16;
+    AP_Int32 i32;
+    AP_Float f[6];
+    AP_Vector3f v;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO_FLAGS("ENABLE", 0, TestGroup, enable, 1, AP_PARAM_FLAG_ENABLE),
+    AP_GROUPINFO("I16", 1, TestGroup, i16, 100),
+    AP_GROUPINFO("I32", 2, TestGroup, i32, 100000),
+    AP_GROUPINFO("F0", 3, TestGroup, f[0], 0),
+    AP_GROUPINFO("F1", 4, TestGroup, f[1], 1.5),
+    AP_GROUPINFO("F2", 5, TestGroup, f[2], 2.5),
+    AP_GROUPINFO("F3", 6, TestGroup, f[3], 0),
+    AP_GROUPINFO("F4", 7, TestGroup, f[4], 0),
+    AP_GROUPINFO("F5", 8, TestGroup, f[5], 0),
+    AP_GROUPINFO("VEC", 9, TestGroup, v, 0),
+    AP_GROUPEND
+};
+
+static AP_Int16 format_version;
+static TestGroup groups[2];
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", &format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    { "A_", &groups[0], {group_info : TestGroup::var_info}, 0, 1, AP_PARAM_GROUP },
+    { "B_", &groups[1], {group_info : TestGroup::var_info}, 0, 2, AP_PARAM_GROUP },
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+class AP_Param_Test
+{
+public:
+    // save_sync() from before saves were batched, less the GCS
+    // notification: scan storage, then update the stored copy or
+    // append a new sentinel, the data and then the header
+    static void save_unbatched(AP_Param *ap, bool force_save)
+    {
+        uint32_t group_element = 0;
+        const struct AP_Param::GroupInfo *ginfo;
+        struct AP_Param::GroupNesting group_nesting {};
+        uint8_t idx;
+        const struct AP_Param::Info *info = ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
+        if (info == nullptr) {
+            return;
+        }
+        struct AP_Param::Param_header phdr;
+        phdr.type = ginfo != nullptr ? ginfo->type : info->type;
+        AP_Param::set_key(phdr, info->key);
+        phdr.group_element = group_element;
+        const AP_Param *var = ap;
+        if (phdr.type != AP_PARAM_VECTOR3F && idx != 0) {
+            return;
+        }
+        if (idx != 0) {
+            var = (const AP_Param *)((ptrdiff_t)var) - (idx*sizeof(float));
+        }
+        const uint8_t size = AP_Param::type_size((enum ap_var_type)phdr.type);
+
+        uint16_t ofs;
+        if (AP_Param::scan(&phdr, &ofs)) {
+            AP_Param::eeprom_write_check(var, ofs+sizeof(phdr), size);
+            return;
+        }
+        if (ofs == (uint16_t) ~0) {
+            return;
+        }
+        if (phdr.type <= AP_PARAM_FLOAT) {
+            const float v1 = ap->cast_to_float((enum ap_var_type)phdr.type);
+            const float v2 = ginfo != nullptr ?
+                AP_Param::get_default_value(ap, *ginfo) :
+                AP_Param::get_default_value(ap, *info);
+            if (is_equal(v1,v2) && !force_save) {
+                return;
+            }
+            if (!force_save &&
+                (phdr.type != AP_PARAM_INT32 &&
+                 (fabsf(v1-v2) < 0.0001f*fabsf(v1)))) {
+                return;
+            }
+        }
+        if (ofs+size+2*sizeof(phdr) >= AP_Param::_storage.size()) {
+            return;
+        }
+        AP_Param::write_sentinal(ofs + sizeof(phdr) + size);
+        AP_Param::eeprom_write_check(var, ofs+sizeof(phdr), size);
+        AP_Param::eeprom_write_check(&phdr, ofs, sizeof(phdr));
+    }
+
+    // the IO thread's path: prepare each save, then write them a
+    // batch at a time
+    static void save_batched(AP_Param *const params[], const bool force_save[], uint8_t n)
+    {
+        for (uint8_t i=0; i<n; i += AP_Param::save_batch_size) {
+            const uint8_t len = MIN(n-i, AP_Param::save_batch_size);
+            uint8_t count = 0;
+            for (uint8_t j=0; j<len; j++) {
+                if (params[i+j]->prepare_save(AP_Param::save_batch_pending[count], force_save[i+j], false)) {
+                    count++;
+                }
+            }
+            AP_Param::write_saves(AP_Param::save_batch_pending, count);
+        }
+    }
+
+    static uint16_t storage_size()
+    {
+        return AP_Param::_storage.size();
+    }
+
+    static void read_storage(uint8_t *buf)
+    {
+        AP_Param::_storage.read_block(buf, 0, storage_size());
+    }
+};
+
+struct save_list {
+    AP_Param *params[32];
+    bool force_save[32];
+    uint8_t n;
+    void add(AP_Param &p, bool force=false)
+    {
+        params[n] = &p;
+        force_save[n] = force;
+        n++;
+    }
+};
+
+// element idx of a Vector3f parameter, as a GCS sets it
+static AP_Param &vec_element(AP_Vector3f &v, uint8_t idx)
+{
+    return *(AP_Param *)(((uint8_t *)&v) + idx*sizeof(float));
+}
+
+enum class SaveMethod {
+    UNBATCHED,
+    SAVE_SYNC,
+    BATCHED,
+};
+
+static void apply_saves(SaveMethod method, const save_list &saves)
+{
+    switch (method) {
+    case SaveMethod::UNBATCHED:
+        for (uint8_t i=0; i<saves.n; i++) {
+            AP_Param_Test::save_unbatched(saves.params[i], saves.force_save[i]);
+        }
+        break;
+    case SaveMethod::SAVE_SYNC:
+        for (uint8_t i=0; i<saves.n; i++) {
+            saves.params[i]->save_sync(saves.force_save[i], false);
+        }
+        break;
+    case SaveMethod::BATCHED:
+        AP_Param_Test::save_batched(saves.params, saves.force_save, saves.n);
+        break;
+    }
+}
+
+/*
+  two rounds of saves from erased storage: the first appends, the
+  second updates some of the same variables, appends others and
+  saves some at their defaults
+ */
+static void run_saves(SaveMethod method, uint8_t *image)
+{
+    AP_Param::erase_all();
+    for (uint8_t g=0; g<2; g++) {
+        TestGroup &t = groups[g];
+        t.enable.set(1);
+        t.i16.set(100);
+        t.i32.set(100000);
+        for (uint8_t i=0; i<6; i++) {
+            t.f[i].set(0);
+        }
+        t.f[1].set(1.5);
+        t.f[2].set(2.5);
+        t.v.set(Vector3f());
+    }
+    format_version.set(0);
+
+    save_list first {};
+    format_version.set(120);
+    first.add(format_version);
+    groups[0].i16.set(7);
+    first.add(groups[0].i16);
+    groups[0].f[0].set(0.25);
+    first.add(groups[0].f[0]);
+    // at its default, so not stored
+    first.add(groups[0].f[1]);
+    // within 0.01% of its default, so not stored
+    groups[0].f[2].set(2.5001);
+    first.add(groups[0].f[2]);
+    groups[0].v.set(Vector3f(1, 2, 3));
+    first.add(vec_element(groups[0].v, 0));
+    first.add(vec_element(groups[0].v, 2));
+    groups[1].i32.set(-5);
+    first.add(groups[1].i32);
+    // forced at its default
+    first.add(groups[1].enable, true);
+    groups[0].f[3].set(-8);
+    first.add(groups[0].f[3]);
+    apply_saves(method, first);
+
+    save_list second {};
+    // stored neighbours, one of them saved twice
+    groups[0].i16.set(-300);
+    second.add(groups[0].i16);
+    groups[0].f[0].set(4);
+    second.add(groups[0].f[0]);
+    second.add(groups[0].i16);
+    // new variables between updates of stored ones
+    groups[1].f[5].set(9.5);
+    second.add(groups[1].f[5]);
+    groups[0].v.set(Vector3f(-1, 0, 5));
+    second.add(vec_element(groups[0].v, 1));
+    groups[1].v.set(Vector3f(0, 0, 1));
+    second.add(vec_element(groups[1].v, 2));
+    second.add(vec_element(groups[1].v, 0));
+    // now stored at a value that is the default
+    groups[0].f[3].set(0);
+    second.add(groups[0].f[3]);
+    groups[1].f[4].set(3);
+    second.add(groups[1].f[4]);
+    groups[0].f[1].set(6);
+    second.add(groups[0].f[1]);
+    format_version.set(121);
+    second.add(format_version);
+    groups[1].i16.set(100);
+    second.add(groups[1].i16, true);
+    apply_saves(method, second);
+
+    AP_Param_Test::read_storage(image);
+}
+
+TEST(AP_Param, BatchedSavesMatchUnbatched)
+{
+    ASSERT_TRUE(AP_Param::setup());
+    const uint16_t size = AP_Param_Test::storage_size();
+    uint8_t *unbatched = new uint8_t[size];
+    uint8_t *save_sync = new uint8_t[size];
+    uint8_t *batched = new uint8_t[size];
+
+    run_saves(SaveMethod::UNBATCHED, unbatched);
+    run_saves(SaveMethod::SAVE_SYNC, save_sync);
+    run_saves(SaveMethod::BATCHED, batched);
+
+    for (uint16_t i=0; i<size; i++) {
+        EXPECT_EQ(unbatched[i], save_sync[i]) << "save_sync differs at offset " << i;
+        EXPECT_EQ(unbatched[i], batched[i]) << "batched differs at offset " << i;
+    }
+
+    // and that something was stored
+    uint8_t *erased = new uint8_t[size];
+    AP_Param::erase_all();
+    AP_Param_Test::read_storage(erased);
+    EXPECT_NE(memcmp(erased, batched, size), 0);
+    delete[] erased;
+
+    delete[] unbatched;
+    delete[] save_sync;
+    delete[] batched;
+}
+
+AP_GTEST_MAIN()
@@ -67,7 +67,7 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
     // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Bitmask: 0:Enable per-task perf info,1:Enable scheduler trace,2:Earliest deadline first scheduling
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
@@ -126,13 +126,40 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
    _last_run = new uint16_t[_num_tasks];
     _tick_counter = 0;
 
+#if AP_SCHEDULER_EDF_ENABLED
+    // merged table of vehicle and common tasks, in the order they
+    // are run by run_priority(), for picking tasks by deadline
+    _tasks = new const Task*[_num_tasks];
+    _interval_ticks = new uint16_t[_num_tasks];
+    _due_tasks = new uint8_t[_num_tasks];
+    if (_tasks == nullptr || _interval_ticks == nullptr || _due_tasks == nullptr) {
+        // EDF is not available
+        delete[] _tasks;
+        delete[] _interval_ticks;
+        delete[] _due_tasks;
+        _tasks = nullptr;
+    } else {
+        uint8_t vehicle_tasks_offset = 0;
+        uint8_t common_tasks_offset = 0;
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            if (common_tasks_offset >= _num_common_tasks ||
+                (vehicle_tasks_offset < _num_vehicle_tasks &&
+                 _vehicle_tasks[vehicle_tasks_offset].priority <= _common_tasks[common_tasks_offset].priority)) {
+                _tasks[i] = &_vehicle_tasks[vehicle_tasks_offset++];
+            } else {
+                _tasks[i] = &_common_tasks[common_tasks_offset++];
+            }
+            // the loop rate is fixed once we are initialised
+            _interval_ticks[i] = MIN(task_interval_ticks(*_tasks[i]), uint32_t(UINT16_MAX));
+        }
+    }
+#endif
+
     // setup initial performance counters
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
 
-    if (_options & uint8_t(Options::RECORD_TASK_INFO)) {
-        perf_info.allocate_task_info(_num_tasks);
-    }
+    update_perf_info_options();
 
     _log_performance_bit = log_performance_bit;
 
@@ -181,9 +208,46 @@ static void fill_nanf_stack(void)
  */
 void AP_Scheduler::run(uint32_t time_available)
 {
-    uint32_t run_started_usec = AP_HAL::micros();
-    uint32_t now = run_started_usec;
+    uint32_t now = AP_HAL::micros();
+
+#if AP_SCHEDULER_EDF_ENABLED
+    if ((_options & uint8_t(Options::EARLIEST_DEADLINE_FIRST)) && _tasks != nullptr) {
+        run_edf(now, time_available);
+    } else
+#endif
+    {
+        run_priority(now, time_available);
+    }
+
+    // update number of spare microseconds
+    _spare_micros += time_available;
+
+    _spare_ticks++;
+    if (_spare_ticks == 32) {
+        _spare_ticks /= 2;
+        _spare_micros /= 2;
+    }
+}
+
+/*
+  number of ticks between runs of a task
+ */
+uint32_t AP_Scheduler::task_interval_ticks(const Task &task) const
+{
+    // we allow 0 to mean loop rate
+    uint32_t interval_ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
+    if (interval_ticks < 1) {
+        interval_ticks = 1;
+    }
+    return interval_ticks;
+}
 
+/*
+  walk the task table in priority order, running each task that is
+  due and fits in the time remaining
+ */
+void AP_Scheduler::run_priority(uint32_t &now, uint32_t &time_available)
+{
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
@@ -219,13 +283,11 @@ void AP_Scheduler::run(uint32_t time_available)
             common_tasks_offset++;
         }
 
+        uint16_t dt = 0;
+        uint32_t interval_ticks = 0;
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
-            const uint16_t dt = _tick_counter - _last_run[i];
-            // we allow 0 to mean loop rate
-            uint32_t interval_ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
-            if (interval_ticks < 1) {
-                interval_ticks = 1;
-            }
+            dt = _tick_counter - _last_run[i];
+            interval_ticks = task_interval_ticks(task);
             if (dt < interval_ticks) {
                 // this task is not yet scheduled to run again
                 continue;
@@ -252,58 +314,137 @@ void AP_Scheduler::run(uint32_t time_available)
             _task_time_allowed = get_loop_period_us();
         }
 
-        // run it
-        _task_time_started = now;
-        hal.util->persistent_data.scheduler_task = i;
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        fill_nanf_stack();
-#endif
-        task.function();
-        hal.util->persistent_data.scheduler_task = -1;
-
-        // record the tick counter when we ran. This drives
-        // when we next run the event
-        _last_run[i] = _tick_counter;
-
-        // work out how long the event actually took
-        now = AP_HAL::micros();
-        uint32_t time_taken = now - _task_time_started;
-        bool overrun = false;
-        if (time_taken > _task_time_allowed) {
-            overrun = true;
-            // the event overran!
-            debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
-                  (unsigned)i,
-                  task.name,
-                  (unsigned)time_taken,
-                  (unsigned)_task_time_allowed);
+        run_task(i, task, dt, interval_ticks, now, time_available);
+    }
+}
+
+#if AP_SCHEDULER_EDF_ENABLED
+/*
+  earliest deadline first scheduling. Fast tasks run every loop as
+  usual, then the tasks that are due run in order of deadline, skipping
+  any that don't fit in the time remaining. A task is due
+  interval_ticks after it last ran and its deadline is one interval
+  later, when it would be due again. Ties go to the higher priority
+  task.
+
+  Deadlines don't change within a loop and the time remaining only
+  goes down, so this is the same as repeatedly picking the due task
+  with the earliest deadline that fits
+ */
+void AP_Scheduler::run_edf(uint32_t &now, uint32_t &time_available)
+{
+    // the fast tasks sort to the start of the table
+    uint8_t first_task = 0;
+    for (; first_task<_num_tasks && _tasks[first_task]->priority <= MAX_FAST_TASK_PRIORITIES; first_task++) {
+        _task_time_allowed = get_loop_period_us();
+        run_task(first_task, *_tasks[first_task], 0, 0, now, time_available);
+    }
+
+    // account for tasks running slowly, whether or not they get to
+    // run this loop, and insert the due tasks into the list by
+    // deadline. The table is in priority order, so equal deadlines
+    // stay in priority order
+    uint8_t num_due = 0;
+    for (uint8_t i=first_task; i<_num_tasks; i++) {
+        const uint16_t dt = _tick_counter - _last_run[i];
+        const uint32_t interval_ticks = _interval_ticks[i];
+        if (dt >= interval_ticks*2) {
+            perf_info.task_slipped(i);
+        }
+        if (dt >= interval_ticks*max_task_slowdown) {
+            task_not_achieved++;
+        }
+        if (dt < interval_ticks) {
+            continue;
         }
+        // ticks until the deadline, negative once it has passed
+        const int32_t deadline = int32_t(interval_ticks*2) - int32_t(dt);
+        uint8_t pos = num_due++;
+        for (; pos > 0; pos--) {
+            const uint8_t prev = _due_tasks[pos-1];
+            if (int32_t(_interval_ticks[prev]*2) - int32_t(uint16_t(_tick_counter - _last_run[prev])) <= deadline) {
+                break;
+            }
+            _due_tasks[pos] = prev;
+        }
+        _due_tasks[pos] = i;
+    }
 
-        perf_info.update_task_info(i, time_taken, overrun);
-
-        if (time_taken >= time_available) {
-            /*
-              we are out of time, but we need to keep walking the task
-              table in case there is another fast loop task after this
-              task, plus we need to update the accouting so we can
-              work out if we need to allocate extra time for the loop
-              (lower the loop rate)
-              Just set time_available to zero, which means we will
-              only run fast tasks after this one
-             */
-            time_available = 0;
-        } else {
-            time_available -= time_taken;
+    for (uint8_t d=0; d<num_due; d++) {
+        const uint8_t i = _due_tasks[d];
+        const Task &task = *_tasks[i];
+        if (task.max_time_micros > time_available) {
+            // doesn't fit
+            continue;
         }
+        _task_time_allowed = task.max_time_micros;
+        run_task(i, task, _tick_counter - _last_run[i], _interval_ticks[i], now, time_available);
     }
+}
+#endif // AP_SCHEDULER_EDF_ENABLED
 
-    // update number of spare microseconds
-    _spare_micros += time_available;
+/*
+  run a single task, dt ticks after it last ran. interval_ticks is
+  zero for fast tasks
+ */
+void AP_Scheduler::run_task(uint8_t i, const Task &task, uint16_t dt, uint32_t interval_ticks, uint32_t &now, uint32_t &time_available)
+{
+    // record how late the task is, and how many times it should have
+    // run since it last ran
+    uint16_t missed_deadlines = 0;
+    if (interval_ticks > 0 && dt > interval_ticks) {
+        missed_deadlines = dt / interval_ticks - 1;
+        perf_info.task_late(i, (dt - interval_ticks) * get_loop_period_us(), missed_deadlines);
+    }
 
-    _spare_ticks++;
-    if (_spare_ticks == 32) {
-        _spare_ticks /= 2;
-        _spare_micros /= 2;
+    // run it
+    _task_time_started = now;
+    hal.util->persistent_data.scheduler_task = i;
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf_stack();
+#endif
+    task.function();
+    hal.util->persistent_data.scheduler_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    now = AP_HAL::micros();
+    uint32_t time_taken = now - _task_time_started;
+    bool overrun = false;
+    if (time_taken > _task_time_allowed) {
+        overrun = true;
+        // the event overran!
+        debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
+              (unsigned)i,
+              task.name,
+              (unsigned)time_taken,
+              (unsigned)_task_time_allowed);
+    }
+
+    const uint32_t start_jitter_us = _task_time_started - _loop_sample_time_us;
+    perf_info.update_task_info(i, time_taken, start_jitter_us, overrun);
+#if AP_SCHEDULER_TRACE_ENABLED
+    perf_info.trace_event(i, _task_time_started, start_jitter_us, time_taken,
+                          (overrun ? AP::PerfInfo::TRACE_OVERRUN : 0) |
+                          (missed_deadlines > 0 ? AP::PerfInfo::TRACE_SLIPPED : 0));
+#endif
+
+    if (time_taken >= time_available) {
+        /*
+          we are out of time, but we need to keep walking the task
+          table in case there is another fast loop task after this
+          task, plus we need to update the accouting so we can
+          work out if we need to allocate extra time for the loop
+          (lower the loop rate)
+          Just set time_available to zero, which means we will
+          only run fast tasks after this one
+         */
+        time_available = 0;
+    } else {
+        time_available -= time_taken;
     }
 }
 
@@ -346,7 +487,8 @@ void AP_Scheduler::loop()
     hal.util->persistent_data.scheduler_task = -1;
 
     const uint32_t sample_time_us = AP_HAL::micros();
-    
+    _loop_sample_time_us = sample_time_us;
+
     if (_loop_timer_start_us == 0) {
         _loop_timer_start_us = sample_time_us;
         _last_loop_time_s = get_loop_period_s();
@@ -388,6 +530,12 @@ void AP_Scheduler::loop()
     // run the tasks
     run(time_available);
 
+#if AP_SCHEDULER_TRACE_ENABLED
+    perf_info.trace_event(AP::PerfInfo::TRACE_LOOP, sample_time_us,
+                          sample_time_us - _loop_timer_start_us,
+                          AP_HAL::micros() - sample_time_us, 0);
+#endif
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     // move result of AP_HAL::micros() forward:
     hal.scheduler->delay_microseconds(1);
@@ -415,6 +563,16 @@ void AP_Scheduler::loop()
         
     _loop_timer_start_us = sample_time_us;
 
+#if AP_SCHEDULER_TRACE_ENABLED && HAL_LOGGING_ENABLED
+    // write out a trace captured around a slow loop a few events at
+    // a time, to keep the extra loop time small
+    if (perf_info.trace_frozen() &&
+        _log_performance_bit != (uint32_t)-1 &&
+        AP::logger().should_log(_log_performance_bit)) {
+        perf_info.trace_log(16);
+    }
+#endif
+
 #if AP_SIM_ENABLED && CONFIG_HAL_BOARD != HAL_BOARD_SITL
     hal.simstate->update();
 #endif
@@ -433,11 +591,7 @@ void AP_Scheduler::update_logging()
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
     // dynamically update the per-task perf counter
-    if (!(_options & uint8_t(Options::RECORD_TASK_INFO)) && perf_info.has_task_info()) {
-        perf_info.free_task_info();
-    } else if ((_options & uint8_t(Options::RECORD_TASK_INFO)) && !perf_info.has_task_info()) {
-        perf_info.allocate_task_info(_num_tasks);
-    }
+    update_perf_info_options();
 }
 
 // Write a performance monitoring packet
@@ -465,11 +619,35 @@ void AP_Scheduler::Log_Write_Performance()
 }
 #endif  // HAL_LOGGING_ENABLED
 
+// allocate or free the per-task perf info and trace to match the
+// OPTIONS parameter
+void AP_Scheduler::update_perf_info_options()
+{
+    const bool record_task_info = (_options & uint8_t(Options::RECORD_TASK_INFO)) != 0;
+    if (!record_task_info && perf_info.has_task_info()) {
+        perf_info.free_task_info();
+    } else if (record_task_info && !perf_info.has_task_info()) {
+        perf_info.allocate_task_info(_num_tasks);
+    }
+#if AP_SCHEDULER_TRACE_ENABLED
+    const bool record_trace = (_options & uint8_t(Options::RECORD_TRACE)) != 0;
+    if (!record_trace && perf_info.has_trace()) {
+        perf_info.free_trace();
+    } else if (record_trace && !perf_info.has_trace()) {
+        perf_info.allocate_trace(AP_SCHEDULER_TRACE_SIZE);
+    }
+#endif
+}
+
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
 {
     // a header to allow for machine parsers to determine format
-    str.printf("TasksV2\n");
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    str.printf("TasksV5\n");
+#else
+    str.printf("TasksV4\n");
+#endif
 
     // dynamically enable statistics collection
     if (!(_options & uint8_t(Options::RECORD_TASK_INFO))) {
@@ -531,6 +709,18 @@ void AP_Scheduler::task_info(ExpandingString &str)
     }
 }
 
+#if AP_SCHEDULER_TRACE_ENABLED
+// display the scheduler trace as binary for @SYS/sched_trace.bin
+void AP_Scheduler::trace_info(ExpandingString &str)
+{
+    // dynamically enable the trace
+    if (!(_options & uint8_t(Options::RECORD_TRACE))) {
+        _options.set(_options | uint8_t(Options::RECORD_TRACE));
+    }
+    perf_info.trace_info(str);
+}
+#endif
+
 namespace AP {
 
 AP_Scheduler &scheduler()
@@ -91,7 +91,9 @@ public:
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        RECORD_TRACE = 1 << 1,
+        EARLIEST_DEADLINE_FIRST = 1 << 2,
     };
 
     enum FastTaskPriorities {
@@ -183,6 +185,11 @@ public:
 
     void task_info(ExpandingString &str);
 
+#if AP_SCHEDULER_TRACE_ENABLED
+    // display the scheduler trace as binary for @SYS/sched_trace.bin
+    void trace_info(ExpandingString &str);
+#endif
+
     static const struct AP_Param::GroupInfo var_info[];
 
     // loop performance monitoring:
@@ -226,6 +233,15 @@ private:
     // tick counter at the time we last ran each task
     uint16_t *_last_run;
 
+#if AP_SCHEDULER_EDF_ENABLED
+    // vehicle and common tasks merged in priority order
+    const Task **_tasks;
+    // ticks between runs of each task in _tasks
+    uint16_t *_interval_ticks;
+    // scratch list of the tasks due this loop, by deadline
+    uint8_t *_due_tasks;
+#endif
+
     // number of microseconds allowed for the current task
     uint32_t _task_time_allowed;
 
@@ -241,6 +257,9 @@ private:
     // start of loop timing
     uint32_t _loop_timer_start_us;
 
+    // time of the INS sample that started the current loop
+    uint32_t _loop_sample_time_us;
+
     // time of last loop in seconds
     float _last_loop_time_s;
     
@@ -263,6 +282,17 @@ private:
 
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
+
+    // allocate or free the per-task perf info and trace to match
+    // the OPTIONS parameter
+    void update_perf_info_options();
+
+    uint32_t task_interval_ticks(const Task &task) const;
+    void run_priority(uint32_t &now, uint32_t &time_available);
+#if AP_SCHEDULER_EDF_ENABLED
+    void run_edf(uint32_t &now, uint32_t &time_available);
+#endif
+    void run_task(uint8_t i, const Task &task, uint16_t dt, uint32_t interval_ticks, uint32_t &now, uint32_t &time_available);
 };
 
 namespace AP {
@@ -9,3 +9,24 @@
 #ifndef AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED 1
 #endif
+
+// per-task log scale histograms of run time and start jitter, shown
+// as percentiles in @SYS/tasks.txt
+#ifndef AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+#define AP_SCHEDULER_TASK_HISTOGRAM_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_1000)
+#endif
+
+// ring of scheduler events around slow loops, readable as
+// @SYS/sched_trace.bin and logged as SCHT messages
+#ifndef AP_SCHEDULER_TRACE_ENABLED
+#define AP_SCHEDULER_TRACE_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_1000)
+#endif
+
+#ifndef AP_SCHEDULER_TRACE_SIZE
+#define AP_SCHEDULER_TRACE_SIZE 1024
+#endif
+
+// optional earliest deadline first task selection, see SCHED_OPTIONS
+#ifndef AP_SCHEDULER_EDF_ENABLED
+#define AP_SCHEDULER_EDF_ENABLED (BOARD_FLASH_SIZE > 1024)
+#endif
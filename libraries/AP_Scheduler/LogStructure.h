@@ -0,0 +1,31 @@
+#pragma once
+
+#include <AP_Logger/LogStructure.h>
+#include "AP_Scheduler_config.h"
+
+#define LOG_IDS_FROM_SCHEDULER \
+    LOG_SCHED_TRACE_MSG
+
+// @LoggerMessage: SCHT
+// @Description: Scheduler trace of the tasks run around a slow loop
+// @Field: TimeUS: Time the task started
+// @Field: Task: Task index, in the order of @SYS/tasks.txt, or 255 for the end of a loop
+// @Field: Ofs: For a task, start time relative to the INS sample which started the loop. For the end of a loop, time since the previous loop started
+// @Field: Run: For a task, its run time. For the end of a loop, time from the INS sample to the end of the loop
+// @Field: Flags: Bit 0 task overran, bit 1 task slipped, bit 2 slow loop
+struct PACKED log_SchedTrace {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t task;
+    uint16_t offset_us;
+    uint16_t run_us;
+    uint8_t flags;
+};
+
+#if !AP_SCHEDULER_TRACE_ENABLED
+#define LOG_STRUCTURE_FROM_SCHEDULER
+#else
+#define LOG_STRUCTURE_FROM_SCHEDULER \
+    { LOG_SCHED_TRACE_MSG, sizeof(log_SchedTrace), \
+      "SCHT", "QBHHB", "TimeUS,Task,Ofs,Run,Flags", "s-ss-", "F-FF-" },
+#endif
@@ -22,6 +22,8 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+    missed_deadlines = 0;
+    max_lateness_us = 0;
     if (_task_info != nullptr) {
         memset(_task_info, 0, (_num_tasks) * sizeof(TaskInfo));
     }
@@ -53,7 +55,7 @@ void AP::PerfInfo::free_task_info()
 }
 
 // called after each run of a task to update its statistics based on measurements taken by the scheduler
-void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun)
+void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, uint32_t start_jitter_us, bool overrun)
 {
     if (_task_info == nullptr) {
         return;
@@ -64,10 +66,23 @@ void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, b
         return;
     }
     TaskInfo& ti = _task_info[task_index];
-    ti.update(task_time_us, overrun);
+    ti.update(task_time_us, start_jitter_us, overrun);
 }
 
-void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
+// record that a task ran late_us after it was due, having missed the
+// given number of deadlines
+void AP::PerfInfo::task_late(uint8_t task_index, uint32_t late_us, uint16_t num_missed)
+{
+    missed_deadlines += num_missed;
+    max_lateness_us = MAX(max_lateness_us, late_us);
+    if (_task_info && task_index < _num_tasks) {
+        TaskInfo& ti = _task_info[task_index];
+        ti.missed_deadlines += num_missed;
+        ti.max_lateness_us = MAX(ti.max_lateness_us, late_us);
+    }
+}
+
+void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, uint32_t start_jitter_us, bool overrun)
 {
     max_time_us = MAX(max_time_us, task_time_us);
     if (min_time_us == 0) {
@@ -80,6 +95,10 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     if (overrun) {
         overrun_count++;
     }
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    run_time.add(task_time_us);
+    start_jitter.add(start_jitter_us);
+#endif
 }
 
 void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
@@ -91,14 +110,79 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
         avg = MIN(uint16_t(elapsed_time_us / tick_count), 9999);
     }
 #if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
-    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%";
 #else
-    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%";
 #endif
     str.printf(fmt, task_name,
                 unsigned(MIN(min_time_us, 9999)), unsigned(MIN(max_time_us, 9999)), unsigned(avg),
                 unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
+    str.printf(" LATE=%6u MISS=%5u",
+               unsigned(MIN(max_lateness_us, 999999U)),
+               unsigned(MIN(missed_deadlines, 99999U)));
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    str.printf(" P50=%4u P99=%4u P999=%4u J50=%4u J99=%4u J999=%4u",
+               unsigned(MIN(run_time.percentile_us(500), 9999U)),
+               unsigned(MIN(run_time.percentile_us(990), 9999U)),
+               unsigned(MIN(run_time.percentile_us(999), 9999U)),
+               unsigned(MIN(start_jitter.percentile_us(500), 9999U)),
+               unsigned(MIN(start_jitter.percentile_us(990), 9999U)),
+               unsigned(MIN(start_jitter.percentile_us(999), 9999U)));
+#endif
+    str.printf("\n");
+}
+
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+uint8_t AP::PerfInfo::TimeHistogram::bucket(uint32_t time_us)
+{
+    if (time_us < 8) {
+        return time_us;
+    }
+    // four buckets for each power of two, split on the next two bits
+    const uint8_t msb = 31 - __builtin_clz(time_us);
+    const uint32_t b = 4*msb - 4 + ((time_us >> (msb-2)) & 3U);
+    return MIN(b, num_buckets-1U);
+}
+
+uint32_t AP::PerfInfo::TimeHistogram::bucket_max_us(uint8_t b)
+{
+    if (b < 8) {
+        return b;
+    }
+    const uint8_t msb = (b+4) / 4;
+    const uint8_t sub = (b+4) % 4;
+    return (1U<<msb) + (sub+1) * (1U<<(msb-2)) - 1;
+}
+
+void AP::PerfInfo::TimeHistogram::add(uint32_t time_us)
+{
+    uint16_t &c = count[bucket(time_us)];
+    if (c < UINT16_MAX) {
+        c++;
+    }
+}
+
+uint32_t AP::PerfInfo::TimeHistogram::percentile_us(uint16_t per_mille) const
+{
+    uint32_t total = 0;
+    for (const auto c : count) {
+        total += c;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // number of samples at or below the percentile, rounded up
+    const uint32_t target = (total * per_mille + 999) / 1000;
+    uint32_t sum = 0;
+    for (uint8_t b=0; b<num_buckets; b++) {
+        sum += count[b];
+        if (sum >= target) {
+            return bucket_max_us(b);
+        }
+    }
+    return bucket_max_us(num_buckets-1);
 }
+#endif // AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
 
 // check_loop_time - check latest loop time vs min, max and overtime threshold
 void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
@@ -119,6 +203,9 @@ void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
     }
     if (time_in_micros > overtime_threshold_micros) {
         long_running++;
+#if AP_SCHEDULER_TRACE_ENABLED
+        trace_trigger();
+#endif
     }
     sigma_time += time_in_micros;
     sigmasquared_time += time_in_micros * time_in_micros;
@@ -205,6 +292,11 @@ void AP::PerfInfo::update_logging() const
                     (unsigned)(0.5+get_filtered_loop_rate_hz()),
                     (unsigned long)get_stddev_time(),
                     (unsigned long)AP::scheduler().get_extra_loop_us());
+    if (get_num_missed_deadlines() > 0) {
+        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "PERF: missed deadlines %lu, max late %luus",
+                      (unsigned long)get_num_missed_deadlines(),
+                      (unsigned long)get_max_lateness_us());
+    }
 }
 
 void AP::PerfInfo::set_loop_rate(uint16_t rate_hz)
@@ -217,3 +309,122 @@ void AP::PerfInfo::set_loop_rate(uint16_t rate_hz)
         filtered_loop_time = 1.0f / rate_hz;
     }
 }
+
+#if AP_SCHEDULER_TRACE_ENABLED
+// allocate the ring of scheduler events
+void AP::PerfInfo::allocate_trace(uint16_t num_events)
+{
+    _trace = new TraceEvent[num_events];
+    if (_trace == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler trace\n");
+        _trace_size = 0;
+        return;
+    }
+    _trace_size = num_events;
+    trace_restart();
+}
+
+void AP::PerfInfo::free_trace()
+{
+    delete[] _trace;
+    _trace = nullptr;
+    _trace_size = 0;
+    trace_restart();
+}
+
+// empty the ring and start recording again
+void AP::PerfInfo::trace_restart()
+{
+    _trace_head = 0;
+    _trace_count = 0;
+    _trace_log_pos = 0;
+    _trace_triggered = false;
+    _trace_frozen = false;
+    _trace_restart_requested = false;
+}
+
+void AP::PerfInfo::trace_event(uint8_t task, uint32_t start_us, uint32_t offset_us, uint32_t run_us, uint8_t flags)
+{
+    if (_trace_restart_requested) {
+        trace_restart();
+    }
+    if (_trace == nullptr || _trace_frozen) {
+        return;
+    }
+    if (task == TRACE_LOOP && offset_us > overtime_threshold_micros) {
+        flags |= TRACE_SLOW_LOOP;
+    }
+    TraceEvent &ev = _trace[_trace_head];
+    ev.start_us = start_us;
+    ev.offset_us = MIN(offset_us, uint32_t(UINT16_MAX));
+    ev.run_us = MIN(run_us, uint32_t(UINT16_MAX));
+    ev.task = task;
+    ev.flags = flags;
+    _trace_head = (_trace_head + 1) % _trace_size;
+    if (_trace_count < _trace_size) {
+        _trace_count++;
+    }
+    if (_trace_triggered && --_trace_after_trigger == 0) {
+        _trace_frozen = true;
+    }
+}
+
+void AP::PerfInfo::trace_trigger()
+{
+    if (_trace == nullptr || _trace_triggered) {
+        return;
+    }
+    _trace_triggered = true;
+    _trace_after_trigger = MAX(_trace_size/2, 1);
+}
+
+#if HAL_LOGGING_ENABLED
+void AP::PerfInfo::trace_log(uint16_t max_events)
+{
+    if (!_trace_frozen) {
+        return;
+    }
+    const uint32_t now_us = AP_HAL::micros();
+    const uint64_t now_us64 = AP_HAL::micros64();
+    for (; max_events > 0 && _trace_log_pos < _trace_count; max_events--) {
+        const TraceEvent &ev = trace_get(_trace_log_pos++);
+        const struct log_SchedTrace pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_SCHED_TRACE_MSG),
+            time_us   : now_us64 - (now_us - ev.start_us),
+            task      : ev.task,
+            offset_us : ev.offset_us,
+            run_us    : ev.run_us,
+            flags     : ev.flags,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+    if (_trace_log_pos >= _trace_count) {
+        trace_restart();
+    }
+}
+#endif // HAL_LOGGING_ENABLED
+
+// binary copy of the ring for @SYS/sched_trace.bin
+void AP::PerfInfo::trace_info(ExpandingString &str)
+{
+    const struct TraceHeader hdr = {
+        magic : trace_magic,
+        version : 1,
+        event_size : sizeof(TraceEvent),
+        num_events : _trace_count,
+        now_us : AP_HAL::micros(),
+        loop_rate_hz : loop_rate_hz,
+        frozen : _trace_frozen,
+        pad : 0,
+    };
+    str.append((const char *)&hdr, sizeof(hdr));
+    for (uint16_t i=0; i<_trace_count; i++) {
+        str.append((const char *)&trace_get(i), sizeof(TraceEvent));
+    }
+    if (_trace_frozen) {
+        // this runs on the thread reading the file, so leave the
+        // restart to the main thread
+        _trace_restart_requested = true;
+    }
+}
+#endif // AP_SCHEDULER_TRACE_ENABLED
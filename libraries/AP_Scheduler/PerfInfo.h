@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <AP_Common/AP_Common.h>
 #include <AP_Common/ExpandingString.h>
+#include "AP_Scheduler_config.h"
 
 namespace AP {
 
@@ -9,6 +11,27 @@ class PerfInfo {
 public:
     PerfInfo() {}
 
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    /*
+      log scale histogram of times in microseconds, with four buckets
+      per power of two so percentiles are within 25%. Times up to 7us
+      have a bucket each, and the last bucket holds everything from
+      57344us up
+     */
+    struct TimeHistogram {
+        static const uint8_t num_buckets = 60;
+        uint16_t count[num_buckets];
+
+        void add(uint32_t time_us);
+        // upper limit of the bucket holding the given percentile,
+        // specified in tenths of a percent
+        uint32_t percentile_us(uint16_t per_mille) const;
+
+        static uint8_t bucket(uint32_t time_us);
+        static uint32_t bucket_max_us(uint8_t b);
+    };
+#endif
+
     // per-task timing information
     struct TaskInfo {
         uint16_t min_time_us;
@@ -17,8 +40,18 @@ public:
         uint32_t tick_count;
         uint16_t slip_count;
         uint16_t overrun_count;
+        // longest time the task started after it was due, and the
+        // number of times it should have run but didn't
+        uint32_t max_lateness_us;
+        uint32_t missed_deadlines;
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+        TimeHistogram run_time;
+        // time from the INS sample that started the loop to the
+        // start of the task
+        TimeHistogram start_jitter;
+#endif
 
-        void update(uint16_t task_time_us, bool overrun);
+        void update(uint16_t task_time_us, uint32_t start_jitter_us, bool overrun);
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
     };
 
@@ -33,6 +66,8 @@ public:
     uint32_t get_min_time() const;
     uint16_t get_num_long_running() const;
     uint32_t get_avg_time() const;
+    uint32_t get_num_missed_deadlines() const { return missed_deadlines; }
+    uint32_t get_max_lateness_us() const { return max_lateness_us; }
     uint32_t get_stddev_time() const;
     float    get_filtered_time() const;
     float get_filtered_loop_rate_hz() const;
@@ -50,7 +85,7 @@ public:
         return (_task_info && task_index < _num_tasks) ? &_task_info[task_index] : nullptr;
     }
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
-    void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+    void update_task_info(uint8_t task_index, uint16_t task_time_us, uint32_t start_jitter_us, bool overrun);
     // record that a task slipped
     void task_slipped(uint8_t task_index) {
         if (_task_info && task_index < _num_tasks) {
@@ -58,6 +93,69 @@ public:
         }
     }
 
+    // record that a task ran late_us after it was due, having missed
+    // the given number of deadlines
+    void task_late(uint8_t task_index, uint32_t late_us, uint16_t num_missed);
+
+#if AP_SCHEDULER_TRACE_ENABLED
+    // task number used in the trace for the end of a loop
+    static const uint8_t TRACE_LOOP = 255;
+
+    enum TraceFlags : uint8_t {
+        TRACE_OVERRUN = 1U<<0,
+        TRACE_SLIPPED = 1U<<1,
+        TRACE_SLOW_LOOP = 1U<<2,
+    };
+
+    /*
+      one scheduler event in the trace ring. For the end of a loop
+      offset_us is the time since the previous loop started and run_us
+      is the time from the INS sample to the end of the loop
+     */
+    struct PACKED TraceEvent {
+        uint32_t start_us;
+        uint16_t offset_us;
+        uint16_t run_us;
+        uint8_t task;
+        uint8_t flags;
+    };
+
+    // header of @SYS/sched_trace.bin, followed by num_events
+    // TraceEvents, oldest first
+    struct PACKED TraceHeader {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t event_size;
+        uint16_t num_events;
+        uint32_t now_us;
+        uint16_t loop_rate_hz;
+        uint8_t frozen;
+        uint8_t pad;
+    };
+    static const uint32_t trace_magic = 0x54524353; // "SCRT"
+
+    // allocate the ring of scheduler events
+    void allocate_trace(uint16_t num_events);
+    void free_trace();
+    bool has_trace() const { return _trace != nullptr; }
+
+    // record a scheduler event
+    void trace_event(uint8_t task, uint32_t start_us, uint32_t offset_us, uint32_t run_us, uint8_t flags);
+
+    // a slow loop has happened. The ring is frozen once it holds as
+    // many events after the slow loop as before it
+    void trace_trigger();
+    bool trace_frozen() const { return _trace_frozen; }
+
+    // write the next max_events of a frozen trace as SCHT log
+    // messages, restarting the trace once it has all been written
+    void trace_log(uint16_t max_events);
+
+    // binary copy of the ring for @SYS/sched_trace.bin. Reading a
+    // frozen trace restarts it
+    void trace_info(ExpandingString &str);
+#endif
+
 private:
     uint16_t loop_rate_hz;
     uint16_t overtime_threshold_micros;
@@ -68,11 +166,34 @@ private:
     uint64_t sigmasquared_time;
     uint16_t long_running;
     uint32_t last_check_us;
+    uint32_t missed_deadlines;
+    uint32_t max_lateness_us;
     float filtered_loop_time;
     bool ignore_loop;
     // performance monitoring
     uint8_t _num_tasks;
     TaskInfo* _task_info;
+
+#if AP_SCHEDULER_TRACE_ENABLED
+    // trace ring, with _trace_count events ending before _trace_head
+    TraceEvent* _trace;
+    uint16_t _trace_size;
+    uint16_t _trace_head;
+    uint16_t _trace_count;
+    // events still to record after a slow loop before freezing
+    uint16_t _trace_after_trigger;
+    // next event of a frozen trace to log
+    uint16_t _trace_log_pos;
+    bool _trace_triggered;
+    bool _trace_frozen;
+    // set when a frozen trace has been read through @SYS
+    bool _trace_restart_requested;
+
+    const TraceEvent &trace_get(uint16_t i) const {
+        return _trace[(_trace_head + _trace_size - _trace_count + i) % _trace_size];
+    }
+    void trace_restart();
+#endif
 };
 
 };
@@ -0,0 +1,260 @@
+//
+// CPU load benchmark comparing the priority scheduler with earliest
+// deadline first scheduling (SCHED_OPTIONS bit 2)
+//
+// A synthetic task table is run at increasing CPU load. For each
+// load and scheduling mode we report how often each task achieved
+// its rate, the longest gap between runs and the deadlines missed
+//
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_ExternalAHRS/AP_ExternalAHRS.h>
+#include <AP_Scheduler/AP_Scheduler.h>
+#include <AP_BoardConfig/AP_BoardConfig.h>
+#include <AP_Logger/AP_Logger.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+AP_Int32 log_bitmask;
+AP_Logger AP_Logger{log_bitmask};
+
+#if AP_SCHEDULER_EDF_ENABLED
+
+// number of synthetic tasks
+#define NUM_WORK_TASKS 10
+
+// time each load and mode is run for
+static const uint32_t phase_time_ms = 10000;
+
+// CPU load of the synthetic tasks, as a multiple of their base cost
+static const uint8_t load_factors[] = { 1, 4, 6, 8 };
+
+class SchedBench {
+public:
+    void setup();
+    void loop();
+
+    static const AP_Param::Info var_info[];
+
+private:
+    AP_InertialSensor ins;
+#if HAL_EXTERNAL_AHRS_ENABLED
+    AP_ExternalAHRS eAHRS;
+#endif // HAL_EXTERNAL_AHRS_ENABLED
+    AP_Scheduler scheduler;
+
+    static const AP_Scheduler::Task scheduler_tasks[];
+
+    // rate and base cost of each synthetic task
+    struct WorkTask {
+        float rate_hz;
+        uint16_t cost_us;
+    };
+    static const WorkTask work_tasks[NUM_WORK_TASKS];
+
+    struct WorkStats {
+        uint32_t runs;
+        uint32_t last_run_us;
+        uint32_t max_gap_us;
+    } stats[NUM_WORK_TASKS];
+
+    uint8_t load_factor = 1;
+    uint8_t phase;
+    uint32_t phase_start_ms;
+    uint32_t phase_loops;
+
+    void ins_update(void);
+    template <uint8_t N> void work(void);
+
+    void start_phase(void);
+    void end_phase(void);
+};
+
+static AP_BoardConfig board_config;
+static SchedBench schedbench;
+
+class Parameters {
+public:
+    enum {
+        k_param_scheduler = 1,
+    };
+};
+
+const AP_Param::Info SchedBench::var_info[] = {
+    { "SCHED_", (const void *)&schedbench.scheduler, {group_info : AP_Scheduler::var_info}, 0, Parameters::k_param_scheduler, AP_PARAM_GROUP },
+    AP_VAREND
+};
+
+static AP_Param param{SchedBench::var_info};
+
+#define SCHED_TASK(func, _interval_ticks, _max_time_micros, _priority) SCHED_TASK_CLASS(SchedBench, &schedbench, func, _interval_ticks, _max_time_micros, _priority)
+
+/*
+  the work tasks declare a maximum time of twice their base cost, so
+  at high load they overrun as well as being skipped for lack of time
+ */
+const SchedBench::WorkTask SchedBench::work_tasks[NUM_WORK_TASKS] = {
+    { 400, 100 },
+    { 200, 150 },
+    { 100, 200 },
+    {  50, 300 },
+    {  50, 400 },
+    {  20, 500 },
+    {  10, 800 },
+    {   5, 1000 },
+    {   1, 1000 },
+    {   1, 1200 },
+};
+
+const AP_Scheduler::Task SchedBench::scheduler_tasks[] = {
+    FAST_TASK_CLASS(SchedBench, &schedbench, ins_update),
+    SCHED_TASK(work<0>,  400,   200,  6),
+    SCHED_TASK(work<1>,  200,   300,  9),
+    SCHED_TASK(work<2>,  100,   400, 12),
+    SCHED_TASK(work<3>,   50,   600, 15),
+    SCHED_TASK(work<4>,   50,   800, 18),
+    SCHED_TASK(work<5>,   20,  1000, 21),
+    SCHED_TASK(work<6>,   10,  1600, 24),
+    SCHED_TASK(work<7>,    5,  2000, 27),
+    SCHED_TASK(work<8>,    1,  2000, 30),
+    SCHED_TASK(work<9>,    1,  2400, 33),
+};
+
+void SchedBench::setup(void)
+{
+    hal.console->printf("Scheduler CPU load benchmark\n");
+
+    AP_Param::setup();
+
+    // the task rates assume a 400Hz loop
+    if (!AP_Param::set_by_name("SCHED_LOOP_RATE", 400)) {
+        hal.console->printf("Failed to set SCHED_LOOP_RATE\n");
+    }
+
+    board_config.init();
+
+    ins.init(scheduler.get_loop_rate_hz());
+
+    // initialise the scheduler
+    scheduler.init(&scheduler_tasks[0], ARRAY_SIZE(scheduler_tasks), (uint32_t)-1);
+
+    start_phase();
+}
+
+void SchedBench::loop(void)
+{
+    // run all tasks
+    scheduler.loop();
+    phase_loops++;
+
+    if (AP_HAL::millis() - phase_start_ms >= phase_time_ms) {
+        end_phase();
+        phase++;
+        if (phase >= 2*ARRAY_SIZE(load_factors)) {
+            hal.console->printf("Benchmark complete\n");
+            phase = 0;
+        }
+        start_phase();
+    }
+}
+
+/*
+  even phases use the priority scheduler and odd phases earliest
+  deadline first, at the same load
+ */
+void SchedBench::start_phase(void)
+{
+    load_factor = load_factors[phase/2];
+    const bool edf = (phase % 2) != 0;
+    if (!AP_Param::set_by_name("SCHED_OPTIONS", edf ? uint8_t(AP_Scheduler::Options::EARLIEST_DEADLINE_FIRST) : 0)) {
+        hal.console->printf("Failed to set SCHED_OPTIONS\n");
+    }
+    memset(stats, 0, sizeof(stats));
+    scheduler.perf_info.reset();
+    phase_loops = 0;
+    phase_start_ms = AP_HAL::millis();
+}
+
+void SchedBench::end_phase(void)
+{
+    const float elapsed_s = (AP_HAL::millis() - phase_start_ms) * 0.001f;
+    uint32_t load_us = 0;
+    for (uint8_t i=0; i<NUM_WORK_TASKS; i++) {
+        load_us += work_tasks[i].rate_hz * work_tasks[i].cost_us * load_factor;
+    }
+    hal.console->printf("%s load=%u%% loop_rate=%.1fHz extra=%uus missed=%u max_late=%uus\n",
+                        (phase % 2) ? "EDF" : "PRI",
+                        unsigned(load_us / 10000),
+                        phase_loops / elapsed_s,
+                        unsigned(scheduler.get_extra_loop_us()),
+                        unsigned(scheduler.perf_info.get_num_missed_deadlines()),
+                        unsigned(scheduler.perf_info.get_max_lateness_us()));
+    for (uint8_t i=0; i<NUM_WORK_TASKS; i++) {
+        const WorkTask &w = work_tasks[i];
+        const float expected = w.rate_hz * elapsed_s;
+        hal.console->printf("  task%u %5.1fHz cost=%4uus achieved=%5.1f%% max_gap=%6.1fms\n",
+                            unsigned(i), w.rate_hz, unsigned(w.cost_us * load_factor),
+                            100 * stats[i].runs / expected,
+                            stats[i].max_gap_us * 0.001f);
+    }
+}
+
+void SchedBench::ins_update(void)
+{
+    ins.update();
+}
+
+/*
+  busy wait for the task's cost at the current load
+ */
+template <uint8_t N>
+void SchedBench::work(void)
+{
+    const uint32_t start_us = AP_HAL::micros();
+    WorkStats &st = stats[N];
+    if (st.runs > 0) {
+        st.max_gap_us = MAX(st.max_gap_us, start_us - st.last_run_us);
+    }
+    st.runs++;
+    st.last_run_us = start_us;
+    const uint32_t cost_us = work_tasks[N].cost_us * load_factor;
+    while (AP_HAL::micros() - start_us < cost_us) {
+    }
+}
+
+void setup(void);
+void loop(void);
+
+void setup(void)
+{
+    schedbench.setup();
+}
+void loop(void)
+{
+    schedbench.loop();
+}
+
+#else
+
+void setup(void);
+void loop(void);
+
+void setup(void)
+{
+    hal.console->printf("Earliest deadline first scheduling not available on this board\n");
+}
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // AP_SCHEDULER_EDF_ENABLED
+
+AP_HAL_MAIN();
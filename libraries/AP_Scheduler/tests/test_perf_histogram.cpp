@@ -0,0 +1,68 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Scheduler/PerfInfo.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+
+using Histogram = AP::PerfInfo::TimeHistogram;
+
+TEST(PerfInfoHistogram, buckets)
+{
+    // every time falls within the limits of its bucket
+    for (uint32_t t=0; t<70000; t++) {
+        const uint8_t b = Histogram::bucket(t);
+        ASSERT_LT(b, Histogram::num_buckets);
+        if (b < Histogram::num_buckets-1) {
+            EXPECT_LE(t, Histogram::bucket_max_us(b));
+        }
+        if (b > 0) {
+            EXPECT_GT(t, Histogram::bucket_max_us(b-1));
+        }
+    }
+    EXPECT_EQ(Histogram::bucket(7), 7);
+    EXPECT_EQ(Histogram::bucket_max_us(8), 9U);
+    EXPECT_EQ(Histogram::bucket_max_us(11), 15U);
+    EXPECT_EQ(Histogram::bucket(57343), Histogram::num_buckets-2);
+    EXPECT_EQ(Histogram::bucket(57344), Histogram::num_buckets-1);
+    EXPECT_EQ(Histogram::bucket(UINT32_MAX), Histogram::num_buckets-1);
+}
+
+TEST(PerfInfoHistogram, percentiles)
+{
+    Histogram h {};
+    EXPECT_EQ(h.percentile_us(500), 0U);
+
+    // 990 fast runs, 9 slower and one very slow
+    for (uint16_t i=0; i<990; i++) {
+        h.add(100);
+    }
+    for (uint16_t i=0; i<9; i++) {
+        h.add(1000);
+    }
+    h.add(10000);
+
+    EXPECT_EQ(h.percentile_us(500), Histogram::bucket_max_us(Histogram::bucket(100)));
+    EXPECT_EQ(h.percentile_us(990), Histogram::bucket_max_us(Histogram::bucket(100)));
+    EXPECT_EQ(h.percentile_us(999), Histogram::bucket_max_us(Histogram::bucket(1000)));
+    EXPECT_EQ(h.percentile_us(1000), Histogram::bucket_max_us(Histogram::bucket(10000)));
+
+    // the reported percentile is within 25% above the true value
+    EXPECT_GE(h.percentile_us(500), 100U);
+    EXPECT_LE(h.percentile_us(500), 125U);
+}
+
+TEST(PerfInfoHistogram, saturation)
+{
+    Histogram h {};
+    for (uint32_t i=0; i<100000; i++) {
+        h.add(50);
+    }
+    EXPECT_EQ(h.count[Histogram::bucket(50)], UINT16_MAX);
+}
+
+#endif // AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+
+AP_GTEST_MAIN()
@@ -57,8 +57,8 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Terrain options
-    // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download
+    // @Description: Options to change behaviour of terrain system. Memory mapped files are only available on Linux boards and SITL, and load terrain data through the operating system page cache rather than reading one grid block at a time.
+    // @Bitmask: 0:Disable Download,1:Disable Prefetch,2:Memory mapped files
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -77,6 +77,13 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Range: 0 50
     // @User: Advanced
     AP_GROUPINFO("OFS_MAX",  4, AP_Terrain, offset_max, 30),
+
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: The number of terrain grid blocks kept in memory. Each block takes about 2k of memory and covers 28x32 grid points. A larger cache reduces how often blocks are reloaded from the SD card on long missions. When the cache is larger than the default of 12 blocks, blocks ahead of the vehicle on the current mission leg and along the current ground track are loaded before they are needed. The cache is resized when there are no pending disk writes.
+    // @Range: 1 1024
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
     
     AP_GROUPEND
 };
@@ -357,6 +364,7 @@ void AP_Terrain::update(void)
 {
     if (!enable) { return; }
     // just schedule any needed disk IO
+    update_cache_size();
     schedule_disk_io();
 
     const AP_AHRS &ahrs = AP::ahrs();
@@ -385,6 +393,7 @@ void AP_Terrain::update(void)
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
+        update_prefetch(loc);
     } else {
         have_surrounding_tiles = false;
     }
@@ -488,16 +497,78 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
-    if (cache == nullptr) {
-        GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
-        memory_alloc_failed = true;
+    const uint16_t size = constrain_int16(config_cache_size, 1, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+    if (allocate_cache(size)) {
+        return true;
+    }
+    // fall back to the default size if a larger cache doesn't fit
+    if (size > TERRAIN_GRID_BLOCK_CACHE_SIZE &&
+        allocate_cache(TERRAIN_GRID_BLOCK_CACHE_SIZE)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Terrain: cache of %u failed", (unsigned)size);
+        failed_cache_size = size;
+        return true;
+    }
+    GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
+    memory_alloc_failed = true;
+    return false;
+}
+
+/*
+  allocate a cache of the given size and its hash table, replacing
+  any existing cache. The existing cache is kept if allocation fails
+ */
+bool AP_Terrain::allocate_cache(uint16_t size)
+{
+    uint16_t num_buckets = 1;
+    while (num_buckets < size) {
+        num_buckets <<= 1;
+    }
+    struct grid_cache *new_cache = (struct grid_cache *)calloc(size, sizeof(new_cache[0]));
+    uint16_t *new_hash = (uint16_t *)calloc(num_buckets, sizeof(new_hash[0]));
+    if (new_cache == nullptr || new_hash == nullptr) {
+        free(new_cache);
+        free(new_hash);
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    free(cache);
+    free(cache_hash);
+    cache = new_cache;
+    cache_hash = new_hash;
+    hash_mask = num_buckets - 1;
+    cache_size = size;
     return true;
 }
 
+/*
+  resize the cache when TERRAIN_CACHE_SZ changes. Blocks held in the
+  old cache are reloaded from disk as needed, so this waits until no
+  disk IO is in progress and no blocks are waiting to be written
+ */
+void AP_Terrain::update_cache_size(void)
+{
+    if (cache == nullptr) {
+        return;
+    }
+    const uint16_t size = constrain_int16(config_cache_size, 1, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+    if (size == cache_size || size == failed_cache_size) {
+        return;
+    }
+    if (disk_io_state != DiskIoIdle) {
+        return;
+    }
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].state == GRID_CACHE_DIRTY) {
+            return;
+        }
+    }
+    if (!allocate_cache(size)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Terrain: cache of %u failed", (unsigned)size);
+        failed_cache_size = size;
+        return;
+    }
+    failed_cache_size = 0;
+}
+
 /*
   setup a reference location for terrain adjustment. This should
   be called when the vehicle is definately on the ground
@@ -31,6 +31,14 @@
 
 #define TERRAIN_DEBUG 0
 
+// memory mapped terrain files, selected with TERRAIN_OPTIONS
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// number of degree files kept mapped
+#define TERRAIN_MMAP_MAX_FILES 4
+
 
 // MAVLink sends 4x4 grids
 #define TERRAIN_GRID_MAVLINK_SIZE 4
@@ -50,9 +58,16 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+// largest cache allowed by TERRAIN_CACHE_SZ. Each block uses about 2k
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX 1024
+
+// how far ahead of the vehicle to prefetch grid blocks, in seconds at
+// the current ground speed
+#define TERRAIN_PREFETCH_TIME_S 60
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -185,6 +200,24 @@ public:
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded) const;
 
+    /*
+      statistics on the grid cache
+     */
+    struct CacheStatistics {
+        uint16_t cache_size;    // number of grid blocks in the cache
+        uint32_t hits;          // lookups of blocks holding data
+        uint32_t misses;        // lookups of blocks not yet loaded
+        uint32_t evictions;     // blocks dropped to make room for another
+        uint32_t prefetches;    // blocks queued by the prefetcher
+        uint32_t prefetch_hits; // prefetched blocks later looked up
+        uint32_t disk_reads;    // completed disk reads
+        uint32_t read_us_avg;   // time taken by a disk read
+        uint32_t read_us_max;
+        uint32_t load_ms_avg;   // time from a block being queued to loaded from disk
+        uint32_t load_ms_max;
+    };
+    void get_statistics(CacheStatistics &stats) const;
+
     /*
       get grid spacing in meters
      */
@@ -204,6 +237,7 @@ public:
 private:
     // allocate the terrain subsystem data
     bool allocate(void);
+    bool allocate_cache(uint16_t size);
 
     /*
       a grid block is a structure in a local file containing height
@@ -265,6 +299,17 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // time the block was queued for a disk read
+        uint32_t load_start_ms;
+
+        // next block in the same hash bucket as cache index+1, or
+        // zero at the end of the chain
+        uint16_t hash_next;
+        uint16_t hash_bucket;
+
+        // queued by the prefetcher and not looked up since
+        bool prefetched;
     };
 
     /*
@@ -300,9 +345,16 @@ private:
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
     /*
-      find a grid structure given a grid_info
+      find a grid structure given a grid_info. Prefetch lookups are
+      not counted in the cache statistics
     */
-    struct grid_cache &find_grid_cache(const struct grid_info &info);
+    struct grid_cache &find_grid_cache(const struct grid_info &info, bool prefetch=false);
+
+    /*
+      hash table over the grid cache
+     */
+    uint16_t grid_hash(int8_t lat_degrees, int16_t lon_degrees, uint16_t grid_idx_x, uint16_t grid_idx_y) const;
+    void cache_unlink(uint16_t idx);
 
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
@@ -340,12 +392,45 @@ private:
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
+    bool set_file_path(const struct grid_block &block);
     void open_file(void);
     void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t east_blocks(const struct grid_block &block) const;
+    uint32_t block_offset(const struct grid_block &block) const;
+    bool check_disk_block(struct grid_block &block, int32_t lat, int32_t lon);
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped disk IO. Each degree file is mapped at the size
+      needed to hold every block at the current grid spacing, so
+      blocks are found by pointer rather than seek and read
+     */
+    struct mapped_file {
+        uint8_t *data;
+        uint32_t size;
+        uint32_t last_use_ms;
+        uint16_t spacing;
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+        // written through the mapping since the last msync
+        bool dirty;
+    };
+    bool use_mmap(void) const;
+    uint32_t north_blocks(const struct grid_block &block) const;
+    struct mapped_file *mmap_find(const struct grid_block &block);
+    struct mapped_file *mmap_open(const struct grid_block &block);
+    bool mmap_read(struct grid_block &block);
+    bool mmap_write(const struct grid_block &block);
+    bool mmap_resident(const struct grid_block &block);
+    bool mmap_load(struct grid_cache &gcache);
+    void mmap_update(void);
+    void mmap_read_block(void);
+    void mmap_write_block(void);
+    void mmap_sync(void);
+#endif
+
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
 
@@ -359,6 +444,15 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      queue disk reads of blocks ahead of the vehicle
+     */
+    void update_prefetch(const Location &loc);
+    void prefetch_line(const Location &loc, const Vector2f &ofs_ne, uint16_t &budget);
+
+    // change the cache size to match TERRAIN_CACHE_SZ
+    void update_cache_size(void);
+
     /*
       calculate reference offset if needed
      */
@@ -371,15 +465,35 @@ private:
     AP_Int16 grid_spacing; // meters between grid points
     AP_Int16 options; // option bits
     AP_Float offset_max;
+    AP_Int16 config_cache_size;
 
     enum class Options {
         DisableDownload = (1U<<0),
+        DisablePrefetch = (1U<<1),
+        UseMmap         = (1U<<2),
     };
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash buckets over the cache, each holding the cache index+1 of
+    // the first block in the bucket
+    uint16_t *cache_hash = nullptr;
+    uint16_t hash_mask;
+
+    // TERRAIN_CACHE_SZ that we failed to allocate
+    uint16_t failed_cache_size;
+
+    // cache statistics, with the totals for the averages
+    struct CacheStatistics cache_stats;
+    uint64_t read_us_total;
+    uint64_t load_ms_total;
+    uint32_t loads;
+
+    // last time the prefetcher ran
+    uint32_t last_prefetch_ms;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -391,6 +505,9 @@ private:
     volatile enum DiskIoState disk_io_state;
     union grid_io_block disk_block;
 
+    // time taken by the last disk read, set by the IO thread
+    uint32_t disk_read_us;
+
     // last time we asked for more grids
     uint32_t last_request_time_ms[MAVLINK_COMM_NUM_BUFFERS];
 
@@ -399,6 +516,13 @@ private:
     // open file handle on degree file
     int fd;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    // mapped degree files. These are created and removed by the IO
+    // thread, and used by the main thread when it owns disk_block
+    struct mapped_file mapped_files[TERRAIN_MMAP_MAX_FILES];
+    uint32_t last_msync_ms;
+#endif
+
     // has the timer been setup?
     bool timer_setup;
 
@@ -196,6 +196,17 @@ void AP_Terrain::get_statistics(uint16_t &pending, uint16_t &loaded) const
     }
 }
 
+/*
+  get statistics on the grid cache
+*/
+void AP_Terrain::get_statistics(CacheStatistics &stats) const
+{
+    stats = cache_stats;
+    stats.cache_size = cache_size;
+    stats.read_us_avg = cache_stats.disk_reads ? read_us_total / cache_stats.disk_reads : 0;
+    stats.load_ms_avg = loads ? load_ms_total / loads : 0;
+}
+
 /* 
    handle terrain messages from GCS
  */
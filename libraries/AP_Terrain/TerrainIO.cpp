@@ -33,13 +33,25 @@ extern const AP_HAL::HAL& hal;
  */
 void AP_Terrain::check_disk_read(void)
 {
+    // blocks which have been looked up go ahead of prefetched blocks
+    int16_t prefetch_idx = -1;
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
+            if (cache[i].prefetched) {
+                if (prefetch_idx == -1) {
+                    prefetch_idx = i;
+                }
+                continue;
+            }
             disk_block.block = cache[i].grid;
             disk_io_state = DiskIoWaitRead;
             return;
         }
-    }    
+    }
+    if (prefetch_idx != -1) {
+        disk_block.block = cache[prefetch_idx].grid;
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -72,24 +84,26 @@ void AP_Terrain::schedule_disk_io(void)
 
     switch (disk_io_state) {
     case DiskIoIdle:
-        // look for a block that needs reading or writing
-        check_disk_read();
-        if (disk_io_state == DiskIoIdle) {
-            // still idle, check for writes
-            check_disk_write();            
-        }
         break;
-        
+
     case DiskIoDoneRead: {
         // a read has completed
+        cache_stats.disk_reads++;
+        read_us_total += disk_read_us;
+        cache_stats.read_us_max = MAX(cache_stats.read_us_max, disk_read_us);
         int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
         if (cache_idx != -1) {
             if (disk_block.block.bitmap != 0) {
                 // when bitmap is zero we read an empty block
                 cache[cache_idx].grid = disk_block.block;
             }
+            const uint32_t now_ms = AP_HAL::millis();
+            const uint32_t load_ms = now_ms - cache[cache_idx].load_start_ms;
+            loads++;
+            load_ms_total += load_ms;
+            cache_stats.load_ms_max = MAX(cache_stats.load_ms_max, load_ms);
             cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            cache[cache_idx].last_access_ms = now_ms;
         }
         disk_io_state = DiskIoIdle;
         break;
@@ -113,6 +127,24 @@ void AP_Terrain::schedule_disk_io(void)
         // waiting for io_timer()
         break;
     }
+
+#if AP_TERRAIN_MMAP_ENABLED
+    if (disk_io_state == DiskIoIdle) {
+        // blocks in files which are already mapped don't need the
+        // IO thread
+        mmap_update();
+    }
+#endif
+
+    if (disk_io_state == DiskIoIdle) {
+        // look for a block that needs reading or writing, starting
+        // the next IO straight after a completion
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            // still idle, check for writes
+            check_disk_write();
+        }
+    }
 }
 
 
@@ -131,17 +163,11 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  set file_path to the degree file holding a block, creating the
+  terrain directory if need be
  */
-void AP_Terrain::open_file(void)
+bool AP_Terrain::set_file_path(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
-    if (fd != -1 && 
-        block.lat_degrees == file_lat_degrees &&
-        block.lon_degrees == file_lon_degrees) {
-        // already open on right file
-        return;
-    }
     if (file_path == nullptr) {
         const char* terrain_dir = hal.util->get_custom_terrain_directory();
         if (terrain_dir == nullptr) {
@@ -150,17 +176,17 @@ void AP_Terrain::open_file(void)
         if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
             io_failure = true;
             file_path = nullptr;
-            return;
+            return false;
         }
     }
     if (file_path == nullptr) {
         io_failure = true;
-        return;
+        return false;
     }
     char *p = &file_path[strlen(file_path)-12];
     if (*p != '/') {
         io_failure = true;
-        return;        
+        return false;
     }
     // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
     // thinks there are more digits than there can be so says there's
@@ -192,10 +218,28 @@ void AP_Terrain::open_file(void)
             } else {
                 // if we didn't succeed at making the directory, then IO failed
                 io_failure = true;
-                return;
+                return false;
             }
         }
     }
+    return true;
+}
+
+/*
+  open the current degree file
+ */
+void AP_Terrain::open_file(void)
+{
+    struct grid_block &block = disk_block.block;
+    if (fd != -1 && 
+        block.lat_degrees == file_lat_degrees &&
+        block.lon_degrees == file_lon_degrees) {
+        // already open on right file
+        return;
+    }
+    if (!set_file_path(block)) {
+        return;
+    }
 
     if (fd != -1) {
         AP::FS().close(fd);
@@ -217,7 +261,7 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(const struct grid_block &block) const
 {
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -232,14 +276,34 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  offset of a block within its degree file
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_offset(const struct grid_block &block) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
-    uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    return blocknum * sizeof(union grid_io_block);
+}
+
+/*
+  check that a block read from disk is valid and is the one asked for
+ */
+bool AP_Terrain::check_disk_block(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
+/*
+  seek to the right offset for disk_block
+ */
+void AP_Terrain::seek_offset(void)
+{
+    uint32_t file_offset = block_offset(disk_block.block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -289,6 +353,7 @@ void AP_Terrain::write_block(void)
  */
 void AP_Terrain::read_block(void)
 {
+    const uint32_t start_us = AP_HAL::micros();
     seek_offset();
     if (io_failure) {
         return;
@@ -298,12 +363,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !check_disk_block(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -331,6 +391,7 @@ void AP_Terrain::read_block(void)
                (unsigned long long)disk_block.block.bitmap);
 #endif
     }
+    disk_read_us = AP_HAL::micros() - start_us;
     disk_io_state = DiskIoDoneRead;
 }
 
@@ -351,6 +412,12 @@ void AP_Terrain::io_timer(void)
 
     update_reference_offset();
 
+#if AP_TERRAIN_MMAP_ENABLED
+    if (use_mmap()) {
+        mmap_sync();
+    }
+#endif
+
     switch (disk_io_state) {
     case DiskIoIdle:
     case DiskIoDoneRead:
@@ -359,6 +426,12 @@ void AP_Terrain::io_timer(void)
         break;
         
     case DiskIoWaitWrite:
+#if AP_TERRAIN_MMAP_ENABLED
+        if (use_mmap()) {
+            mmap_write_block();
+            break;
+        }
+#endif
         // need to write out the block
         open_file();
         if (fd == -1) {
@@ -368,6 +441,12 @@ void AP_Terrain::io_timer(void)
         break;
 
     case DiskIoWaitRead:
+#if AP_TERRAIN_MMAP_ENABLED
+        if (use_mmap()) {
+            mmap_read_block();
+            break;
+        }
+#endif
         // need to read in the block
         open_file();
         if (fd == -1) {
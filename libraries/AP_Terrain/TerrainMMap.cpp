@@ -0,0 +1,324 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped disk IO for terrain code on Linux and SITL
+
+  Each degree file is mapped in full, so a grid block is a pointer
+  into the mapping and the kernel page cache decides what stays in
+  memory. Mapping a file involves syscalls that may block, so it is
+  done by the IO thread using the same disk_io_state handshake as
+  TerrainIO.cpp. Once a file is mapped the main thread copies blocks
+  out of it directly whenever it owns disk_block, but only when
+  mincore() shows the pages are already in memory, so the main thread
+  never waits on a page fault that needs the disk. Other reads, and
+  all writes, are left for the IO thread.
+
+  Dirty pages are written back by the IO thread with an msync() of
+  each written file once a second, rather than an fsync() per block.
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+bool AP_Terrain::use_mmap(void) const
+{
+    return (options.get() & uint16_t(Options::UseMmap)) != 0;
+}
+
+/*
+  work out how many rows of blocks there are in a degree file
+ */
+uint32_t AP_Terrain::north_blocks(const struct grid_block &block) const
+{
+    Location loc1, loc2;
+    loc1.lat = block.lat_degrees*10*1000*1000L;
+    loc1.lng = block.lon_degrees*10*1000*1000L;
+    loc2.lat = (block.lat_degrees+1)*10*1000*1000L;
+    loc2.lng = loc1.lng;
+
+    // shift another two blocks north to ensure room is available
+    loc2.offset(2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_X, 0);
+    const Vector2f offset = loc1.get_distance_NE(loc2);
+    return offset.x / (grid_spacing*TERRAIN_GRID_BLOCK_SPACING_X);
+}
+
+/*
+  find the mapping of the degree file holding a block
+ */
+AP_Terrain::mapped_file *AP_Terrain::mmap_find(const struct grid_block &block)
+{
+    for (auto &mf : mapped_files) {
+        if (mf.data != nullptr &&
+            mf.lat_degrees == block.lat_degrees &&
+            mf.lon_degrees == block.lon_degrees &&
+            mf.spacing == grid_spacing) {
+            mf.last_use_ms = AP_HAL::millis();
+            return &mf;
+        }
+    }
+    return nullptr;
+}
+
+/*
+  map the degree file holding a block, replacing the least recently
+  used mapping. Called from the IO thread
+ */
+AP_Terrain::mapped_file *AP_Terrain::mmap_open(const struct grid_block &block)
+{
+    struct mapped_file *mf = mmap_find(block);
+    if (mf != nullptr) {
+        return mf;
+    }
+    mf = &mapped_files[0];
+    for (auto &m : mapped_files) {
+        if (m.data == nullptr) {
+            mf = &m;
+            break;
+        }
+        if (m.last_use_ms < mf->last_use_ms) {
+            mf = &m;
+        }
+    }
+    if (mf->data != nullptr) {
+        if (mf->dirty) {
+            msync(mf->data, mf->size, MS_SYNC);
+        }
+        munmap(mf->data, mf->size);
+        mf->data = nullptr;
+    }
+
+    if (!set_file_path(block)) {
+        return nullptr;
+    }
+    const uint64_t size64 = uint64_t(north_blocks(block)) * east_blocks(block) * sizeof(union grid_io_block);
+    if (size64 > INT32_MAX) {
+        // grid spacing too fine to map a whole degree
+        io_failure = true;
+        return nullptr;
+    }
+    const uint32_t size = size64;
+    const int mfd = ::open(file_path, O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+    if (mfd == -1) {
+        io_failure = true;
+        return nullptr;
+    }
+    // grow the file so every block can be written through the
+    // mapping. The file is sparse, and holes read as empty blocks
+    struct stat st;
+    if (fstat(mfd, &st) != 0 ||
+        (st.st_size < off_t(size) && ftruncate(mfd, size) != 0)) {
+        ::close(mfd);
+        io_failure = true;
+        return nullptr;
+    }
+    void *data = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, mfd, 0);
+    ::close(mfd);
+    if (data == MAP_FAILED) {
+#if TERRAIN_DEBUG
+        hal.console->printf("mmap %s failed - %s\n", file_path, strerror(errno));
+#endif
+        io_failure = true;
+        return nullptr;
+    }
+
+    mf->data = (uint8_t *)data;
+    mf->size = size;
+    mf->dirty = false;
+    mf->spacing = grid_spacing;
+    mf->lat_degrees = block.lat_degrees;
+    mf->lon_degrees = block.lon_degrees;
+    mf->last_use_ms = AP_HAL::millis();
+    return mf;
+}
+
+/*
+  fill in a block from its mapped file. Returns false if the file is
+  not mapped. A missing or bad block on disk leaves an empty block
+ */
+bool AP_Terrain::mmap_read(struct grid_block &block)
+{
+    const struct mapped_file *mf = mmap_find(block);
+    if (mf == nullptr) {
+        return false;
+    }
+    const uint32_t ofs = block_offset(block);
+    if (ofs + sizeof(union grid_io_block) <= mf->size) {
+        // copy out before checking, as the CRC check modifies the block
+        struct grid_block disk;
+        memcpy(&disk, &mf->data[ofs], sizeof(disk));
+        if (check_disk_block(disk, block.lat, block.lon)) {
+            block = disk;
+            return true;
+        }
+    }
+    block.bitmap = 0;
+    return true;
+}
+
+/*
+  store a block in its mapped file. Returns false if the file is not
+  mapped or the block is outside it. Called from the IO thread
+ */
+bool AP_Terrain::mmap_write(const struct grid_block &block)
+{
+    struct mapped_file *mf = mmap_find(block);
+    if (mf == nullptr) {
+        return false;
+    }
+    const uint32_t ofs = block_offset(block);
+    if (ofs + sizeof(union grid_io_block) > mf->size) {
+        return false;
+    }
+    struct grid_block disk = block;
+    disk.crc = get_block_crc(disk);
+    memcpy(&mf->data[ofs], &disk, sizeof(disk));
+    mf->dirty = true;
+    return true;
+}
+
+/*
+  return true if a block is in a mapped file and its pages are in
+  memory, so the main thread can copy it without blocking on the disk
+ */
+bool AP_Terrain::mmap_resident(const struct grid_block &block)
+{
+    const struct mapped_file *mf = mmap_find(block);
+    if (mf == nullptr) {
+        return false;
+    }
+    const uint32_t ofs = block_offset(block);
+    if (ofs + sizeof(union grid_io_block) > mf->size) {
+        return false;
+    }
+    static const uint32_t page_size = sysconf(_SC_PAGESIZE);
+    const uint32_t start = ofs - ofs % page_size;
+    const uint32_t len = ofs + sizeof(union grid_io_block) - start;
+    unsigned char pages[sizeof(union grid_io_block) / 4096 + 2];
+    const uint32_t npages = (len + page_size - 1) / page_size;
+    if (npages > ARRAY_SIZE(pages) ||
+        mincore(&mf->data[start], len, pages) != 0) {
+        return false;
+    }
+    for (uint32_t i=0; i<npages; i++) {
+        if ((pages[i] & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  load a cache block waiting for a disk read from a mapped file, if
+  the main thread owns the mappings
+ */
+bool AP_Terrain::mmap_load(struct grid_cache &gcache)
+{
+    if (!use_mmap() ||
+        disk_io_state == DiskIoWaitRead ||
+        disk_io_state == DiskIoWaitWrite) {
+        return false;
+    }
+    if (!mmap_resident(gcache.grid)) {
+        return false;
+    }
+    const uint32_t start_us = AP_HAL::micros();
+    mmap_read(gcache.grid);
+    const uint32_t read_us = AP_HAL::micros() - start_us;
+    cache_stats.disk_reads++;
+    read_us_total += read_us;
+    cache_stats.read_us_max = MAX(cache_stats.read_us_max, read_us);
+    const uint32_t load_ms = AP_HAL::millis() - gcache.load_start_ms;
+    loads++;
+    load_ms_total += load_ms;
+    cache_stats.load_ms_max = MAX(cache_stats.load_ms_max, load_ms);
+    gcache.state = GRID_CACHE_VALID;
+    return true;
+}
+
+/*
+  read the cache blocks which are in memory in mapped files, leaving
+  the rest for the IO thread
+ */
+void AP_Terrain::mmap_update(void)
+{
+    if (!use_mmap()) {
+        return;
+    }
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].state == GRID_CACHE_DISKWAIT) {
+            mmap_load(cache[i]);
+        }
+    }
+}
+
+/*
+  IO thread read of disk_block, mapping its file first
+ */
+void AP_Terrain::mmap_read_block(void)
+{
+    const uint32_t start_us = AP_HAL::micros();
+    if (mmap_open(disk_block.block) == nullptr) {
+        return;
+    }
+    mmap_read(disk_block.block);
+    disk_read_us = AP_HAL::micros() - start_us;
+    disk_io_state = DiskIoDoneRead;
+}
+
+/*
+  IO thread write of disk_block, mapping its file first
+ */
+void AP_Terrain::mmap_write_block(void)
+{
+    if (mmap_open(disk_block.block) == nullptr) {
+        return;
+    }
+    if (!mmap_write(disk_block.block)) {
+        // the same as a failed write to the file
+        io_failure = true;
+    }
+    disk_io_state = DiskIoDoneWrite;
+}
+
+/*
+  IO thread write back of pages dirtied through the mappings
+ */
+void AP_Terrain::mmap_sync(void)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_msync_ms < 1000) {
+        return;
+    }
+    last_msync_ms = now_ms;
+    for (auto &mf : mapped_files) {
+        if (mf.data != nullptr && mf.dirty) {
+            msync(mf.data, mf.size, MS_SYNC);
+            mf.dirty = false;
+        }
+    }
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
@@ -26,6 +26,7 @@
 #include <AP_Mission/AP_Mission.h>
 #include <AP_Rally/AP_Rally.h>
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -114,6 +115,99 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+/*
+  queue disk reads for blocks the vehicle is about to fly over, along
+  the current ground track and the next legs of a running mission. The
+  blocks are loaded by the normal disk IO, behind any blocks which
+  have been looked up. Prefetching only happens when the cache has
+  been made larger than the default, so it can't evict the blocks
+  around the vehicle
+ */
+void AP_Terrain::update_prefetch(const Location &loc)
+{
+    if (cache_size <= TERRAIN_GRID_BLOCK_CACHE_SIZE ||
+        (options.get() & uint16_t(Options::DisablePrefetch)) != 0 ||
+        grid_spacing <= 0) {
+        return;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < 1000) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    // limit the prefetched blocks waiting for disk reads to half
+    // of the extra cache. Prefetched blocks which are no longer on
+    // the path age out of the cache like any other block
+    const uint16_t limit = (cache_size - TERRAIN_GRID_BLOCK_CACHE_SIZE) / 2;
+    uint16_t outstanding = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].prefetched && cache[i].state == GRID_CACHE_DISKWAIT) {
+            outstanding++;
+        }
+    }
+    if (outstanding >= limit) {
+        return;
+    }
+    uint16_t budget = limit - outstanding;
+
+    // along the current ground track
+    const Vector2f &groundspeed = AP::ahrs().groundspeed_vector();
+    if (groundspeed.length() > 1) {
+        prefetch_line(loc, groundspeed * TERRAIN_PREFETCH_TIME_S, budget);
+    }
+
+#if AP_MISSION_ENABLED
+    // along the next two legs of the mission
+    const AP_Mission *mission = AP::mission();
+    if (mission == nullptr ||
+        mission->state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+    uint16_t index = mission->get_current_nav_index();
+    if (index == 0) {
+        return;
+    }
+    Location leg_start = loc;
+    uint8_t legs = 0;
+    for (uint8_t i=0; i<20 && legs<2 && budget>0; i++, index++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission->read_cmd_from_storage(index, cmd)) {
+            break;
+        }
+        if ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
+             cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        prefetch_line(leg_start, leg_start.get_distance_NE(cmd.content.location), budget);
+        leg_start = cmd.content.location;
+        legs++;
+    }
+#endif // AP_MISSION_ENABLED
+}
+
+/*
+  queue blocks along a line from loc, stepping at half the block
+  spacing so no block along the line is missed
+ */
+void AP_Terrain::prefetch_line(const Location &loc, const Vector2f &ofs_ne, uint16_t &budget)
+{
+    const float length = ofs_ne.length();
+    const float step = 0.5f * grid_spacing * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y);
+    for (float dist = 0; dist < length && budget > 0; dist += step) {
+        Location loc2 = loc;
+        loc2.offset(ofs_ne.x * dist / length, ofs_ne.y * dist / length);
+        struct grid_info info;
+        calculate_grid_info(loc2, info);
+        const uint32_t prefetches = cache_stats.prefetches;
+        find_grid_cache(info, true);
+        if (cache_stats.prefetches != prefetches) {
+            budget--;
+        }
+    }
+}
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
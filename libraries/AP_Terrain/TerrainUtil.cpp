@@ -101,29 +101,79 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 }
 
 
+/*
+  hash bucket for a grid block. Blocks are keyed on their indices,
+  which are exact, rather than the corner lat/lon which can differ by
+  the acceptance margin
+ */
+uint16_t AP_Terrain::grid_hash(int8_t lat_degrees, int16_t lon_degrees, uint16_t grid_idx_x, uint16_t grid_idx_y) const
+{
+    uint32_t h = uint8_t(lat_degrees);
+    h = (h * 0x9E3779B1U) ^ uint16_t(lon_degrees);
+    h = (h * 0x9E3779B1U) ^ grid_idx_x;
+    h = (h * 0x9E3779B1U) ^ grid_idx_y;
+    h *= 0x9E3779B1U;
+    return (h >> 16) & hash_mask;
+}
+
+/*
+  remove a cache entry from its hash bucket
+ */
+void AP_Terrain::cache_unlink(uint16_t idx)
+{
+    uint16_t *p = &cache_hash[cache[idx].hash_bucket];
+    while (*p != 0) {
+        if (*p == idx+1) {
+            *p = cache[idx].hash_next;
+            return;
+        }
+        p = &cache[*p-1].hash_next;
+    }
+}
+
 /*
   find a grid structure given a grid_info
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info, bool prefetch)
 {
-    uint16_t oldest_i = 0;
+    const uint16_t bucket = grid_hash(info.lat_degrees, info.lon_degrees, info.grid_idx_x, info.grid_idx_y);
+    const uint32_t now_ms = AP_HAL::millis();
 
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
-            TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
-        }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
+    for (uint16_t i=cache_hash[bucket]; i != 0; i=cache[i-1].hash_next) {
+        struct grid_cache &grid = cache[i-1];
+        if (TERRAIN_LATLON_EQUAL(grid.grid.lat,info.grid_lat) &&
+            TERRAIN_LATLON_EQUAL(grid.grid.lon,info.grid_lon) &&
+            grid.grid.spacing == grid_spacing) {
+            grid.last_access_ms = now_ms;
+            if (!prefetch) {
+                if (grid.state >= GRID_CACHE_VALID) {
+                    cache_stats.hits++;
+                } else {
+                    cache_stats.misses++;
+                }
+                if (grid.prefetched) {
+                    cache_stats.prefetch_hits++;
+                    grid.prefetched = false;
+                }
+            }
+            return grid;
         }
     }
 
     // Not found. Use the oldest grid and make it this grid,
     // initially unpopulated
+    uint16_t oldest_i = 0;
+    for (uint16_t i=1; i<cache_size; i++) {
+        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
+            oldest_i = i;
+        }
+    }
     struct grid_cache &grid = cache[oldest_i];
+    if (grid.state != GRID_CACHE_INVALID) {
+        cache_stats.evictions++;
+    }
+    cache_unlink(oldest_i);
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -134,11 +184,27 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
+    grid.last_access_ms = now_ms;
+    grid.load_start_ms = now_ms;
+    grid.prefetched = prefetch;
+    if (prefetch) {
+        cache_stats.prefetches++;
+    } else {
+        cache_stats.misses++;
+    }
+
+    grid.hash_bucket = bucket;
+    grid.hash_next = cache_hash[bucket];
+    cache_hash[bucket] = oldest_i+1;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    // a block in a mapped file can be loaded straight away
+    mmap_load(grid);
+#endif
+
     return grid;
 }
 
@@ -0,0 +1,311 @@
+/*
+  benchmark of AP_Terrain::height_amsl() lookups spread over a large
+  synthetic tile set, comparing the default file backend with the
+  memory mapped backend (TERRAIN_OPTIONS bit 2)
+
+  The tile set is written into the terrain directory, so don't run
+  this on a board holding terrain data you want to keep
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Param/AP_Param.h>
+#include <AP_Terrain/AP_Terrain.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_Baro/AP_Baro.h>
+#include <AP_GPS/AP_GPS.h>
+#include <AP_Compass/AP_Compass.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+// south west corner and size of the tile set, in degrees
+static const int8_t tile_lat = -36;
+static const int16_t tile_lon = 148;
+static const uint8_t tile_degrees = 2;
+
+static const uint16_t grid_spacing = 100;
+static const uint32_t num_lookups = 20000;
+
+class Parameters {
+public:
+    enum {
+        k_param_terrain = 1,
+    };
+};
+
+static AP_InertialSensor ins;
+static AP_Baro baro;
+static AP_GPS gps;
+static Compass compass;
+static AP_AHRS ahrs;
+static AP_Terrain terrain;
+
+const struct AP_Param::Info var_info[] = {
+    { "TERRAIN_", (const void *)&terrain, {group_info : AP_Terrain::var_info}, 0, Parameters::k_param_terrain, AP_PARAM_GROUP },
+    AP_VAREND
+};
+
+static AP_Param param{var_info};
+
+/*
+  on disk format of a grid block, as written by AP_Terrain and
+  create_terrain.py
+ */
+struct PACKED disk_block {
+    uint64_t bitmap;
+    int32_t lat;
+    int32_t lon;
+    uint16_t crc;
+    uint16_t version;
+    uint16_t spacing;
+    int16_t height[TERRAIN_GRID_BLOCK_SIZE_X][TERRAIN_GRID_BLOCK_SIZE_Y];
+    uint16_t grid_idx_x;
+    uint16_t grid_idx_y;
+    int16_t lon_degrees;
+    int8_t lat_degrees;
+};
+
+union disk_io_block {
+    struct disk_block block;
+    uint8_t buffer[2048];
+};
+
+/*
+  number of blocks needed east and north in a degree file, as
+  calculated by AP_Terrain
+ */
+static uint32_t blocks_east(int8_t lat_degrees, int16_t lon_degrees)
+{
+    Location loc1, loc2;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
+    loc2.lat = loc1.lat;
+    loc2.lng = (lon_degrees+1)*10*1000*1000L;
+    loc2.offset(0, 2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
+    return loc1.get_distance_NE(loc2).y / (grid_spacing*TERRAIN_GRID_BLOCK_SPACING_Y);
+}
+
+static uint32_t blocks_north(int8_t lat_degrees, int16_t lon_degrees)
+{
+    Location loc1, loc2;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
+    loc2.lat = (lat_degrees+1)*10*1000*1000L;
+    loc2.lng = loc1.lng;
+    return loc1.get_distance_NE(loc2).x / (grid_spacing*TERRAIN_GRID_BLOCK_SPACING_X) + 1;
+}
+
+// synthetic terrain height at a global grid point
+static int16_t synthetic_height(uint32_t gx, uint32_t gy)
+{
+    return 200 + (gx * 7 + gy * 13) % 1000;
+}
+
+/*
+  write a complete degree file
+ */
+static bool write_degree_file(const char *dir, int8_t lat_degrees, int16_t lon_degrees)
+{
+    char path[100];
+    hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT", dir,
+                       lat_degrees<0?'S':'N', (unsigned)abs(lat_degrees),
+                       lon_degrees<0?'W':'E', (unsigned)abs(lon_degrees));
+    int fd = AP::FS().open(path, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        hal.console->printf("Failed to create %s\n", path);
+        return false;
+    }
+    const uint32_t east = blocks_east(lat_degrees, lon_degrees);
+    const uint32_t north = blocks_north(lat_degrees, lon_degrees);
+    for (uint32_t x=0; x<north; x++) {
+        for (uint32_t y=0; y<east; y++) {
+            union disk_io_block io {};
+            struct disk_block &b = io.block;
+            Location ref;
+            ref.lat = lat_degrees*10*1000*1000L;
+            ref.lng = lon_degrees*10*1000*1000L;
+            ref.offset(x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+                       y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+            b.bitmap = (((uint64_t)1U)<<(TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y)) - 1;
+            b.lat = ref.lat;
+            b.lon = ref.lng;
+            b.version = TERRAIN_GRID_FORMAT_VERSION;
+            b.spacing = grid_spacing;
+            b.grid_idx_x = x;
+            b.grid_idx_y = y;
+            b.lat_degrees = lat_degrees;
+            b.lon_degrees = lon_degrees;
+            for (uint8_t i=0; i<TERRAIN_GRID_BLOCK_SIZE_X; i++) {
+                for (uint8_t j=0; j<TERRAIN_GRID_BLOCK_SIZE_Y; j++) {
+                    b.height[i][j] = synthetic_height(x*TERRAIN_GRID_BLOCK_SPACING_X+i,
+                                                      y*TERRAIN_GRID_BLOCK_SPACING_Y+j);
+                }
+            }
+            b.crc = crc16_ccitt((const uint8_t *)&b, sizeof(b), 0);
+            if (AP::FS().lseek(fd, (east*x + y)*sizeof(io), SEEK_SET) == -1 ||
+                AP::FS().write(fd, &io, sizeof(io)) != sizeof(io)) {
+                hal.console->printf("Failed to write %s\n", path);
+                AP::FS().close(fd);
+                return false;
+            }
+        }
+    }
+    AP::FS().close(fd);
+    return true;
+}
+
+static bool create_tiles(void)
+{
+    const char *dir = hal.util->get_custom_terrain_directory();
+    if (dir == nullptr) {
+        dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+    AP::FS().mkdir(dir);
+    for (uint8_t i=0; i<tile_degrees; i++) {
+        for (uint8_t j=0; j<tile_degrees; j++) {
+            if (!write_degree_file(dir, tile_lat+i, tile_lon+j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+  set a parameter and let the terrain code act on it
+ */
+static void set_param(const char *name, float value)
+{
+    if (!AP_Param::set_by_name(name, value)) {
+        hal.console->printf("Failed to set %s\n", name);
+    }
+}
+
+/*
+  empty the cache by shrinking it to a single block
+ */
+static void flush_cache(uint16_t cache_size)
+{
+    AP_Terrain::CacheStatistics stats;
+    for (uint16_t size : { uint16_t(1), cache_size }) {
+        set_param("TERRAIN_CACHE_SZ", size);
+        do {
+            terrain.update();
+            hal.scheduler->delay(1);
+            terrain.get_statistics(stats);
+        } while (stats.cache_size != size);
+    }
+}
+
+/*
+  look up heights at pseudo random points over the tile set, waiting
+  for each one to load
+ */
+static void run_lookups(const char *name, uint16_t options, uint16_t cache_size, float *heights)
+{
+    set_param("TERRAIN_OPTIONS", options);
+    flush_cache(cache_size);
+
+    AP_Terrain::CacheStatistics start;
+    terrain.get_statistics(start);
+
+    uint32_t seed = 1;
+    uint32_t failed = 0;
+    const uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i=0; i<num_lookups; i++) {
+        // points are spread over the whole tile set, so most lookups
+        // miss a small cache
+        seed = seed * 1103515245U + 12345U;
+        Location loc;
+        loc.lat = tile_lat*10*1000*1000L + 1000 + int32_t((seed >> 8) % ((tile_degrees*10*1000*1000L)-2000));
+        seed = seed * 1103515245U + 12345U;
+        loc.lng = tile_lon*10*1000*1000L + 1000 + int32_t((seed >> 8) % ((tile_degrees*10*1000*1000L)-2000));
+
+        const uint32_t wait_start_ms = AP_HAL::millis();
+        while (!terrain.height_amsl(loc, heights[i], false)) {
+            if (AP_HAL::millis() - wait_start_ms > 5000) {
+                failed++;
+                heights[i] = 0;
+                break;
+            }
+            terrain.update();
+            hal.scheduler->delay_microseconds(100);
+        }
+    }
+    const uint64_t elapsed_us = AP_HAL::micros64() - start_us;
+
+    AP_Terrain::CacheStatistics stats;
+    terrain.get_statistics(stats);
+    hal.console->printf("%s: %u lookups in %.3fs (%.1fus each) failed=%u\n",
+                        name, (unsigned)num_lookups, elapsed_us*1.0e-6,
+                        double(elapsed_us)/num_lookups, (unsigned)failed);
+    hal.console->printf("  cache=%u hits=%u misses=%u reads=%u read_us avg=%u max=%u load_ms avg=%u max=%u\n",
+                        (unsigned)stats.cache_size,
+                        (unsigned)(stats.hits - start.hits),
+                        (unsigned)(stats.misses - start.misses),
+                        (unsigned)(stats.disk_reads - start.disk_reads),
+                        (unsigned)stats.read_us_avg, (unsigned)stats.read_us_max,
+                        (unsigned)stats.load_ms_avg, (unsigned)stats.load_ms_max);
+}
+
+static float heights_file[num_lookups];
+static float heights_mmap[num_lookups];
+
+void setup(void)
+{
+    hal.console->printf("Terrain backend benchmark\n");
+    if (!AP_Param::setup()) {
+        hal.console->printf("Failed to setup parameters\n");
+        return;
+    }
+    set_param("TERRAIN_ENABLE", 1);
+    set_param("TERRAIN_SPACING", grid_spacing);
+
+    hal.console->printf("Creating %ux%u degree tile set\n", tile_degrees, tile_degrees);
+    if (!create_tiles()) {
+        return;
+    }
+
+    for (uint16_t cache_size : { uint16_t(TERRAIN_GRID_BLOCK_CACHE_SIZE), uint16_t(256) }) {
+        hal.console->printf("Cache size %u\n", (unsigned)cache_size);
+        run_lookups("file", 0, cache_size, heights_file);
+        run_lookups("mmap", uint16_t(1U<<2), cache_size, heights_mmap);
+
+        uint32_t mismatch = 0;
+        for (uint32_t i=0; i<num_lookups; i++) {
+            if (!is_equal(heights_file[i], heights_mmap[i])) {
+                mismatch++;
+            }
+        }
+        hal.console->printf("  %u height mismatches between backends\n", (unsigned)mismatch);
+    }
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->printf("Memory mapped terrain not available on this board\n");
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+const struct AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
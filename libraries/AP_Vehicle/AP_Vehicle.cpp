@@ -713,6 +713,14 @@ void AP_Vehicle::update_dynamic_notch(AP_InertialSensor::HarmonicNotch &notch)
     if (!notch.params.enabled()) {
         return;
     }
+#if HAL_GYROFFT_PARALLEL_ENABLED
+    // per-IMU frequencies only come from FFT analysis of each IMU
+    if (notch.params.tracking_mode() != HarmonicNotchDynamicMode::UpdateGyroFFT ||
+        is_zero(notch.params.reference()) ||
+        gyro_fft.get_num_imus() <= 1) {
+        notch.clear_instance_frequencies();
+    }
+#endif
     const float ref_freq = notch.params.center_freq_hz();
     const float ref = notch.params.reference();
     if (is_zero(ref)) {
@@ -797,6 +805,26 @@ void AP_Vehicle::update_dynamic_notch(AP_InertialSensor::HarmonicNotch &notch)
                     notch.set_inactive(true);
                 }
             }
+#if HAL_GYROFFT_PARALLEL_ENABLED
+            // when each IMU is analysed independently track the noise seen by each IMU
+            if (gyro_fft.get_num_imus() > 1) {
+                for (uint8_t imu = 0; imu < gyro_fft.get_num_imus(); imu++) {
+                    float notches[INS_MAX_NOTCHES];
+                    uint8_t peaks;
+                    if (notch.params.hasOption(HarmonicNotchFilterParams::Options::DynamicHarmonic)) {
+                        peaks = gyro_fft.get_weighted_noise_center_frequencies_hz(imu, notch.num_dynamic_notches, notches);
+                    } else {
+                        notches[0] = gyro_fft.get_weighted_noise_center_freq_hz(imu);
+                        peaks = is_zero(notches[0]) ? 0 : 1;
+                    }
+                    for (uint8_t i = 0; i < peaks; i++) {
+                        notches[i] = MAX(ref_freq, notches[i]);
+                    }
+                    // IMUs without a detected peak use the vehicle-wide frequencies
+                    notch.update_frequencies_hz(imu, peaks, notches);
+                }
+            }
+#endif
             break;
 #endif
         case HarmonicNotchDynamicMode::Fixed: // static
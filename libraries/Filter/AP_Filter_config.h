@@ -13,3 +13,9 @@
 #ifndef AP_FILTER_ENABLED
 #define AP_FILTER_ENABLED AP_FILTER_NUM_FILTERS > 0
 #endif
+
+// apply the notches of a 3-axis harmonic notch filter as one packed
+// bank, vectorised with SSE or NEON where available
+#ifndef AP_FILTER_NOTCH_BANK_ENABLED
+#define AP_FILTER_NOTCH_BANK_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
@@ -19,6 +19,7 @@
 /// See http://www.holoborodko.com/pavel/numerical-methods/numerical-derivative/smooth-low-noise-differentiators/
 #pragma once
 
+#include <AP_Common/AP_Common.h>
 #include "FilterClass.h"
 #include "FilterWithBuffer.h"
 
@@ -53,3 +54,76 @@ private:
 typedef DerivativeFilter<float,5> DerivativeFilterFloat_Size5;
 typedef DerivativeFilter<float,7> DerivativeFilterFloat_Size7;
 typedef DerivativeFilter<float,9> DerivativeFilterFloat_Size9;
+
+/// A derivative filter for samples at a fixed rate of SAMPLE_FREQ Hz. The slope is per
+/// second and uses coefficients fixed at compile time rather than dividing by the
+/// differences between timestamps
+template <class T, uint8_t FILTER_SIZE, uint16_t SAMPLE_FREQ>
+class DerivativeFilterConst
+{
+public:
+    static_assert(FILTER_SIZE == 5 || FILTER_SIZE == 7 || FILTER_SIZE == 9 || FILTER_SIZE == 11, "unsupported filter size");
+    static_assert(SAMPLE_FREQ > 0, "sample frequency must be positive");
+
+    DerivativeFilterConst() {}
+
+    CLASS_NO_COPY(DerivativeFilterConst);
+
+    // add a new sample
+    void update(const T &sample) {
+        _samples[_index] = _samples[_index + FILTER_SIZE] = sample;
+        _index = (_index + 1) % FILTER_SIZE;
+        if (_count < FILTER_SIZE) {
+            _count++;
+        }
+    }
+
+    // return the derivative, zero until the filter is full
+    T slope(void) const {
+        if (_count < FILTER_SIZE) {
+            return T();
+        }
+        // the samples oldest first, f(0) is the middle sample
+        const T *f = &_samples[_index + FILTER_SIZE/2];
+        T result = (f[1] - f[-1]) * coefficient(1);
+        for (uint8_t k = 2; k <= FILTER_SIZE/2; k++) {
+            result += (f[k] - f[-k]) * coefficient(k);
+        }
+        return result;
+    }
+
+    // add a new sample and return the derivative
+    T apply(const T &sample) {
+        update(sample);
+        return slope();
+    }
+
+    // clear the filter
+    void reset(void) {
+        _index = 0;
+        _count = 0;
+    }
+
+    // apply each of n filters to the corresponding sample
+    static void apply_n(DerivativeFilterConst *filters, const T *samples, T *slopes, uint16_t n) {
+        for (uint16_t i = 0; i < n; i++) {
+            slopes[i] = filters[i].apply(samples[i]);
+        }
+    }
+
+private:
+    // with uniformly spaced samples each term of DerivativeFilter::slope() reduces to
+    // weight * (f(k) - f(-k)) / dt, with the weights scaled by the divisor
+    static constexpr float coefficient(uint8_t k) {
+        return float(SAMPLE_FREQ) * (FILTER_SIZE == 5 ? (k == 1 ? 2 : 1) / 8.0f :
+                                     FILTER_SIZE == 7 ? (k == 1 ? 5 : k == 2 ? 4 : 1) / 32.0f :
+                                     FILTER_SIZE == 9 ? (k <= 2 ? 14 : k == 3 ? 6 : 1) / 128.0f :
+                                     (k == 1 ? 42 : k == 2 ? 48 : k == 3 ? 27 : k == 4 ? 8 : 1) / 512.0f);
+    }
+
+    // each sample is stored twice, so the last FILTER_SIZE samples are always
+    // contiguous starting from the oldest at _index
+    T _samples[2*FILTER_SIZE] {};
+    uint8_t _index = 0;
+    uint8_t _count = 0;
+};
@@ -19,6 +19,7 @@
 #endif
 
 #include "HarmonicNotchFilter.h"
+#include "NotchFilterBank.h"
 #include <GCS_MAVLink/GCS.h>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -132,6 +133,9 @@ const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
 template <class T>
 HarmonicNotchFilter<T>::~HarmonicNotchFilter() {
     delete[] _filters;
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    delete _bank;
+#endif
     _num_filters = 0;
     _num_enabled_filters = 0;
 }
@@ -183,6 +187,9 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint32_t harm
             _num_filters = 0;
         }
     }
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    allocate_bank();
+#endif
 }
 
 /*
@@ -209,6 +216,9 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
     _filters = filters;
     _num_filters = total_notches;
     delete[] _old_filters;
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    allocate_bank();
+#endif
 }
 
 /*
@@ -252,6 +262,9 @@ void HarmonicNotchFilter<T>::update(float center_freq_hz)
             }
         }
     }
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    update_bank();
+#endif
 }
 
 /*
@@ -307,6 +320,9 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
             }
         }
     }
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    update_bank();
+#endif
 }
 
 /*
@@ -319,6 +335,12 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
         return sample;
     }
 
+#if AP_FILTER_NOTCH_BANK_ENABLED && !NOTCH_DEBUG_LOGGING
+    if (_bank != nullptr) {
+        return apply_bank(sample);
+    }
+#endif
+
 #if NOTCH_DEBUG_LOGGING
     static int dfd = -1;
     if (dfd == -1) {
@@ -358,7 +380,97 @@ void HarmonicNotchFilter<T>::reset()
     for (uint16_t i = 0; i < _num_filters; i++) {
         _filters[i].reset();
     }
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    if (_bank != nullptr) {
+        _bank->reset();
+        _bank_reset_pending = true;
+    }
+#endif
+}
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+/*
+  the bank is only used for 3-axis filters, where there is enough
+  work per notch to be worth vectorising
+ */
+template <class T>
+void HarmonicNotchFilter<T>::allocate_bank()
+{
+}
+
+template <class T>
+void HarmonicNotchFilter<T>::update_bank()
+{
+}
+
+template <class T>
+T HarmonicNotchFilter<T>::apply_bank(const T &sample)
+{
+    return sample;
+}
+
+/*
+  copy the coefficients of the enabled filters into the bank
+ */
+template <>
+void HarmonicNotchFilter<Vector3f>::update_bank()
+{
+    if (_bank == nullptr) {
+        return;
+    }
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+        _bank->set_stage(i, _filters[i]);
+    }
+}
+
+/*
+  allocate or expand the bank to hold all of the filters. If that
+  fails the filters are applied individually, restarting from the
+  next sample
+ */
+template <>
+void HarmonicNotchFilter<Vector3f>::allocate_bank()
+{
+    if (_num_filters == 0) {
+        return;
+    }
+    if (_bank == nullptr) {
+        _bank = new NotchFilterBank();
+        if (_bank == nullptr) {
+            return;
+        }
+    }
+    if (!_bank->allocate(_num_filters)) {
+        delete _bank;
+        _bank = nullptr;
+        for (uint16_t i = 0; i < _num_filters; i++) {
+            _filters[i].reset();
+        }
+        return;
+    }
+    update_bank();
+}
+
+/*
+  apply a sample to the enabled stages of the bank. The bank holds the
+  filter state, so the filters are only kept for their coefficients
+ */
+template <>
+Vector3f HarmonicNotchFilter<Vector3f>::apply_bank(const Vector3f &sample)
+{
+    const Vector3f output = _bank->apply(sample, _num_enabled_filters);
+    if (_bank_reset_pending) {
+        // clear the reset flag of the filters just applied, as
+        // NotchFilter::apply() would. It limits how far update() may
+        // slew the center frequency
+        for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+            _filters[i].need_reset = false;
+        }
+        _bank_reset_pending = _num_enabled_filters < _num_filters;
+    }
+    return output;
 }
+#endif // AP_FILTER_NOTCH_BANK_ENABLED
 
 /*
   create parameters for the harmonic notch filter and initialise defaults
@@ -18,6 +18,7 @@
 #include <cmath>
 #include <AP_Param/AP_Param.h>
 #include "NotchFilter.h"
+#include "AP_Filter_config.h"
 
 #define HNF_MAX_HARMONICS 16
 
@@ -69,6 +70,17 @@ private:
 
     // have we failed to expand filters?
     bool _alloc_has_failed;
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    // packed copy of the filters, used in place of them by apply()
+    NotchFilterBank *_bank;
+    // filters may still have their reset flag set since reset()
+    bool _bank_reset_pending;
+
+    void allocate_bank();
+    void update_bank();
+    T apply_bank(const T &sample);
+#endif
 };
 
 // Harmonic notch update mode
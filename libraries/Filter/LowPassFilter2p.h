@@ -89,6 +89,121 @@ LowPassFilter2p<T>::LowPassFilter2p(float sample_freq, float cutoff_freq) {
 }
 */
 
+/*
+  constexpr trigonometry for calculating filter coefficients at compile
+  time. The Taylor series are accurate to double precision for angles
+  up to pi/2
+ */
+namespace FilterConst {
+constexpr double sin_series(double x2, double term, uint8_t k) {
+    return k > 16 ? term : term + sin_series(x2, -term * x2 / ((2*k) * (2*k+1)), k + 1);
+}
+constexpr double cos_series(double x2, double term, uint8_t k) {
+    return k > 16 ? term : term + cos_series(x2, -term * x2 / ((2*k-1) * (2*k)), k + 1);
+}
+constexpr double tan(double x) {
+    return sin_series(x*x, x, 1) / cos_series(x*x, 1.0, 1);
+}
+
+// biquad coefficients as calculated by DigitalBiquadFilter::compute_params(),
+// where 2*cos(pi/4) is sqrt(2)
+constexpr double sqrt2 = 1.4142135623730951;
+constexpr double biquad_ohm(double sample_freq, double cutoff_freq) {
+    return tan(M_PI * cutoff_freq / sample_freq);
+}
+constexpr double biquad_c(double ohm) {
+    return 1.0 + sqrt2 * ohm + ohm * ohm;
+}
+constexpr double biquad_b0(double ohm) {
+    return ohm * ohm / biquad_c(ohm);
+}
+constexpr double biquad_a1(double ohm) {
+    return 2.0 * (ohm * ohm - 1.0) / biquad_c(ohm);
+}
+constexpr double biquad_a2(double ohm) {
+    return (1.0 - sqrt2 * ohm + ohm * ohm) / biquad_c(ohm);
+}
+}
+
+/// A second order low pass filter with the sample and cutoff frequencies fixed at
+/// compile time. The coefficients are constants shared by every instance, so the
+/// filter holds only its state and apply() does not check its parameters.
+/// The cutoff is CUTOFF_FREQ / CUTOFF_DIVISOR Hz, e.g. LowPassFilter2pConst<float, 400, 25, 10>
+/// is a 2.5Hz filter at 400Hz
+template <class T, uint16_t SAMPLE_FREQ, uint16_t CUTOFF_FREQ, uint16_t CUTOFF_DIVISOR = 1>
+class LowPassFilter2pConst {
+public:
+    static_assert(SAMPLE_FREQ > 0 && CUTOFF_FREQ > 0 && CUTOFF_DIVISOR > 0, "frequencies must be positive");
+    // LowPassFilter2p limits the cutoff to 0.4 of the sample frequency
+    static_assert(uint32_t(CUTOFF_FREQ) * 5 <= uint32_t(SAMPLE_FREQ) * CUTOFF_DIVISOR * 2, "cutoff frequency must be at most 0.4 of the sample frequency");
+
+    LowPassFilter2pConst() {}
+
+    CLASS_NO_COPY(LowPassFilter2pConst);
+
+    static constexpr float get_cutoff_freq(void) { return float(CUTOFF_FREQ) / CUTOFF_DIVISOR; }
+    static constexpr float get_sample_freq(void) { return SAMPLE_FREQ; }
+
+    T apply(const T &sample) {
+        if (!_initialised) {
+            reset(sample);
+        }
+        return step(sample);
+    }
+
+    void reset(void) {
+        _initialised = false;
+    }
+
+    void reset(const T &value) {
+        _delay_element_1 = _delay_element_2 = value * reset_scale;
+        _initialised = true;
+    }
+
+    // apply each of n filters to the corresponding sample
+    static void apply_n(LowPassFilter2pConst *filters, const T *samples, T *outputs, uint16_t n) {
+        for (uint16_t i = 0; i < n; i++) {
+            if (!filters[i]._initialised) {
+                filters[i].reset(samples[i]);
+            }
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            outputs[i] = filters[i].step(samples[i]);
+        }
+    }
+
+    static constexpr float b0 = FilterConst::biquad_b0(FilterConst::biquad_ohm(double(SAMPLE_FREQ) * CUTOFF_DIVISOR, CUTOFF_FREQ));
+    static constexpr float b1 = 2 * b0;
+    static constexpr float b2 = b0;
+    static constexpr float a1 = FilterConst::biquad_a1(FilterConst::biquad_ohm(double(SAMPLE_FREQ) * CUTOFF_DIVISOR, CUTOFF_FREQ));
+    static constexpr float a2 = FilterConst::biquad_a2(FilterConst::biquad_ohm(double(SAMPLE_FREQ) * CUTOFF_DIVISOR, CUTOFF_FREQ));
+
+private:
+    static constexpr double reset_scale = 1.0 / (1 + double(a1) + double(a2));
+
+    T step(const T &sample) {
+        const T delay_element_0 = sample - _delay_element_1 * a1 - _delay_element_2 * a2;
+        const T output = delay_element_0 * b0 + _delay_element_1 * b1 + _delay_element_2 * b2;
+
+        _delay_element_2 = _delay_element_1;
+        _delay_element_1 = delay_element_0;
+
+        return output;
+    }
+
+    T _delay_element_1 = T();
+    T _delay_element_2 = T();
+    bool _initialised = false;
+};
+
+// the coefficients are passed by reference to the vector operators
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr float LowPassFilter2pConst<T,S,C,D>::b0;
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr float LowPassFilter2pConst<T,S,C,D>::b1;
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr float LowPassFilter2pConst<T,S,C,D>::b2;
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr float LowPassFilter2pConst<T,S,C,D>::a1;
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr float LowPassFilter2pConst<T,S,C,D>::a2;
+template <class T, uint16_t S, uint16_t C, uint16_t D> constexpr double LowPassFilter2pConst<T,S,C,D>::reset_scale;
+
 typedef LowPassFilter2p<int>      LowPassFilter2pInt;
 typedef LowPassFilter2p<long>     LowPassFilter2pLong;
 typedef LowPassFilter2p<float>    LowPassFilter2pFloat;
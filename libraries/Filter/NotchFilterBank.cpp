@@ -0,0 +1,197 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#define AP_INLINE_VECTOR_OPS
+#pragma GCC optimize("O2")
+#endif
+
+#include "NotchFilterBank.h"
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define NOTCH_BANK_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NOTCH_BANK_NEON 1
+#endif
+
+// number of Lanes arrays per stage
+static const uint8_t lanes_per_stage = 9;
+
+NotchFilterBank::~NotchFilterBank()
+{
+    delete[] _lanes;
+    delete[] _flags;
+}
+
+bool NotchFilterBank::allocate(uint16_t num_stages)
+{
+    if (num_stages <= _num_stages) {
+        return true;
+    }
+    Lanes *lanes = new Lanes[num_stages * lanes_per_stage]();
+    uint8_t *flags = new uint8_t[num_stages]();
+    if (lanes == nullptr || flags == nullptr) {
+        delete[] lanes;
+        delete[] flags;
+        return false;
+    }
+
+    // each array keeps its existing stages. New stages start zeroed
+    // and inactive, like a newly allocated NotchFilter
+    Lanes *old[lanes_per_stage] { _b0, _b1, _b2, _a1, _a2, _x1, _x2, _y1, _y2 };
+    Lanes **arrays[lanes_per_stage] { &_b0, &_b1, &_b2, &_a1, &_a2, &_x1, &_x2, &_y1, &_y2 };
+    for (uint8_t a=0; a<lanes_per_stage; a++) {
+        *arrays[a] = &lanes[a * num_stages];
+        if (_num_stages > 0) {
+            memcpy(*arrays[a], old[a], _num_stages * sizeof(Lanes));
+        }
+    }
+    if (_num_stages > 0) {
+        memcpy(flags, _flags, _num_stages);
+    }
+
+    delete[] _lanes;
+    delete[] _flags;
+    _lanes = lanes;
+    _flags = flags;
+    _num_stages = num_stages;
+    return true;
+}
+
+void NotchFilterBank::set_stage(uint16_t stage, const NotchFilter<Vector3f> &filter)
+{
+    if (stage >= _num_stages) {
+        return;
+    }
+    for (uint8_t i=0; i<4; i++) {
+        _b0[stage].v[i] = filter.b0;
+        _b1[stage].v[i] = filter.b1;
+        _b2[stage].v[i] = filter.b2;
+        _a1[stage].v[i] = filter.a1;
+        _a2[stage].v[i] = filter.a2;
+    }
+    uint8_t flags = _flags[stage] & STAGE_RESET;
+    if (filter.initialised) {
+        flags |= STAGE_ACTIVE;
+    }
+    if (filter.need_reset) {
+        flags |= STAGE_RESET;
+    }
+    _flags[stage] = flags;
+}
+
+void NotchFilterBank::reset()
+{
+    for (uint16_t i=0; i<_num_stages; i++) {
+        _flags[i] |= STAGE_RESET;
+    }
+}
+
+/*
+  apply a sample to each stage in turn. A stage which is inactive or
+  being reset passes the sample through, setting its state from it,
+  as NotchFilter::apply() does
+ */
+Vector3f NotchFilterBank::apply(const Vector3f &sample, uint16_t num_stages)
+{
+    num_stages = MIN(num_stages, _num_stages);
+
+#if NOTCH_BANK_SSE
+    __m128 in = _mm_set_ps(0, sample.z, sample.y, sample.x);
+    for (uint16_t i=0; i<num_stages; i++) {
+        if (_flags[i] != STAGE_ACTIVE) {
+            _mm_storeu_ps(_x1[i].v, in);
+            _mm_storeu_ps(_x2[i].v, in);
+            _mm_storeu_ps(_y1[i].v, in);
+            _mm_storeu_ps(_y2[i].v, in);
+            _flags[i] &= ~STAGE_RESET;
+            continue;
+        }
+        const __m128 x1 = _mm_loadu_ps(_x1[i].v);
+        const __m128 y1 = _mm_loadu_ps(_y1[i].v);
+        __m128 out = _mm_mul_ps(in, _mm_loadu_ps(_b0[i].v));
+        out = _mm_add_ps(out, _mm_mul_ps(x1, _mm_loadu_ps(_b1[i].v)));
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_loadu_ps(_x2[i].v), _mm_loadu_ps(_b2[i].v)));
+        out = _mm_sub_ps(out, _mm_mul_ps(y1, _mm_loadu_ps(_a1[i].v)));
+        out = _mm_sub_ps(out, _mm_mul_ps(_mm_loadu_ps(_y2[i].v), _mm_loadu_ps(_a2[i].v)));
+        _mm_storeu_ps(_x2[i].v, x1);
+        _mm_storeu_ps(_x1[i].v, in);
+        _mm_storeu_ps(_y2[i].v, y1);
+        _mm_storeu_ps(_y1[i].v, out);
+        in = out;
+    }
+    float result[4];
+    _mm_storeu_ps(result, in);
+    return Vector3f(result[0], result[1], result[2]);
+
+#elif NOTCH_BANK_NEON
+    const float input[4] { sample.x, sample.y, sample.z, 0 };
+    float32x4_t in = vld1q_f32(input);
+    for (uint16_t i=0; i<num_stages; i++) {
+        if (_flags[i] != STAGE_ACTIVE) {
+            vst1q_f32(_x1[i].v, in);
+            vst1q_f32(_x2[i].v, in);
+            vst1q_f32(_y1[i].v, in);
+            vst1q_f32(_y2[i].v, in);
+            _flags[i] &= ~STAGE_RESET;
+            continue;
+        }
+        const float32x4_t x1 = vld1q_f32(_x1[i].v);
+        const float32x4_t y1 = vld1q_f32(_y1[i].v);
+        float32x4_t out = vmulq_f32(in, vld1q_f32(_b0[i].v));
+        out = vaddq_f32(out, vmulq_f32(x1, vld1q_f32(_b1[i].v)));
+        out = vaddq_f32(out, vmulq_f32(vld1q_f32(_x2[i].v), vld1q_f32(_b2[i].v)));
+        out = vsubq_f32(out, vmulq_f32(y1, vld1q_f32(_a1[i].v)));
+        out = vsubq_f32(out, vmulq_f32(vld1q_f32(_y2[i].v), vld1q_f32(_a2[i].v)));
+        vst1q_f32(_x2[i].v, x1);
+        vst1q_f32(_x1[i].v, in);
+        vst1q_f32(_y2[i].v, y1);
+        vst1q_f32(_y1[i].v, out);
+        in = out;
+    }
+    float result[4];
+    vst1q_f32(result, in);
+    return Vector3f(result[0], result[1], result[2]);
+
+#else
+    Lanes in {{ sample.x, sample.y, sample.z, 0 }};
+    for (uint16_t i=0; i<num_stages; i++) {
+        if (_flags[i] != STAGE_ACTIVE) {
+            _x1[i] = _x2[i] = _y1[i] = _y2[i] = in;
+            _flags[i] &= ~STAGE_RESET;
+            continue;
+        }
+        const float b0 = _b0[i].v[0], b1 = _b1[i].v[0], b2 = _b2[i].v[0];
+        const float a1 = _a1[i].v[0], a2 = _a2[i].v[0];
+        Lanes out;
+        for (uint8_t j=0; j<3; j++) {
+            out.v[j] = in.v[j]*b0 + _x1[i].v[j]*b1 + _x2[i].v[j]*b2 - _y1[i].v[j]*a1 - _y2[i].v[j]*a2;
+        }
+        out.v[3] = 0;
+        _x2[i] = _x1[i];
+        _x1[i] = in;
+        _y2[i] = _y1[i];
+        _y1[i] = out;
+        in = out;
+    }
+    return Vector3f(in.v[0], in.v[1], in.v[2]);
+#endif
+}
+
+#endif // AP_FILTER_NOTCH_BANK_ENABLED
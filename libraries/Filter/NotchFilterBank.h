@@ -0,0 +1,78 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a cascade of 3-axis notch filters with the coefficients and state
+  of every notch held in separate contiguous arrays, so the whole
+  cascade is applied in a single pass without touching the
+  NotchFilter objects. With SSE or NEON the three axes of each notch
+  are filtered together.
+
+  The arithmetic is done in the same order as NotchFilter::apply(),
+  so the output is bit for bit the same as applying the notches in
+  turn, provided the compiler does not fuse multiplies and adds in
+  one path and not the other
+ */
+
+#include "AP_Filter_config.h"
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+#include <AP_Math/AP_Math.h>
+#include "NotchFilter.h"
+
+class NotchFilterBank {
+public:
+    ~NotchFilterBank();
+
+    // allocate space for num_stages notches, keeping the state of
+    // the existing notches. Returns false if allocation fails
+    bool allocate(uint16_t num_stages);
+
+    // copy the coefficients of a notch filter into a stage
+    void set_stage(uint16_t stage, const NotchFilter<Vector3f> &filter);
+
+    // reset the state of each stage from the next sample
+    void reset();
+
+    // apply a sample to the first num_stages stages in turn
+    Vector3f apply(const Vector3f &sample, uint16_t num_stages);
+
+    uint16_t get_num_stages() const { return _num_stages; }
+
+private:
+    // one value for each axis, plus an unused lane to make a vector
+    struct Lanes {
+        float v[4];
+    };
+
+    enum StageFlags : uint8_t {
+        STAGE_ACTIVE = 1U<<0,
+        STAGE_RESET = 1U<<1,
+    };
+
+    uint16_t _num_stages;
+
+    // coefficients, copied to every lane
+    Lanes *_b0, *_b1, *_b2, *_a1, *_a2;
+    // last two inputs and outputs of each stage
+    Lanes *_x1, *_x2, *_y1, *_y2;
+    // all of the above in one allocation
+    Lanes *_lanes;
+    uint8_t *_flags;
+};
+
+#endif // AP_FILTER_NOTCH_BANK_ENABLED
@@ -0,0 +1,67 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/NotchFilterBank.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+/*
+  compare applying a cascade of 3-axis notches one NotchFilter at a
+  time with applying the same cascade as a NotchFilterBank. The
+  number of notches covers a single harmonic notch up to per-motor
+  triple notches on an octa
+ */
+
+static const uint16_t max_notches = 48;
+
+static void setup_filters(NotchFilter<Vector3f> *filters, uint16_t num_notches)
+{
+    for (uint16_t i=0; i<num_notches; i++) {
+        filters[i].init(1000, 40 + 9*i, 20, 40);
+    }
+}
+
+static void BM_NotchCascade(benchmark::State& state)
+{
+    const uint16_t num_notches = state.range(0);
+    NotchFilter<Vector3f> filters[max_notches] {};
+    setup_filters(filters, num_notches);
+
+    Vector3f sample { 0.1f, -0.2f, 0.3f };
+    while (state.KeepRunning()) {
+        Vector3f v = sample;
+        for (uint16_t i=0; i<num_notches; i++) {
+            v = filters[i].apply(v);
+        }
+        gbenchmark_escape(&v);
+        sample.x = -sample.x;
+    }
+}
+
+static void BM_NotchBank(benchmark::State& state)
+{
+    const uint16_t num_notches = state.range(0);
+    NotchFilter<Vector3f> filters[max_notches] {};
+    setup_filters(filters, num_notches);
+    NotchFilterBank bank {};
+    bank.allocate(num_notches);
+    for (uint16_t i=0; i<num_notches; i++) {
+        bank.set_stage(i, filters[i]);
+    }
+
+    Vector3f sample { 0.1f, -0.2f, 0.3f };
+    while (state.KeepRunning()) {
+        Vector3f v = bank.apply(sample, num_notches);
+        gbenchmark_escape(&v);
+        sample.x = -sample.x;
+    }
+}
+
+BENCHMARK(BM_NotchCascade)->Arg(8)->Arg(24)->Arg(48);
+BENCHMARK(BM_NotchBank)->Arg(8)->Arg(24)->Arg(48);
+
+#endif // AP_FILTER_NOTCH_BANK_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+/*
+  benchmark of the runtime configured filters against their
+  compile-time LowPassFilter2pConst and DerivativeFilterConst
+  equivalents, reporting the cost in ns per sample
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/DerivativeFilter.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t sample_freq = 1000;
+static const uint16_t cutoff_freq = 80;
+static const uint32_t num_samples = 200000;
+static const uint16_t num_filters = 64;
+
+typedef LowPassFilter2pConst<float, sample_freq, cutoff_freq> LowPassConstFloat;
+typedef LowPassFilter2pConst<Vector3f, sample_freq, cutoff_freq> LowPassConstVector3f;
+typedef DerivativeFilterConst<float, 7, sample_freq> DerivativeConstFloat;
+
+static float input[256];
+static float samples[num_filters];
+static float outputs[num_filters];
+
+// keep the results live so the compiler can't drop the loops
+static volatile float sink;
+
+// samples come from a precomputed table so the signal generation
+// doesn't dominate the timing
+static float sample_at(uint32_t i)
+{
+    return input[i & 0xFF];
+}
+
+static void report(const char *name, uint64_t elapsed_us, uint32_t count)
+{
+    hal.console->printf("%-28s %7.2f ns/sample\n", name, elapsed_us * 1.0e3 / count);
+}
+
+static void bench_lowpass(void)
+{
+    LowPassFilter2pFloat runtime(sample_freq, cutoff_freq);
+    LowPassConstFloat fixed;
+    float sum = 0;
+
+    uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        sum += runtime.apply(sample_at(i));
+    }
+    report("LowPassFilter2pFloat", AP_HAL::micros64() - start_us, num_samples);
+
+    start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        sum += fixed.apply(sample_at(i));
+    }
+    report("LowPassFilter2pConst<float>", AP_HAL::micros64() - start_us, num_samples);
+    sink = sum;
+}
+
+static void bench_lowpass_vector(void)
+{
+    LowPassFilter2pVector3f runtime(sample_freq, cutoff_freq);
+    LowPassConstVector3f fixed;
+    Vector3f sum;
+
+    uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        const float s = sample_at(i);
+        sum += runtime.apply(Vector3f(s, -s, 0.5f * s));
+    }
+    report("LowPassFilter2pVector3f", AP_HAL::micros64() - start_us, num_samples);
+
+    start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        const float s = sample_at(i);
+        sum += fixed.apply(Vector3f(s, -s, 0.5f * s));
+    }
+    report("LowPassFilter2pConst<Vec3f>", AP_HAL::micros64() - start_us, num_samples);
+    sink = sum.x + sum.y + sum.z;
+}
+
+static void bench_lowpass_bank(void)
+{
+    static LowPassConstFloat filters[num_filters];
+    const uint32_t rounds = num_samples / num_filters;
+    float sum = 0;
+
+    for (uint16_t j = 0; j < num_filters; j++) {
+        samples[j] = sample_at(j);
+    }
+
+    uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < rounds; i++) {
+        for (uint16_t j = 0; j < num_filters; j++) {
+            outputs[j] = filters[j].apply(samples[j]);
+        }
+        sum += outputs[i % num_filters];
+    }
+    report("Const bank, apply() loop", AP_HAL::micros64() - start_us, rounds * num_filters);
+
+    for (uint16_t j = 0; j < num_filters; j++) {
+        filters[j].reset();
+    }
+
+    start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < rounds; i++) {
+        LowPassConstFloat::apply_n(filters, samples, outputs, num_filters);
+        sum += outputs[i % num_filters];
+    }
+    report("Const bank, apply_n()", AP_HAL::micros64() - start_us, rounds * num_filters);
+    sink = sum;
+}
+
+static void bench_derivative(void)
+{
+    DerivativeFilterFloat_Size7 runtime;
+    DerivativeConstFloat fixed;
+    const uint32_t dt_us = 1000000UL / sample_freq;
+    float sum = 0;
+
+    uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        runtime.update(sample_at(i), i * dt_us);
+        sum += runtime.slope();
+    }
+    report("DerivativeFilterFloat_Size7", AP_HAL::micros64() - start_us, num_samples);
+
+    start_us = AP_HAL::micros64();
+    for (uint32_t i = 0; i < num_samples; i++) {
+        sum += fixed.apply(sample_at(i));
+    }
+    report("DerivativeFilterConst<7>", AP_HAL::micros64() - start_us, num_samples);
+    sink = sum;
+}
+
+void setup(void)
+{
+    for (uint16_t i = 0; i < ARRAY_SIZE(input); i++) {
+        input[i] = sinf(i * (2 * M_PI * 35 / sample_freq)) + 0.1f * sinf(i * (2 * M_PI * 310 / sample_freq));
+    }
+    hal.console->printf("Filter benchmark, %u Hz sample rate, %u Hz cutoff\n",
+                        (unsigned)sample_freq, (unsigned)cutoff_freq);
+}
+
+void loop(void)
+{
+    bench_lowpass();
+    bench_lowpass_vector();
+    bench_lowpass_bank();
+    bench_derivative();
+    hal.console->printf("\n");
+    hal.scheduler->delay(1000);
+}
+
+const struct AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
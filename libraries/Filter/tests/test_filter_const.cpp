@@ -0,0 +1,153 @@
+#include <AP_gtest.h>
+
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/DerivativeFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// repeatable random value in the range -1 to 1
+static float rand_value(uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+/*
+  compile time coefficients match those calculated at run time
+ */
+template <uint16_t SAMPLE_FREQ, uint16_t CUTOFF_FREQ, uint16_t CUTOFF_DIVISOR>
+static void check_coefficients()
+{
+    typedef LowPassFilter2pConst<float, SAMPLE_FREQ, CUTOFF_FREQ, CUTOFF_DIVISOR> Filter;
+    DigitalBiquadFilter<float>::biquad_params params;
+    DigitalBiquadFilter<float>::compute_params(SAMPLE_FREQ, float(CUTOFF_FREQ) / CUTOFF_DIVISOR, params);
+    EXPECT_FLOAT_EQ(Filter::get_cutoff_freq(), params.cutoff_freq);
+    EXPECT_FLOAT_EQ(Filter::get_sample_freq(), params.sample_freq);
+    EXPECT_NEAR(Filter::b0, params.b0, 1.0e-6f * fabsf(params.b0));
+    EXPECT_NEAR(Filter::b1, params.b1, 1.0e-6f * fabsf(params.b1));
+    EXPECT_NEAR(Filter::b2, params.b2, 1.0e-6f * fabsf(params.b2));
+    EXPECT_NEAR(Filter::a1, params.a1, 1.0e-6f * fabsf(params.a1));
+    EXPECT_NEAR(Filter::a2, params.a2, 1.0e-6f * fabsf(params.a2));
+}
+
+TEST(FilterConstTest, LowPassCoefficients)
+{
+    check_coefficients<400, 20, 1>();
+    check_coefficients<400, 25, 10>();
+    check_coefficients<1000, 80, 1>();
+    check_coefficients<1000, 400, 1>();
+    check_coefficients<50, 1, 2>();
+}
+
+TEST(FilterConstTest, LowPassMatchesRuntime)
+{
+    LowPassFilter2pFloat filter(400, 20);
+    LowPassFilter2pConst<float, 400, 20> filter_const;
+    LowPassFilter2pVector3f vfilter(400, 20);
+    LowPassFilter2pConst<Vector3f, 400, 20> vfilter_const;
+    // the run time filters don't clear their state when constructed
+    filter.reset();
+    vfilter.reset();
+
+    uint32_t seed = 1;
+    for (uint16_t i = 0; i < 2000; i++) {
+        const float sample = 10 + rand_value(seed);
+        const float out = filter_const.apply(sample);
+        EXPECT_NEAR(out, filter.apply(sample), 1.0e-4f);
+        const Vector3f vsample { sample, -sample, 2 * sample };
+        const Vector3f vout = vfilter_const.apply(vsample);
+        const Vector3f expected = vfilter.apply(vsample);
+        EXPECT_NEAR(vout.x, expected.x, 1.0e-4f);
+        EXPECT_NEAR(vout.y, expected.y, 1.0e-4f);
+        EXPECT_NEAR(vout.z, expected.z, 3.0e-4f);
+        if (i == 1000) {
+            filter.reset(3);
+            filter_const.reset(3);
+            vfilter.reset();
+            vfilter_const.reset();
+        }
+    }
+}
+
+TEST(FilterConstTest, LowPassApplyN)
+{
+    const uint16_t n = 17;
+    LowPassFilter2pConst<float, 1000, 50> filters[n];
+    LowPassFilter2pConst<float, 1000, 50> batched[n];
+    float samples[n];
+    float outputs[n];
+
+    uint32_t seed = 2;
+    for (uint16_t i = 0; i < 500; i++) {
+        for (uint16_t j = 0; j < n; j++) {
+            samples[j] = j + rand_value(seed);
+        }
+        LowPassFilter2pConst<float, 1000, 50>::apply_n(batched, samples, outputs, n);
+        for (uint16_t j = 0; j < n; j++) {
+            const float expected = filters[j].apply(samples[j]);
+            EXPECT_FLOAT_EQ(outputs[j], expected);
+        }
+    }
+}
+
+/*
+  with uniformly spaced timestamps the fixed rate derivative matches
+  DerivativeFilter
+ */
+template <uint8_t FILTER_SIZE>
+static void check_derivative()
+{
+    // static so that the timestamps start zeroed
+    static DerivativeFilter<float, FILTER_SIZE> filter;
+    DerivativeFilterConst<float, FILTER_SIZE, 50> filter_const;
+
+    uint32_t seed = 3;
+    for (uint16_t i = 0; i < 200; i++) {
+        // timestamps in ms give a slope per ms
+        const float sample = 3 * sinf(i * 0.05f) + 0.01f * rand_value(seed);
+        filter.update(sample, 1000 + i * 20);
+        filter_const.update(sample);
+        if (i < FILTER_SIZE - 1) {
+            // DerivativeFilter starts calculating one sample early
+            continue;
+        }
+        const float expected = filter.slope() * 1000;
+        EXPECT_NEAR(filter_const.slope(), expected, 1.0e-3f) << "size " << int(FILTER_SIZE) << " sample " << i;
+    }
+
+    // a ramp has a constant slope
+    filter_const.reset();
+    for (uint16_t i = 0; i < FILTER_SIZE; i++) {
+        EXPECT_FLOAT_EQ(filter_const.slope(), 0);
+        filter_const.update(i * 0.1f);
+    }
+    EXPECT_NEAR(filter_const.slope(), 5, 1.0e-4f);
+}
+
+TEST(FilterConstTest, DerivativeMatchesRuntime)
+{
+    check_derivative<5>();
+    check_derivative<7>();
+    check_derivative<9>();
+    check_derivative<11>();
+}
+
+TEST(FilterConstTest, DerivativeApplyN)
+{
+    DerivativeFilterConst<Vector3f, 7, 400> filters[4];
+    Vector3f samples[4];
+    Vector3f slopes[4];
+    for (uint16_t i = 0; i < 20; i++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            samples[j] = Vector3f(i, -i * 2.0f, j) / 400;
+        }
+        DerivativeFilterConst<Vector3f, 7, 400>::apply_n(filters, samples, slopes, 4);
+    }
+    for (uint8_t j = 0; j < 4; j++) {
+        EXPECT_NEAR(slopes[j].x, 1, 1.0e-4f);
+        EXPECT_NEAR(slopes[j].y, -2, 1.0e-4f);
+        EXPECT_NEAR(slopes[j].z, 0, 1.0e-4f);
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,159 @@
+#include <AP_gtest.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/HarmonicNotchFilter.h>
+#include <Filter/NotchFilterBank.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+static const float rate_hz = 1000;
+
+// repeatable random value in the range -1 to 1
+static float rand_value(uint32_t &seed)
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+static bool same_bits(const Vector3f &v1, const Vector3f &v2)
+{
+    return memcmp(&v1, &v2, sizeof(v1)) == 0;
+}
+
+/*
+  a bank must give exactly the same output as applying its notches in
+  turn, through frequency changes, resets and changes in the number
+  of notches applied
+ */
+TEST(NotchFilterBankTest, MatchesCascade)
+{
+    const uint16_t num_notches = 24;
+    NotchFilter<Vector3f> filters[num_notches] {};
+    NotchFilterBank bank {};
+    ASSERT_TRUE(bank.allocate(num_notches));
+    EXPECT_EQ(bank.get_num_stages(), num_notches);
+
+    float A, Q;
+    NotchFilter<Vector3f>::calculate_A_and_Q(80, 40, 40, A, Q);
+
+    uint32_t seed = 1;
+    uint16_t num_active = num_notches;
+    for (uint32_t s=0; s<20000; s++) {
+        if (s % 100 == 0) {
+            // move the notches, leaving some above nyquist so they
+            // pass samples through
+            const float base_freq = 60 + 40 * rand_value(seed);
+            for (uint16_t i=0; i<num_notches; i++) {
+                filters[i].init_with_A_and_Q(rate_hz, base_freq * (1 + i/3), A, Q);
+                bank.set_stage(i, filters[i]);
+            }
+        }
+        if (s % 1000 == 500) {
+            for (auto &f : filters) {
+                f.reset();
+            }
+            bank.reset();
+        }
+        if (s % 700 == 0) {
+            num_active = num_notches/2 + (seed >> 8) % (num_notches/2 + 1);
+        }
+
+        const Vector3f sample { rand_value(seed), rand_value(seed), rand_value(seed) };
+        Vector3f expected = sample;
+        for (uint16_t i=0; i<num_active; i++) {
+            expected = filters[i].apply(expected);
+        }
+        const Vector3f output = bank.apply(sample, num_active);
+        if (!same_bits(output, expected)) {
+            ADD_FAILURE() << "sample " << s << " output " << output.x << "," << output.y << "," << output.z
+                          << " expected " << expected.x << "," << expected.y << "," << expected.z;
+            return;
+        }
+    }
+}
+
+/*
+  expanding a bank keeps the state of the existing notches
+ */
+TEST(NotchFilterBankTest, Expand)
+{
+    NotchFilter<Vector3f> filters[8] {};
+    NotchFilterBank bank {};
+    ASSERT_TRUE(bank.allocate(4));
+    for (uint16_t i=0; i<8; i++) {
+        filters[i].init(rate_hz, 50*(i+1), 20, 30);
+    }
+    for (uint16_t i=0; i<4; i++) {
+        bank.set_stage(i, filters[i]);
+    }
+
+    uint32_t seed = 7;
+    for (uint32_t s=0; s<2000; s++) {
+        if (s == 1000) {
+            ASSERT_TRUE(bank.allocate(8));
+            for (uint16_t i=4; i<8; i++) {
+                bank.set_stage(i, filters[i]);
+            }
+        }
+        const uint16_t n = bank.get_num_stages();
+        const Vector3f sample { rand_value(seed), rand_value(seed), rand_value(seed) };
+        Vector3f expected = sample;
+        for (uint16_t i=0; i<n; i++) {
+            expected = filters[i].apply(expected);
+        }
+        ASSERT_TRUE(same_bits(bank.apply(sample, n), expected));
+    }
+}
+
+/*
+  a 3-axis harmonic notch filter, which uses a bank, must match a
+  single axis harmonic notch filter on each axis
+ */
+TEST(NotchFilterBankTest, HarmonicNotch)
+{
+    HarmonicNotchFilter<Vector3f> filter3 {};
+    HarmonicNotchFilter<float> filter1[3] {};
+
+    filter3.allocate_filters(4, 0x0F, 3);
+    filter3.init(rate_hz, 80, 40, 40);
+    for (auto &f : filter1) {
+        f.allocate_filters(4, 0x0F, 3);
+        f.init(rate_hz, 80, 40, 40);
+    }
+
+    uint32_t seed = 3;
+    float centers[4] { 80, 80, 80, 80 };
+    for (uint32_t s=0; s<20000; s++) {
+        if (s % 10 == 0) {
+            // motors changing speed, with one sometimes stopped
+            for (uint8_t c=0; c<4; c++) {
+                centers[c] = constrain_float(centers[c] + 5 * rand_value(seed), 30, 200);
+            }
+            const uint8_t num_centers = (s % 3000 < 1500) ? 4 : 3;
+            filter3.update(num_centers, centers);
+            for (auto &f : filter1) {
+                f.update(num_centers, centers);
+            }
+        }
+        if (s % 5000 == 2500) {
+            filter3.reset();
+            for (auto &f : filter1) {
+                f.reset();
+            }
+        }
+        const Vector3f sample { rand_value(seed), rand_value(seed), rand_value(seed) };
+        const Vector3f output = filter3.apply(sample);
+        const Vector3f expected { filter1[0].apply(sample.x), filter1[1].apply(sample.y), filter1[2].apply(sample.z) };
+        if (!same_bits(output, expected)) {
+            ADD_FAILURE() << "sample " << s << " output " << output.x << "," << output.y << "," << output.z
+                          << " expected " << expected.x << "," << expected.y << "," << expected.z;
+            return;
+        }
+    }
+}
+
+#endif // AP_FILTER_NOTCH_BANK_ENABLED
+
+AP_GTEST_MAIN()
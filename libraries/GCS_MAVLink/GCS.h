@@ -305,9 +305,12 @@ public:
         return GCS_MAVLINK::active_channel_mask() & (1 << (chan-MAVLINK_COMM_0));
     }
     bool is_streaming() const {
-        return sending_bucket_id != no_bucket_to_send;
+        return num_scheduled_messages > num_critical_messages;
     }
 
+    // requested and achieved rates of each scheduled message
+    void stream_info(ExpandingString &str) const;
+
     mavlink_channel_t get_chan() const { return chan; }
     uint32_t get_last_heartbeat_time() const { return last_heartbeat_time; };
 
@@ -807,45 +810,78 @@ private:
     // last reported radio buffer percent available
     uint8_t          last_txbuf = 100;
 
-    // outbound ("deferred message") queue.
-
-    // "special" messages such as heartbeat, next_param etc are stored
-    // separately to stream-rated messages like AHRS2 etc.  If these
-    // were to be stored in buckets then they would be slowed down
-    // based on stream_slowdown, which we have not traditionally done.
-    struct deferred_message_t {
-        const ap_message id;
-        uint16_t interval_ms;
-        uint16_t last_sent_ms; // from AP_HAL::millis16()
-    } deferred_message[3] = {
-        { MSG_HEARTBEAT, },
-        { MSG_NEXT_PARAM, },
-#if HAL_HIGH_LATENCY2_ENABLED
-        { MSG_HIGH_LATENCY2, },
-#endif
+    // outbound message scheduler.  Every message with an interval
+    // has an entry in scheduled_message[].  Critical messages such as
+    // heartbeat and next_param are sent on their own clock ahead of
+    // everything else, and are not slowed down by stream_slowdown,
+    // which we have not traditionally done.  When the link can't
+    // keep up with the other messages the one which has waited the
+    // most intervals, weighted by its priority, is sent first, so
+    // higher priority messages get their rates before lower priority
+    // ones rather than by their position in the enum.
+    enum class MessagePriority : uint8_t {
+        LOW = 0,
+        NORMAL = 1,
+        HIGH = 2,
+        CRITICAL = 3,
     };
-    // returns index of id in deferred_message[] or -1 if not present
-    int8_t get_deferred_message_index(const ap_message id) const;
-    // returns index of a message in deferred_message[] which should
-    // be sent (or -1 if none to send at the moment)
-    int8_t deferred_message_to_send_index(uint16_t now16_ms);
-    // cache of which deferred message should be sent next:
-    int8_t next_deferred_message_to_send_cache = -1;
-
-    struct deferred_message_bucket_t {
-        Bitmask<MSG_LAST> ap_message_ids;
-        uint16_t interval_ms;
-        uint16_t last_sent_ms; // from AP_HAL::millis16()
-    };
-    deferred_message_bucket_t deferred_message_bucket[10];
-    static const uint8_t no_bucket_to_send = -1;
-    static const ap_message no_message_to_send = (ap_message)-1;
-    uint8_t sending_bucket_id = no_bucket_to_send;
-    Bitmask<MSG_LAST> bucket_message_ids_to_send;
+    static MessagePriority get_ap_message_priority(const ap_message id);
 
-    ap_message next_deferred_bucket_message_to_send(uint16_t now16_ms);
-    void find_next_bucket_to_send(uint16_t now16_ms);
-    void remove_message_from_bucket(int8_t bucket, ap_message id);
+    struct scheduled_message_t {
+        ap_message id;
+        MessagePriority priority;
+        uint16_t interval_ms;      // requested interval
+        uint16_t last_sent_ms;     // from AP_HAL::millis16()
+        uint16_t bytes;            // bytes written the last time it was sent
+        uint16_t sent;             // sends in the current rate window
+        uint16_t sent_last_window; // sends in the last rate window
+    };
+    // critical messages are kept at the start of the array, the
+    // streamed messages after them.  The array is allocated as
+    // messages are scheduled, so a link only uses memory for the
+    // messages it sends
+    scheduled_message_t *scheduled_message;
+    uint8_t scheduled_message_size;
+    uint8_t num_scheduled_messages;
+    uint8_t num_critical_messages;
+    static const uint8_t no_message_to_send = -1;
+
+    // returns the index of id in scheduled_message[], or
+    // no_message_to_send if it isn't scheduled
+    uint8_t find_scheduled_message(const ap_message id) const;
+    // returns a new entry for id, nullptr if there is no room
+    scheduled_message_t *add_scheduled_message(const ap_message id);
+    void remove_scheduled_message(const ap_message id);
+    // make room for more scheduled messages, false if there is none
+    bool expand_scheduled_messages();
+
+    // returns index in scheduled_message[] of the next critical
+    // message to send, or no_message_to_send
+    uint8_t next_critical_message_to_send(uint16_t now16_ms);
+    // returns index in scheduled_message[] of the next streamed
+    // message to send, or no_message_to_send
+    uint8_t next_streamed_message_to_send(uint16_t now16_ms);
+    // move the scheduled time of a message on after sending it
+    void reschedule_message(scheduled_message_t &msg, uint16_t interval_ms, uint16_t now16_ms);
+    // no streamed message is due before this time, from
+    // AP_HAL::millis16()
+    uint16_t next_streamed_message_check_ms;
+    // a streamed message this far overdue is sent ahead of higher
+    // priority messages, and well before millis16() wraps
+    static const uint16_t stream_max_overdue_ms = 2000;
+
+    // achieved rates are measured over windows of this length
+    static const uint16_t stream_rate_window_ms = 5000;
+    uint32_t stream_rate_window_start_ms;
+    uint16_t stream_rate_last_window_ms;
+    uint32_t stream_rate_window_start_bytes;
+    uint32_t stream_rate_last_window_bytes;
+    // times a streamed message had to wait because the link was full
+    uint32_t stream_saturated_count;
+    void update_stream_rate_window(uint32_t now_ms);
+
+    // bytes written by the last call to do_try_send_message
+    uint16_t last_try_send_bytes;
 
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
@@ -870,6 +906,9 @@ private:
     // try_send_message, will cause a mavlink message with that id to
     // be emitted.  Returns MSG_LAST if no such mapping exists.
     ap_message mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const;
+    // map an ap_message to the id of the mavlink message it sends.
+    // Returns -1 if no such mapping exists.
+    static int32_t ap_message_id_to_mavlink_id(const ap_message id);
     // set the interval at which an ap_message should be emitted (in ms)
     bool set_ap_message_interval(enum ap_message id, uint16_t interval_ms);
     // call set_ap_message_interval for each entry in a stream,
@@ -887,10 +926,13 @@ private:
     // read file, set message intervals from it:
     void get_intervals_from_filepath(const char *path, DefaultIntervalsFromFiles &);
 #endif
-    // return interval deferred message bucket should be sent after.
-    // When sending parameters and waypoints this may be longer than
-    // the interval specified in "deferred"
-    uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
+    // return interval a streamed message should be sent after.  When
+    // sending parameters and waypoints this may be longer than the
+    // interval requested for it
+    uint16_t get_reschedule_interval_ms(uint16_t interval_ms, uint8_t multiplier) const;
+    // returns the factor stream intervals are multiplied by while
+    // the link is busy with parameters, waypoints or ftp
+    uint8_t get_reschedule_interval_multiplier() const;
 
     bool do_try_send_message(const ap_message id);
 
@@ -1083,7 +1125,7 @@ private:
         uint16_t statustext_last_sent_ms;
         uint32_t behind;
         uint32_t out_of_time;
-        uint16_t fnbts_maxtime;
+        uint16_t select_maxtime;
         uint32_t max_retry_deferred_body_us;
         uint8_t max_retry_deferred_body_type;
     } try_send_message_stats;
@@ -1174,6 +1216,8 @@ public:
     virtual const GCS_MAVLINK *chan(const uint8_t ofs) const = 0;
     // return the number of valid GCS objects
     uint8_t num_gcs() const { return _num_gcs; };
+    // requested and achieved message rates for @SYS/streams.txt
+    void stream_info(ExpandingString &str) const;
     void send_message(enum ap_message id);
     void send_mission_item_reached_message(uint16_t mission_index);
     void send_named_float(const char *name, float value) const;
@@ -47,6 +47,7 @@
 #include <AP_RCTelemetry/AP_Spektrum_Telem.h>
 #include <AP_Mount/AP_Mount.h>
 #include <AP_Common/AP_FWVersion.h>
+#include <AP_Common/ExpandingString.h>
 #include <AP_VisualOdom/AP_VisualOdom.h>
 #include <AP_Baro/AP_Baro.h>
 #include <AP_EFI/AP_EFI.h>
@@ -945,156 +946,170 @@ void GCS_MAVLINK::handle_mission_item(const mavlink_message_t &msg)
     prot->handle_mission_item(msg, mission_item_int);
 }
 
-ap_message GCS_MAVLINK::mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const
-{
-    // MSG_NEXT_MISSION_REQUEST doesn't correspond to a mavlink message directly.
-    // It is used to request the next waypoint after receiving one.
+// map between ap_message and the mavlink message it sends
 
-    // MSG_NEXT_PARAM doesn't correspond to a mavlink message directly.
-    // It is used to send the next parameter in a stream after sending one
+// MSG_NEXT_MISSION_REQUEST doesn't correspond to a mavlink message directly.
+// It is used to request the next waypoint after receiving one.
 
-    // MSG_NAMED_FLOAT messages can't really be "streamed"...
+// MSG_NEXT_PARAM doesn't correspond to a mavlink message directly.
+// It is used to send the next parameter in a stream after sending one
 
-    static const struct {
-        uint32_t mavlink_id;
-        ap_message msg_id;
-    } map[] {
-        { MAVLINK_MSG_ID_HEARTBEAT,             MSG_HEARTBEAT},
-        { MAVLINK_MSG_ID_ATTITUDE,              MSG_ATTITUDE},
-        { MAVLINK_MSG_ID_ATTITUDE_QUATERNION,   MSG_ATTITUDE_QUATERNION},
-        { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,   MSG_LOCATION},
-        { MAVLINK_MSG_ID_HOME_POSITION,         MSG_HOME},
-        { MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN,     MSG_ORIGIN},
-        { MAVLINK_MSG_ID_SYS_STATUS,            MSG_SYS_STATUS},
-        { MAVLINK_MSG_ID_POWER_STATUS,          MSG_POWER_STATUS},
+// MSG_NAMED_FLOAT messages can't really be "streamed"...
+
+static const struct {
+    uint32_t mavlink_id;
+    ap_message msg_id;
+} ap_message_mavlink_ids[] {
+    { MAVLINK_MSG_ID_HEARTBEAT,             MSG_HEARTBEAT},
+    { MAVLINK_MSG_ID_ATTITUDE,              MSG_ATTITUDE},
+    { MAVLINK_MSG_ID_ATTITUDE_QUATERNION,   MSG_ATTITUDE_QUATERNION},
+    { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,   MSG_LOCATION},
+    { MAVLINK_MSG_ID_HOME_POSITION,         MSG_HOME},
+    { MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN,     MSG_ORIGIN},
+    { MAVLINK_MSG_ID_SYS_STATUS,            MSG_SYS_STATUS},
+    { MAVLINK_MSG_ID_POWER_STATUS,          MSG_POWER_STATUS},
 #if HAL_WITH_MCU_MONITORING
-        { MAVLINK_MSG_ID_MCU_STATUS,            MSG_MCU_STATUS},
-#endif
-        { MAVLINK_MSG_ID_MEMINFO,               MSG_MEMINFO},
-        { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, MSG_NAV_CONTROLLER_OUTPUT},
-        { MAVLINK_MSG_ID_MISSION_CURRENT,       MSG_CURRENT_WAYPOINT},
-        { MAVLINK_MSG_ID_VFR_HUD,               MSG_VFR_HUD},
-        { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,      MSG_SERVO_OUTPUT_RAW},
-        { MAVLINK_MSG_ID_RC_CHANNELS,           MSG_RC_CHANNELS},
-        { MAVLINK_MSG_ID_RC_CHANNELS_RAW,       MSG_RC_CHANNELS_RAW},
-        { MAVLINK_MSG_ID_RAW_IMU,               MSG_RAW_IMU},
-        { MAVLINK_MSG_ID_SCALED_IMU,            MSG_SCALED_IMU},
-        { MAVLINK_MSG_ID_SCALED_IMU2,           MSG_SCALED_IMU2},
-        { MAVLINK_MSG_ID_SCALED_IMU3,           MSG_SCALED_IMU3},
-        { MAVLINK_MSG_ID_SCALED_PRESSURE,       MSG_SCALED_PRESSURE},
-        { MAVLINK_MSG_ID_SCALED_PRESSURE2,      MSG_SCALED_PRESSURE2},
-        { MAVLINK_MSG_ID_SCALED_PRESSURE3,      MSG_SCALED_PRESSURE3},
+    { MAVLINK_MSG_ID_MCU_STATUS,            MSG_MCU_STATUS},
+#endif
+    { MAVLINK_MSG_ID_MEMINFO,               MSG_MEMINFO},
+    { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, MSG_NAV_CONTROLLER_OUTPUT},
+    { MAVLINK_MSG_ID_MISSION_CURRENT,       MSG_CURRENT_WAYPOINT},
+    { MAVLINK_MSG_ID_VFR_HUD,               MSG_VFR_HUD},
+    { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,      MSG_SERVO_OUTPUT_RAW},
+    { MAVLINK_MSG_ID_RC_CHANNELS,           MSG_RC_CHANNELS},
+    { MAVLINK_MSG_ID_RC_CHANNELS_RAW,       MSG_RC_CHANNELS_RAW},
+    { MAVLINK_MSG_ID_RAW_IMU,               MSG_RAW_IMU},
+    { MAVLINK_MSG_ID_SCALED_IMU,            MSG_SCALED_IMU},
+    { MAVLINK_MSG_ID_SCALED_IMU2,           MSG_SCALED_IMU2},
+    { MAVLINK_MSG_ID_SCALED_IMU3,           MSG_SCALED_IMU3},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE,       MSG_SCALED_PRESSURE},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE2,      MSG_SCALED_PRESSURE2},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE3,      MSG_SCALED_PRESSURE3},
 #if AP_GPS_ENABLED
-        { MAVLINK_MSG_ID_GPS_RAW_INT,           MSG_GPS_RAW},
-        { MAVLINK_MSG_ID_GPS_RTK,               MSG_GPS_RTK},
+    { MAVLINK_MSG_ID_GPS_RAW_INT,           MSG_GPS_RAW},
+    { MAVLINK_MSG_ID_GPS_RTK,               MSG_GPS_RTK},
 #if GPS_MAX_RECEIVERS > 1
-        { MAVLINK_MSG_ID_GPS2_RAW,              MSG_GPS2_RAW},
-        { MAVLINK_MSG_ID_GPS2_RTK,              MSG_GPS2_RTK},
+    { MAVLINK_MSG_ID_GPS2_RAW,              MSG_GPS2_RAW},
+    { MAVLINK_MSG_ID_GPS2_RTK,              MSG_GPS2_RTK},
 #endif
 #endif
-        { MAVLINK_MSG_ID_SYSTEM_TIME,           MSG_SYSTEM_TIME},
-        { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,    MSG_SERVO_OUT},
-        { MAVLINK_MSG_ID_PARAM_VALUE,           MSG_NEXT_PARAM},
+    { MAVLINK_MSG_ID_SYSTEM_TIME,           MSG_SYSTEM_TIME},
+    { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,    MSG_SERVO_OUT},
+    { MAVLINK_MSG_ID_PARAM_VALUE,           MSG_NEXT_PARAM},
 #if AP_FENCE_ENABLED
-        { MAVLINK_MSG_ID_FENCE_STATUS,          MSG_FENCE_STATUS},
+    { MAVLINK_MSG_ID_FENCE_STATUS,          MSG_FENCE_STATUS},
 #endif
-        { MAVLINK_MSG_ID_AHRS,                  MSG_AHRS},
+    { MAVLINK_MSG_ID_AHRS,                  MSG_AHRS},
 #if AP_SIM_ENABLED
-        { MAVLINK_MSG_ID_SIMSTATE,              MSG_SIMSTATE},
-        { MAVLINK_MSG_ID_SIM_STATE,             MSG_SIM_STATE},
+    { MAVLINK_MSG_ID_SIMSTATE,              MSG_SIMSTATE},
+    { MAVLINK_MSG_ID_SIM_STATE,             MSG_SIM_STATE},
 #endif
-        { MAVLINK_MSG_ID_AHRS2,                 MSG_AHRS2},
-        { MAVLINK_MSG_ID_HWSTATUS,              MSG_HWSTATUS},
-        { MAVLINK_MSG_ID_WIND,                  MSG_WIND},
+    { MAVLINK_MSG_ID_AHRS2,                 MSG_AHRS2},
+    { MAVLINK_MSG_ID_HWSTATUS,              MSG_HWSTATUS},
+    { MAVLINK_MSG_ID_WIND,                  MSG_WIND},
 #if AP_RANGEFINDER_ENABLED
-        { MAVLINK_MSG_ID_RANGEFINDER,           MSG_RANGEFINDER},
+    { MAVLINK_MSG_ID_RANGEFINDER,           MSG_RANGEFINDER},
 #endif
-        { MAVLINK_MSG_ID_DISTANCE_SENSOR,       MSG_DISTANCE_SENSOR},
-            // request also does report:
-        { MAVLINK_MSG_ID_TERRAIN_REQUEST,       MSG_TERRAIN},
+    { MAVLINK_MSG_ID_DISTANCE_SENSOR,       MSG_DISTANCE_SENSOR},
+        // request also does report:
+    { MAVLINK_MSG_ID_TERRAIN_REQUEST,       MSG_TERRAIN},
 #if AP_MAVLINK_BATTERY2_ENABLED
-        { MAVLINK_MSG_ID_BATTERY2,              MSG_BATTERY2},
+    { MAVLINK_MSG_ID_BATTERY2,              MSG_BATTERY2},
 #endif
 #if AP_CAMERA_ENABLED
-        { MAVLINK_MSG_ID_CAMERA_FEEDBACK,       MSG_CAMERA_FEEDBACK},
-        { MAVLINK_MSG_ID_CAMERA_INFORMATION,    MSG_CAMERA_INFORMATION},
-        { MAVLINK_MSG_ID_CAMERA_SETTINGS,       MSG_CAMERA_SETTINGS},
-        { MAVLINK_MSG_ID_CAMERA_FOV_STATUS,     MSG_CAMERA_FOV_STATUS},
-        { MAVLINK_MSG_ID_CAMERA_CAPTURE_STATUS, MSG_CAMERA_CAPTURE_STATUS},
+    { MAVLINK_MSG_ID_CAMERA_FEEDBACK,       MSG_CAMERA_FEEDBACK},
+    { MAVLINK_MSG_ID_CAMERA_INFORMATION,    MSG_CAMERA_INFORMATION},
+    { MAVLINK_MSG_ID_CAMERA_SETTINGS,       MSG_CAMERA_SETTINGS},
+    { MAVLINK_MSG_ID_CAMERA_FOV_STATUS,     MSG_CAMERA_FOV_STATUS},
+    { MAVLINK_MSG_ID_CAMERA_CAPTURE_STATUS, MSG_CAMERA_CAPTURE_STATUS},
 #endif
 #if HAL_MOUNT_ENABLED
-        { MAVLINK_MSG_ID_GIMBAL_DEVICE_ATTITUDE_STATUS, MSG_GIMBAL_DEVICE_ATTITUDE_STATUS},
-        { MAVLINK_MSG_ID_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE, MSG_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE},
-        { MAVLINK_MSG_ID_GIMBAL_MANAGER_INFORMATION, MSG_GIMBAL_MANAGER_INFORMATION},
-        { MAVLINK_MSG_ID_GIMBAL_MANAGER_STATUS, MSG_GIMBAL_MANAGER_STATUS},
+    { MAVLINK_MSG_ID_GIMBAL_DEVICE_ATTITUDE_STATUS, MSG_GIMBAL_DEVICE_ATTITUDE_STATUS},
+    { MAVLINK_MSG_ID_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE, MSG_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE},
+    { MAVLINK_MSG_ID_GIMBAL_MANAGER_INFORMATION, MSG_GIMBAL_MANAGER_INFORMATION},
+    { MAVLINK_MSG_ID_GIMBAL_MANAGER_STATUS, MSG_GIMBAL_MANAGER_STATUS},
 #endif
 #if AP_OPTICALFLOW_ENABLED
-        { MAVLINK_MSG_ID_OPTICAL_FLOW,          MSG_OPTICAL_FLOW},
+    { MAVLINK_MSG_ID_OPTICAL_FLOW,          MSG_OPTICAL_FLOW},
 #endif
 #if COMPASS_CAL_ENABLED
-        { MAVLINK_MSG_ID_MAG_CAL_PROGRESS,      MSG_MAG_CAL_PROGRESS},
-        { MAVLINK_MSG_ID_MAG_CAL_REPORT,        MSG_MAG_CAL_REPORT},
+    { MAVLINK_MSG_ID_MAG_CAL_PROGRESS,      MSG_MAG_CAL_PROGRESS},
+    { MAVLINK_MSG_ID_MAG_CAL_REPORT,        MSG_MAG_CAL_REPORT},
 #endif
-        { MAVLINK_MSG_ID_EKF_STATUS_REPORT,     MSG_EKF_STATUS_REPORT},
-        { MAVLINK_MSG_ID_LOCAL_POSITION_NED,    MSG_LOCAL_POSITION},
-        { MAVLINK_MSG_ID_PID_TUNING,            MSG_PID_TUNING},
-        { MAVLINK_MSG_ID_VIBRATION,             MSG_VIBRATION},
+    { MAVLINK_MSG_ID_EKF_STATUS_REPORT,     MSG_EKF_STATUS_REPORT},
+    { MAVLINK_MSG_ID_LOCAL_POSITION_NED,    MSG_LOCAL_POSITION},
+    { MAVLINK_MSG_ID_PID_TUNING,            MSG_PID_TUNING},
+    { MAVLINK_MSG_ID_VIBRATION,             MSG_VIBRATION},
 #if AP_RPM_ENABLED
-        { MAVLINK_MSG_ID_RPM,                   MSG_RPM},
+    { MAVLINK_MSG_ID_RPM,                   MSG_RPM},
 #endif
-        { MAVLINK_MSG_ID_MISSION_ITEM_REACHED,  MSG_MISSION_ITEM_REACHED},
-        { MAVLINK_MSG_ID_ATTITUDE_TARGET,       MSG_ATTITUDE_TARGET},
-        { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT,  MSG_POSITION_TARGET_GLOBAL_INT},
-        { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED,  MSG_POSITION_TARGET_LOCAL_NED},
+    { MAVLINK_MSG_ID_MISSION_ITEM_REACHED,  MSG_MISSION_ITEM_REACHED},
+    { MAVLINK_MSG_ID_ATTITUDE_TARGET,       MSG_ATTITUDE_TARGET},
+    { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT,  MSG_POSITION_TARGET_GLOBAL_INT},
+    { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED,  MSG_POSITION_TARGET_LOCAL_NED},
 #if HAL_ADSB_ENABLED
-        { MAVLINK_MSG_ID_ADSB_VEHICLE,          MSG_ADSB_VEHICLE},
+    { MAVLINK_MSG_ID_ADSB_VEHICLE,          MSG_ADSB_VEHICLE},
 #endif
 #if AP_BATTERY_ENABLED
-        { MAVLINK_MSG_ID_BATTERY_STATUS,        MSG_BATTERY_STATUS},
+    { MAVLINK_MSG_ID_BATTERY_STATUS,        MSG_BATTERY_STATUS},
 #endif
-        { MAVLINK_MSG_ID_AOA_SSA,               MSG_AOA_SSA},
+    { MAVLINK_MSG_ID_AOA_SSA,               MSG_AOA_SSA},
 #if HAL_LANDING_DEEPSTALL_ENABLED
-        { MAVLINK_MSG_ID_DEEPSTALL,             MSG_LANDING},
+    { MAVLINK_MSG_ID_DEEPSTALL,             MSG_LANDING},
 #endif
-        { MAVLINK_MSG_ID_EXTENDED_SYS_STATE,    MSG_EXTENDED_SYS_STATE},
-        { MAVLINK_MSG_ID_AUTOPILOT_VERSION,     MSG_AUTOPILOT_VERSION},
+    { MAVLINK_MSG_ID_EXTENDED_SYS_STATE,    MSG_EXTENDED_SYS_STATE},
+    { MAVLINK_MSG_ID_AUTOPILOT_VERSION,     MSG_AUTOPILOT_VERSION},
 #if HAL_EFI_ENABLED
-        { MAVLINK_MSG_ID_EFI_STATUS,            MSG_EFI_STATUS},
+    { MAVLINK_MSG_ID_EFI_STATUS,            MSG_EFI_STATUS},
 #endif
 #if HAL_GENERATOR_ENABLED
-        { MAVLINK_MSG_ID_GENERATOR_STATUS,      MSG_GENERATOR_STATUS},
+    { MAVLINK_MSG_ID_GENERATOR_STATUS,      MSG_GENERATOR_STATUS},
 #endif
 #if AP_WINCH_ENABLED
-        { MAVLINK_MSG_ID_WINCH_STATUS,          MSG_WINCH_STATUS},
+    { MAVLINK_MSG_ID_WINCH_STATUS,          MSG_WINCH_STATUS},
 #endif
 #if HAL_WITH_ESC_TELEM
-        { MAVLINK_MSG_ID_ESC_TELEMETRY_1_TO_4,  MSG_ESC_TELEMETRY},
+    { MAVLINK_MSG_ID_ESC_TELEMETRY_1_TO_4,  MSG_ESC_TELEMETRY},
 #endif
 #if AP_RANGEFINDER_ENABLED && APM_BUILD_TYPE(APM_BUILD_Rover)
-        { MAVLINK_MSG_ID_WATER_DEPTH,           MSG_WATER_DEPTH},
+    { MAVLINK_MSG_ID_WATER_DEPTH,           MSG_WATER_DEPTH},
 #endif
 #if HAL_HIGH_LATENCY2_ENABLED
-        { MAVLINK_MSG_ID_HIGH_LATENCY2,         MSG_HIGH_LATENCY2},
+    { MAVLINK_MSG_ID_HIGH_LATENCY2,         MSG_HIGH_LATENCY2},
 #endif
 #if AP_AIS_ENABLED
-        { MAVLINK_MSG_ID_AIS_VESSEL,            MSG_AIS_VESSEL},
+    { MAVLINK_MSG_ID_AIS_VESSEL,            MSG_AIS_VESSEL},
 #endif
 #if AP_MAVLINK_MSG_UAVIONIX_ADSB_OUT_STATUS_ENABLED
-        { MAVLINK_MSG_ID_UAVIONIX_ADSB_OUT_STATUS, MSG_UAVIONIX_ADSB_OUT_STATUS},
+    { MAVLINK_MSG_ID_UAVIONIX_ADSB_OUT_STATUS, MSG_UAVIONIX_ADSB_OUT_STATUS},
 #endif
 #if AP_MAVLINK_MSG_RELAY_STATUS_ENABLED
-        { MAVLINK_MSG_ID_RELAY_STATUS, MSG_RELAY_STATUS},
+    { MAVLINK_MSG_ID_RELAY_STATUS, MSG_RELAY_STATUS},
 #endif
-            };
+};
 
-    for (uint8_t i=0; i<ARRAY_SIZE(map); i++) {
-        if (map[i].mavlink_id == mavlink_id) {
-            return map[i].msg_id;
+ap_message GCS_MAVLINK::mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(ap_message_mavlink_ids); i++) {
+        if (ap_message_mavlink_ids[i].mavlink_id == mavlink_id) {
+            return ap_message_mavlink_ids[i].msg_id;
         }
     }
     return MSG_LAST;
 }
 
+// returns the id of the mavlink message sent for an ap_message, or
+// -1 if there isn't one
+int32_t GCS_MAVLINK::ap_message_id_to_mavlink_id(const ap_message id)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(ap_message_mavlink_ids); i++) {
+        if (ap_message_mavlink_ids[i].msg_id == id) {
+            return ap_message_mavlink_ids[i].mavlink_id;
+        }
+    }
+    return -1;
+}
+
 bool GCS_MAVLINK::set_mavlink_message_id_interval(const uint32_t mavlink_id,
                                                   const uint16_t interval_ms)
 {
@@ -1126,27 +1141,32 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
     return false;
 }
 
-uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
+uint8_t GCS_MAVLINK::get_reschedule_interval_multiplier() const
 {
-    uint32_t interval_ms = deferred.interval_ms;
-
-    interval_ms += stream_slowdown_ms;
+    uint8_t multiplier = 1;
 
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
         // we are sending parameters, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
     if (requesting_mission_items()) {
         // we are sending requests for waypoints, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
     if (AP_HAL::millis() - ftp.last_send_ms < 500) {
         // we are sending ftp replies
-        interval_ms *= 4;
+        multiplier *= 4;
     }
 
+    return multiplier;
+}
+
+uint16_t GCS_MAVLINK::get_reschedule_interval_ms(uint16_t interval, uint8_t multiplier) const
+{
+    const uint32_t interval_ms = (uint32_t(interval) + stream_slowdown_ms) * multiplier;
+
     if (interval_ms > 60000) {
         return 60000;
     }
@@ -1154,74 +1174,264 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
-// typical runtime on fmuv3: 5 microseconds for 3 buckets
-void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
+/*
+  priority of each message when the link can't send everything.
+  Critical messages are sent before anything else, the others share
+  the link weighted by their priority
+ */
+GCS_MAVLINK::MessagePriority GCS_MAVLINK::get_ap_message_priority(const ap_message id)
+{
+    switch (id) {
+    case MSG_HEARTBEAT:
+    case MSG_NEXT_PARAM:
+#if HAL_HIGH_LATENCY2_ENABLED
+    case MSG_HIGH_LATENCY2:
+#endif
+        return MessagePriority::CRITICAL;
+
+    // what a GCS needs to fly the vehicle
+    case MSG_SYS_STATUS:
+    case MSG_EXTENDED_SYS_STATE:
+    case MSG_ATTITUDE:
+    case MSG_LOCATION:
+    case MSG_GPS_RAW:
+    case MSG_VFR_HUD:
+    case MSG_BATTERY_STATUS:
+    case MSG_CURRENT_WAYPOINT:
+    case MSG_EKF_STATUS_REPORT:
+    case MSG_HOME:
+    case MSG_ORIGIN:
+        return MessagePriority::HIGH;
+
+    // raw sensor and diagnostic data
+    case MSG_RAW_IMU:
+    case MSG_SCALED_IMU:
+    case MSG_SCALED_IMU2:
+    case MSG_SCALED_IMU3:
+    case MSG_SCALED_PRESSURE2:
+    case MSG_SCALED_PRESSURE3:
+    case MSG_SERVO_OUTPUT_RAW:
+    case MSG_RC_CHANNELS_RAW:
+    case MSG_POWER_STATUS:
+    case MSG_MEMINFO:
+    case MSG_MCU_STATUS:
+    case MSG_HWSTATUS:
+    case MSG_SIMSTATE:
+    case MSG_SIM_STATE:
+    case MSG_AHRS:
+    case MSG_AHRS2:
+    case MSG_PID_TUNING:
+    case MSG_ESC_TELEMETRY:
+        return MessagePriority::LOW;
+
+    default:
+        return MessagePriority::NORMAL;
+    }
+}
+
+/*
+  messages are only looked up when their intervals are set or
+  requested, and a link schedules a few dozen at most, so a search is
+  cheaper in memory than an index by ap_message
+ */
+uint8_t GCS_MAVLINK::find_scheduled_message(const ap_message id) const
+{
+    for (uint8_t i=0; i<num_scheduled_messages; i++) {
+        if (scheduled_message[i].id == id) {
+            return i;
+        }
+    }
+    return no_message_to_send;
+}
+
+bool GCS_MAVLINK::expand_scheduled_messages()
+{
+    if (scheduled_message_size >= GCS_MAVLINK_MAX_SCHEDULED_MESSAGES) {
+        return false;
+    }
+    const uint8_t new_size = MIN(scheduled_message_size + GCS_MAVLINK_SCHEDULED_MESSAGES_STEP,
+                                 GCS_MAVLINK_MAX_SCHEDULED_MESSAGES);
+    scheduled_message_t *new_table = new scheduled_message_t[new_size];
+    if (new_table == nullptr) {
+        return false;
+    }
+    if (scheduled_message != nullptr) {
+        memcpy(new_table, scheduled_message, num_scheduled_messages * sizeof(scheduled_message_t));
+    }
+    delete[] scheduled_message;
+    scheduled_message = new_table;
+    scheduled_message_size = new_size;
+    return true;
+}
+
+GCS_MAVLINK::scheduled_message_t *GCS_MAVLINK::add_scheduled_message(const ap_message id)
+{
+    // @SYS/streams.txt reads the table from another thread
+    WITH_SEMAPHORE(comm_chan_lock(chan));
+    if (num_scheduled_messages >= scheduled_message_size &&
+        !expand_scheduled_messages()) {
+        return nullptr;
+    }
+    const MessagePriority priority = get_ap_message_priority(id);
+    uint8_t i = num_scheduled_messages++;
+    if (priority == MessagePriority::CRITICAL) {
+        // make room at the end of the critical messages
+        if (i != num_critical_messages) {
+            scheduled_message[i] = scheduled_message[num_critical_messages];
+        }
+        i = num_critical_messages++;
+    }
+    scheduled_message_t &msg = scheduled_message[i];
+    msg = {};
+    msg.id = id;
+    msg.priority = priority;
+    return &msg;
+}
+
+void GCS_MAVLINK::remove_scheduled_message(const ap_message id)
+{
+    WITH_SEMAPHORE(comm_chan_lock(chan));
+    uint8_t gap = find_scheduled_message(id);
+    if (gap == no_message_to_send) {
+        return;
+    }
+    if (scheduled_message[gap].priority == MessagePriority::CRITICAL) {
+        // fill the gap with the last critical message, leaving the
+        // gap between the critical and streamed messages
+        num_critical_messages--;
+        if (gap != num_critical_messages) {
+            scheduled_message[gap] = scheduled_message[num_critical_messages];
+        }
+        gap = num_critical_messages;
+    }
+    num_scheduled_messages--;
+    if (gap != num_scheduled_messages) {
+        scheduled_message[gap] = scheduled_message[num_scheduled_messages];
+    }
+}
+
+// returns the most overdue critical message
+uint8_t GCS_MAVLINK::next_critical_message_to_send(uint16_t now16_ms)
 {
+    uint8_t next = no_message_to_send;
+    uint16_t most_ms_overdue = 0;
+    for (uint8_t i=0; i<num_critical_messages; i++) {
+        const scheduled_message_t &msg = scheduled_message[i];
+        const uint16_t ms_since_last_sent = now16_ms - msg.last_sent_ms;
+        if (ms_since_last_sent < msg.interval_ms) {
+            continue;
+        }
+        const uint16_t ms_overdue = ms_since_last_sent - msg.interval_ms;
+#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
+        if (ms_overdue > 0) {
+            // should already have sent this one!
+            try_send_message_stats.behind++;
+        }
+#endif
+        if (next == no_message_to_send || ms_overdue > most_ms_overdue) {
+            next = i;
+            most_ms_overdue = ms_overdue;
+        }
+    }
+    return next;
+}
+
+/*
+  returns the streamed message which has waited the most intervals,
+  weighted by priority.  When the link keeps up this is just the
+  next message due.  When it can't, higher priority messages get
+  their requested rates first, and messages with the same priority
+  get the same fraction of their requested rates.  A message which
+  is more than stream_max_overdue_ms overdue is sent before any
+  that isn't, whatever its priority
+ */
+uint8_t GCS_MAVLINK::next_streamed_message_to_send(uint16_t now16_ms)
+{
+    if (int16_t(now16_ms - next_streamed_message_check_ms) < 0) {
+        // nothing is due yet
+        return no_message_to_send;
+    }
+
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_us = AP_HAL::micros();
 #endif
 
-    // all done sending this bucket... find another bucket...
-    sending_bucket_id = no_bucket_to_send;
-    uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
+    const uint8_t multiplier = get_reschedule_interval_multiplier();
+    uint8_t next = no_message_to_send;
+    uint64_t best_score = 0;
+    uint16_t ms_before_next_due = 100;
+    for (uint8_t i=num_critical_messages; i<num_scheduled_messages; i++) {
+        const scheduled_message_t &msg = scheduled_message[i];
+        const uint16_t interval_ms = get_reschedule_interval_ms(msg.interval_ms, multiplier);
+        const uint16_t ms_since_last_sent = now16_ms - msg.last_sent_ms;
+        if (ms_since_last_sent < interval_ms) {
+            ms_before_next_due = MIN(ms_before_next_due, interval_ms - ms_since_last_sent);
             continue;
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
-        const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
-        uint16_t ms_before_send_this_bucket;
-        if (ms_since_last_sent > interval) {
-            // should already have sent this bucket!
-            ms_before_send_this_bucket = 0;
-        } else {
-            ms_before_send_this_bucket = interval - ms_since_last_sent;
+        // intervals waited in 1/256ths, times 16 for each priority
+        // level, so a message only gets ahead of one with a higher
+        // priority when it has waited 16 times as many intervals.
+        // This is below 2^24 before the shift and 2^32 after it
+        const uint32_t intervals = (uint32_t(ms_since_last_sent) << 8) / interval_ms;
+        uint64_t score = uint64_t(intervals) << (4 * uint8_t(msg.priority));
+        const uint16_t ms_overdue = ms_since_last_sent - interval_ms;
+        if (ms_overdue > stream_max_overdue_ms) {
+            // starved, the most overdue goes first
+            score = (uint64_t(1) << 32) + ms_overdue;
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
-            sending_bucket_id = i;
-            ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+        if (next == no_message_to_send || score > best_score) {
+            next = i;
+            best_score = score;
         }
     }
-    if (sending_bucket_id != no_bucket_to_send) {
-        bucket_message_ids_to_send = deferred_message_bucket[sending_bucket_id].ap_message_ids;
+    if (next == no_message_to_send) {
+        next_streamed_message_check_ms = now16_ms + ms_before_next_due;
     } else {
-        bucket_message_ids_to_send.clearall();
+        next_streamed_message_check_ms = now16_ms;
     }
 
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     uint32_t delta_us = AP_HAL::micros() - start_us;
     hal.scheduler->restore_interrupts(data);
-    if (delta_us > try_send_message_stats.fnbts_maxtime) {
-        try_send_message_stats.fnbts_maxtime = delta_us;
+    if (delta_us > try_send_message_stats.select_maxtime) {
+        try_send_message_stats.select_maxtime = delta_us;
     }
 #endif
+
+    return next;
 }
 
-ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
+void GCS_MAVLINK::reschedule_message(scheduled_message_t &msg, uint16_t interval_ms, uint16_t now16_ms)
 {
-    if (sending_bucket_id == no_bucket_to_send) {
-        // could happen if all streamrates are zero?
-        return no_message_to_send;
+    // we try to keep output on a regular clock to avoid user support
+    // questions:
+    msg.last_sent_ms += interval_ms;
+    // but we do not want to try to catch up too much:
+    if (uint16_t(now16_ms - msg.last_sent_ms) > interval_ms) {
+        msg.last_sent_ms = now16_ms;
     }
+}
 
-    const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[sending_bucket_id].last_sent_ms;
-    if (ms_since_last_sent < get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id])) {
-        // not time to send this bucket
-        return no_message_to_send;
+/*
+  move the rate measurement on to a new window if it is time
+ */
+void GCS_MAVLINK::update_stream_rate_window(uint32_t now_ms)
+{
+    const uint32_t window_ms = now_ms - stream_rate_window_start_ms;
+    if (window_ms < stream_rate_window_ms) {
+        return;
     }
-
-    const int16_t next = bucket_message_ids_to_send.first_set();
-    if (next == -1) {
-        // should not happen
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        AP_HAL::panic("next_deferred_bucket_message_to_send called on empty bucket");
-#endif
-        find_next_bucket_to_send(now16_ms);
-        return no_message_to_send;
+    for (uint8_t i=0; i<num_scheduled_messages; i++) {
+        scheduled_message_t &msg = scheduled_message[i];
+        msg.sent_last_window = msg.sent;
+        msg.sent = 0;
     }
-    return (ap_message)next;
+    const uint32_t tx_bytes = comm_get_tx_bytes(chan);
+    stream_rate_last_window_bytes = tx_bytes - stream_rate_window_start_bytes;
+    stream_rate_window_start_bytes = tx_bytes;
+    stream_rate_last_window_ms = MIN(window_ms, uint32_t(UINT16_MAX));
+    stream_rate_window_start_ms = now_ms;
 }
 
 // call try_send_message if appropriate.  Incorporates debug code to
@@ -1229,6 +1439,7 @@ ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
 // expected to be overridden, not this function.
 bool GCS_MAVLINK::do_try_send_message(const ap_message id)
 {
+    last_try_send_bytes = 0;
     const bool in_delay_callback = hal.scheduler->in_delay_callback();
     if (in_delay_callback && !should_send_message_in_delay_callback(id)) {
         return true;
@@ -1241,6 +1452,7 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_send_message_us = AP_HAL::micros();
 #endif
+    const uint32_t start_tx_bytes = comm_get_tx_bytes(chan);
     if (!try_send_message(id)) {
         // didn't fit in buffer...
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1257,60 +1469,11 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
         try_send_message_stats.longest_id = id;
     }
 #endif
+    // we hold the channel lock, so these are all from this message:
+    last_try_send_bytes = MIN(comm_get_tx_bytes(chan) - start_tx_bytes, uint32_t(UINT16_MAX));
     return true;
 }
 
-int8_t GCS_MAVLINK::get_deferred_message_index(const ap_message id) const
-{
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message); i++) {
-        if (deferred_message[i].id == id) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int8_t GCS_MAVLINK::deferred_message_to_send_index(uint16_t now16_ms)
-{
-
-    if (next_deferred_message_to_send_cache == -1) {
-        uint16_t ms_before_next_message_to_send = UINT16_MAX;
-        for (uint8_t i=0; i<ARRAY_SIZE(deferred_message); i++) {
-            const uint16_t interval_ms = deferred_message[i].interval_ms;
-            if (interval_ms == 0) {
-                continue;
-            }
-            const uint16_t ms_since_last_sent = now16_ms - deferred_message[i].last_sent_ms;
-            uint16_t ms_before_send_this_message;
-            if (ms_since_last_sent > interval_ms) {
-                // should already have sent this one!
-                ms_before_send_this_message = 0;
-#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-                try_send_message_stats.behind++;
-#endif
-            } else {
-                ms_before_send_this_message = interval_ms - ms_since_last_sent;
-            }
-            if (ms_before_send_this_message < ms_before_next_message_to_send) {
-                next_deferred_message_to_send_cache = i;
-                ms_before_next_message_to_send = ms_before_send_this_message;
-            }
-        }
-    }
-
-    if (next_deferred_message_to_send_cache == -1) {
-        // this really shouldn't happen; we force parameter rates, for example.
-        return -1;
-    }
-
-    const uint16_t ms_since_last_sent = now16_ms - deferred_message[next_deferred_message_to_send_cache].last_sent_ms;
-    if (ms_since_last_sent < deferred_message[next_deferred_message_to_send_cache].interval_ms) {
-        return -1;
-    }
-
-    return next_deferred_message_to_send_cache;
-}
-
 bool GCS_MAVLINK_InProgress::send_ack(MAV_RESULT result)
 {
     if (!HAVE_PAYLOAD_SPACE(chan, COMMAND_ACK)) {
@@ -1459,6 +1622,7 @@ void GCS_MAVLINK::update_send()
 
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
+    update_stream_rate_window(start);
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
         if (gcs().out_of_time()) {
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1471,23 +1635,21 @@ void GCS_MAVLINK::update_send()
         retry_deferred_body_start = AP_HAL::micros();
 #endif
 
-        // check if any "specially handled" messages should be sent out
+        // check if any critical messages should be sent out.  If one
+        // doesn't fit nothing else is sent, so the space freed as the
+        // link drains goes to them first
         {
-            const int8_t next = deferred_message_to_send_index(start16);
-            if (next != -1) {
-                if (!do_try_send_message(deferred_message[next].id)) {
+            const uint8_t next = next_critical_message_to_send(start16);
+            if (next != no_message_to_send) {
+                scheduled_message_t &msg = scheduled_message[next];
+                if (!do_try_send_message(msg.id)) {
                     break;
                 }
-                // we try to keep output on a regular clock to avoid
-                // user support questions:
-                const uint16_t interval_ms = deferred_message[next].interval_ms;
-                deferred_message[next].last_sent_ms += interval_ms;
-                // but we do not want to try to catch up too much:
-                if (uint16_t(start16 - deferred_message[next].last_sent_ms) > interval_ms) {
-                    deferred_message[next].last_sent_ms = start16;
+                reschedule_message(msg, msg.interval_ms, start16);
+                if (last_try_send_bytes != 0) {
+                    msg.bytes = last_try_send_bytes;
+                    msg.sent++;
                 }
-
-                next_deferred_message_to_send_cache = -1; // deferred_message_to_send will recalculate
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
                 const uint32_t stop = AP_HAL::micros();
                 const uint32_t delta = stop - retry_deferred_body_start;
@@ -1519,23 +1681,20 @@ void GCS_MAVLINK::update_send()
             continue;
         }
 
-        ap_message next = next_deferred_bucket_message_to_send(start16);
+        const uint8_t next = next_streamed_message_to_send(start16);
         if (next != no_message_to_send) {
-            if (!do_try_send_message(next)) {
+            scheduled_message_t &msg = scheduled_message[next];
+            // a message which didn't fit last time is not tried until
+            // it will, and less overdue messages are not sent in its
+            // place, so large messages are not starved by small ones
+            if (msg.bytes > txspace() || !do_try_send_message(msg.id)) {
+                stream_saturated_count++;
                 break;
             }
-            bucket_message_ids_to_send.clear(next);
-            if (bucket_message_ids_to_send.count() == 0) {
-                // we sent everything in the bucket.  Reschedule it.
-                // we try to keep output on a regular clock to avoid
-                // user support questions:
-                const uint16_t interval_ms = get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
-                deferred_message_bucket[sending_bucket_id].last_sent_ms += interval_ms;
-                // but we do not want to try to catch up too much:
-                if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
-                    deferred_message_bucket[sending_bucket_id].last_sent_ms = start16;
-                }
-                find_next_bucket_to_send(start16);
+            reschedule_message(msg, get_reschedule_interval_ms(msg.interval_ms, get_reschedule_interval_multiplier()), start16);
+            if (last_try_send_bytes != 0) {
+                msg.bytes = last_try_send_bytes;
+                msg.sent++;
             }
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
                 const uint32_t stop = AP_HAL::micros();
@@ -1565,36 +1724,12 @@ void GCS_MAVLINK::update_send()
     last_tx_seq = _channel_status.current_tx_seq;
 }
 
-void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
+bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_ms)
 {
-    deferred_message_bucket[bucket].ap_message_ids.clear(id);
-    if (deferred_message_bucket[bucket].ap_message_ids.count() == 0) {
-        // bucket empty.  Free it:
-        deferred_message_bucket[bucket].interval_ms = 0;
-        deferred_message_bucket[bucket].last_sent_ms = 0;
-    }
-
-    if (bucket == sending_bucket_id) {
-        bucket_message_ids_to_send.clear(id);
-        if (bucket_message_ids_to_send.count() == 0) {
-            find_next_bucket_to_send(AP_HAL::millis16());
-        } else {
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-            if (deferred_message_bucket[bucket].interval_ms == 0 &&
-                deferred_message_bucket[bucket].last_sent_ms == 0) {
-                // we just freed this bucket!  this would mean that
-                // somehow our messages-still-to-send was a superset
-                // of the messages in the bucket we were sending,
-                // which would be bad.
-                INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
-            }
-#endif
-        }
+    if (id >= MSG_LAST) {
+        return false;
     }
-}
 
-bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_ms)
-{
     if (id == MSG_NEXT_PARAM) {
         // force parameters to *always* get streamed so a vehicle is
         // recoverable from bad configuration:
@@ -1611,94 +1746,75 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         interval_ms = AP::scheduler().get_loop_period_us()/800.0f;
     }
 
-    // check if it's a specially-handled message:
-    const int8_t deferred_offset = get_deferred_message_index(id);
-    if (deferred_offset != -1) {
-        deferred_message[deferred_offset].interval_ms = interval_ms;
-        deferred_message[deferred_offset].last_sent_ms = AP_HAL::millis16();
-        return true;
-    }
-
-    // see which bucket has the closest interval:
-    int8_t closest_bucket = -1;
-    uint16_t closest_bucket_interval_delta = UINT16_MAX;
-    int8_t in_bucket = -1;
-    int8_t empty_bucket_id = -1;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
-        if (bucket.interval_ms == 0) {
-            // unused bucket
-            if (empty_bucket_id == -1) {
-                empty_bucket_id = i;
-            }
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-            if (bucket.ap_message_ids.count() != 0) {
-                AP_HAL::panic("Bucket %u has zero interval but with ids set", i);
-            }
-#endif
-            continue;
-        }
-        if (bucket.ap_message_ids.get(id)) {
-            in_bucket = i;
-        }
-        const uint16_t interval_delta = abs(bucket.interval_ms - interval_ms);
-        if (interval_delta < closest_bucket_interval_delta) {
-            closest_bucket = i;
-            closest_bucket_interval_delta = interval_delta;
-        }
-    }
-
-    if (in_bucket == -1 && interval_ms == 0) {
-        // not in a bucket and told to remove from scheduling
+    if (interval_ms == 0) {
+        // told to remove from scheduling
+        remove_scheduled_message(id);
         return true;
     }
 
-    if (in_bucket != -1) {
-        if (interval_ms == 0) {
-            // remove it
-            remove_message_from_bucket(in_bucket, id);
+    scheduled_message_t *msg = nullptr;
+    const uint8_t i = find_scheduled_message(id);
+    if (i != no_message_to_send) {
+        msg = &scheduled_message[i];
+        if (msg->interval_ms == interval_ms) {
+            // don't need to reschedule it
             return true;
         }
-        if (closest_bucket_interval_delta == 0 &&
-            in_bucket == closest_bucket) {
-            // don't need to move it
-            return true;
-        }
-        // remove from existing bucket
-        remove_message_from_bucket(in_bucket, id);
-        if (empty_bucket_id == -1 &&
-            deferred_message_bucket[in_bucket].ap_message_ids.count() == 0) {
-            empty_bucket_id = in_bucket;
-        }
-    }
-
-    if (closest_bucket == -1 && empty_bucket_id == -1) {
-        // gah?!
+    } else {
+        msg = add_scheduled_message(id);
+        if (msg == nullptr) {
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        ::fprintf(stderr, "no buckets?!\n");
-        abort();
+            ::fprintf(stderr, "no room to schedule message %u\n", unsigned(id));
 #endif
-        return false;
+            return false;
+        }
     }
 
-    if (closest_bucket_interval_delta != 0 &&
-        empty_bucket_id != -1) {
-        // allocate a bucket for this interval
-        deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
-        deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
-        closest_bucket = empty_bucket_id;
-    }
+    msg->interval_ms = interval_ms;
+    msg->last_sent_ms = AP_HAL::millis16();
 
-    deferred_message_bucket[closest_bucket].ap_message_ids.set(id);
-
-    if (sending_bucket_id == no_bucket_to_send) {
-        sending_bucket_id = closest_bucket;
-        bucket_message_ids_to_send = deferred_message_bucket[closest_bucket].ap_message_ids;
-    }
+    // check whether it is due sooner than anything else
+    next_streamed_message_check_ms = msg->last_sent_ms;
 
     return true;
 }
 
+/*
+  requested and achieved rates of each message scheduled on this
+  link, with the bytes it took the last time it was sent
+ */
+void GCS_MAVLINK::stream_info(ExpandingString &str) const
+{
+    // the table can be reallocated by the main thread
+    WITH_SEMAPHORE(comm_chan_lock(chan));
+    // rates are over the last complete window
+    const uint16_t window_ms = MAX(stream_rate_last_window_ms, 1U);
+    str.printf("MAV%u bytes/s=%u saturated=%u\n",
+               unsigned(chan),
+               unsigned(stream_rate_last_window_bytes * 1000ULL / window_ms),
+               unsigned(stream_saturated_count));
+    for (uint8_t i=0; i<num_scheduled_messages; i++) {
+        const scheduled_message_t &msg = scheduled_message[i];
+        str.printf("MAV%u msg=%u id=%d prio=%u req=%.2f got=%.2f bytes=%u\n",
+                   unsigned(chan),
+                   unsigned(msg.id),
+                   int(ap_message_id_to_mavlink_id(msg.id)),
+                   unsigned(msg.priority),
+                   (double)(1000.0f / msg.interval_ms),
+                   (double)(msg.sent_last_window * 1000.0f / window_ms),
+                   unsigned(msg.bytes));
+    }
+}
+
+void GCS::stream_info(ExpandingString &str) const
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("StreamsV1\n");
+    for (uint8_t i=0; i<num_gcs(); i++) {
+        chan(i)->stream_info(str);
+    }
+}
+
 // queue a message to be sent (try_send_message does the *actual*
 // mavlink work!)
 void GCS_MAVLINK::send_message(enum ap_message id)
@@ -1892,12 +2008,12 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
                             try_send_message_stats.behind);
             try_send_message_stats.behind = 0;
         }
-        if (try_send_message_stats.fnbts_maxtime) {
+        if (try_send_message_stats.select_maxtime) {
             gcs().send_text(MAV_SEVERITY_INFO,
-                            "GCS.chan(%u): fnbts_maxtime=%uus",
+                            "GCS.chan(%u): select_maxtime=%uus",
                             chan,
-                            try_send_message_stats.fnbts_maxtime);
-            try_send_message_stats.fnbts_maxtime = 0;
+                            try_send_message_stats.select_maxtime);
+            try_send_message_stats.select_maxtime = 0;
         }
         if (try_send_message_stats.max_retry_deferred_body_us) {
             gcs().send_text(MAV_SEVERITY_INFO,
@@ -1909,16 +2025,11 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
             try_send_message_stats.max_retry_deferred_body_us = 0;
         }
 
-        for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-            gcs().send_text(MAV_SEVERITY_INFO,
-                            "B. intvl. (%u): %u %u %u %u %u",
-                            chan,
-                            deferred_message_bucket[0].interval_ms,
-                            deferred_message_bucket[1].interval_ms,
-                            deferred_message_bucket[2].interval_ms,
-                            deferred_message_bucket[3].interval_ms,
-                            deferred_message_bucket[4].interval_ms);
-        }
+        gcs().send_text(MAV_SEVERITY_INFO,
+                        "GCS.chan(%u): scheduled=%u saturated=%u",
+                        chan,
+                        num_scheduled_messages,
+                        unsigned(stream_saturated_count));
 
         try_send_message_stats.statustext_last_sent_ms = now16_ms;
     }
@@ -2991,22 +3102,12 @@ MAV_RESULT GCS_MAVLINK::handle_command_request_message(const mavlink_command_int
 
 bool GCS_MAVLINK::get_ap_message_interval(ap_message id, uint16_t &interval_ms) const
 {
-    // check if it's a specially-handled message:
-    const int8_t deferred_offset = get_deferred_message_index(id);
-    if (deferred_offset != -1) {
-        interval_ms = deferred_message[deferred_offset].interval_ms;
+    const uint8_t i = find_scheduled_message(id);
+    if (i != no_message_to_send) {
+        interval_ms = scheduled_message[i].interval_ms;
         return true;
     }
 
-    // check the deferred message buckets:
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
-        if (bucket.ap_message_ids.get(id)) {
-            interval_ms = bucket.interval_ms;
-            return true;
-        }
-    }
-
     return false;
 }
 
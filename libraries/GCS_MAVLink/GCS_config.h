@@ -42,6 +42,17 @@
 #define AP_MAVLINK_MAV_CMD_REQUEST_AUTOPILOT_CAPABILITIES_ENABLED 1
 #endif
 
+// most messages each link can schedule
+#ifndef GCS_MAVLINK_MAX_SCHEDULED_MESSAGES
+#define GCS_MAVLINK_MAX_SCHEDULED_MESSAGES MSG_LAST
+#endif
+
+// the table of scheduled messages grows by this many entries at a
+// time as messages are scheduled
+#ifndef GCS_MAVLINK_SCHEDULED_MESSAGES_STEP
+#define GCS_MAVLINK_SCHEDULED_MESSAGES_STEP 8
+#endif
+
 #ifndef HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED
 #define HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED ((AP_FILESYSTEM_FATFS_ENABLED || AP_FILESYSTEM_POSIX_ENABLED) && BOARD_FLASH_SIZE > 1024)
 #endif
@@ -30,8 +30,16 @@ extern const AP_HAL::HAL& hal;
 
 #define ROUTING_DEBUG 0
 
+static_assert(MAVLINK_MAX_ROUTES < 255, "route indexes must fit in route_slots");
+static_assert(MAVLINK_COMM_NUM_BUFFERS <= 8, "channel masks must fit in 8 bits");
+
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    route_slots{},
+    sysid_channel_mask{},
+    all_channel_mask(0)
+{}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -164,45 +172,53 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    // find the channels matching the targets. Private channels only
+    // get packets targeted at a sysid/compid heard on them
+    const uint8_t private_mask = GCS_MAVLINK::private_channel_mask();
+    uint8_t mask;
+    if (broadcast_system) {
+        mask = all_channel_mask & ~private_mask;
+    } else {
+        const route *r = nullptr;
+        if (target_component != -1) {
+            r = find_route(target_system, target_component);
+        }
+        const uint8_t component_mask = (r != nullptr) ? r->channel_mask : 0;
+        if (broadcast_component || !match_system) {
+            mask = sysid_channel_mask[target_system] & ~private_mask;
+        } else {
+            mask = component_mask & ~private_mask;
+        }
+        mask |= component_mask & private_mask;
+    }
 
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
-        if (out_link == nullptr) {
-            // this is bad
+    // don't send back on the incoming channel
+    mask &= ~(1U<<(in_link.get_chan()-MAVLINK_COMM_0));
+
+    // forward on the matching channels
+    bool forwarded = false;
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
             continue;
         }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        GCS_MAVLINK *out_link = gcs().chan(channel);
+        if (out_link == nullptr) {
+            // this is bad
             continue;
         }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link->get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_link.get_chan(),
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
+        forwarded = true;
     }
 
     if ((!forwarded && match_system) ||
@@ -229,29 +245,24 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels our system ID has been seen on
+    const uint8_t mask = sysid_channel_mask[mavlink_system.sysid];
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
-        }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u sysid=%u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel,
+                 (unsigned)mavlink_system.sysid);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -259,13 +270,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -280,7 +290,7 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
         if (routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + __builtin_ctz(routes[i].channel_mask));
             return true;
         }
     }
@@ -298,7 +308,7 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
     for (uint8_t i=0; i<num_routes; i++) {
         if ((routes[i].mavtype == mavtype) && (routes[i].compid == compid)) {
             sysid = routes[i].sysid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + __builtin_ctz(routes[i].channel_mask));
             return true;
         }
     }
@@ -310,7 +320,6 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -328,24 +337,30 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-            }
-            break;
-        }
-    }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    const uint8_t channel_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    const uint32_t now_ms = AP_HAL::millis();
+    route *r = find_route(msg.sysid, msg.compid);
+    if (r == nullptr) {
+        if (num_routes == MAVLINK_MAX_ROUTES && !remove_stale_route(now_ms)) {
+            // the routing table is full
+            return;
         }
+        r = &routes[num_routes];
+        r->sysid = msg.sysid;
+        r->compid = msg.compid;
+        r->mavtype = 0;
+        r->channel_mask = 0;
         num_routes++;
+        uint16_t slot = hash_slot(msg.sysid, msg.compid);
+        while (route_slots[slot] != 0) {
+            slot = (slot + 1) % num_route_slots;
+        }
+        route_slots[slot] = num_routes;
+    }
+    if (!(r->channel_mask & channel_bit)) {
+        r->channel_mask |= channel_bit;
+        sysid_channel_mask[msg.sysid] |= channel_bit;
+        all_channel_mask |= channel_bit;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg.sysid,
@@ -353,6 +368,84 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
                  (unsigned)in_channel);
 #endif
     }
+    if (r->mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r->mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    r->last_seen_ms = now_ms;
+}
+
+/*
+  slot in the hash table to start looking for a sysid/compid
+*/
+uint16_t MAVLink_routing::hash_slot(uint8_t sysid, uint8_t compid)
+{
+    const uint32_t key = (uint32_t(sysid) << 8) | compid;
+    return ((key * 2654435761U) >> 16) % num_route_slots;
+}
+
+/*
+  find the route for a sysid/compid
+*/
+MAVLink_routing::route *MAVLink_routing::find_route(uint8_t sysid, uint8_t compid)
+{
+    for (uint16_t slot = hash_slot(sysid, compid);
+         route_slots[slot] != 0;
+         slot = (slot + 1) % num_route_slots) {
+        route &r = routes[route_slots[slot]-1];
+        if (r.sysid == sysid && r.compid == compid) {
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+/*
+  make room in a full routing table by removing the least recently
+  heard route, if it hasn't been heard from for MAVLINK_ROUTE_TIMEOUT_MS
+*/
+bool MAVLink_routing::remove_stale_route(uint32_t now_ms)
+{
+    if (num_routes == 0) {
+        return false;
+    }
+    uint8_t oldest = 0;
+    for (uint8_t i=1; i<num_routes; i++) {
+        if (now_ms - routes[i].last_seen_ms > now_ms - routes[oldest].last_seen_ms) {
+            oldest = i;
+        }
+    }
+    if (now_ms - routes[oldest].last_seen_ms < MAVLINK_ROUTE_TIMEOUT_MS) {
+        return false;
+    }
+#if ROUTING_DEBUG
+    ::printf("removed route %u %u\n",
+             (unsigned)routes[oldest].sysid,
+             (unsigned)routes[oldest].compid);
+#endif
+    num_routes--;
+    routes[oldest] = routes[num_routes];
+    rebuild_index();
+    return true;
+}
+
+/*
+  rebuild the hash table and channel masks after removing a route
+*/
+void MAVLink_routing::rebuild_index(void)
+{
+    memset(route_slots, 0, sizeof(route_slots));
+    memset(sysid_channel_mask, 0, sizeof(sysid_channel_mask));
+    all_channel_mask = 0;
+    for (uint8_t i=0; i<num_routes; i++) {
+        const route &r = routes[i];
+        uint16_t slot = hash_slot(r.sysid, r.compid);
+        while (route_slots[slot] != 0) {
+            slot = (slot + 1) % num_route_slots;
+        }
+        route_slots[slot] = i+1;
+        sysid_channel_mask[r.sysid] |= r.channel_mask;
+        all_channel_mask |= r.channel_mask;
+    }
 }
 
 
@@ -375,10 +468,9 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    const route *r = find_route(msg.sysid, msg.compid);
+    if (r != nullptr) {
+        mask &= ~r->channel_mask;
     }
 
     if (mask == 0) {
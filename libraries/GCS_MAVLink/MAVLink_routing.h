@@ -5,9 +5,22 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
+// maximum number of sysid/compid pairs we can route to. Vehicles
+// with companion computers, cameras, gimbals and several GCS links
+// can have a lot of them
+#ifndef MAVLINK_MAX_ROUTES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define MAVLINK_MAX_ROUTES 64
+#else
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// when the routing table is full a route not heard from for this
+// long can be replaced by a new one
+#ifndef MAVLINK_ROUTE_TIMEOUT_MS
+#define MAVLINK_ROUTE_TIMEOUT_MS 30000
+#endif
 
 /*
   object to handle MAVLink packet routing
@@ -50,22 +63,51 @@ public:
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    /*
+      the routing table. There is a route for each sysid/compid we
+      have heard from, with a mask of the channels it was heard
+      on. Routes are found with a hash of the sysid/compid, and the
+      channels each sysid was heard on are kept for messages targeted
+      at a whole system, so routing a packet doesn't depend on the
+      number of routes
+     */
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
         uint8_t mavtype;
+        uint8_t channel_mask;
+        uint32_t last_seen_ms;
     } routes[MAVLINK_MAX_ROUTES];
-    
+
+    // hash table of indexes into routes, plus one so zero is empty
+    static const uint16_t num_route_slots = MAVLINK_MAX_ROUTES * 2;
+    uint8_t route_slots[num_route_slots];
+
+    // channels each sysid has been heard on
+    uint8_t sysid_channel_mask[256];
+
+    // channels any route has been heard on
+    uint8_t all_channel_mask;
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
     // learn new routes
     void learn_route(GCS_MAVLINK &link, const mavlink_message_t &msg);
 
+    // slot in route_slots to start looking for a sysid/compid
+    static uint16_t hash_slot(uint8_t sysid, uint8_t compid);
+
+    // find the route for a sysid/compid, nullptr if not known
+    route *find_route(uint8_t sysid, uint8_t compid);
+
+    // remove the least recently heard route if it has timed out
+    bool remove_stale_route(uint32_t now_ms);
+
+    // rebuild the hash table and channel masks from routes
+    void rebuild_index(void);
+
     // extract target sysid and compid from a message
     void get_targets(const mavlink_message_t &msg, int16_t &sysid, int16_t &compid);
 
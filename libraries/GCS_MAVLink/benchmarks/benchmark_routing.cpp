@@ -0,0 +1,154 @@
+#include <AP_gbenchmark.h>
+
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_GCS_ENABLED
+
+const AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+/*
+  route a mix of traffic like that on a vehicle with two GCS links, a
+  companion computer with cameras and gimbals, an ADS-B receiver and
+  other vehicles on a mesh radio. The links are locked so nothing is
+  written to a port, and the benchmark measures the routing decisions
+ */
+
+// a GCS_Dummy link on a channel without a running port
+class BenchLink : public GCS_MAVLINK_Dummy {
+public:
+    BenchLink(GCS_MAVLINK_Parameters &params, AP_HAL::UARTDriver &uart, uint8_t instance) :
+        GCS_MAVLINK_Dummy(params, uart)
+    {
+        chan = (mavlink_channel_t)(MAVLINK_COMM_0 + instance);
+        lock(true);
+    }
+};
+
+class BenchGCS : public GCS_Dummy {
+public:
+    void add_links(uint8_t n) {
+        while (_num_gcs < n) {
+            _chan[_num_gcs] = new BenchLink(chan_parameters[_num_gcs], *hal.serial(0), _num_gcs);
+            _num_gcs++;
+        }
+    }
+};
+
+static BenchGCS bench_gcs;
+static MAVLink_routing routing;
+static mavlink_status_t status;
+
+struct Source {
+    uint8_t sysid;
+    uint8_t compid;
+    uint8_t chan;
+};
+
+static const uint16_t max_packets = 4096;
+static mavlink_message_t packets[max_packets];
+static uint8_t packet_chan[max_packets];
+
+/*
+  make a capture of packets from the vehicles and components, with
+  num_cameras camera components on the companion computer link
+ */
+static void make_capture(uint8_t num_cameras)
+{
+    bench_gcs.add_links(5);
+    mavlink_system.sysid = 1;
+
+    Source sources[80] {
+        { 255, MAV_COMP_ID_MISSIONPLANNER, 0 },     // GCS on telemetry radio
+        { 254, MAV_COMP_ID_MISSIONPLANNER, 4 },     // GCS over UDP
+        { 1, MAV_COMP_ID_ONBOARD_COMPUTER, 1 },
+        { 1, MAV_COMP_ID_GIMBAL, 2 },
+        { 1, MAV_COMP_ID_GIMBAL2, 2 },
+        { 1, MAV_COMP_ID_ADSB, 3 },
+        { 2, MAV_COMP_ID_AUTOPILOT1, 3 },           // other vehicles
+        { 3, MAV_COMP_ID_AUTOPILOT1, 3 },
+        { 4, MAV_COMP_ID_AUTOPILOT1, 3 },
+    };
+    uint8_t num_sources = 9;
+    for (uint8_t i=0; i<num_cameras && num_sources < ARRAY_SIZE(sources); i++) {
+        sources[num_sources++] = { 1, uint8_t(MAV_COMP_ID_CAMERA + i), 1 };
+    }
+
+    uint32_t seed = 1;
+    for (uint16_t i=0; i<max_packets; i++) {
+        seed = seed * 1103515245U + 12345U;
+        const Source &src = sources[(seed >> 16) % num_sources];
+        const Source &dest = sources[(seed >> 8) % num_sources];
+        mavlink_message_t &msg = packets[i];
+        packet_chan[i] = src.chan;
+        if (src.compid == MAV_COMP_ID_ADSB) {
+            const mavlink_adsb_vehicle_t adsb {};
+            mavlink_msg_adsb_vehicle_encode_status(src.sysid, src.compid, &status, &msg, &adsb);
+            continue;
+        }
+        switch ((seed >> 24) % 8) {
+        case 0: {
+            // heartbeats
+            const mavlink_heartbeat_t heartbeat {};
+            mavlink_msg_heartbeat_encode_status(src.sysid, src.compid, &status, &msg, &heartbeat);
+            break;
+        }
+        case 1:
+        case 2:
+        case 3: {
+            // telemetry without a target
+            const mavlink_attitude_t attitude {};
+            mavlink_msg_attitude_encode_status(src.sysid, src.compid, &status, &msg, &attitude);
+            break;
+        }
+        case 4:
+        case 5: {
+            // targeted at another component or vehicle
+            mavlink_param_set_t param_set {};
+            param_set.target_system = dest.sysid;
+            param_set.target_component = dest.compid;
+            mavlink_msg_param_set_encode_status(src.sysid, src.compid, &status, &msg, &param_set);
+            break;
+        }
+        case 6: {
+            // targeted at the autopilot
+            mavlink_param_set_t param_set {};
+            param_set.target_system = mavlink_system.sysid;
+            param_set.target_component = mavlink_system.compid;
+            mavlink_msg_param_set_encode_status(src.sysid, src.compid, &status, &msg, &param_set);
+            break;
+        }
+        default: {
+            // broadcast to all components of a system
+            mavlink_param_set_t param_set {};
+            param_set.target_system = dest.sysid;
+            param_set.target_component = 0;
+            mavlink_msg_param_set_encode_status(src.sysid, src.compid, &status, &msg, &param_set);
+            break;
+        }
+        }
+    }
+}
+
+static void BM_RoutingMixedTraffic(benchmark::State& state)
+{
+    make_capture(state.range(0));
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        GCS_MAVLINK *link = gcs().chan(packet_chan[i]);
+        bool local = routing.check_and_forward(*link, packets[i]);
+        gbenchmark_escape(&local);
+        i = (i + 1) % max_packets;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 15 routes, then 59
+BENCHMARK(BM_RoutingMixedTraffic)->Arg(6)->Arg(50);
+
+#endif // HAL_GCS_ENABLED
+
+BENCHMARK_MAIN();